@@ -86,6 +86,8 @@ int main()
     auto connOpts = mqtt::connect_options_builder().automatic_reconnect().finalize();
     client = new mqttcpp::MqttClient(SERVER_ADDRESS, CLIENT_ID, connOpts);
     client->set_event_handler(main_event_handle);
+    // This demo inspects the completed tokens in EVENT_ACTION_SUCCESS
+    client->set_completion_mode(CompletionMode::TOKEN_EVENTS);
     if (!client->connect(true, 5))
     {
         return 0;
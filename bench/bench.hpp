@@ -0,0 +1,58 @@
+/**
+ * @file bench.hpp
+ * @brief Minimal timing helpers shared by the MQTTClient benchmarks.
+ *
+ * The benchmarks are plain executables: each one prints a line per case with the
+ * total wall time and the average cost per operation. Broker settings are read from
+ * the same environment variables as the unit tests.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_BENCH__
+#define __CORE_MQTT_BENCH__
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace bench
+{
+    /**
+     * @brief Reads an environment variable, falling back to a default value.
+     */
+    inline std::string env_or(const char* name, const char* fallback)
+    {
+        const char* value = std::getenv(name);
+        return value ? value : fallback;
+    }
+
+    /**
+     * @brief Broker address used by benchmarks that need a live connection.
+     */
+    inline std::string server_address()
+    {
+        return env_or("MQTT_SERVER", "tcp://localhost:1883");
+    }
+
+    /**
+     * @brief Runs @p fn once and reports the elapsed time divided by @p ops.
+     *
+     * @param name Label printed in front of the result.
+     * @param ops Number of operations performed by @p fn, used for the per-op average.
+     * @param fn The measured callable.
+     * @return The average cost of one operation, in nanoseconds.
+     */
+    template <typename Fn>
+    double measure(const char* name, std::size_t ops, Fn&& fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        double perOp = ops ? ns / static_cast<double>(ops) : ns;
+        std::printf("%-48s %12.3f ms %12.1f ns/op\n", name, ns / 1e6, perOp);
+        return perOp;
+    }
+} // namespace bench
+
+#endif // __CORE_MQTT_BENCH__
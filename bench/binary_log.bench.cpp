@@ -0,0 +1,118 @@
+#include "binary_log.hpp"
+#include "bench.hpp"
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const std::string TOPIC = "fleet/dev42/telemetry";
+
+    // The operation-level statement of a message arrival, as text and as a binary record
+    void log_text(std::size_t i)
+    {
+        dinfo1("Message arrived: topic %s, %zu bytes, qos %d, retained %d", TOPIC.c_str(), i, 1, 0).print();
+    }
+
+    void log_binary(std::size_t i)
+    {
+        dbinfo("Message arrived: topic %s, %zu bytes, qos %d, retained %d", TOPIC, i, 1, 0);
+    }
+
+    // CPU time of the calling thread, which excludes the async backend thread
+    double thread_cpu_nanos()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) * 1e9 + static_cast<double>(now.tv_nsec);
+    }
+
+    template <typename Fn>
+    void run(const char* name, std::size_t calls, Fn&& fn)
+    {
+        double start = thread_cpu_nanos();
+        for (std::size_t i = 0; i < calls; ++i)
+        {
+            fn(i);
+        }
+        std::printf("%-48s %12.1f ns/op of caller CPU\n", name,
+                    (thread_cpu_nanos() - start) / static_cast<double>(calls));
+    }
+
+    template <typename Fn>
+    void run_threads(const char* name, std::size_t threads, std::size_t calls, Fn&& fn)
+    {
+        bench::measure(name, calls * threads, [&] {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&] {
+                    for (std::size_t i = 0; i < calls; ++i)
+                    {
+                        fn(i);
+                    }
+                });
+            }
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+        });
+    }
+} // namespace
+
+// Compares one operation-level statement printed as text to /dev/null, queued to the asynchronous text
+// backend and written as a binary record, then decodes the binary file.
+int main(int argc, char* argv[])
+{
+    const std::size_t calls = argc > 1 ? std::stoul(argv[1]) : 200000;
+    const std::string path = argc > 2 ? argv[2] : "binary_log.bench.bin";
+    if (!std::freopen("/dev/null", "w", stderr))
+    {
+        std::perror("freopen");
+        return 1;
+    }
+
+    run("text, synchronous", calls, log_text);
+    run_threads("text, synchronous, 4 threads", 4, calls / 4, log_text);
+
+    FILE* sink = std::fopen("/dev/null", "w");
+    ddbg::async_log_options asyncOpts;
+    asyncOpts.output = sink;
+    asyncOpts.ringBytes = 1 << 22;
+    ddbg::start_async_logging(asyncOpts);
+    run("text, asynchronous backend", calls, log_text);
+    ddbg::flush_async_log();
+    ddbg::stop_async_logging();
+    std::fclose(sink);
+
+    ddbg::binary_log_options binaryOpts;
+    binaryOpts.path = path;
+    binaryOpts.fileBytes = 256 * 1024 * 1024;
+    if (!ddbg::start_binary_logging(binaryOpts))
+    {
+        std::printf("cannot map %s\n", path.c_str());
+        return 1;
+    }
+    run("binary", calls, log_binary);
+    run_threads("binary, 4 threads", 4, calls / 4, log_binary);
+    ddbg::stop_binary_logging();
+    ddbg::binary_log_stats stats = ddbg::get_binary_log_stats();
+
+    std::size_t decoded = 0;
+    std::string out;
+    bench::measure("decode binary file", 2 * calls, [&] {
+        ddbg::read_binary_log(path, [&](const ddbg::binary_log_record& record) {
+            out.clear();
+            ddbg::append_log_entry(out, record.entry);
+            ++decoded;
+        });
+    });
+    std::printf("binary: %llu records, %llu dropped, %llu bytes, %zu decoded\n",
+                static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped),
+                static_cast<unsigned long long>(stats.bytes), decoded);
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "mqttclient.hpp"
+#include "bench.hpp"
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // Publishes count messages of size bytes to the client's own subscription and waits until they are saved
+    bool fill(MqttClient& client, const std::string& topic, std::size_t count, std::size_t size)
+    {
+        mqtt::const_message_ptr msg = mqtt::make_message(topic, std::string(size, 'x'), 1, false);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (!client.publish(msg, i + 1 == count, 10000))
+            {
+                return false;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return true;
+    }
+} // namespace
+
+// Compares taking saved messages as payload copies (mqtt::binary) with taking the shared
+// message pointers, for 1 KB and 1 MB payloads.
+// Requires a broker reachable at MQTT_SERVER (default tcp://localhost:1883).
+int main(int argc, char* argv[])
+{
+    const std::size_t smallCount = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const std::size_t largeCount = argc > 2 ? std::stoul(argv[2]) : 50;
+    const std::string topic = bench::env_or("MQTT_TOPIC", "bench/consume");
+
+    MqttClient client(bench::server_address(), "bench_consume");
+    if (!client.connect(true, 5000) || !client.connected() || !client.subscribe(topic, 1, true, 5000) ||
+        !client.start_saving_message())
+    {
+        std::fprintf(stderr, "Cannot connect to %s\n", bench::server_address().c_str());
+        return 1;
+    }
+
+    struct
+    {
+        const char* label;
+        std::size_t count;
+        std::size_t size;
+    } cases[] = {{"1 KB", smallCount, 1024}, {"1 MB", largeCount, 1024 * 1024}};
+
+    for (const auto& c : cases)
+    {
+        std::string name;
+
+        if (!fill(client, topic, c.count, c.size))
+        {
+            return 1;
+        }
+        name = std::string("wait_next_message(binary) ") + c.label;
+        bench::measure(name.c_str(), c.count, [&] {
+            mqtt::binary msg;
+            for (std::size_t i = 0; i < c.count && client.wait_next_message(msg, 1000); ++i)
+            {
+            }
+        });
+
+        if (!fill(client, topic, c.count, c.size))
+        {
+            return 1;
+        }
+        name = std::string("wait_next_message(message_ptr) ") + c.label;
+        bench::measure(name.c_str(), c.count, [&] {
+            mqtt::const_message_ptr msg;
+            for (std::size_t i = 0; i < c.count && client.wait_next_message(msg, 1000); ++i)
+            {
+            }
+        });
+    }
+
+    client.disconnect(true, 5000);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "flight_recorder.hpp"
+#include "bench.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void run(const char* name, mqttcpp::FlightRecorder& recorder, std::size_t threads, std::size_t calls)
+    {
+        const uint64_t topic = mqttcpp::FlightRecorder::topic_hash("fleet/dev42/telemetry");
+        bench::measure(name, calls * threads, [&] {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&] {
+                    for (std::size_t i = 0; i < calls; ++i)
+                    {
+                        recorder.record("publish done", topic, static_cast<int>(i), 0, 0);
+                    }
+                });
+            }
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+        });
+    }
+} // namespace
+
+// Measures the cost of one recorded event, which MqttClient pays for every operation, completion and callback
+// event, and the cost of reading the whole ring back.
+int main(int argc, char* argv[])
+{
+    const std::size_t calls = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    mqttcpp::FlightRecorder recorder;
+
+    run("record, 1 thread", recorder, 1, calls);
+    run("record, 4 threads", recorder, 4, calls / 4);
+
+    std::size_t events = 0;
+    bench::measure("snapshot of the ring", 1000, [&] {
+        for (int i = 0; i < 1000; ++i)
+        {
+            events += recorder.snapshot().size();
+        }
+    });
+    return events == 0;
+}
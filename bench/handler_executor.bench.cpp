@@ -0,0 +1,61 @@
+#include "handler_executor.hpp"
+#include "bench.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // Stands in for a handler waiting on I/O, e.g. a database write
+    void slow_handler(unsigned int micros)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(micros));
+    }
+} // namespace
+
+// Compares handling messages on the callback thread with handing them to 1..16 keyed workers, when every
+// handler takes a fixed time. The producer loop plays the part of the paho callback thread.
+int main(int argc, char* argv[])
+{
+    const std::size_t messages = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const unsigned int handlerMicros = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 100;
+    const std::size_t topicCount = 64;
+    std::vector<mqtt::const_message_ptr> msgs;
+    for (std::size_t i = 0; i < messages; ++i)
+    {
+        msgs.push_back(mqtt::make_message("fleet/dev" + std::to_string(i % topicCount) + "/telemetry", "x", 0, false));
+    }
+    std::printf("%zu messages over %zu topics, %u us per handler\n", messages, topicCount, handlerMicros);
+
+    bench::measure("callback thread (no workers)", messages, [&] {
+        for (const auto& msg : msgs)
+        {
+            (void)msg;
+            slow_handler(handlerMicros);
+        }
+    });
+
+    for (std::size_t workers : {1, 2, 4, 8, 16})
+    {
+        handler_executor_options opts;
+        opts.workers = workers;
+        opts.keyLevel = 1;
+        double callbackNanos = 0;
+        std::string name = std::to_string(workers) + " workers, keyed by device";
+        bench::measure(name.c_str(), messages, [&] {
+            HandlerExecutor executor(opts, [&](const mqtt::const_message_ptr&) { slow_handler(handlerMicros); });
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& msg : msgs)
+            {
+                executor.submit(msg);
+            }
+            callbackNanos = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            // The destructor waits for the queued messages
+        });
+        std::printf("%-48s %12.3f ms of callback thread time\n", "", callbackNanos / 1e6);
+    }
+    return 0;
+}
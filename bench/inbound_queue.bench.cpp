@@ -0,0 +1,124 @@
+#include "inbound_queue.hpp"
+#include "bench.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // The former design: one deque behind a mutex, taken on every push and pop
+    class LockedQueue
+    {
+        std::mutex guard_;
+        std::condition_variable cv_;
+        std::deque<mqtt::const_message_ptr> queue_;
+
+    public:
+        bool push(const mqtt::const_message_ptr& msg)
+        {
+            {
+                std::lock_guard<std::mutex> lock(guard_);
+                queue_.push_back(msg);
+            }
+            cv_.notify_one();
+            return true;
+        }
+
+        bool pop(mqtt::const_message_ptr& msg, unsigned int wait_for)
+        {
+            std::unique_lock<std::mutex> lock(guard_);
+            if (!cv_.wait_for(lock, std::chrono::milliseconds(wait_for), [this] { return !queue_.empty(); }))
+            {
+                return false;
+            }
+            msg = std::move(queue_.front());
+            queue_.pop_front();
+            return true;
+        }
+    };
+
+    // One producer pushes every message while consumers pop until all of them were consumed
+    template <typename Push, typename Pop>
+    void run(const std::vector<mqtt::const_message_ptr>& msgs, std::size_t consumers, Push&& push, Pop&& pop)
+    {
+        std::atomic<std::size_t> consumed{0};
+        std::vector<std::thread> threads;
+        for (std::size_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&, c] {
+                mqtt::const_message_ptr msg;
+                while (consumed.load(std::memory_order_relaxed) < msgs.size())
+                {
+                    if (pop(c, msg))
+                    {
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (const auto& msg : msgs)
+        {
+            while (!push(msg))
+            {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+} // namespace
+
+// Measures one producer feeding 1 to 16 consumer threads through a mutex-protected deque,
+// the shared lock-free InboundQueue, and an InboundQueue with one shard per consumer.
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    const std::size_t capacity = 16384;
+
+    std::vector<mqtt::const_message_ptr> msgs;
+    msgs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        msgs.push_back(mqtt::make_message("bench/inbound/" + std::to_string(i % 256), "payload", 0, false));
+    }
+
+    for (std::size_t consumers : {1, 2, 4, 8, 16})
+    {
+        std::string name = "mutex deque, consumers=" + std::to_string(consumers);
+        bench::measure(name.c_str(), count, [&] {
+            LockedQueue queue;
+            run(msgs,
+                consumers,
+                [&](const mqtt::const_message_ptr& msg) { return queue.push(msg); },
+                [&](std::size_t, mqtt::const_message_ptr& msg) { return queue.pop(msg, 1); });
+        });
+
+        name = "InboundQueue shared, consumers=" + std::to_string(consumers);
+        bench::measure(name.c_str(), count, [&] {
+            InboundQueue queue(inbound_queue_options{capacity, 1});
+            queue.open();
+            run(msgs,
+                consumers,
+                [&](const mqtt::const_message_ptr& msg) { return queue.push(msg); },
+                [&](std::size_t, mqtt::const_message_ptr& msg) { return queue.pop(msg, 1); });
+        });
+
+        name = "InboundQueue sharded, consumers=" + std::to_string(consumers);
+        bench::measure(name.c_str(), count, [&] {
+            InboundQueue queue(inbound_queue_options{capacity, consumers});
+            queue.open();
+            run(msgs,
+                consumers,
+                [&](const mqtt::const_message_ptr& msg) { return queue.push(msg); },
+                [&](std::size_t shard, mqtt::const_message_ptr& msg) { return queue.pop(shard, msg, 1); });
+        });
+    }
+    return 0;
+}
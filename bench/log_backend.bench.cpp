@@ -0,0 +1,90 @@
+#include "monitor.hpp"
+#include "bench.hpp"
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The statement mqttclient.cpp runs for every arrived message
+    void log_arrival(const std::string& topic, const std::string& payload)
+    {
+        dinfo1("Message arrived: ") << "Topic: " << topic << ", Payload: " << payload << ", Retained: false"
+                                    << std::endl;
+    }
+
+    // CPU time of the calling thread, which excludes the background thread
+    double thread_cpu_nanos()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) * 1e9 + static_cast<double>(now.tv_nsec);
+    }
+
+    void run(const char* name, std::size_t threads, std::size_t calls)
+    {
+        const std::string topic = "fleet/dev42/telemetry";
+        const std::string payload(64, 'x');
+        if (threads == 1)
+        {
+            double start = thread_cpu_nanos();
+            for (std::size_t i = 0; i < calls; ++i)
+            {
+                log_arrival(topic, payload);
+            }
+            std::printf("%-48s %12.1f ns/op of caller CPU\n", name,
+                        (thread_cpu_nanos() - start) / static_cast<double>(calls));
+            return;
+        }
+        bench::measure(name, calls * threads, [&] {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&] {
+                    for (std::size_t i = 0; i < calls; ++i)
+                    {
+                        log_arrival(topic, payload);
+                    }
+                });
+            }
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+        });
+    }
+} // namespace
+
+// Compares the per-call cost of a Printer statement printed synchronously to stderr with the same statement
+// queued to the asynchronous backend. Both write to /dev/null so that the terminal is not measured. The single
+// thread cases report the caller's CPU time, the multi-thread cases the wall time including the backend thread.
+int main(int argc, char* argv[])
+{
+    const std::size_t calls = argc > 1 ? std::stoul(argv[1]) : 200000;
+    if (!std::freopen("/dev/null", "w", stderr))
+    {
+        std::perror("freopen");
+        return 1;
+    }
+
+    run("synchronous print, 1 thread", 1, calls);
+    run("synchronous print, 4 threads", 4, calls / 4);
+
+    FILE* sink = std::fopen("/dev/null", "w");
+    ddbg::async_log_options opts;
+    opts.output = sink;
+    opts.ringBytes = 1 << 20;
+    ddbg::start_async_logging(opts);
+    run("asynchronous backend, 1 thread", 1, calls);
+    run("asynchronous backend, 4 threads", 4, calls / 4);
+    ddbg::flush_async_log();
+    ddbg::stop_async_logging();
+    std::fclose(sink);
+
+    ddbg::async_log_stats stats = ddbg::get_async_log_stats();
+    std::printf("asynchronous backend: %llu written, %llu dropped\n", static_cast<unsigned long long>(stats.written),
+                static_cast<unsigned long long>(stats.dropped));
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "mqttclient.hpp"
+#include "monitor.hpp"
+#include "bench.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace mqttcpp;
+
+// Measures the message-arrival path (callback thread, topic handler, EVENT_MESSAGE_ARRIVED) with the arrival
+// logged to /dev/null and with INFO and all logging switched off at runtime. 1 KB payloads, QoS 1.
+// Requires a broker reachable at MQTT_SERVER (default tcp://localhost:1883).
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const std::string topic = bench::env_or("MQTT_TOPIC", "bench/log_level");
+    mqtt::const_message_ptr msg = mqtt::make_message(topic, std::string(1024, 'x'), 1, false);
+
+    MqttClient client(bench::server_address(), "bench_log_level");
+    if (!client.connect(true, 5000) || !client.connected() || !client.subscribe(topic, 1, true, 5000))
+    {
+        std::fprintf(stderr, "Cannot connect to %s\n", bench::server_address().c_str());
+        return 1;
+    }
+    std::atomic<std::size_t> arrived{0};
+    client.add_message_handler(topic, [&arrived](const mqtt::const_message_ptr&) { arrived.fetch_add(1); });
+    if (!std::freopen("/dev/null", "w", stderr))
+    {
+        std::perror("freopen");
+        return 1;
+    }
+
+    struct
+    {
+        const char* label;
+        int level;
+    } cases[] = {{"arrival path, DEBUG (printed)", DD_LEVEL_DEBUG},
+                 {"arrival path, ERROR (arrival not logged)", DD_LEVEL_ERROR},
+                 {"arrival path, OFF", DD_LEVEL_OFF}};
+
+    for (const auto& c : cases)
+    {
+        ddbg::set_log_level(c.level);
+        arrived.store(0);
+        bench::measure(c.label, count, [&] {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                client.publish(msg, false);
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            while (arrived.load() < count && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+        if (arrived.load() < count)
+        {
+            std::printf("%-48s only %zu of %zu messages arrived\n", "", arrived.load(), count);
+        }
+    }
+    ddbg::set_log_level(DD_LEVEL_DEBUG);
+    client.disconnect(true, 5000);
+    return 0;
+}
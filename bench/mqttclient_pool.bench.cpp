@@ -0,0 +1,61 @@
+#include "mqttclient_pool.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+// Measures publish throughput through pools of 1 to N connections, with one publishing
+// thread per connection. Requires a broker reachable at MQTT_SERVER (default tcp://localhost:1883).
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const std::size_t maxSize = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency() / 2);
+    const unsigned int qos = 1;
+
+    for (std::size_t size = 1; size <= maxSize; size *= 2)
+    {
+        MqttClientPool pool(bench::server_address(), "bench_pool", size);
+        if (!pool.connect(true, 5000))
+        {
+            std::fprintf(stderr, "Cannot connect %zu clients to %s\n", size, bench::server_address().c_str());
+            return 1;
+        }
+
+        // Give every publisher topics that all land on its own connection
+        std::vector<std::vector<std::string>> topics(size);
+        auto short_of_topics = [](const std::vector<std::string>& own) { return own.size() < 8; };
+        for (std::size_t i = 0; std::any_of(topics.begin(), topics.end(), short_of_topics); ++i)
+        {
+            std::string topic = "bench/pool/" + std::to_string(i);
+            topics[pool.shard_of(topic)].push_back(topic);
+        }
+
+        std::string label = std::to_string(size) + " connection(s)";
+        bench::measure(label.c_str(), count, [&] {
+            std::vector<std::thread> publishers;
+            for (std::size_t t = 0; t < size; ++t)
+            {
+                publishers.emplace_back([&, t] {
+                    mqtt::token_ptr token;
+                    const auto& own = topics[t];
+                    for (std::size_t i = t; i < count; i += size)
+                    {
+                        pool.publish(token, own[i % own.size()], "payload", qos);
+                    }
+                    if (token)
+                    {
+                        token->wait();
+                    }
+                });
+            }
+            for (auto& publisher : publishers)
+            {
+                publisher.join();
+            }
+        });
+        pool.disconnect(true, 5000);
+    }
+    return 0;
+}
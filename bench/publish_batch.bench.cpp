@@ -0,0 +1,45 @@
+#include "mqttclient.hpp"
+#include "bench.hpp"
+#include <vector>
+
+using namespace mqttcpp;
+
+// Compares N single publishes with one publish_batch of N messages.
+// Requires a broker reachable at MQTT_SERVER (default tcp://localhost:1883).
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const std::string topic = bench::env_or("MQTT_TOPIC", "bench/publish_batch");
+    const unsigned int qos = 0;
+
+    MqttClient client(bench::server_address(), "bench_publish_batch");
+    if (!client.connect(true, 5000) || !client.connected())
+    {
+        std::fprintf(stderr, "Cannot connect to %s\n", bench::server_address().c_str());
+        return 1;
+    }
+
+    std::vector<publish_request> msgs;
+    msgs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        msgs.push_back({topic, std::string("reading ") + std::to_string(i), qos});
+    }
+
+    bench::measure("publish x N", count, [&] {
+        mqtt::token_ptr token;
+        for (const auto& msg : msgs)
+        {
+            client.publish(token, msg.topic, msg.payload.str(), qos);
+        }
+        if (token)
+        {
+            token->wait();
+        }
+    });
+
+    bench::measure("publish_batch(N)", count, [&] { client.publish_batch(msgs, true); });
+
+    client.disconnect(true, 5000);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "mqttclient.hpp"
+#include "bench.hpp"
+
+using namespace mqttcpp;
+
+namespace
+{
+    class NullListener : public mqtt::iaction_listener
+    {
+    public:
+        void on_failure(const mqtt::token&) override
+        {}
+        void on_success(const mqtt::token&) override
+        {}
+    };
+} // namespace
+
+// Compares MqttClient::publish with calling mqtt::async_client::publish directly, using a
+// prebuilt QoS 0 message so that only the wrapper overhead differs.
+// Requires a broker reachable at MQTT_SERVER (default tcp://localhost:1883).
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const std::string topic = bench::env_or("MQTT_TOPIC", "bench/publish_overhead");
+    mqtt::const_message_ptr msg = mqtt::make_message(topic, "overhead", 0, false);
+
+    NullListener listener;
+    mqtt::async_client direct(bench::server_address(), "bench_overhead_direct");
+    MqttClient client(bench::server_address(), "bench_overhead_wrapped");
+    try
+    {
+        direct.connect(mqtt::connect_options(), nullptr, listener)->wait();
+    }
+    catch (const mqtt::exception& exc)
+    {
+        std::fprintf(stderr, "Cannot connect to %s: %s\n", bench::server_address().c_str(), exc.what());
+        return 1;
+    }
+    if (!client.connect(true, 5000) || !client.connected())
+    {
+        std::fprintf(stderr, "Cannot connect to %s\n", bench::server_address().c_str());
+        return 1;
+    }
+
+    bench::measure("async_client::publish", count, [&] {
+        mqtt::delivery_token_ptr token;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            token = direct.publish(msg, nullptr, listener);
+        }
+        token->wait();
+    });
+
+    bench::measure("MqttClient::publish", count, [&] {
+        mqtt::token_ptr token;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            client.publish(token, msg);
+        }
+        token->wait();
+    });
+
+    client.disconnect(true, 5000);
+    direct.disconnect(10000, nullptr, listener)->wait();
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "rate_limiter.hpp"
+#include "bench.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+// Measures the per-publish cost of the rate limiter on the hot path, without a broker.
+// The limits are set high enough that nothing is ever delayed or dropped.
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const std::size_t threads = argc > 2 ? std::stoul(argv[2]) : 4;
+    const std::string topic = "plant/line1/sensor42/temperature";
+    const double unlimited = 1e12;
+
+    RateLimiter none;
+    bench::measure("no limits", count, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            none.acquire(topic);
+        }
+    });
+
+    RateLimiter global;
+    global.set_global_limit(unlimited, 1000, RateLimitMode::FAIL);
+    bench::measure("global limit", count, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            global.acquire(topic);
+        }
+    });
+
+    RateLimiter filters;
+    filters.set_global_limit(unlimited, 1000, RateLimitMode::FAIL);
+    for (int i = 0; i < 8; ++i)
+    {
+        filters.set_topic_limit("plant/line" + std::to_string(i) + "/#", unlimited, 1000, RateLimitMode::FAIL);
+    }
+    filters.set_topic_limit("plant/+/+/temperature", unlimited, 1000, RateLimitMode::DELAY);
+    bench::measure("global + 9 topic limits", count, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            filters.acquire(topic);
+        }
+    });
+
+    std::string label = "global limit, " + std::to_string(threads) + " threads";
+    bench::measure(label.c_str(), count * threads, [&] {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&] {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    global.acquire(topic);
+                }
+            });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "topic_dispatcher.hpp"
+#include "topic_simd.hpp"
+#include "bench.hpp"
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // One filter per device, with a wildcard-only filter per fleet every hundredth device
+    std::string make_filter(std::size_t i)
+    {
+        if (i % 100 == 99)
+        {
+            return "fleet/" + std::to_string(i / 1000) + "/#";
+        }
+        return "fleet/" + std::to_string(i / 1000) + "/dev" + std::to_string(i % 1000) + "/+";
+    }
+
+    std::string make_topic(std::size_t i, std::size_t filters)
+    {
+        std::size_t device = (i * 7919) % filters;
+        return "fleet/" + std::to_string(device / 1000) + "/dev" + std::to_string(device % 1000) + "/telemetry";
+    }
+
+    void run(std::size_t filters, std::size_t lookups)
+    {
+        std::printf("-- %zu filters\n", filters);
+        TopicDispatcher dispatcher;
+        std::vector<std::string> names;
+        names.reserve(filters);
+        for (std::size_t i = 0; i < filters; ++i)
+        {
+            names.push_back(make_filter(i));
+        }
+        bench::measure("register", filters, [&] {
+            for (const auto& name : names)
+            {
+                dispatcher.add(name, [](const mqtt::const_message_ptr&) {});
+            }
+        });
+
+        std::vector<std::string> topics;
+        for (std::size_t i = 0; i < 1024; ++i)
+        {
+            topics.push_back(make_topic(i, filters));
+        }
+        std::vector<TopicDispatcher::handler_ptr> matched;
+        std::size_t hits = 0;
+        bench::measure("trie match", lookups, [&] {
+            for (std::size_t i = 0; i < lookups; ++i)
+            {
+                matched.clear();
+                dispatcher.match(topics[i % topics.size()], matched);
+                hits += matched.size();
+            }
+        });
+
+        auto msg = mqtt::make_message(topics[0], "payload", 0, false);
+        bench::measure("trie dispatch", lookups, [&] {
+            for (std::size_t i = 0; i < lookups; ++i)
+            {
+                hits += dispatcher.dispatch(msg);
+            }
+        });
+
+        // The linear scan is what a handler comparing every filter does; keep it short at large sizes
+        const std::size_t scans = std::max<std::size_t>(1, lookups * 1000 / filters / 100);
+        bench::measure("linear filter_matches scan", scans, [&] {
+            for (std::size_t i = 0; i < scans; ++i)
+            {
+                const std::string& topic = topics[i % topics.size()];
+                for (const auto& name : names)
+                {
+                    hits += filter_matches(name, topic) ? 1 : 0;
+                }
+            }
+        });
+        std::printf("   (%zu matches)\n", hits);
+    }
+} // namespace
+
+// Measures the cost of matching one inbound topic against many registered filters.
+int main(int argc, char* argv[])
+{
+    const std::size_t lookups = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<std::size_t> sizes;
+    for (int i = 2; i < argc; ++i)
+    {
+        sizes.push_back(std::stoul(argv[i]));
+    }
+    if (sizes.empty())
+    {
+        sizes = {10000, 1000000};
+    }
+    for (std::size_t filters : sizes)
+    {
+        run(filters, lookups);
+    }
+    return 0;
+}
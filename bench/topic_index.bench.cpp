@@ -0,0 +1,116 @@
+#include "topic_index.hpp"
+#include "bench.hpp"
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // Resident memory of the process, in bytes
+    std::size_t resident_bytes()
+    {
+        std::ifstream statm("/proc/self/statm");
+        std::size_t pages = 0;
+        std::size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * 4096;
+    }
+
+    // Node-per-level trie keyed by std::string with std::map children, as a reference point
+    struct naive_node
+    {
+        std::map<std::string, std::unique_ptr<naive_node>> children;
+        std::vector<uint32_t> values;
+    };
+
+    void naive_insert(naive_node& root, const std::string& filter, uint32_t value)
+    {
+        naive_node* current = &root;
+        std::size_t pos = 0;
+        while (pos <= filter.size())
+        {
+            std::size_t end = filter.find('/', pos);
+            if (end == std::string::npos)
+            {
+                end = filter.size();
+            }
+            auto& child = current->children[filter.substr(pos, end - pos)];
+            if (!child)
+            {
+                child = std::make_unique<naive_node>();
+            }
+            current = child.get();
+            pos = end + 1;
+        }
+        current->values.push_back(value);
+    }
+
+    // A filter per downstream device: gateway/<site>/<device serial>/<channel or +>
+    std::string make_filter(std::size_t i)
+    {
+        return "gateway/site" + std::to_string(i / 5000) + "/dev-" + std::to_string(100000000 + i) + "/" +
+               (i % 4 == 0 ? "+" : "telemetry");
+    }
+} // namespace
+
+// Reports the memory footprint of one million device filters and the latency of matching a topic.
+int main(int argc, char* argv[])
+{
+    const std::size_t filters = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const std::size_t lookups = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    std::vector<std::string> names;
+    names.reserve(filters);
+    for (std::size_t i = 0; i < filters; ++i)
+    {
+        names.push_back(make_filter(i));
+    }
+
+    std::size_t before = resident_bytes();
+    TopicIndex index;
+    bench::measure("TopicIndex insert", filters, [&] {
+        for (std::size_t i = 0; i < filters; ++i)
+        {
+            index.insert(names[i], static_cast<uint32_t>(i));
+        }
+    });
+    std::size_t indexResident = resident_bytes() - before;
+    std::printf("TopicIndex: %.1f bytes/filter allocated, %.1f bytes/filter resident, %zu levels\n",
+                static_cast<double>(index.memory_usage()) / static_cast<double>(filters),
+                static_cast<double>(indexResident) / static_cast<double>(filters),
+                index.level_count());
+
+    std::vector<std::string> topics;
+    for (std::size_t i = 0; i < 4096; ++i)
+    {
+        std::size_t device = (i * 7919) % filters;
+        topics.push_back("gateway/site" + std::to_string(device / 5000) + "/dev-" +
+                         std::to_string(100000000 + device) + "/telemetry");
+    }
+    std::vector<uint32_t> matched;
+    std::size_t hits = 0;
+    bench::measure("TopicIndex match", lookups, [&] {
+        for (std::size_t i = 0; i < lookups; ++i)
+        {
+            matched.clear();
+            index.match(topics[i % topics.size()], matched);
+            hits += matched.size();
+        }
+    });
+
+    before = resident_bytes();
+    naive_node naive;
+    bench::measure("naive std::map trie insert", filters, [&] {
+        for (std::size_t i = 0; i < filters; ++i)
+        {
+            naive_insert(naive, names[i], static_cast<uint32_t>(i));
+        }
+    });
+    std::printf("naive trie: %.1f bytes/filter resident\n",
+                static_cast<double>(resident_bytes() - before) / static_cast<double>(filters));
+    std::printf("(%zu matches)\n", hits);
+    return 0;
+}
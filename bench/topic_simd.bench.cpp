@@ -0,0 +1,97 @@
+#include "topic_simd.hpp"
+#include "bench.hpp"
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    // Scalar reference: the std::string::find loop the index used before the vectorized splitter
+    std::size_t reference_split(const std::string& topic, std::string_view* levels, std::size_t max)
+    {
+        std::size_t count = 0;
+        std::size_t pos = 0;
+        while (pos <= topic.size())
+        {
+            std::size_t end = topic.find('/', pos);
+            if (end == std::string::npos)
+            {
+                end = topic.size();
+            }
+            if (count < max)
+            {
+                levels[count] = std::string_view(topic.data() + pos, end - pos);
+            }
+            ++count;
+            pos = end + 1;
+        }
+        return count;
+    }
+
+    void run(const char* label, const std::vector<std::string>& topics, const std::string& filter, std::size_t ops)
+    {
+        std::printf("-- %s (%zu bytes), filter %s\n", label, topics[0].size(), filter.c_str());
+        std::string_view levels[32];
+        std::size_t sink = 0;
+        std::string name;
+
+        bench::measure("split: std::string::find reference", ops, [&] {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                sink += reference_split(topics[i % topics.size()], levels, 32);
+            }
+        });
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2})
+        {
+            if (!simd_supported(level))
+            {
+                continue;
+            }
+            name = std::string("split: ") + simd_level_name(level);
+            bench::measure(name.c_str(), ops, [&] {
+                for (std::size_t i = 0; i < ops; ++i)
+                {
+                    sink += split_topic(level, topics[i % topics.size()], levels, 32);
+                }
+            });
+        }
+
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2})
+        {
+            if (!simd_supported(level))
+            {
+                continue;
+            }
+            name = std::string("match: ") + simd_level_name(level);
+            bench::measure(name.c_str(), ops, [&] {
+                for (std::size_t i = 0; i < ops; ++i)
+                {
+                    sink += filter_matches(level, filter, topics[i % topics.size()]) ? 1 : 0;
+                }
+            });
+        }
+        std::printf("(%zu)\n", sink);
+    }
+} // namespace
+
+// Compares the vectorized splitter and matcher against the scalar ones on short and long topics.
+int main(int argc, char* argv[])
+{
+    const std::size_t ops = argc > 1 ? std::stoul(argv[1]) : 5000000;
+    std::printf("dispatching to %s\n", simd_level_name(simd_level()));
+
+    std::vector<std::string> shortTopics;
+    std::vector<std::string> longTopics;
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        shortTopics.push_back("fleet/" + std::to_string(i % 16) + "/dev" + std::to_string(i) + "/temp");
+        longTopics.push_back("enterprise/region-eu-west/plant-" + std::to_string(i % 16) +
+                             "/production-line-assembly/cell-0042/device-" + std::to_string(100000000 + i) +
+                             "/telemetry/vibration/axis-z");
+    }
+    run("short topics", shortTopics, "fleet/+/dev7/#", ops);
+    run("long topics", longTopics, "enterprise/region-eu-west/+/production-line-assembly/cell-0042/+/telemetry/#",
+        ops);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "binary_log.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    void usage(const char* program)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--lines] <file>\n"
+                     "Renders a ddbg binary log to stdout.\n"
+                     "  --lines  one line per record: time, thread, level, location and message, without colors\n",
+                     program);
+    }
+
+    void print_line(const ddbg::binary_log_record& record)
+    {
+        static const char* const LEVELS[] = {"ERROR", "INFO", "DEBUG"};
+        const ddbg::log_entry& entry = record.entry;
+        const char* level = entry.mode >= 0 && entry.mode < 3 ? LEVELS[entry.mode] : "-";
+        const long long seconds = static_cast<long long>(entry.when / 1000000000);
+        const long long nanos = static_cast<long long>(entry.when % 1000000000);
+        std::printf("%lld.%09lld T%u %-5s %s:%u %.*s\n", seconds, nanos, record.thread, level,
+                    entry.file ? entry.file : "?", entry.line, static_cast<int>(entry.message.size()),
+                    entry.message.data());
+    }
+} // namespace
+
+// Renders a file written by ddbg::start_binary_logging(), by default in the layout of ddbg::Printer
+int main(int argc, char* argv[])
+{
+    bool lines = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--lines") == 0)
+        {
+            lines = true;
+        }
+        else if (!path && argv[i][0] != '-')
+        {
+            path = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!path)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string error;
+    std::string out;
+    bool ok = ddbg::read_binary_log(
+        path,
+        [&](const ddbg::binary_log_record& record) {
+            if (lines)
+            {
+                print_line(record);
+                return;
+            }
+            out.clear();
+            ddbg::append_log_entry(out, record.entry);
+            out += '\n';
+            std::fwrite(out.data(), 1, out.size(), stdout);
+        },
+        &error);
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,698 @@
+#include "binary_log.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ddbg
+{
+    namespace
+    {
+        constexpr char MAGIC[8] = {'D', 'D', 'B', 'G', 'B', 'I', 'N', '1'};
+        constexpr uint32_t VERSION = 1;
+        constexpr uint16_t SITE_RECORD = 1;  ///< Describes a call site; the strings follow the header.
+        constexpr uint16_t EVENT_RECORD = 2; ///< One call; the encoded arguments follow the header.
+
+        /**
+         * @brief Start of the file. Records follow it, each 8-byte aligned.
+         */
+        struct file_header
+        {
+            char magic[8];       ///< MAGIC.
+            uint32_t version;    ///< VERSION.
+            uint32_t headerSize; ///< sizeof(file_header), where the first record starts.
+            int64_t systemStart; ///< System clock at start, in nanoseconds since the epoch.
+            int64_t steadyStart; ///< Steady clock at start, in nanoseconds, paired with systemStart.
+            uint64_t used;       ///< Bytes used, written by stop; 0 if the process did not stop the log.
+            uint64_t reserved[3];
+        };
+
+        /**
+         * @brief Fixed part of a record.
+         */
+        struct record_header
+        {
+            uint32_t size;    ///< Bytes of the record, alignment included. Written last; 0 until complete.
+            uint32_t payload; ///< Bytes following the header, without the alignment.
+            uint16_t kind;    ///< SITE_RECORD or EVENT_RECORD.
+            int16_t level;    ///< DD_LEVEL_* of the site.
+            uint32_t site;    ///< Site id.
+            uint32_t thread;  ///< Number of the logging thread.
+            uint32_t unused;  ///< Padding, so that when is 8-byte aligned.
+            int64_t when;     ///< Steady clock of the call, in nanoseconds.
+        };
+
+        /**
+         * @brief Fixed part of a SITE_RECORD payload; the file, function and format follow it.
+         */
+        struct site_description
+        {
+            uint32_t line;
+            uint32_t fileLength;
+            uint32_t funcLength;
+            uint32_t formatLength;
+        };
+
+        inline std::size_t align8(std::size_t bytes)
+        {
+            return (bytes + 7) & ~static_cast<std::size_t>(7);
+        }
+
+        inline int64_t steady_nanos()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        /**
+         * @brief Process-wide state of the binary log. Never destroyed, so threads may log during exit.
+         */
+        struct backend
+        {
+            std::mutex lifecycle;                        ///< Serializes start and stop.
+            std::atomic<bool> running{false};            ///< Whether DD_BINARY statements write.
+            std::atomic<int64_t> writers{0};             ///< Records being written, awaited by stop.
+            std::atomic<uint64_t> generation{0};         ///< Bumped by every start, so sites describe themselves again.
+            alignas(64) std::atomic<uint64_t> offset{0}; ///< Next free byte of the mapping.
+            char* base = nullptr;                        ///< The mapping.
+            std::size_t capacity = 0;                    ///< Bytes mapped.
+            std::atomic<uint32_t> nextSite{1};           ///< Next site id.
+            std::atomic<uint32_t> nextThread{1};         ///< Next thread number.
+            std::atomic<uint64_t> written{0};            ///< Records written.
+            std::atomic<uint64_t> dropped{0};            ///< Records dropped on a full file.
+            uint64_t lastBytes = 0;                      ///< Bytes used by the last stopped file.
+#if defined(_WIN32)
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#else
+            int fd = -1;
+#endif
+        };
+
+        backend& state()
+        {
+            static backend* instance = new backend();
+            return *instance;
+        }
+
+        uint32_t thread_number()
+        {
+            thread_local uint32_t number = state().nextThread.fetch_add(1, std::memory_order_relaxed);
+            return number;
+        }
+
+        bool map_file(backend& b, const binary_log_options& opts)
+        {
+#if defined(_WIN32)
+            b.file = CreateFileA(opts.path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                 CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (b.file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            const uint64_t size = opts.fileBytes;
+            b.mapping = CreateFileMappingA(b.file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                           static_cast<DWORD>(size & 0xffffffffu), nullptr);
+            void* view = b.mapping ? MapViewOfFile(b.mapping, FILE_MAP_ALL_ACCESS, 0, 0, opts.fileBytes) : nullptr;
+            if (!view)
+            {
+                if (b.mapping)
+                {
+                    CloseHandle(b.mapping);
+                    b.mapping = nullptr;
+                }
+                CloseHandle(b.file);
+                b.file = INVALID_HANDLE_VALUE;
+                return false;
+            }
+            b.base = static_cast<char*>(view);
+#else
+            b.fd = ::open(opts.path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (b.fd < 0)
+            {
+                return false;
+            }
+            void* view = MAP_FAILED;
+            if (::ftruncate(b.fd, static_cast<off_t>(opts.fileBytes)) == 0)
+            {
+                view = ::mmap(nullptr, opts.fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, b.fd, 0);
+            }
+            if (view == MAP_FAILED)
+            {
+                ::close(b.fd);
+                b.fd = -1;
+                return false;
+            }
+            b.base = static_cast<char*>(view);
+#endif
+            b.capacity = opts.fileBytes;
+            return true;
+        }
+
+        void unmap_file(backend& b, uint64_t used)
+        {
+#if defined(_WIN32)
+            FlushViewOfFile(b.base, 0);
+            UnmapViewOfFile(b.base);
+            CloseHandle(b.mapping);
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(used);
+            SetFilePointerEx(b.file, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(b.file);
+            CloseHandle(b.file);
+            b.mapping = nullptr;
+            b.file = INVALID_HANDLE_VALUE;
+#else
+            ::msync(b.base, b.capacity, MS_SYNC);
+            ::munmap(b.base, b.capacity);
+            if (::ftruncate(b.fd, static_cast<off_t>(used)) != 0)
+            {
+                // The file keeps its mapped size; the reader stops at the first empty record
+            }
+            ::close(b.fd);
+            b.fd = -1;
+#endif
+            b.base = nullptr;
+            b.capacity = 0;
+        }
+
+        /**
+         * @brief Reserves @p payload bytes plus a header. Called with a writer registered.
+         */
+        record_header* reserve(backend& b, std::size_t payload)
+        {
+            const std::size_t size = align8(sizeof(record_header) + payload);
+            const uint64_t at = b.offset.fetch_add(size, std::memory_order_relaxed);
+            if (at + size > b.capacity)
+            {
+                b.dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            record_header* header = reinterpret_cast<record_header*>(b.base + at);
+            header->payload = static_cast<uint32_t>(payload);
+            header->thread = thread_number();
+            header->when = steady_nanos();
+            return header;
+        }
+
+        void publish(backend& b, record_header* header)
+        {
+            // The reader trusts a record once its size is set
+            std::atomic_thread_fence(std::memory_order_release);
+            header->size = static_cast<uint32_t>(align8(sizeof(record_header) + header->payload));
+            b.written.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void describe(backend& b, binary_log_site& site, uint32_t id, uint64_t generation)
+        {
+            site_description description{site.line, static_cast<uint32_t>(std::strlen(site.file)),
+                                         static_cast<uint32_t>(std::strlen(site.func)),
+                                         static_cast<uint32_t>(std::strlen(site.format))};
+            const std::size_t payload =
+                sizeof(description) + description.fileLength + description.funcLength + description.formatLength;
+            record_header* header = reserve(b, payload);
+            if (!header)
+            {
+                return;
+            }
+            header->kind = SITE_RECORD;
+            header->level = static_cast<int16_t>(site.level);
+            header->site = id;
+            char* out = reinterpret_cast<char*>(header + 1);
+            std::memcpy(out, &description, sizeof(description));
+            out += sizeof(description);
+            std::memcpy(out, site.file, description.fileLength);
+            out += description.fileLength;
+            std::memcpy(out, site.func, description.funcLength);
+            out += description.funcLength;
+            std::memcpy(out, site.format, description.formatLength);
+            publish(b, header);
+            // Two threads may both describe the site; the reader keeps either copy
+            site.described.store(generation, std::memory_order_relaxed);
+        }
+
+        uint32_t site_id(backend& b, binary_log_site& site)
+        {
+            uint32_t id = site.id.load(std::memory_order_relaxed);
+            if (id == 0)
+            {
+                uint32_t fresh = b.nextSite.fetch_add(1, std::memory_order_relaxed);
+                id = site.id.compare_exchange_strong(id, fresh, std::memory_order_relaxed) ? fresh : id;
+            }
+            return id;
+        }
+
+        /**
+         * @brief Reads a value of type T at @p at of @p data, if there is room.
+         */
+        template <typename T>
+        bool read_at(const std::vector<char>& data, std::size_t at, T& value)
+        {
+            if (at > data.size() || data.size() - at < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, data.data() + at, sizeof(T));
+            return true;
+        }
+
+        /**
+         * @brief Argument being rendered, decoded from its tag.
+         */
+        struct decoded_arg
+        {
+            uint8_t type = 0;      ///< binlog::arg_type, 0 when missing.
+            uint64_t bits = 0;     ///< Number or pointer bits.
+            std::string_view text; ///< STRING characters.
+        };
+
+        bool next_arg(const char*& cursor, const char* end, decoded_arg& arg)
+        {
+            arg = decoded_arg();
+            if (cursor >= end)
+            {
+                return false;
+            }
+            uint8_t type = static_cast<uint8_t>(*cursor++);
+            if (type == binlog::TEXT)
+            {
+                uint32_t length = 0;
+                if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(length)))
+                {
+                    cursor = end;
+                    return false;
+                }
+                std::memcpy(&length, cursor, sizeof(length));
+                cursor += sizeof(length);
+                if (static_cast<std::size_t>(end - cursor) < length)
+                {
+                    cursor = end;
+                    return false;
+                }
+                arg.text = std::string_view(cursor, length);
+                cursor += length;
+            }
+            else
+            {
+                if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(arg.bits)))
+                {
+                    cursor = end;
+                    return false;
+                }
+                std::memcpy(&arg.bits, cursor, sizeof(arg.bits));
+                cursor += sizeof(arg.bits);
+            }
+            arg.type = type;
+            return true;
+        }
+
+        int64_t as_int(const decoded_arg& arg)
+        {
+            if (arg.type == binlog::REAL)
+            {
+                double number;
+                std::memcpy(&number, &arg.bits, sizeof(number));
+                return static_cast<int64_t>(number);
+            }
+            return static_cast<int64_t>(arg.bits);
+        }
+
+        double as_double(const decoded_arg& arg)
+        {
+            if (arg.type == binlog::REAL)
+            {
+                double number;
+                std::memcpy(&number, &arg.bits, sizeof(number));
+                return number;
+            }
+            return arg.type == binlog::SIGNED_INT ? static_cast<double>(static_cast<int64_t>(arg.bits))
+                                           : static_cast<double>(arg.bits);
+        }
+
+        void append_formatted(std::string& out, const char* spec, ...)
+        {
+            char small[128];
+            va_list args;
+            va_start(args, spec);
+            va_list copy;
+            va_copy(copy, args);
+            int size = vsnprintf(small, sizeof(small), spec, copy);
+            va_end(copy);
+            if (size >= 0 && static_cast<std::size_t>(size) < sizeof(small))
+            {
+                out.append(small, static_cast<std::size_t>(size));
+            }
+            else if (size >= 0)
+            {
+                std::vector<char> buffer(static_cast<std::size_t>(size) + 1);
+                vsnprintf(buffer.data(), buffer.size(), spec, args);
+                out.append(buffer.data(), static_cast<std::size_t>(size));
+            }
+            va_end(args);
+        }
+    } // namespace
+
+    namespace binlog
+    {
+        char* begin_record(binary_log_site& site, std::size_t bytes)
+        {
+            backend& b = state();
+            // Registering before checking running lets stop wait for every writer that saw it set
+            b.writers.fetch_add(1, std::memory_order_seq_cst);
+            if (!b.running.load(std::memory_order_seq_cst))
+            {
+                b.writers.fetch_sub(1, std::memory_order_release);
+                return nullptr;
+            }
+            const uint32_t id = site_id(b, site);
+            const uint64_t generation = b.generation.load(std::memory_order_relaxed);
+            if (site.described.load(std::memory_order_relaxed) != generation)
+            {
+                describe(b, site, id, generation);
+            }
+            record_header* header = reserve(b, bytes);
+            if (!header)
+            {
+                b.writers.fetch_sub(1, std::memory_order_release);
+                return nullptr;
+            }
+            header->kind = EVENT_RECORD;
+            header->level = static_cast<int16_t>(site.level);
+            header->site = id;
+            return reinterpret_cast<char*>(header + 1);
+        }
+
+        void commit_record(char* args)
+        {
+            backend& b = state();
+            publish(b, reinterpret_cast<record_header*>(args) - 1);
+            b.writers.fetch_sub(1, std::memory_order_release);
+        }
+    } // namespace binlog
+
+    bool start_binary_logging(const binary_log_options& opts)
+    {
+        backend& b = state();
+        std::lock_guard<std::mutex> lock(b.lifecycle);
+        if (b.running.load() || opts.path.empty() || opts.fileBytes < sizeof(file_header))
+        {
+            return false;
+        }
+        if (!map_file(b, opts))
+        {
+            return false;
+        }
+        file_header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.headerSize = sizeof(file_header);
+        header.systemStart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+        header.steadyStart = steady_nanos();
+        std::memcpy(b.base, &header, sizeof(header));
+        b.offset.store(sizeof(file_header));
+        // Generation 0 means "never described", so the first file is generation 1
+        b.generation.fetch_add(1);
+        b.running.store(true);
+        return true;
+    }
+
+    void stop_binary_logging()
+    {
+        backend& b = state();
+        std::lock_guard<std::mutex> lock(b.lifecycle);
+        if (!b.running.load())
+        {
+            return;
+        }
+        b.running.store(false);
+        while (b.writers.load(std::memory_order_acquire) != 0)
+        {
+            std::this_thread::yield();
+        }
+        const uint64_t used = std::min<uint64_t>(b.offset.load(), b.capacity);
+        file_header* header = reinterpret_cast<file_header*>(b.base);
+        header->used = used;
+        b.lastBytes = used;
+        unmap_file(b, used);
+    }
+
+    bool binary_logging_enabled()
+    {
+        return state().running.load(std::memory_order_relaxed);
+    }
+
+    binary_log_stats get_binary_log_stats()
+    {
+        backend& b = state();
+        std::lock_guard<std::mutex> lock(b.lifecycle);
+        uint64_t bytes = b.running.load() ? std::min<uint64_t>(b.offset.load(), b.capacity) : b.lastBytes;
+        return binary_log_stats{b.written.load(), b.dropped.load(), bytes};
+    }
+
+    std::string render_binary_format(const char* format, const char* args, std::size_t bytes)
+    {
+        std::string out;
+        const char* cursor = args;
+        const char* end = args + bytes;
+        decoded_arg arg;
+        for (const char* p = format; *p; ++p)
+        {
+            if (*p != '%')
+            {
+                out += *p;
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                out += '%';
+                ++p;
+                continue;
+            }
+            // Keeps flags, width and precision, drops the length modifier and picks one from the argument
+            std::string spec = "%";
+            ++p;
+            while (*p && std::strchr("-+ #0", *p))
+            {
+                spec += *p++;
+            }
+            while (*p && (std::isdigit(static_cast<unsigned char>(*p)) || *p == '.' || *p == '*'))
+            {
+                if (*p == '*')
+                {
+                    next_arg(cursor, end, arg);
+                    spec += std::to_string(as_int(arg));
+                }
+                else
+                {
+                    spec += *p;
+                }
+                ++p;
+            }
+            while (*p && std::strchr("hljztLq", *p))
+            {
+                ++p;
+            }
+            if (!*p)
+            {
+                break;
+            }
+            const char conversion = *p;
+            if (conversion == 'n')
+            {
+                continue;
+            }
+            if (!next_arg(cursor, end, arg))
+            {
+                out += "<missing>";
+                continue;
+            }
+            if (arg.type == binlog::TEXT)
+            {
+                // A string renders as a string whatever the conversion
+                append_formatted(out, conversion == 's' ? (spec + "s").c_str() : "%s", std::string(arg.text).c_str());
+                continue;
+            }
+            switch (conversion)
+            {
+            case 'd':
+            case 'i':
+                append_formatted(out, (spec + "lld").c_str(), static_cast<long long>(as_int(arg)));
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                append_formatted(out, (spec + "ll" + conversion).c_str(), static_cast<unsigned long long>(as_int(arg)));
+                break;
+            case 'c':
+                append_formatted(out, (spec + "c").c_str(), static_cast<int>(as_int(arg)));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                append_formatted(out, (spec + conversion).c_str(), as_double(arg));
+                break;
+            case 'p':
+                append_formatted(out, (spec + "p").c_str(), reinterpret_cast<void*>(static_cast<uintptr_t>(arg.bits)));
+                break;
+            default:
+                // %s of a number, or an unknown conversion
+                if (arg.type == binlog::REAL)
+                {
+                    append_formatted(out, "%g", as_double(arg));
+                }
+                else if (arg.type == binlog::UNSIGNED_INT || arg.type == binlog::POINTER)
+                {
+                    append_formatted(out, "%llu", static_cast<unsigned long long>(arg.bits));
+                }
+                else
+                {
+                    append_formatted(out, "%lld", static_cast<long long>(as_int(arg)));
+                }
+                break;
+            }
+        }
+        return out;
+    }
+
+    bool read_binary_log(const std::string& path,
+                         const std::function<void(const binary_log_record&)>& fn,
+                         std::string* error)
+    {
+        auto fail = [error](const std::string& reason) {
+            if (error)
+            {
+                *error = reason;
+            }
+            return false;
+        };
+
+        FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in)
+        {
+            return fail("cannot open " + path);
+        }
+        std::vector<char> data;
+        char buffer[1 << 16];
+        std::size_t read = 0;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), in)) > 0)
+        {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        std::fclose(in);
+
+        file_header header;
+        if (!read_at(data, 0, header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return fail(path + " is not a ddbg binary log");
+        }
+        if (header.version != VERSION)
+        {
+            return fail(path + " has binary log version " + std::to_string(header.version));
+        }
+        std::size_t limit = data.size();
+        if (header.used != 0 && header.used < limit)
+        {
+            limit = static_cast<std::size_t>(header.used);
+        }
+
+        /**
+         * @brief Call site read back from a SITE_RECORD.
+         */
+        struct site_info
+        {
+            std::string file;
+            std::string func;
+            std::string format;
+            unsigned int line = 0;
+        };
+        std::vector<site_info> sites;
+        binary_log_record record;
+        std::size_t at = header.headerSize;
+        record_header rh;
+        while (read_at(data, at, rh) && at < limit)
+        {
+            if (rh.size == 0)
+            {
+                // A writer died inside this record; its reserved length still allows skipping it
+                const std::size_t reserved = align8(sizeof(record_header) + rh.payload);
+                if (rh.payload == 0 || at + reserved > limit)
+                {
+                    break;
+                }
+                at += reserved;
+                continue;
+            }
+            if (at + rh.size > limit || sizeof(record_header) + rh.payload > rh.size)
+            {
+                break;
+            }
+            const char* payload = data.data() + at + sizeof(record_header);
+            if (rh.kind == SITE_RECORD)
+            {
+                site_description description;
+                if (rh.payload >= sizeof(description))
+                {
+                    std::memcpy(&description, payload, sizeof(description));
+                    const std::size_t total = sizeof(description) + std::size_t{description.fileLength} +
+                                              description.funcLength + description.formatLength;
+                    if (total <= rh.payload)
+                    {
+                        if (sites.size() <= rh.site)
+                        {
+                            sites.resize(rh.site + 1);
+                        }
+                        const char* text = payload + sizeof(description);
+                        site_info& site = sites[rh.site];
+                        site.line = description.line;
+                        site.file.assign(text, description.fileLength);
+                        text += description.fileLength;
+                        site.func.assign(text, description.funcLength);
+                        text += description.funcLength;
+                        site.format.assign(text, description.formatLength);
+                    }
+                }
+            }
+            else if (rh.kind == EVENT_RECORD)
+            {
+                const site_info* site = rh.site < sites.size() ? &sites[rh.site] : nullptr;
+                record.text = site ? render_binary_format(site->format.c_str(), payload, rh.payload)
+                                   : "<unknown site " + std::to_string(rh.site) + ">";
+                record.steady = rh.when;
+                record.thread = rh.thread;
+                record.entry = log_entry{rh.level,
+                                         true,
+                                         header.systemStart + (rh.when - header.steadyStart),
+                                         site ? site->file.c_str() : nullptr,
+                                         site ? site->line : 0,
+                                         site ? site->func.c_str() : nullptr,
+                                         record.text};
+                fn(record);
+            }
+            at += rh.size;
+        }
+        return true;
+    }
+} // namespace ddbg
@@ -0,0 +1,259 @@
+/**
+ * @file binary_log.hpp
+ * @brief Binary log mode of ddbg: format-string ids and raw arguments in a memory-mapped file.
+ *
+ * A dbinfo/dberror/dbdebug statement does not format anything. The first time it runs against a
+ * file it writes a description of its call site (level, printf format, file, line, function) and
+ * gets a small id; from then on each call appends the id, a steady-clock timestamp, a thread number
+ * and the raw bytes of its arguments to a file mapped in memory. The ddbg-decode tool, or
+ * read_binary_log(), renders the file to text afterwards.
+ *
+ * The file has a fixed size. Records that do not fit are dropped and counted, and a record is only
+ * seen by the reader once fully written, so the file of a crashed process stays readable.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_BINARY_LOG__
+#define __CORE_MQTT_BINARY_LOG__
+#include "monitor.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ddbg
+{
+    /**
+     * @brief Configuration of the binary log file.
+     */
+    struct binary_log_options
+    {
+        std::string path;                         ///< File to create; an existing file is replaced.
+        std::size_t fileBytes = 64 * 1024 * 1024; ///< Bytes mapped; records past them are dropped.
+    };
+
+    /**
+     * @brief Snapshot of the binary log counters.
+     */
+    struct binary_log_stats
+    {
+        uint64_t written; ///< Records written, call site descriptions included.
+        uint64_t dropped; ///< Records dropped because the file was full.
+        uint64_t bytes;   ///< Bytes used in the current or last file.
+    };
+
+    /**
+     * @brief Static description of one binary log statement, defined by the DD_BINARY macro.
+     */
+    struct binary_log_site
+    {
+        const int level;                    ///< DD_LEVEL_* of the statement.
+        const char* const format;           ///< printf format, a string literal.
+        const char* const file;             ///< Source file.
+        const unsigned int line;            ///< Source line.
+        const char* const func;             ///< Source function.
+        std::atomic<uint32_t> id{0};        ///< Id of the site, assigned on first use.
+        std::atomic<uint64_t> described{0}; ///< Generation of the file that holds the site's description.
+
+        constexpr binary_log_site(int lvl, const char* fmt, const char* src, unsigned int ln, const char* fn)
+            : level(lvl), format(fmt), file(src), line(ln), func(fn)
+        {}
+    };
+
+    /**
+     * @brief One record read back from a binary log file; its pointers are valid during the callback only.
+     */
+    struct binary_log_record
+    {
+        log_entry entry;  ///< Mode, wall-clock time, location and rendered text, see append_log_entry().
+        int64_t steady;   ///< Steady-clock time of the call, in nanoseconds.
+        uint32_t thread;  ///< Number of the logging thread, in order of each thread's first record.
+        std::string text; ///< Rendered message, viewed by entry.message.
+    };
+
+    /**
+     * @brief Creates and maps the file and enables the DD_BINARY statements.
+     *
+     * @return false if binary logging already runs or the file cannot be created and mapped.
+     */
+    bool start_binary_logging(const binary_log_options& opts);
+
+    /**
+     * @brief Disables the DD_BINARY statements, waits for the records being written and truncates the file to
+     * its used size.
+     */
+    void stop_binary_logging();
+
+    /**
+     * @brief Checks whether binary logging runs.
+     */
+    bool binary_logging_enabled();
+
+    /**
+     * @brief Returns a snapshot of the binary log counters; written and dropped are kept across files.
+     */
+    binary_log_stats get_binary_log_stats();
+
+    /**
+     * @brief Calls @p fn for every complete record of the binary log at @p path, in file order.
+     *
+     * @return false, with @p error set when given, if the file cannot be read or is not a binary log.
+     */
+    bool read_binary_log(const std::string& path,
+                         const std::function<void(const binary_log_record&)>& fn,
+                         std::string* error = nullptr);
+
+    /**
+     * @brief Renders a printf @p format with the arguments encoded by write_binary_log().
+     *
+     * Conversions without an argument, or with an argument of another kind, still render something readable.
+     */
+    std::string render_binary_format(const char* format, const char* args, std::size_t bytes);
+
+    namespace binlog
+    {
+        /**
+         * @brief Kind of an encoded argument, stored in front of its bytes.
+         */
+        enum arg_type : uint8_t
+        {
+            SIGNED_INT = 1,   ///< Signed integer, bool, char or enum, as 8 bytes.
+            UNSIGNED_INT = 2, ///< Unsigned integer, as 8 bytes.
+            REAL = 3,         ///< Floating point, as 8 bytes.
+            TEXT = 4,         ///< 4-byte length then the characters.
+            POINTER = 5,      ///< Pointer value, as 8 bytes.
+        };
+
+        /**
+         * @brief Reserves a record of @p bytes argument bytes for @p site.
+         *
+         * @return Where the arguments go, or nullptr if binary logging is off or the file is full.
+         */
+        char* begin_record(binary_log_site& site, std::size_t bytes);
+
+        /**
+         * @brief Makes the record started by begin_record() visible to the reader.
+         */
+        void commit_record(char* args);
+
+        template <typename T>
+        constexpr bool is_text_v = std::is_convertible_v<const T&, std::string_view> ||
+                                   std::is_same_v<std::decay_t<T>, char*> ||
+                                   std::is_same_v<std::decay_t<T>, const char*>;
+
+        template <typename T>
+        inline std::string_view text_of(const T& value)
+        {
+            if constexpr (std::is_array_v<T>)
+            {
+                return std::string_view(value);
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                return value ? std::string_view(value) : std::string_view("(null)");
+            }
+            else
+            {
+                return std::string_view(value);
+            }
+        }
+
+        template <typename T>
+        inline std::size_t encoded_size(const T& value)
+        {
+            if constexpr (is_text_v<T>)
+            {
+                return 1 + sizeof(uint32_t) + text_of(value).size();
+            }
+            else
+            {
+                return 1 + sizeof(uint64_t);
+            }
+        }
+
+        inline char* put(char* out, arg_type type, const void* bytes, std::size_t count)
+        {
+            *out++ = static_cast<char>(type);
+            std::memcpy(out, bytes, count);
+            return out + count;
+        }
+
+        template <typename T>
+        inline char* encode(char* out, const T& value)
+        {
+            using type = std::decay_t<T>;
+            if constexpr (is_text_v<T>)
+            {
+                std::string_view text = text_of(value);
+                uint32_t length = static_cast<uint32_t>(text.size());
+                out = put(out, TEXT, &length, sizeof(length));
+                std::memcpy(out, text.data(), text.size());
+                return out + text.size();
+            }
+            else if constexpr (std::is_floating_point_v<type>)
+            {
+                double number = static_cast<double>(value);
+                return put(out, REAL, &number, sizeof(number));
+            }
+            else if constexpr (std::is_pointer_v<type>)
+            {
+                uint64_t address = reinterpret_cast<uintptr_t>(value);
+                return put(out, POINTER, &address, sizeof(address));
+            }
+            else if constexpr (std::is_integral_v<type> && std::is_unsigned_v<type> && !std::is_same_v<type, bool>)
+            {
+                uint64_t number = value;
+                return put(out, UNSIGNED_INT, &number, sizeof(number));
+            }
+            else
+            {
+                static_assert(std::is_integral_v<type> || std::is_enum_v<type>,
+                              "binary log arguments are numbers, pointers or strings");
+                int64_t number = static_cast<int64_t>(value);
+                return put(out, SIGNED_INT, &number, sizeof(number));
+            }
+        }
+    } // namespace binlog
+
+    /**
+     * @brief Appends one record of @p site with @p args to the binary log; use the DD_BINARY macros.
+     */
+    template <typename... Args>
+    void write_binary_log(binary_log_site& site, const Args&... args)
+    {
+        const std::size_t bytes = (std::size_t{0} + ... + binlog::encoded_size(args));
+        char* out = binlog::begin_record(site, bytes);
+        if (!out)
+        {
+            return;
+        }
+        char* cursor = out;
+        ((cursor = binlog::encode(cursor, args)), ...);
+        (void)cursor;
+        binlog::commit_record(out);
+    }
+
+} // namespace ddbg
+
+/// Binary log statement of @p level; @p fmt must be a string literal, its arguments numbers, pointers or strings.
+#define DD_BINARY(level, fmt, ...)                                                                                     \
+    DD_IF_ENABLED(level)                                                                                               \
+    if (!ddbg::binary_logging_enabled()) {}                                                                            \
+    else                                                                                                               \
+        do                                                                                                             \
+        {                                                                                                              \
+            static ddbg::binary_log_site ddSite_{level, "" fmt, __FILE__, __LINE__, __FUNCTION__};                    \
+            ddbg::write_binary_log(ddSite_, ##__VA_ARGS__);                                                            \
+        } while (0)
+
+/// Binary debug-level logging.
+#define dbdebug(fmt, ...) DD_BINARY(DD_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+/// Binary informational logging.
+#define dbinfo(fmt, ...) DD_BINARY(DD_LEVEL_INFO, fmt, ##__VA_ARGS__)
+/// Binary error logging.
+#define dberror(fmt, ...) DD_BINARY(DD_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif // __CORE_MQTT_BINARY_LOG__
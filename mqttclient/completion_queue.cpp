@@ -0,0 +1,95 @@
+#include "completion_queue.hpp"
+
+namespace mqttcpp
+{
+    static std::size_t round_up_pow2(std::size_t value)
+    {
+        std::size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    CompletionQueue::CompletionQueue(std::size_t capacity)
+        : mask_(round_up_pow2(capacity) - 1), cells_(new cell[mask_ + 1]), enqueuePos_(0), dequeuePos_(0), pushed_(0),
+          dropped_(0)
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool CompletionQueue::push(const completion_record& record)
+    {
+        cell* target = nullptr;
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            target = &cells_[pos & mask_];
+            std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        target->record = record;
+        target->sequence.store(pos + 1, std::memory_order_release);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool CompletionQueue::pop(completion_record& record)
+    {
+        cell* source = nullptr;
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            source = &cells_[pos & mask_];
+            std::size_t sequence = source->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        record = source->record;
+        source->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    completion_stats CompletionQueue::get_stats() const
+    {
+        std::size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+        std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+        return completion_stats{pushed_.load(std::memory_order_relaxed),
+                                dropped_.load(std::memory_order_relaxed),
+                                enqueued > dequeued ? enqueued - dequeued : 0};
+    }
+} // namespace mqttcpp
@@ -0,0 +1,107 @@
+/**
+ * @file completion_queue.hpp
+ * @brief Lightweight completion records for asynchronous client operations.
+ *
+ * A completion record is a small, trivially copyable summary of a finished operation.
+ * Records are passed through a bounded lock-free queue instead of cloning the paho token
+ * of every acknowledgement.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_COMPLETION_QUEUE__
+#define __CORE_MQTT_COMPLETION_QUEUE__
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "mqtt/token.h"
+
+namespace mqttcpp
+{
+    /**
+     * @brief How a client reports completed operations.
+     */
+    enum class CompletionMode
+    {
+        RECORDS,     ///< Push a completion_record to the completion handler or queue.
+        TOKEN_EVENTS ///< Clone the token and raise EVENT_ACTION_SUCCESS / EVENT_ACTION_FAILURE (legacy).
+    };
+
+    /**
+     * @brief Summary of a completed operation.
+     */
+    struct completion_record
+    {
+        mqtt::token::Type type; ///< Kind of operation (CONNECT, SUBSCRIBE, PUBLISH, ...).
+        int msgId;              ///< MQTT packet identifier, 0 if the operation has none.
+        void* cookie;           ///< User context registered with the operation.
+        int returnCode;         ///< paho return code, MQTTASYNC_SUCCESS on success.
+        int reasonCode;         ///< MQTT v5 reason code.
+        uint64_t latencyNanos;  ///< Time from send to acknowledgement, 0 when unknown.
+    };
+
+    /**
+     * @brief Snapshot of the completion queue counters.
+     */
+    struct completion_stats
+    {
+        uint64_t pushed;  ///< Records accepted by the queue.
+        uint64_t dropped; ///< Records dropped because the queue was full.
+        std::size_t size; ///< Records currently waiting to be polled.
+    };
+
+    /**
+     * @brief Bounded lock-free multi-producer multi-consumer queue of completion records.
+     *
+     * A sequence number per cell lets producers and consumers claim cells with a single
+     * compare-and-swap each (Vyukov's bounded queue). The queue never allocates after
+     * construction; a push to a full queue drops the record and counts it.
+     */
+    class CompletionQueue
+    {
+        /**
+         * @brief One slot of the ring.
+         */
+        struct cell
+        {
+            std::atomic<std::size_t> sequence; ///< Position this cell is ready for.
+            completion_record record;          ///< The stored record.
+        };
+
+        const std::size_t mask_;                          ///< Capacity - 1, capacity is a power of two.
+        std::unique_ptr<cell[]> cells_;                   ///< The ring.
+        alignas(64) std::atomic<std::size_t> enqueuePos_; ///< Next position to write.
+        alignas(64) std::atomic<std::size_t> dequeuePos_; ///< Next position to read.
+        alignas(64) std::atomic<uint64_t> pushed_;        ///< Records accepted.
+        std::atomic<uint64_t> dropped_;                   ///< Records dropped.
+
+    public:
+        /**
+         * @brief Creates a queue holding at least @p capacity records.
+         *
+         * @param capacity Requested capacity, rounded up to a power of two.
+         */
+        explicit CompletionQueue(std::size_t capacity = 1024);
+
+        /**
+         * @brief Appends @p record, or drops it if the queue is full.
+         *
+         * @return true if the record was queued.
+         */
+        bool push(const completion_record& record);
+
+        /**
+         * @brief Pops the oldest record.
+         *
+         * @param record Receives the record.
+         * @return true if a record was popped; false if the queue is empty.
+         */
+        bool pop(completion_record& record);
+
+        /**
+         * @brief Returns a snapshot of the queue counters.
+         */
+        completion_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_COMPLETION_QUEUE__
@@ -0,0 +1,128 @@
+#include "conflator.hpp"
+#include "topic_filter.hpp"
+#include "topic_simd.hpp"
+#include <algorithm>
+
+namespace mqttcpp
+{
+    Conflator::Conflator() : active_(false), deferred_(0), conflated_(0), flushed_(0)
+    {}
+
+    bool Conflator::add_filter(const std::string& filter)
+    {
+        if (!is_valid_topic_filter(filter))
+        {
+            return false;
+        }
+        lg lock(guard_);
+        if (std::find(filters_.begin(), filters_.end(), filter) == filters_.end())
+        {
+            filters_.push_back(filter);
+        }
+        active_.store(true);
+        return true;
+    }
+
+    void Conflator::remove_filter(const std::string& filter)
+    {
+        lg lock(guard_);
+        filters_.erase(std::remove(filters_.begin(), filters_.end(), filter), filters_.end());
+        active_.store(!filters_.empty() || !pending_.empty());
+    }
+
+    bool Conflator::matches(const std::string& topic) const
+    {
+        if (!active_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        lg lock(guard_);
+        // A topic with a pending value stays conflated until it is flushed
+        if (pending_.count(topic))
+        {
+            return true;
+        }
+        return std::any_of(filters_.begin(), filters_.end(), [&topic](const std::string& filter) {
+            return filter_matches(filter, topic);
+        });
+    }
+
+    bool Conflator::replace(queued_publish& pub, queued_publish& superseded)
+    {
+        lg lock(guard_);
+        auto it = pending_.find(pub.msg->get_topic());
+        if (it == pending_.end())
+        {
+            return false;
+        }
+        superseded = std::move(it->second);
+        it->second = std::move(pub);
+        ++conflated_;
+        return true;
+    }
+
+    bool Conflator::defer(queued_publish pub, queued_publish& superseded)
+    {
+        lg lock(guard_);
+        const std::string& topic = pub.msg->get_topic();
+        auto it = pending_.find(topic);
+        if (it != pending_.end())
+        {
+            superseded = std::move(it->second);
+            it->second = std::move(pub);
+            ++conflated_;
+            return true;
+        }
+        order_.push_back(topic);
+        pending_.emplace(topic, std::move(pub));
+        active_.store(true);
+        ++deferred_;
+        return false;
+    }
+
+    bool Conflator::take(queued_publish& pub)
+    {
+        if (!active_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        lg lock(guard_);
+        if (order_.empty())
+        {
+            return false;
+        }
+        auto it = pending_.find(order_.front());
+        order_.pop_front();
+        pub = std::move(it->second);
+        pending_.erase(it);
+        ++flushed_;
+        if (filters_.empty() && pending_.empty())
+        {
+            active_.store(false);
+        }
+        return true;
+    }
+
+    bool Conflator::restore(queued_publish pub, queued_publish& superseded)
+    {
+        lg lock(guard_);
+        --flushed_;
+        const std::string& topic = pub.msg->get_topic();
+        if (pending_.count(topic))
+        {
+            superseded = std::move(pub);
+            ++conflated_;
+            return true;
+        }
+        order_.push_front(topic);
+        pending_.emplace(topic, std::move(pub));
+        active_.store(true);
+        return false;
+    }
+
+    conflation_stats Conflator::get_stats() const
+    {
+        lg lock(guard_);
+        return conflation_stats{pending_.size(), deferred_, conflated_, flushed_};
+    }
+} // namespace mqttcpp
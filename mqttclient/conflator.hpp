@@ -0,0 +1,122 @@
+/**
+ * @file conflator.hpp
+ * @brief Last-value conflation of outgoing publishes.
+ *
+ * For topics matching a conflation filter, only the most recent unsent value is kept:
+ * a newer publish to the same topic replaces the pending one in place instead of
+ * queueing behind it.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_CONFLATOR__
+#define __CORE_MQTT_CONFLATOR__
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "publish_window.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Snapshot of the conflation counters.
+     */
+    struct conflation_stats
+    {
+        std::size_t pending; ///< Topics currently holding an unsent value.
+        uint64_t deferred;   ///< Publishes parked because they could not be sent immediately.
+        uint64_t conflated;  ///< Pending values replaced by a newer publish to the same topic.
+        uint64_t flushed;    ///< Pending values eventually submitted.
+    };
+
+    /**
+     * @brief Keeps the latest unsent publish per topic for conflated topic filters.
+     *
+     * Pending values are flushed in the order their topics were first deferred, so a
+     * frequently updated topic cannot starve the others.
+     */
+    class Conflator
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+        mutable std::mutex guard_;                                ///< Mutex guarding the conflation state.
+        std::atomic<bool> active_;                                ///< Whether any filter is registered.
+        std::vector<std::string> filters_;                        ///< Conflated topic filters.
+        std::unordered_map<std::string, queued_publish> pending_; ///< Latest unsent publish per topic.
+        std::deque<std::string> order_;                           ///< Flush order of the pending topics.
+        uint64_t deferred_;                                       ///< Publishes parked.
+        uint64_t conflated_;                                      ///< Pending values replaced.
+        uint64_t flushed_;                                        ///< Pending values submitted.
+
+    public:
+        Conflator();
+
+        /**
+         * @brief Enables conflation for topics matching @p filter.
+         *
+         * @param filter An MQTT topic filter, wildcards allowed.
+         * @return false if @p filter is not a well-formed topic filter, in which case nothing changes.
+         */
+        bool add_filter(const std::string& filter);
+
+        /**
+         * @brief Disables conflation for @p filter. Values already pending are still flushed.
+         *
+         * @param filter A filter previously passed to add_filter().
+         */
+        void remove_filter(const std::string& filter);
+
+        /**
+         * @brief Checks whether publishes to @p topic are conflated.
+         */
+        bool matches(const std::string& topic) const;
+
+        /**
+         * @brief Replaces the pending value of the publish's topic, if there is one.
+         *
+         * @param pub The newer publish. Moved from if it replaced a pending value.
+         * @param superseded Receives the publish that was replaced.
+         * @return true if a pending value was replaced; false if the topic has nothing pending.
+         */
+        bool replace(queued_publish& pub, queued_publish& superseded);
+
+        /**
+         * @brief Parks a publish until it can be sent.
+         *
+         * @param pub The publish to park.
+         * @param superseded Receives the publish that was replaced if the topic already had a pending value.
+         * @return true if a pending value was replaced.
+         */
+        bool defer(queued_publish pub, queued_publish& superseded);
+
+        /**
+         * @brief Pops the oldest pending publish.
+         *
+         * @param pub Receives the publish to submit.
+         * @return true if a publish was popped; false if nothing is pending.
+         */
+        bool take(queued_publish& pub);
+
+        /**
+         * @brief Puts back a publish that take() returned but that could not be submitted.
+         *
+         * The publish goes back to the front of the flush order, unless a newer value for the same
+         * topic was deferred in the meantime, in which case it is returned through @p superseded.
+         *
+         * @param pub The publish to put back.
+         * @param superseded Receives @p pub if it was dropped in favour of a newer value.
+         * @return true if @p pub was dropped.
+         */
+        bool restore(queued_publish pub, queued_publish& superseded);
+
+        /**
+         * @brief Returns a snapshot of the conflation counters.
+         */
+        conflation_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_CONFLATOR__
@@ -0,0 +1,117 @@
+#include "congestion_controller.hpp"
+#include <algorithm>
+
+namespace mqttcpp
+{
+    CongestionController::CongestionController()
+        : enabled_(false), receiveMaximum_(DefaultReceiveMaximum), window_(0), baseLatency_(0), smoothedLatency_(0),
+          increases_(0), decreases_(0)
+    {
+        reset_samples();
+    }
+
+    std::size_t CongestionController::ceiling() const
+    {
+        return std::max<std::size_t>(1, std::min(opts_.maxWindow, receiveMaximum_));
+    }
+
+    void CongestionController::reset_samples()
+    {
+        baseLatency_ = clock::duration::zero();
+        smoothedLatency_ = clock::duration::zero();
+        lastDecrease_ = clock::time_point();
+        const std::size_t top = ceiling();
+        window_ = static_cast<double>(std::clamp(opts_.initialWindow, std::min(opts_.minWindow, top), top));
+    }
+
+    void CongestionController::configure(const congestion_options& opts)
+    {
+        lg lock(guard_);
+        opts_ = opts;
+        // A window of 0 would lift the publish window limit instead of closing it
+        opts_.minWindow = std::max<std::size_t>(1, opts_.minWindow);
+        reset_samples();
+        increases_ = 0;
+        decreases_ = 0;
+        enabled_.store(opts_.enabled, std::memory_order_relaxed);
+    }
+
+    void CongestionController::set_receive_maximum(std::size_t receiveMaximum)
+    {
+        lg lock(guard_);
+        receiveMaximum_ = receiveMaximum > 0 ? receiveMaximum : DefaultReceiveMaximum;
+        reset_samples();
+    }
+
+    bool CongestionController::on_complete(uint64_t latencyNanos, bool success)
+    {
+        if (!enabled())
+        {
+            return false;
+        }
+        if (latencyNanos == 0)
+        {
+            // Send time unknown; count failures anyway
+            return success ? false : on_sample(clock::duration::zero(), false);
+        }
+        return on_sample(std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(latencyNanos)), success);
+    }
+
+    bool CongestionController::on_sample(clock::duration latency, bool success)
+    {
+        lg lock(guard_);
+        const auto before = static_cast<std::size_t>(window_);
+        const auto now = clock::now();
+
+        bool congested = !success;
+        if (success)
+        {
+            if (baseLatency_ == clock::duration::zero() || latency < baseLatency_)
+            {
+                baseLatency_ = latency;
+            }
+            smoothedLatency_ = smoothedLatency_ == clock::duration::zero()
+                                   ? latency
+                                   : smoothedLatency_ - smoothedLatency_ / 8 + latency / 8;
+            congested = static_cast<double>(smoothedLatency_.count()) >
+                        static_cast<double>(baseLatency_.count()) * (1.0 + opts_.latencyTolerance);
+        }
+
+        if (congested)
+        {
+            // Cut at most once per smoothed round trip so one burst of late acks counts once
+            if (now - lastDecrease_ >= smoothedLatency_)
+            {
+                window_ = std::max(static_cast<double>(std::min(opts_.minWindow, ceiling())),
+                                   window_ * opts_.decreaseFactor);
+                lastDecrease_ = now;
+                ++decreases_;
+            }
+        }
+        else
+        {
+            // One full window of acknowledgements grows the window by additiveIncrease
+            window_ = std::min(static_cast<double>(ceiling()), window_ + opts_.additiveIncrease / window_);
+            ++increases_;
+        }
+        return static_cast<std::size_t>(window_) != before;
+    }
+
+    std::size_t CongestionController::window() const
+    {
+        lg lock(guard_);
+        return static_cast<std::size_t>(window_);
+    }
+
+    congestion_stats CongestionController::get_stats() const
+    {
+        lg lock(guard_);
+        return congestion_stats{
+            static_cast<std::size_t>(window_),
+            ceiling(),
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(baseLatency_).count()),
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(smoothedLatency_).count()),
+            increases_,
+            decreases_};
+    }
+} // namespace mqttcpp
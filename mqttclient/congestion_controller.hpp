@@ -0,0 +1,134 @@
+/**
+ * @file congestion_controller.hpp
+ * @brief AIMD controller sizing the publish window from acknowledgement latency.
+ *
+ * The controller is fed the time between handing a QoS 1/2 message to the client
+ * and receiving its acknowledgement, as measured by the client's SendTimes. While the
+ * smoothed latency stays close to the lowest latency seen, the window grows additively;
+ * once it drifts above it, or a publish fails, the window shrinks multiplicatively. The
+ * window never exceeds the broker's MQTT v5 Receive Maximum.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_CONGESTION_CONTROLLER__
+#define __CORE_MQTT_CONGESTION_CONTROLLER__
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace mqttcpp
+{
+    /**
+     * @brief Configuration of the congestion controller.
+     */
+    struct congestion_options
+    {
+        bool enabled = false;          ///< Whether the controller drives the publish window.
+        std::size_t initialWindow = 8; ///< Window used right after enabling or reconnecting.
+        std::size_t minWindow = 1;     ///< Lower bound of the window, raised to 1 if 0.
+        std::size_t maxWindow = 65535; ///< Upper bound of the window, further capped by Receive Maximum.
+        double additiveIncrease = 1.0; ///< Window growth per round trip of acknowledgements.
+        double decreaseFactor = 0.5;   ///< Factor applied to the window on congestion.
+        double latencyTolerance = 1.0; ///< Congestion when smoothed latency exceeds base * (1 + tolerance).
+    };
+
+    /**
+     * @brief Snapshot of the congestion controller state.
+     */
+    struct congestion_stats
+    {
+        std::size_t window;         ///< Current in-flight limit.
+        std::size_t ceiling;        ///< Effective upper bound (maxWindow capped by Receive Maximum).
+        uint64_t baseLatencyUs;     ///< Lowest acknowledgement latency seen, in microseconds.
+        uint64_t smoothedLatencyUs; ///< Exponentially smoothed acknowledgement latency, in microseconds.
+        uint64_t increases;         ///< Number of acknowledgements that widened the window.
+        uint64_t decreases;         ///< Number of times the window was cut.
+    };
+
+    /**
+     * @brief Additive-increase / multiplicative-decrease controller for the publish window.
+     *
+     * Acknowledgement latencies are measured by the client's SendTimes table and handed in
+     * through on_complete(). Samples are processed under a mutex, but they arrive on the
+     * client's callback thread so the lock is uncontended in practice.
+     */
+    class CongestionController
+    {
+        using lg = std::lock_guard<std::mutex>;
+        using clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t DefaultReceiveMaximum = 65535; ///< MQTT 5 default when the broker sends none.
+
+        mutable std::mutex guard_;        ///< Mutex guarding the controller state.
+        std::atomic<bool> enabled_;       ///< Fast-path flag mirroring opts_.enabled.
+        congestion_options opts_;         ///< Current configuration.
+        std::size_t receiveMaximum_;      ///< Receive Maximum announced by the broker.
+        double window_;                   ///< Current window, fractional for additive growth.
+        clock::duration baseLatency_;     ///< Lowest latency seen since the last reset.
+        clock::duration smoothedLatency_; ///< Smoothed latency.
+        clock::time_point lastDecrease_;  ///< Time of the last window cut.
+        uint64_t increases_;              ///< Number of window increases.
+        uint64_t decreases_;              ///< Number of window cuts.
+
+        std::size_t ceiling() const;
+        void reset_samples();
+
+    public:
+        CongestionController();
+
+        /**
+         * @brief Replaces the configuration and restarts the window at `initialWindow`.
+         *
+         * @param opts The new configuration.
+         */
+        void configure(const congestion_options& opts);
+
+        /**
+         * @brief Checks whether the controller currently drives the publish window.
+         */
+        inline bool enabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Sets the Receive Maximum announced by the broker in CONNACK.
+         *
+         * Also restarts the latency baseline, since a new connection may take a different path.
+         *
+         * @param receiveMaximum The broker's Receive Maximum (65535 when not announced).
+         */
+        void set_receive_maximum(std::size_t receiveMaximum);
+
+        /**
+         * @brief Processes the completion of a QoS 1/2 publish.
+         *
+         * @param latencyNanos Time from send to acknowledgement, from the client's SendTimes; 0 if unknown.
+         * @param success Whether the publish was acknowledged.
+         * @return true if the window changed and should be applied.
+         */
+        bool on_complete(uint64_t latencyNanos, bool success);
+
+        /**
+         * @brief Feeds one latency sample into the controller.
+         *
+         * @param latency Time between sending a publish and its acknowledgement.
+         * @param success Whether the publish was acknowledged. A failure always counts as congestion.
+         * @return true if the integer window changed.
+         */
+        bool on_sample(clock::duration latency, bool success);
+
+        /**
+         * @brief Returns the current in-flight limit.
+         */
+        std::size_t window() const;
+
+        /**
+         * @brief Returns a snapshot of the controller state.
+         */
+        congestion_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_CONGESTION_CONTROLLER__
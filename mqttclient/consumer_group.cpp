@@ -0,0 +1,194 @@
+#include "consumer_group.hpp"
+#include "monitor.hpp"
+#include <algorithm>
+
+namespace mqttcpp
+{
+    ConsumerGroup::ConsumerGroup(const std::string& serverAddress,
+                                 const std::string& clientIdPrefix,
+                                 const std::string& group,
+                                 std::size_t size,
+                                 mqtt::connect_options connectOptions,
+                                 const inbound_queue_options& queueOptions)
+        : group_(group), queue_(std::make_shared<InboundQueue>(queueOptions)),
+          received_(new std::atomic<uint64_t>[std::max<std::size_t>(size, 1)]()), rejoins_(0),
+          members_(serverAddress, clientIdPrefix, size, std::move(connectOptions))
+    {
+        if (queue_->unspilled_shards() > 0)
+        {
+            derror1("[ConsumerGroup] Cannot open ")
+                << queue_->unspilled_shards() << " spill file(s) at '" << queueOptions.spillPath
+                << "', their shards drop overflow instead" << std::endl;
+        }
+        queue_->open();
+        for (std::size_t i = 0; i < members_.size(); ++i)
+        {
+            members_.client(i).set_event_handler(
+                [this, i](CallbackEvent event, CallbackVariant info) { on_member_event(i, event, info); });
+        }
+    }
+
+    ConsumerGroup::~ConsumerGroup()
+    {
+        // Consumers blocked in wait_next_message() return before the group goes away
+        close();
+    }
+
+    void ConsumerGroup::close()
+    {
+        queue_->close();
+    }
+
+    std::string ConsumerGroup::shared_filter(const std::string& group, const std::string& filter)
+    {
+        return "$share/" + group + "/" + filter;
+    }
+
+    void ConsumerGroup::set_message_handler(message_handler handler)
+    {
+        std::atomic_store(&messageHandler_,
+                          handler ? std::make_shared<const message_handler>(std::move(handler))
+                                  : std::shared_ptr<const message_handler>());
+    }
+
+    void ConsumerGroup::set_event_handler(event_handler handler)
+    {
+        std::atomic_store(&eventHandler_,
+                          handler ? std::make_shared<const event_handler>(std::move(handler))
+                                  : std::shared_ptr<const event_handler>());
+    }
+
+    void ConsumerGroup::on_member_event(std::size_t index, CallbackEvent event, CallbackVariant info)
+    {
+        if (event == CallbackEvent::EVENT_MESSAGE_ARRIVED)
+        {
+            mqtt::const_message_ptr msg = info.asMessage();
+            if (!msg)
+            {
+                return;
+            }
+            received_[index].fetch_add(1, std::memory_order_relaxed);
+            auto handler = std::atomic_load(&messageHandler_);
+            if (handler)
+            {
+                (*handler)(index, std::move(msg));
+            }
+            else
+            {
+                queue_->push(std::move(msg));
+            }
+            return;
+        }
+
+        if (event == CallbackEvent::EVENT_CONNECTED)
+        {
+            rejoin(index);
+        }
+        auto handler = std::atomic_load(&eventHandler_);
+        if (handler)
+        {
+            (*handler)(index, event, info);
+        }
+    }
+
+    void ConsumerGroup::rejoin(std::size_t index)
+    {
+        std::vector<subscription> subscriptions;
+        {
+            lg lock(guard_);
+            subscriptions = subscriptions_;
+        }
+        if (subscriptions.empty())
+        {
+            return;
+        }
+
+        dinfo1("[ConsumerGroup] Member %zu joining group '%s'\n", index, group_.c_str()).print();
+        // Runs on the member's callback thread: never wait for the acknowledgements here
+        for (const auto& sub : subscriptions)
+        {
+            mqtt::token_ptr token;
+            members_.client(index).subscribe(token, shared_filter(group_, sub.filter), sub.qos);
+        }
+        rejoins_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool ConsumerGroup::subscribe(const std::string& filter, unsigned int qos, bool wait, unsigned int wait_for)
+    {
+        {
+            lg lock(guard_);
+            auto it = std::find_if(subscriptions_.begin(), subscriptions_.end(), [&filter](const subscription& sub) {
+                return sub.filter == filter;
+            });
+            if (it != subscriptions_.end())
+            {
+                it->qos = qos;
+            }
+            else
+            {
+                subscriptions_.push_back(subscription{filter, qos});
+            }
+        }
+
+        const std::string shared = shared_filter(group_, filter);
+        bool ok = true;
+        for (std::size_t i = 0; i < members_.size(); ++i)
+        {
+            MqttClient& member = members_.client(i);
+            if (member.connected())
+            {
+                ok = member.subscribe(shared, qos, wait, wait_for) && ok;
+            }
+        }
+        return ok;
+    }
+
+    bool ConsumerGroup::unsubscribe(const std::string& filter, bool wait, unsigned int wait_for)
+    {
+        {
+            lg lock(guard_);
+            subscriptions_.erase(std::remove_if(subscriptions_.begin(),
+                                                subscriptions_.end(),
+                                                [&filter](const subscription& sub) { return sub.filter == filter; }),
+                                 subscriptions_.end());
+        }
+
+        const std::string shared = shared_filter(group_, filter);
+        bool ok = true;
+        for (std::size_t i = 0; i < members_.size(); ++i)
+        {
+            MqttClient& member = members_.client(i);
+            if (member.connected())
+            {
+                ok = member.unsubscribe(shared, wait, wait_for) && ok;
+            }
+        }
+        return ok;
+    }
+
+    bool ConsumerGroup::get_next_message(mqtt::const_message_ptr& msg)
+    {
+        return queue_->try_pop(msg);
+    }
+
+    bool ConsumerGroup::wait_next_message(mqtt::const_message_ptr& msg, unsigned int wait_for)
+    {
+        // A waiter woken by close() keeps its own reference in case the group is being destroyed
+        std::shared_ptr<InboundQueue> queue = queue_;
+        return queue->pop(msg, wait_for);
+    }
+
+    consumer_group_stats ConsumerGroup::get_stats() const
+    {
+        consumer_group_stats stats;
+        stats.received.reserve(members_.size());
+        for (std::size_t i = 0; i < members_.size(); ++i)
+        {
+            stats.received.push_back(received_[i].load(std::memory_order_relaxed));
+        }
+        stats.queue = queue_->get_stats();
+        stats.queued = stats.queue.size + stats.queue.onDisk;
+        stats.rejoins = rejoins_.load(std::memory_order_relaxed);
+        return stats;
+    }
+} // namespace mqttcpp
@@ -0,0 +1,251 @@
+/**
+ * @file consumer_group.hpp
+ * @brief Shared-subscription consumer groups spread over several connections.
+ *
+ * Every member of a group subscribes to `$share/<group>/<filter>`, so the broker hands
+ * each message to exactly one member. Members deliver on their own paho callback thread,
+ * which lets inbound processing scale past a single connection.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_CONSUMER_GROUP__
+#define __CORE_MQTT_CONSUMER_GROUP__
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "inbound_queue.hpp"
+#include "mqttclient_pool.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Snapshot of the consumer group counters.
+     */
+    struct consumer_group_stats
+    {
+        std::vector<uint64_t> received; ///< Messages received by each member.
+        std::size_t queued;             ///< Messages waiting in the merged queue.
+        inbound_queue_stats queue;      ///< Counters of the merged queue, drops included.
+        uint64_t rejoins;               ///< Times a member re-subscribed after (re)connecting.
+    };
+
+    /**
+     * @brief K connections consuming one set of shared subscriptions as a single stream.
+     *
+     * The group owns the event handlers of its members. Messages from all members are merged
+     * either into a message handler or, when none is set, into one queue read with
+     * get_next_message(). The queue is an InboundQueue, bounded and with the overflow policy
+     * given at construction. Whenever a member connects, including automatic reconnects, it
+     * re-joins every subscription of the group.
+     */
+    class ConsumerGroup
+    {
+        using lg = std::lock_guard<std::mutex>;
+        using message_handler = std::function<void(std::size_t, mqtt::const_message_ptr)>;
+        using event_handler = std::function<void(std::size_t, CallbackEvent, CallbackVariant)>;
+
+        /**
+         * @brief A subscription joined by every member.
+         */
+        struct subscription
+        {
+            std::string filter; ///< The topic filter, without the `$share/<group>/` prefix.
+            unsigned int qos;   ///< Requested QoS.
+        };
+
+        const std::string group_;                               ///< Share name used in `$share/<group>/`.
+        mutable std::mutex guard_;                              ///< Mutex guarding the subscription list.
+        std::vector<subscription> subscriptions_;               ///< Subscriptions re-joined after reconnect.
+        std::shared_ptr<const message_handler> messageHandler_; ///< Merged message handler, accessed atomically.
+        std::shared_ptr<const event_handler> eventHandler_;     ///< Forwarded member events, accessed atomically.
+        std::shared_ptr<InboundQueue> queue_;                   ///< Merged queue used when no handler is set.
+        std::unique_ptr<std::atomic<uint64_t>[]> received_;     ///< Messages received per member.
+        std::atomic<uint64_t> rejoins_;                         ///< Re-subscriptions after connect.
+        MqttClientPool members_;                                ///< The member connections, destroyed first.
+
+        /**
+         * @brief Handles an event raised by member @p index.
+         */
+        void on_member_event(std::size_t index, CallbackEvent event, CallbackVariant info);
+
+        /**
+         * @brief Subscribes member @p index to every subscription of the group, without waiting.
+         */
+        void rejoin(std::size_t index);
+
+    public:
+        /**
+         * @brief Creates a group of @p size members with client IDs `<clientIdPrefix>-<i>`.
+         *
+         * @param serverAddress The broker address shared by every member.
+         * @param clientIdPrefix Prefix of the member client IDs.
+         * @param group The share name of the group.
+         * @param size Number of member connections. Values below 1 are treated as 1.
+         * @param connectOptions Connection options applied to every member. The default keeps automatic
+         *        reconnect on, which the rejoin relies on.
+         * @param queueOptions Limits and overflow policy of the merged queue.
+         */
+        ConsumerGroup(const std::string& serverAddress,
+                      const std::string& clientIdPrefix,
+                      const std::string& group,
+                      std::size_t size,
+                      mqtt::connect_options connectOptions = MqttClient::default_connect_options(),
+                      const inbound_queue_options& queueOptions = inbound_queue_options());
+
+        /**
+         * @brief Closes the merged queue, then disconnects and destroys the members.
+         */
+        ~ConsumerGroup();
+
+        /**
+         * @brief Builds the shared subscription filter `$share/<group>/<filter>`.
+         */
+        static std::string shared_filter(const std::string& group, const std::string& filter);
+
+        /**
+         * @brief Returns the share name of the group.
+         */
+        inline const std::string& group() const
+        {
+            return group_;
+        }
+
+        /**
+         * @brief Returns the number of members.
+         */
+        inline std::size_t size() const
+        {
+            return members_.size();
+        }
+
+        /**
+         * @brief Returns member @p index. Its event handler belongs to the group and must not be replaced.
+         */
+        inline MqttClient& member(std::size_t index)
+        {
+            return members_.client(index);
+        }
+
+        /**
+         * @brief Sets the handler receiving the merged message stream.
+         *
+         * The handler runs on the callback thread of the member that received the message, so it
+         * may be invoked concurrently from several members. Passing an empty handler routes messages
+         * to the merged queue again.
+         *
+         * @param handler Called with the member index and the message.
+         */
+        void set_message_handler(message_handler handler);
+
+        /**
+         * @brief Sets a handler receiving every other member event, tagged with the member index.
+         *
+         * @param handler Called from the member's callback thread.
+         */
+        void set_event_handler(event_handler handler);
+
+        /**
+         * @brief Connects every member. Members join the group's subscriptions as soon as they connect.
+         *
+         * @param wait If true, blocks until every connection completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every member connected (or started connecting, when not waiting).
+         */
+        inline bool connect(bool wait = true, unsigned int wait_for = 0)
+        {
+            return members_.connect(wait, wait_for);
+        }
+
+        /**
+         * @brief Disconnects every member.
+         *
+         * @param wait If true, blocks until every disconnection completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every member disconnected (or started disconnecting, when not waiting).
+         */
+        inline bool disconnect(bool wait = true, unsigned int wait_for = 0)
+        {
+            return members_.disconnect(wait, wait_for);
+        }
+
+        /**
+         * @brief Checks whether every member is connected.
+         */
+        inline bool connected()
+        {
+            return members_.connected();
+        }
+
+        /**
+         * @brief Returns how many members are connected.
+         */
+        inline std::size_t connected_count()
+        {
+            return members_.connected_count();
+        }
+
+        /**
+         * @brief Joins `$share/<group>/<filter>` on every connected member and remembers it for reconnects.
+         *
+         * @param filter The topic filter to consume.
+         * @param qos The Quality of Service level for the subscription (0, 1, or 2).
+         * @param wait If true, blocks until every member acknowledged or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait per member. A value of 0 indicates infinite timeout.
+         * @return true if every connected member subscribed without error.
+         */
+        bool subscribe(const std::string& filter, unsigned int qos = 1, bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Leaves `$share/<group>/<filter>` on every connected member.
+         *
+         * @param filter A filter previously passed to subscribe().
+         * @param wait If true, blocks until every member acknowledged or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait per member. A value of 0 indicates infinite timeout.
+         * @return true if every connected member unsubscribed without error.
+         */
+        bool unsubscribe(const std::string& filter, bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Stops queueing messages, discards the merged queue and wakes every waiting consumer.
+         *
+         * Afterwards wait_next_message() and get_next_message() return false at once. A message handler
+         * still receives messages.
+         */
+        void close();
+
+        /**
+         * @brief Checks whether the merged queue is still open.
+         */
+        inline bool is_open() const
+        {
+            return queue_->is_open();
+        }
+
+        /**
+         * @brief Pops the next message of the merged queue. Never blocks.
+         *
+         * @param msg Receives the message.
+         * @return true if a message was popped; false if the queue is empty.
+         */
+        bool get_next_message(mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Waits for the next message of the merged queue and pops it.
+         *
+         * @param msg Receives the message.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if a message was popped; false on timeout or once the group is closed.
+         */
+        bool wait_next_message(mqtt::const_message_ptr& msg, unsigned int wait_for = 0);
+
+        /**
+         * @brief Returns a snapshot of the group counters.
+         */
+        consumer_group_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_CONSUMER_GROUP__
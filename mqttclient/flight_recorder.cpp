@@ -0,0 +1,439 @@
+#include "flight_recorder.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace mqttcpp
+{
+    namespace
+    {
+        constexpr std::size_t MAX_RECORDERS = 64; ///< Recorders the fatal-signal dump can see at once.
+
+        std::atomic<FlightRecorder*> liveRecorders[MAX_RECORDERS]; ///< Registry read by dump_all().
+        std::atomic<std::size_t> unlistedRecorders{0};             ///< Live recorders that found the registry full.
+
+        const int FATAL_SIGNALS[] = {SIGSEGV, SIGILL, SIGFPE, SIGABRT
+#if defined(SIGBUS)
+                                     ,
+                                     SIGBUS
+#endif
+        };
+        constexpr std::size_t FATAL_COUNT = sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0]);
+
+#if defined(_WIN32)
+        using signal_handler = void (*)(int);
+        signal_handler previousHandlers[FATAL_COUNT]; ///< Handlers replaced by install_fatal_signal_dump().
+#else
+        struct sigaction previousActions[FATAL_COUNT]; ///< Actions replaced by install_fatal_signal_dump().
+#endif
+        std::atomic<bool> dumpInstalled{false};
+        std::atomic<bool> dumping{false};             ///< Set by the first fatal signal, so dumps do not nest.
+
+        int64_t steady_nanos()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void write_all(int fd, const char* data, std::size_t size)
+        {
+            while (size > 0)
+            {
+#if defined(_WIN32)
+                int written = _write(fd, data, static_cast<unsigned int>(size));
+#else
+                ssize_t written = ::write(fd, data, size);
+#endif
+                if (written <= 0)
+                {
+                    return;
+                }
+                data += written;
+                size -= static_cast<std::size_t>(written);
+            }
+        }
+
+        /**
+         * @brief Fixed buffer filled without allocating, for use in signal handlers.
+         */
+        struct line_buffer
+        {
+            char text[256];
+            std::size_t size = 0;
+
+            void put(const char* value)
+            {
+                while (value && *value && size < sizeof(text))
+                {
+                    text[size++] = *value++;
+                }
+            }
+
+            void put(char value)
+            {
+                if (size < sizeof(text))
+                {
+                    text[size++] = value;
+                }
+            }
+
+            void put_unsigned(uint64_t value, int base = 10, int width = 0)
+            {
+                char digits[24];
+                int count = 0;
+                do
+                {
+                    digits[count++] = "0123456789abcdef"[value % static_cast<uint64_t>(base)];
+                    value /= static_cast<uint64_t>(base);
+                } while (value != 0 && count < 24);
+                for (int pad = count; pad < width; ++pad)
+                {
+                    put('0');
+                }
+                while (count > 0)
+                {
+                    put(digits[--count]);
+                }
+            }
+
+            void put_signed(int64_t value)
+            {
+                if (value < 0)
+                {
+                    put('-');
+                    put_unsigned(static_cast<uint64_t>(-(value + 1)) + 1);
+                }
+                else
+                {
+                    put_unsigned(static_cast<uint64_t>(value));
+                }
+            }
+        };
+
+        void dump_on_first_signal(int signum)
+        {
+            bool expected = false;
+            if (dumping.compare_exchange_strong(expected, true))
+            {
+                line_buffer header;
+                header.put("\n*** fatal signal ");
+                header.put_signed(signum);
+                header.put(", dumping MQTT client flight recorders ***\n");
+                write_all(2, header.text, header.size);
+                FlightRecorder::dump_all(2);
+            }
+        }
+
+        std::size_t fatal_index(int signum)
+        {
+            std::size_t i = 0;
+            while (i < FATAL_COUNT && FATAL_SIGNALS[i] != signum)
+            {
+                ++i;
+            }
+            return i;
+        }
+
+#if defined(_WIN32)
+        void on_fatal_signal(int signum)
+        {
+            dump_on_first_signal(signum);
+            const std::size_t i = fatal_index(signum);
+            if (i == FATAL_COUNT)
+            {
+                return;
+            }
+            signal_handler previous = previousHandlers[i];
+            if (previous == SIG_IGN)
+            {
+                return;
+            }
+            if (previous == SIG_DFL || previous == SIG_ERR || previous == nullptr)
+            {
+                std::signal(signum, SIG_DFL);
+                std::raise(signum);
+                return;
+            }
+            previous(signum);
+        }
+#else
+        void on_fatal_signal(int signum, siginfo_t* info, void* context)
+        {
+            dump_on_first_signal(signum);
+            const std::size_t i = fatal_index(signum);
+            if (i == FATAL_COUNT)
+            {
+                return;
+            }
+            const struct sigaction& previous = previousActions[i];
+            const bool withInfo = (previous.sa_flags & SA_SIGINFO) != 0;
+            if (!withInfo && previous.sa_handler == SIG_IGN)
+            {
+                return;
+            }
+            if (!withInfo && previous.sa_handler == SIG_DFL)
+            {
+                // Default action: put it back and re-raise; the signal is delivered once this handler returns
+                ::sigaction(signum, &previous, nullptr);
+                ::raise(signum);
+                return;
+            }
+            if ((previous.sa_flags & static_cast<int>(SA_RESETHAND)) != 0)
+            {
+                struct sigaction reset{};
+                reset.sa_handler = SIG_DFL;
+                ::sigaction(signum, &reset, nullptr);
+            }
+            // Run the previous handler under the mask it was installed with
+            sigset_t mask;
+            ::pthread_sigmask(SIG_BLOCK, &previous.sa_mask, &mask);
+            if (withInfo)
+            {
+                previous.sa_sigaction(signum, info, context);
+            }
+            else
+            {
+                previous.sa_handler(signum);
+            }
+            ::pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+        }
+#endif
+    } // namespace
+
+    FlightRecorder::FlightRecorder(std::size_t events)
+        : mask_([events] {
+              std::size_t capacity = 1;
+              while (capacity < events)
+              {
+                  capacity <<= 1;
+              }
+              return capacity - 1;
+          }()),
+          slots_(new slot[mask_ + 1]), steadyBase_(steady_nanos()),
+          systemBase_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count())
+    {
+        name_[0] = '\0';
+        for (auto& entry : liveRecorders)
+        {
+            FlightRecorder* empty = nullptr;
+            if (entry.compare_exchange_strong(empty, this))
+            {
+                listed_ = true;
+                break;
+            }
+        }
+        if (!listed_)
+        {
+            unlistedRecorders.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    FlightRecorder::~FlightRecorder()
+    {
+        if (!listed_)
+        {
+            unlistedRecorders.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        for (auto& entry : liveRecorders)
+        {
+            FlightRecorder* self = this;
+            if (entry.compare_exchange_strong(self, nullptr))
+            {
+                break;
+            }
+        }
+    }
+
+    void FlightRecorder::set_name(const std::string& name)
+    {
+        std::size_t size = name.size() < sizeof(name_) - 1 ? name.size() : sizeof(name_) - 1;
+        std::memcpy(name_, name.data(), size);
+        name_[size] = '\0';
+    }
+
+    void FlightRecorder::record(const char* what, uint64_t topicHash, int messageId, int result, int reason)
+    {
+        const uint64_t seq = next_.fetch_add(1, std::memory_order_relaxed);
+        slot& entry = slots_[seq & mask_];
+        // Claim the slot only from an older, complete event: a writer lapped by a full ring must neither tear the
+        // slot of a newer writer nor put its older event back over a newer one
+        uint64_t version = entry.version.load(std::memory_order_relaxed);
+        do
+        {
+            if ((version & 1) != 0 || version >= 2 * seq + 2)
+            {
+                lost_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        } while (!entry.version.compare_exchange_weak(version, 2 * seq + 1, std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.when.store(steady_nanos(), std::memory_order_relaxed);
+        entry.what.store(what, std::memory_order_relaxed);
+        entry.topicHash.store(topicHash, std::memory_order_relaxed);
+        entry.messageId.store(messageId, std::memory_order_relaxed);
+        entry.result.store(result, std::memory_order_relaxed);
+        entry.reason.store(reason, std::memory_order_relaxed);
+        entry.version.store(2 * seq + 2, std::memory_order_release);
+    }
+
+    uint64_t FlightRecorder::topic_hash(const std::string& topic)
+    {
+        return static_cast<uint64_t>(std::hash<std::string>()(topic));
+    }
+
+    bool FlightRecorder::read(uint64_t seq, flight_event& event) const
+    {
+        const slot& entry = slots_[seq & mask_];
+        const uint64_t before = entry.version.load(std::memory_order_acquire);
+        if (before != 2 * seq + 2)
+        {
+            return false;
+        }
+        event.seq = seq;
+        event.when = entry.when.load(std::memory_order_relaxed);
+        event.what = entry.what.load(std::memory_order_relaxed);
+        event.topicHash = entry.topicHash.load(std::memory_order_relaxed);
+        event.messageId = entry.messageId.load(std::memory_order_relaxed);
+        event.result = entry.result.load(std::memory_order_relaxed);
+        event.reason = entry.reason.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.version.load(std::memory_order_relaxed) != before)
+        {
+            return false;
+        }
+        event.wallTime = systemBase_ + (event.when - steadyBase_);
+        return true;
+    }
+
+    std::vector<flight_event> FlightRecorder::snapshot() const
+    {
+        const uint64_t end = next_.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity() ? end - capacity() : 0;
+        std::vector<flight_event> events;
+        events.reserve(static_cast<std::size_t>(end - begin));
+        flight_event event{};
+        for (uint64_t seq = begin; seq < end; ++seq)
+        {
+            if (read(seq, event))
+            {
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+
+    void FlightRecorder::dump(int fd) const
+    {
+        const uint64_t end = next_.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity() ? end - capacity() : 0;
+        line_buffer header;
+        header.put("flight recorder '");
+        header.put(name_);
+        header.put("': events ");
+        header.put_unsigned(begin);
+        header.put(" to ");
+        header.put_unsigned(end);
+        header.put('\n');
+        write_all(fd, header.text, header.size);
+
+        flight_event event{};
+        for (uint64_t seq = begin; seq < end; ++seq)
+        {
+            if (!read(seq, event))
+            {
+                continue;
+            }
+            // #seq seconds.micros what topic=hash id=... rc=... reason=...
+            line_buffer line;
+            line.put('#');
+            line.put_unsigned(event.seq);
+            line.put(' ');
+            line.put_signed(event.wallTime / 1000000000);
+            line.put('.');
+            line.put_unsigned(static_cast<uint64_t>(event.wallTime % 1000000000) / 1000, 10, 6);
+            line.put(' ');
+            line.put(event.what ? event.what : "?");
+            if (event.topicHash != 0)
+            {
+                line.put(" topic=");
+                line.put_unsigned(event.topicHash, 16, 16);
+            }
+            if (event.messageId != 0)
+            {
+                line.put(" id=");
+                line.put_signed(event.messageId);
+            }
+            line.put(" rc=");
+            line.put_signed(event.result);
+            if (event.reason != 0)
+            {
+                line.put(" reason=");
+                line.put_signed(event.reason);
+            }
+            line.put('\n');
+            write_all(fd, line.text, line.size);
+        }
+    }
+
+    void FlightRecorder::dump_all(int fd)
+    {
+        for (auto& entry : liveRecorders)
+        {
+            FlightRecorder* recorder = entry.load(std::memory_order_acquire);
+            if (recorder)
+            {
+                recorder->dump(fd);
+            }
+        }
+        const std::size_t unlisted = unlisted_recorders();
+        if (unlisted > 0)
+        {
+            line_buffer line;
+            line.put_unsigned(unlisted);
+            line.put(" more flight recorders not dumped: more than ");
+            line.put_unsigned(MAX_RECORDERS);
+            line.put(" live at once\n");
+            write_all(fd, line.text, line.size);
+        }
+    }
+
+    std::size_t FlightRecorder::unlisted_recorders()
+    {
+        return unlistedRecorders.load(std::memory_order_relaxed);
+    }
+
+    void FlightRecorder::install_fatal_signal_dump()
+    {
+        if (dumpInstalled.exchange(true))
+        {
+            return;
+        }
+#if defined(_WIN32)
+        for (std::size_t i = 0; i < FATAL_COUNT; ++i)
+        {
+            previousHandlers[i] = std::signal(FATAL_SIGNALS[i], on_fatal_signal);
+        }
+#else
+        struct sigaction action{};
+        action.sa_sigaction = on_fatal_signal;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (std::size_t i = 0; i < FATAL_COUNT; ++i)
+        {
+            ::sigaction(FATAL_SIGNALS[i], &action, &previousActions[i]);
+        }
+#endif
+    }
+} // namespace mqttcpp
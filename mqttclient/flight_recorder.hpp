@@ -0,0 +1,165 @@
+/**
+ * @file flight_recorder.hpp
+ * @brief Fixed-size, lock-free trace of the recent events of a client.
+ *
+ * The recorder keeps the last N events in a ring of slots. Recording takes a ticket with one
+ * fetch_add and fills the slot under a per-slot sequence number, so writers never block each other
+ * and a reader skips the slots being rewritten. dump() formats without allocating or locking and
+ * writes with write(2), which makes it usable from a fatal-signal handler
+ * (install_fatal_signal_dump()).
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_FLIGHT_RECORDER__
+#define __CORE_MQTT_FLIGHT_RECORDER__
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mqttcpp
+{
+    /**
+     * @brief One event read back from a FlightRecorder.
+     */
+    struct flight_event
+    {
+        uint64_t seq;       ///< Order of the event since the recorder was created.
+        int64_t when;       ///< Steady-clock time, in nanoseconds.
+        int64_t wallTime;   ///< System-clock time, in nanoseconds since the epoch, derived from when.
+        const char* what;   ///< Static label of the operation, callback event or completion.
+        uint64_t topicHash; ///< std::hash of the topic, 0 without a topic.
+        int messageId;      ///< MQTT message id, 0 without one.
+        int result;         ///< paho return code, 0 on success.
+        int reason;         ///< MQTT v5 reason code.
+    };
+
+    /**
+     * @brief Lock-free ring of the last events of a client.
+     */
+    class FlightRecorder
+    {
+    public:
+        static constexpr std::size_t DEFAULT_EVENTS = 1024; ///< Events kept by MqttClient's recorder.
+
+        /**
+         * @brief Creates a recorder keeping the last @p events events, rounded up to a power of two.
+         */
+        explicit FlightRecorder(std::size_t events = DEFAULT_EVENTS);
+
+        /**
+         * @brief Unregisters the recorder from the fatal-signal dump.
+         */
+        ~FlightRecorder();
+
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        /**
+         * @brief Sets the name printed in front of the dump, truncated to 63 characters.
+         */
+        void set_name(const std::string& name);
+
+        /**
+         * @brief Records an event.
+         *
+         * @param what Static label, such as a string literal; only the pointer is kept.
+         * @param topicHash std::hash of the topic, or 0.
+         * @param messageId MQTT message id, or 0.
+         * @param result paho return code, 0 on success.
+         * @param reason MQTT v5 reason code.
+         */
+        void record(const char* what, uint64_t topicHash = 0, int messageId = 0, int result = 0, int reason = 0);
+
+        /**
+         * @brief Hashes a topic the way the recorded events do.
+         */
+        static uint64_t topic_hash(const std::string& topic);
+
+        /**
+         * @brief Returns the recorded events still in the ring, oldest first.
+         */
+        std::vector<flight_event> snapshot() const;
+
+        /**
+         * @brief Writes the recorded events to @p fd, oldest first, one line each.
+         *
+         * Async-signal-safe: no allocation, no lock, only write(2).
+         */
+        void dump(int fd) const;
+
+        /**
+         * @brief Returns the number of events dropped because a writer lapped by the whole ring found its slot taken
+         * by a newer event.
+         */
+        inline uint64_t lost() const
+        {
+            return lost_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Returns the number of slots of the ring.
+         */
+        inline std::size_t capacity() const
+        {
+            return mask_ + 1;
+        }
+
+        /**
+         * @brief Dumps every live recorder to stderr on SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT, then runs the
+         * previous handler of the signal.
+         *
+         * Installed with sigaction(SA_SIGINFO | SA_ONSTACK), so the dump runs on the alternate signal stack when the
+         * thread has one; the previous action is chained with its own flags and mask. Idempotent; the handlers stay
+         * installed for the life of the process.
+         */
+        static void install_fatal_signal_dump();
+
+        /**
+         * @brief Dumps every live recorder to @p fd. Async-signal-safe.
+         *
+         * Only the first 64 recorders alive at once are registered; the others are counted by unlisted_recorders()
+         * and reported in one line at the end of the dump.
+         */
+        static void dump_all(int fd);
+
+        /**
+         * @brief Returns the number of live recorders left out of dump_all() because the registry was full.
+         */
+        static std::size_t unlisted_recorders();
+
+    private:
+        /**
+         * @brief One event, guarded by its sequence number: odd while written, 2 * seq + 2 once complete.
+         *
+         * A writer claims the slot with a compare-and-swap from an older, even version.
+         */
+        struct slot
+        {
+            std::atomic<uint64_t> version{0};
+            std::atomic<int64_t> when{0};
+            std::atomic<const char*> what{nullptr};
+            std::atomic<uint64_t> topicHash{0};
+            std::atomic<int> messageId{0};
+            std::atomic<int> result{0};
+            std::atomic<int> reason{0};
+        };
+
+        /**
+         * @brief Reads the slot of @p seq if it still holds that event.
+         */
+        bool read(uint64_t seq, flight_event& event) const;
+
+        const std::size_t mask_;                    ///< Capacity - 1.
+        std::unique_ptr<slot[]> slots_;             ///< The ring.
+        alignas(64) std::atomic<uint64_t> next_{0}; ///< Ticket of the next event.
+        std::atomic<uint64_t> lost_{0};             ///< Events dropped by lapped writers.
+        int64_t steadyBase_;                        ///< Steady clock at creation, paired with systemBase_.
+        int64_t systemBase_;                        ///< System clock at creation, in nanoseconds since the epoch.
+        char name_[64];                             ///< Name printed by dump(), always terminated.
+        bool listed_ = false;                       ///< Registered for dump_all().
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_FLIGHT_RECORDER__
@@ -0,0 +1,154 @@
+#include "handler_executor.hpp"
+#include "monitor.hpp"
+#include "topic_simd.hpp"
+#include <string_view>
+
+namespace mqttcpp
+{
+    HandlerExecutor::worker::worker(std::size_t capacity)
+        : queue(capacity), sleeping(false), waitingForRoom(false), executed(0)
+    {}
+
+    HandlerExecutor::HandlerExecutor(const handler_executor_options& opts, task fn)
+        : opts_(opts), task_(std::move(fn)), running_(true), submitted_(0), dropped_(0), blocked_(0)
+    {
+        const std::size_t count = opts_.workers > 0 ? opts_.workers : 1;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            workers_.push_back(std::make_unique<worker>(opts_.capacity));
+        }
+        for (auto& w : workers_)
+        {
+            w->thread = std::thread(&HandlerExecutor::run, this, std::ref(*w));
+        }
+    }
+
+    HandlerExecutor::~HandlerExecutor()
+    {
+        running_.store(false);
+        for (auto& w : workers_)
+        {
+            {
+                lg lock(w->guard);
+            }
+            w->ready.notify_all();
+        }
+        for (auto& w : workers_)
+        {
+            w->thread.join();
+        }
+    }
+
+    std::size_t HandlerExecutor::key_of(const mqtt::const_message_ptr& msg) const
+    {
+        if (opts_.keyHash)
+        {
+            return opts_.keyHash(msg);
+        }
+        const std::string& topic = msg->get_topic();
+        if (opts_.keyLevel >= 0)
+        {
+            thread_local std::vector<std::string_view> levels;
+            levels.resize(static_cast<std::size_t>(opts_.keyLevel) + 1);
+            if (split_topic(topic, levels.data(), levels.size()) >= levels.size())
+            {
+                return std::hash<std::string_view>()(levels.back());
+            }
+        }
+        return std::hash<std::string>()(topic);
+    }
+
+    bool HandlerExecutor::submit(const mqtt::const_message_ptr& msg)
+    {
+        worker& target = *workers_[worker_of(msg)];
+        if (!target.queue.push(msg))
+        {
+            if (opts_.dropWhenFull)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            blocked_.fetch_add(1, std::memory_order_relaxed);
+            target.waitingForRoom.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(target.guard);
+                target.room.wait(lock, [&] { return target.queue.push(msg); });
+            }
+            target.waitingForRoom.store(false, std::memory_order_relaxed);
+        }
+        submitted_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in run(): either the worker sees the message or we see the worker asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (target.sleeping.load(std::memory_order_relaxed))
+        {
+            {
+                lg lock(target.guard);
+            }
+            target.ready.notify_one();
+        }
+        return true;
+    }
+
+    void HandlerExecutor::run(worker& self)
+    {
+        mqtt::const_message_ptr msg;
+        while (true)
+        {
+            if (self.queue.try_pop(msg))
+            {
+                // Pairs with the fence in submit(): either the submitter sees the room or we see it waiting
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (self.waitingForRoom.load(std::memory_order_relaxed))
+                {
+                    {
+                        lg lock(self.guard);
+                    }
+                    self.room.notify_one();
+                }
+                try
+                {
+                    task_(msg);
+                }
+                catch (const std::exception& exc)
+                {
+                    derror1("[HandlerExecutor] Message handler failed: %s\n", exc.what()).print();
+                }
+                catch (...)
+                {
+                    derror1("[HandlerExecutor] Message handler failed with an unknown exception\n").print();
+                }
+                msg.reset();
+                self.executed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // Submits have finished once the destructor runs, so an empty ring means drained
+            if (!running_.load())
+            {
+                return;
+            }
+            self.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(self.guard);
+                self.ready.wait(lock, [&] { return self.queue.size() > 0 || !running_.load(); });
+            }
+            self.sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    handler_executor_stats HandlerExecutor::get_stats() const
+    {
+        handler_executor_stats stats{};
+        stats.submitted = submitted_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.blocked = blocked_.load(std::memory_order_relaxed);
+        stats.workers = workers_.size();
+        for (const auto& w : workers_)
+        {
+            stats.executed += w->executed.load(std::memory_order_relaxed);
+            stats.queued += w->queue.size();
+        }
+        return stats;
+    }
+} // namespace mqttcpp
@@ -0,0 +1,149 @@
+/**
+ * @file handler_executor.hpp
+ * @brief Worker threads running message handlers off the paho callback thread.
+ *
+ * Every arrived message is routed to one worker by the hash of a key taken from its topic,
+ * the whole topic by default. Messages with the same key run one after another on the same
+ * worker, in arrival order, while different keys run in parallel. A slow handler then only
+ * delays the keys of its own worker instead of every callback of the client.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_HANDLER_EXECUTOR__
+#define __CORE_MQTT_HANDLER_EXECUTOR__
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "inbound_queue.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Configuration of the handler workers.
+     */
+    struct handler_executor_options
+    {
+        std::size_t workers = 0;     ///< Worker threads; 0 runs handlers on the callback thread.
+        std::size_t capacity = 4096; ///< Messages waiting per worker.
+        int keyLevel = -1;           ///< Topic level used as the ordering key, -1 for the whole topic. Topics
+                                     ///< with fewer levels use the whole topic.
+        bool dropWhenFull = false;   ///< Drop a message whose worker is full instead of waiting for room.
+        std::function<std::size_t(const mqtt::const_message_ptr&)> keyHash = {}; ///< Custom key hash, used
+                                                                                  ///< instead of keyLevel if set.
+    };
+
+    /**
+     * @brief Snapshot of the handler worker counters.
+     */
+    struct handler_executor_stats
+    {
+        uint64_t submitted;  ///< Messages queued to a worker.
+        uint64_t executed;   ///< Messages whose handlers returned.
+        uint64_t dropped;    ///< Messages dropped because their worker was full (dropWhenFull).
+        uint64_t blocked;    ///< Submits that waited for room in a full worker.
+        std::size_t queued;  ///< Messages currently waiting over all workers.
+        std::size_t workers; ///< Number of worker threads.
+    };
+
+    /**
+     * @brief Fixed pool of worker threads, each consuming its own MessageQueue.
+     *
+     * submit() is meant to be called from a single thread, the client's callback thread; the order
+     * of messages with the same key is the order of the submit() calls. A full worker blocks the
+     * submitting thread by default, which pushes back on the broker through the callback thread
+     * rather than losing messages. Exceptions thrown by the task are logged and swallowed so that a
+     * worker never dies.
+     */
+    class HandlerExecutor
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+    public:
+        using task = std::function<void(const mqtt::const_message_ptr&)>;
+
+    private:
+        /**
+         * @brief One worker thread and its ring.
+         */
+        struct worker
+        {
+            MessageQueue queue;                         ///< Messages waiting for this worker.
+            std::mutex guard;                           ///< Mutex protecting the sleeps, never the queue.
+            std::condition_variable ready;              ///< Signalled when the ring gets a message or on stop.
+            std::condition_variable room;               ///< Signalled when a full ring gets room.
+            std::atomic<bool> sleeping;                 ///< Whether the worker is parked on ready.
+            std::atomic<bool> waitingForRoom;           ///< Whether the submitter is parked on room.
+            alignas(64) std::atomic<uint64_t> executed; ///< Messages handled by this worker.
+            std::thread thread;                         ///< The worker thread.
+
+            explicit worker(std::size_t capacity);
+        };
+
+        const handler_executor_options opts_;          ///< Worker count, capacity and key.
+        const task task_;                              ///< Run for every message.
+        std::vector<std::unique_ptr<worker>> workers_; ///< The workers, fixed at construction.
+        std::atomic<bool> running_;                    ///< Cleared by the destructor to stop the workers.
+        std::atomic<uint64_t> submitted_;              ///< Messages queued.
+        std::atomic<uint64_t> dropped_;                ///< Messages dropped on a full worker.
+        std::atomic<uint64_t> blocked_;                ///< Submits that waited for room.
+
+        /**
+         * @brief Body of a worker: pops and runs messages until stopped and drained.
+         */
+        void run(worker& self);
+
+    public:
+        /**
+         * @brief Starts opts.workers threads, at least one, running @p fn for each submitted message.
+         */
+        HandlerExecutor(const handler_executor_options& opts, task fn);
+
+        /**
+         * @brief Runs the messages still queued, then joins the workers.
+         */
+        ~HandlerExecutor();
+
+        HandlerExecutor(const HandlerExecutor&) = delete;
+        HandlerExecutor& operator=(const HandlerExecutor&) = delete;
+
+        /**
+         * @brief Returns the hash of the ordering key of @p msg.
+         */
+        std::size_t key_of(const mqtt::const_message_ptr& msg) const;
+
+        /**
+         * @brief Returns the worker running messages of @p msg's key.
+         */
+        inline std::size_t worker_of(const mqtt::const_message_ptr& msg) const
+        {
+            return key_of(msg) % workers_.size();
+        }
+
+        /**
+         * @brief Queues @p msg to the worker of its key.
+         *
+         * @return false if the message was dropped because the worker was full.
+         */
+        bool submit(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Returns the number of worker threads.
+         */
+        inline std::size_t size() const
+        {
+            return workers_.size();
+        }
+
+        /**
+         * @brief Returns a snapshot of the worker counters.
+         */
+        handler_executor_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_HANDLER_EXECUTOR__
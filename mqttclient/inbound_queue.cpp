@@ -0,0 +1,669 @@
+#include "inbound_queue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace mqttcpp
+{
+    static std::size_t round_up_pow2(std::size_t value)
+    {
+        std::size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    MessageQueue::MessageQueue(std::size_t capacity)
+        : mask_(round_up_pow2(capacity) - 1), cells_(new cell[mask_ + 1]), enqueuePos_(0), dequeuePos_(0)
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool MessageQueue::push(const mqtt::const_message_ptr& msg)
+    {
+        cell* target = nullptr;
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            target = &cells_[pos & mask_];
+            std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        target->msg = msg;
+        target->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool MessageQueue::try_pop(mqtt::const_message_ptr& msg)
+    {
+        cell* source = nullptr;
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            source = &cells_[pos & mask_];
+            std::size_t sequence = source->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        msg = std::move(source->msg);
+        source->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t MessageQueue::size() const
+    {
+        std::size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+        std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    void InboundQueue::parking::notify_one()
+    {
+        // Taking the mutex orders this notification after a consumer's last check of the queue
+        {
+            lg lock(guard);
+        }
+        cv.notify_one();
+    }
+
+    void InboundQueue::parking::notify_all()
+    {
+        {
+            lg lock(guard);
+        }
+        cv.notify_all();
+    }
+
+    /**
+     * @brief Append-only file of spilled messages, read back in order.
+     *
+     * Each record is the topic and payload lengths (32 bits each), the QoS and the retained
+     * flag (8 bits each), then the topic and payload bytes. The file is reused from the start
+     * once every record has been read back. All members are protected by the guard, except
+     * pending which the producer reads to keep a spilling shard in order.
+     */
+    struct InboundQueue::spill_file
+    {
+        std::mutex guard;                 ///< Serializes writers and readers.
+        std::FILE* file;                  ///< The open file.
+        std::string path;                 ///< Path of the file, empty for an anonymous temporary file.
+        long readPos;                     ///< Offset of the next record to read back.
+        long nextPos;                     ///< Offset after the record returned by the last read().
+        long writePos;                    ///< Offset of the next record to write.
+        std::atomic<std::size_t> pending; ///< Records written and not yet read back.
+
+        spill_file(std::FILE* f, std::string p)
+            : file(f), path(std::move(p)), readPos(0), nextPos(0), writePos(0), pending(0)
+        {}
+
+        ~spill_file()
+        {
+            std::fclose(file);
+            if (!path.empty())
+            {
+                std::remove(path.c_str());
+            }
+        }
+
+        static std::unique_ptr<spill_file> open(const std::string& prefix, std::size_t index)
+        {
+            std::string path = prefix.empty() ? std::string() : prefix + "." + std::to_string(index);
+            std::FILE* f = path.empty() ? std::tmpfile() : std::fopen(path.c_str(), "w+b");
+            return f ? std::make_unique<spill_file>(f, std::move(path)) : nullptr;
+        }
+
+        bool write(const mqtt::message& msg)
+        {
+            const std::string& topic = msg.get_topic();
+            const mqtt::binary& payload = msg.get_payload();
+            const uint32_t lengths[2] = {static_cast<uint32_t>(topic.size()), static_cast<uint32_t>(payload.size())};
+            const uint8_t flags[2] = {static_cast<uint8_t>(msg.get_qos()), static_cast<uint8_t>(msg.is_retained())};
+            if (std::fseek(file, writePos, SEEK_SET) != 0 || std::fwrite(lengths, sizeof(lengths), 1, file) != 1 ||
+                std::fwrite(flags, sizeof(flags), 1, file) != 1 ||
+                std::fwrite(topic.data(), 1, topic.size(), file) != topic.size() ||
+                std::fwrite(payload.data(), 1, payload.size(), file) != payload.size())
+            {
+                return false;
+            }
+            writePos = std::ftell(file);
+            pending.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Reads the next record without consuming it; commit() consumes it.
+         */
+        bool read(mqtt::const_message_ptr& msg)
+        {
+            uint32_t lengths[2];
+            uint8_t flags[2];
+            if (std::fseek(file, readPos, SEEK_SET) != 0 || std::fread(lengths, sizeof(lengths), 1, file) != 1 ||
+                std::fread(flags, sizeof(flags), 1, file) != 1)
+            {
+                return false;
+            }
+            std::string topic(lengths[0], '\0');
+            mqtt::binary payload(lengths[1], '\0');
+            if (std::fread(&topic[0], 1, topic.size(), file) != topic.size() ||
+                std::fread(&payload[0], 1, payload.size(), file) != payload.size())
+            {
+                return false;
+            }
+            nextPos = std::ftell(file);
+            msg = mqtt::make_message(std::move(topic), std::move(payload), flags[0], flags[1] != 0);
+            return true;
+        }
+
+        void commit()
+        {
+            readPos = nextPos;
+            if (pending.fetch_sub(1, std::memory_order_release) == 1)
+            {
+                readPos = nextPos = writePos = 0;
+            }
+        }
+
+        /**
+         * @brief Forgets every record and returns how many were pending.
+         */
+        std::size_t clear()
+        {
+            readPos = nextPos = writePos = 0;
+            return pending.exchange(0, std::memory_order_release);
+        }
+    };
+
+    InboundQueue::shard::shard(std::size_t capacity, std::unique_ptr<spill_file> file)
+        : queue(capacity), spill(std::move(file)), bytes(0), pushed(0), dropped(0), evicted(0), blocked(0), spilled(0)
+    {}
+
+    InboundQueue::shard::~shard() = default;
+
+    static inbound_queue_options normalized(inbound_queue_options opts)
+    {
+        opts.capacity = std::max<std::size_t>(opts.capacity, 1);
+        opts.shards = std::max<std::size_t>(opts.shards, 1);
+        return opts;
+    }
+
+    InboundQueue::InboundQueue(const inbound_queue_options& opts)
+        : opts_(normalized(opts)), nextShard_(0), open_(false), aboveHigh_(false)
+    {
+        shards_.reserve(opts_.shards);
+        for (std::size_t i = 0; i < opts_.shards; ++i)
+        {
+            std::unique_ptr<spill_file> file;
+            if (opts_.policy == OverflowPolicy::SPILL)
+            {
+                file = spill_file::open(opts_.spillPath, i);
+            }
+            shards_.push_back(std::make_unique<shard>(opts_.capacity, std::move(file)));
+        }
+    }
+
+    InboundQueue::~InboundQueue() = default;
+
+    std::size_t InboundQueue::shard_of(const std::string& topic) const
+    {
+        return shards_.size() == 1 ? 0 : std::hash<std::string>()(topic) % shards_.size();
+    }
+
+    std::size_t InboundQueue::message_bytes(const mqtt::message& msg)
+    {
+        return msg.get_topic().size() + msg.get_payload().size();
+    }
+
+    std::size_t InboundQueue::total_bytes() const
+    {
+        std::size_t total = 0;
+        for (const auto& s : shards_)
+        {
+            total += s->bytes.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    bool InboundQueue::fits(std::size_t size) const
+    {
+        if (opts_.maxBytes == 0)
+        {
+            return true;
+        }
+        const std::size_t total = total_bytes();
+        return total == 0 || total + size <= opts_.maxBytes;
+    }
+
+    bool InboundQueue::has_room(const shard& target, std::size_t size) const
+    {
+        return target.queue.size() < opts_.capacity && fits(size);
+    }
+
+    bool InboundQueue::enqueue(shard& target, const mqtt::const_message_ptr& msg, std::size_t size, bool overLimit)
+    {
+        if (overLimit ? target.queue.size() >= opts_.capacity : !has_room(target, size))
+        {
+            return false;
+        }
+        // Accounted before the push so that a consumer popping it right away never underflows
+        target.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (!target.queue.push(msg))
+        {
+            target.bytes.fetch_sub(size, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Pop>
+    bool InboundQueue::wait(parking& park, Pop&& pop, unsigned int wait_for)
+    {
+        bool popped = false;
+        park.waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(park.guard);
+            auto ready = [&] {
+                popped = pop();
+                return popped || !open_.load(std::memory_order_relaxed);
+            };
+            if (wait_for > 0)
+            {
+                park.cv.wait_for(lock, std::chrono::milliseconds(wait_for), ready);
+            }
+            else
+            {
+                park.cv.wait(lock, ready);
+            }
+        }
+        park.waiters.fetch_sub(1, std::memory_order_relaxed);
+        return popped;
+    }
+
+    bool InboundQueue::take(shard& source, mqtt::const_message_ptr& msg)
+    {
+        if (!source.queue.try_pop(msg))
+        {
+            if (!source.spill || source.spill->pending.load(std::memory_order_acquire) == 0)
+            {
+                return false;
+            }
+            refill(source);
+            if (!source.queue.try_pop(msg))
+            {
+                return false;
+            }
+        }
+        source.bytes.fetch_sub(message_bytes(*msg), std::memory_order_relaxed);
+        if (opts_.policy == OverflowPolicy::BLOCK)
+        {
+            // Pairs with the fence in wait(): either the producer sees the room or we see the producer
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (roomPark_.waiters.load(std::memory_order_relaxed) > 0)
+            {
+                roomPark_.notify_all();
+            }
+        }
+        if (opts_.watermarkHandler && aboveHigh_.load(std::memory_order_relaxed))
+        {
+            check_low_watermark();
+        }
+        return true;
+    }
+
+    bool InboundQueue::evict(shard& target)
+    {
+        mqtt::const_message_ptr oldest;
+        shard* source = &target;
+        if (!target.queue.try_pop(oldest))
+        {
+            // The byte limit may be held by other shards
+            source = nullptr;
+            for (auto& s : shards_)
+            {
+                if (s->queue.try_pop(oldest))
+                {
+                    source = s.get();
+                    break;
+                }
+            }
+            if (!source)
+            {
+                return false;
+            }
+        }
+        source->bytes.fetch_sub(message_bytes(*oldest), std::memory_order_relaxed);
+        source->evicted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool InboundQueue::wait_for_room(shard& target, std::size_t size)
+    {
+        target.blocked.fetch_add(1, std::memory_order_relaxed);
+        return wait(roomPark_, [this, &target, size] { return has_room(target, size); }, opts_.blockTimeout) &&
+               is_open();
+    }
+
+    void InboundQueue::refill(shard& target)
+    {
+        spill_file& spill = *target.spill;
+        lg lock(spill.guard);
+        mqtt::const_message_ptr msg;
+        while (spill.pending.load(std::memory_order_relaxed) > 0)
+        {
+            if (!spill.read(msg))
+            {
+                // An unreadable spill file loses its backlog rather than wedging the shard
+                target.dropped.fetch_add(spill.clear(), std::memory_order_relaxed);
+                return;
+            }
+            if (!enqueue(target, msg, message_bytes(*msg), target.queue.size() == 0))
+            {
+                return;
+            }
+            spill.commit();
+        }
+    }
+
+    void InboundQueue::notify_consumers(shard& target)
+    {
+        // Pairs with the fence in wait(): either the consumer sees the message or we see the consumer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (target.park.waiters.load(std::memory_order_relaxed) > 0)
+        {
+            target.park.notify_one();
+        }
+        if (anyPark_.waiters.load(std::memory_order_relaxed) > 0)
+        {
+            anyPark_.notify_one();
+        }
+    }
+
+    double InboundQueue::fill_ratio() const
+    {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+        for (const auto& s : shards_)
+        {
+            count += s->queue.size();
+            if (s->spill)
+            {
+                count += s->spill->pending.load(std::memory_order_relaxed);
+            }
+            bytes += s->bytes.load(std::memory_order_relaxed);
+        }
+        double ratio = static_cast<double>(count) / static_cast<double>(opts_.capacity * shards_.size());
+        if (opts_.maxBytes > 0)
+        {
+            ratio = std::max(ratio, static_cast<double>(bytes) / static_cast<double>(opts_.maxBytes));
+        }
+        return ratio;
+    }
+
+    void InboundQueue::check_high_watermark()
+    {
+        if (aboveHigh_.load(std::memory_order_relaxed) || fill_ratio() < opts_.highWatermark)
+        {
+            return;
+        }
+        if (!aboveHigh_.exchange(true))
+        {
+            opts_.watermarkHandler(true);
+        }
+    }
+
+    void InboundQueue::check_low_watermark()
+    {
+        if (fill_ratio() > opts_.lowWatermark)
+        {
+            return;
+        }
+        if (aboveHigh_.exchange(false))
+        {
+            opts_.watermarkHandler(false);
+        }
+    }
+
+    void InboundQueue::discard()
+    {
+        mqtt::const_message_ptr stale;
+        for (auto& s : shards_)
+        {
+            if (s->spill)
+            {
+                lg lock(s->spill->guard);
+                s->spill->clear();
+            }
+            while (s->queue.try_pop(stale))
+            {
+                s->bytes.fetch_sub(message_bytes(*stale), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void InboundQueue::open()
+    {
+        discard();
+        aboveHigh_.store(false);
+        open_.store(true);
+    }
+
+    void InboundQueue::close()
+    {
+        open_.store(false);
+        discard();
+        for (auto& s : shards_)
+        {
+            s->park.notify_all();
+        }
+        anyPark_.notify_all();
+        roomPark_.notify_all();
+    }
+
+    bool InboundQueue::push(mqtt::const_message_ptr msg)
+    {
+        if (!open_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        shard& target = *shards_[shard_of(msg->get_topic())];
+        const std::size_t size = message_bytes(*msg);
+        bool queued = false;
+        if (target.spill && target.spill->pending.load(std::memory_order_acquire) > 0)
+        {
+            // Messages behind a spilled backlog are spilled too so that the shard stays in order
+            lg lock(target.spill->guard);
+            queued = target.spill->write(*msg);
+            target.spilled.fetch_add(queued, std::memory_order_relaxed);
+        }
+        else
+        {
+            while (!(queued = enqueue(target, msg, size)))
+            {
+                if (opts_.policy == OverflowPolicy::DROP_OLDEST && evict(target))
+                {
+                    continue;
+                }
+                if (opts_.policy == OverflowPolicy::BLOCK && wait_for_room(target, size))
+                {
+                    continue;
+                }
+                if (opts_.policy == OverflowPolicy::SPILL && target.spill)
+                {
+                    lg lock(target.spill->guard);
+                    queued = target.spill->write(*msg);
+                    target.spilled.fetch_add(queued, std::memory_order_relaxed);
+                }
+                break;
+            }
+        }
+        if (!queued)
+        {
+            target.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        target.pushed.fetch_add(1, std::memory_order_relaxed);
+        if (opts_.watermarkHandler)
+        {
+            check_high_watermark();
+        }
+        notify_consumers(target);
+        return true;
+    }
+
+    bool InboundQueue::try_pop(mqtt::const_message_ptr& msg)
+    {
+        const std::size_t count = shards_.size();
+        if (count == 1)
+        {
+            return take(*shards_[0], msg);
+        }
+        const std::size_t start = nextShard_.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (take(*shards_[(start + i) % count], msg))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool InboundQueue::try_pop(std::size_t index, mqtt::const_message_ptr& msg)
+    {
+        return index < shards_.size() && take(*shards_[index], msg);
+    }
+
+    bool InboundQueue::pop(mqtt::const_message_ptr& msg, unsigned int wait_for)
+    {
+        if (try_pop(msg))
+        {
+            return true;
+        }
+        if (!is_open())
+        {
+            return false;
+        }
+        return wait(anyPark_, [this, &msg] { return try_pop(msg); }, wait_for);
+    }
+
+    bool InboundQueue::pop(std::size_t index, mqtt::const_message_ptr& msg, unsigned int wait_for)
+    {
+        if (index >= shards_.size())
+        {
+            return false;
+        }
+        shard& source = *shards_[index];
+        if (take(source, msg))
+        {
+            return true;
+        }
+        if (!is_open())
+        {
+            return false;
+        }
+        return wait(source.park, [this, &source, &msg] { return take(source, msg); }, wait_for);
+    }
+
+    std::size_t InboundQueue::pop_batch(std::vector<mqtt::const_message_ptr>& out,
+                                        std::size_t max,
+                                        unsigned int wait_for)
+    {
+        mqtt::const_message_ptr msg;
+        if (max == 0 || !pop(msg, wait_for))
+        {
+            return 0;
+        }
+        std::size_t count = 0;
+        do
+        {
+            out.push_back(std::move(msg));
+            ++count;
+        } while (count < max && try_pop(msg));
+        return count;
+    }
+
+    std::size_t InboundQueue::pop_batch(std::size_t index,
+                                        std::vector<mqtt::const_message_ptr>& out,
+                                        std::size_t max,
+                                        unsigned int wait_for)
+    {
+        mqtt::const_message_ptr msg;
+        if (max == 0 || !pop(index, msg, wait_for))
+        {
+            return 0;
+        }
+        std::size_t count = 0;
+        do
+        {
+            out.push_back(std::move(msg));
+            ++count;
+        } while (count < max && take(*shards_[index], msg));
+        return count;
+    }
+
+    inbound_queue_stats InboundQueue::get_stats() const
+    {
+        inbound_queue_stats stats{};
+        stats.shards = shards_.size();
+        for (const auto& s : shards_)
+        {
+            stats.pushed += s->pushed.load(std::memory_order_relaxed);
+            stats.dropped += s->dropped.load(std::memory_order_relaxed);
+            stats.evicted += s->evicted.load(std::memory_order_relaxed);
+            stats.blocked += s->blocked.load(std::memory_order_relaxed);
+            stats.spilled += s->spilled.load(std::memory_order_relaxed);
+            stats.size += s->queue.size();
+            stats.bytes += s->bytes.load(std::memory_order_relaxed);
+            if (s->spill)
+            {
+                stats.onDisk += s->spill->pending.load(std::memory_order_relaxed);
+            }
+        }
+        stats.unspilled = unspilled_shards();
+        return stats;
+    }
+
+    std::size_t InboundQueue::unspilled_shards() const
+    {
+        if (opts_.policy != OverflowPolicy::SPILL)
+        {
+            return 0;
+        }
+        return static_cast<std::size_t>(
+            std::count_if(shards_.begin(), shards_.end(), [](const std::unique_ptr<shard>& s) { return !s->spill; }));
+    }
+} // namespace mqttcpp
@@ -0,0 +1,381 @@
+/**
+ * @file inbound_queue.hpp
+ * @brief Bounded lock-free queue of inbound messages, optionally sharded per worker.
+ *
+ * Messages saved by the client are pushed from the paho callback thread and popped by any
+ * number of consumer threads. Pushing and popping never take a lock; a mutex is only used
+ * to park consumers that found the queue empty, a producer blocked on a full queue, and to
+ * access the spill files.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_INBOUND_QUEUE__
+#define __CORE_MQTT_INBOUND_QUEUE__
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mqtt/message.h"
+
+namespace mqttcpp
+{
+    /**
+     * @brief What the inbound queue does with a message arriving while it is full.
+     */
+    enum class OverflowPolicy
+    {
+        DROP_NEWEST, ///< Drop the arriving message.
+        DROP_OLDEST, ///< Drop queued messages, oldest first, until the arriving one fits.
+        BLOCK,       ///< Block the pushing thread until consumers make room or the timeout expires.
+                     ///< When pushing from the callback thread this stalls every callback of the client.
+        SPILL        ///< Append the message to a spill file, read back once consumers empty the shard.
+    };
+
+    /**
+     * @brief Configuration of the inbound queue.
+     *
+     * The queue is full when a shard holds @ref capacity messages or when all shards together hold
+     * @ref maxBytes bytes of topic and payload. A single message larger than @ref maxBytes is still
+     * accepted into an empty queue.
+     */
+    struct inbound_queue_options
+    {
+        std::size_t capacity = 16384;                        ///< Messages held per shard.
+        std::size_t shards = 1;                              ///< Number of shards; a topic always maps to one shard.
+        std::size_t maxBytes = 0;                            ///< Bytes held over all shards, 0 for no limit.
+        OverflowPolicy policy = OverflowPolicy::DROP_NEWEST; ///< Behaviour when the queue is full.
+        unsigned int blockTimeout = 0;                       ///< BLOCK: milliseconds before dropping, 0 waits forever.
+        std::string spillPath = "";                          ///< SPILL: shard i spills to "<spillPath>.<i>", or to an
+                                                             ///< anonymous temporary file if empty.
+        double highWatermark = 0.8;                          ///< Fill ratio reported to the watermark handler.
+        double lowWatermark = 0.5;                           ///< Fill ratio clearing the high watermark.
+        std::function<void(bool)> watermarkHandler = {};     ///< Called with true above the high watermark and with
+                                                             ///< false back below the low one, on the crossing thread.
+    };
+
+    /**
+     * @brief Snapshot of the inbound queue counters.
+     */
+    struct inbound_queue_stats
+    {
+        uint64_t pushed;       ///< Messages accepted by the queue, spilled ones included.
+        uint64_t dropped;      ///< Arriving messages dropped (DROP_NEWEST, BLOCK timeout, spill failure).
+        uint64_t evicted;      ///< Queued messages dropped to make room (DROP_OLDEST).
+        uint64_t blocked;      ///< Pushes that had to wait for room (BLOCK).
+        uint64_t spilled;      ///< Messages written to a spill file (SPILL).
+        std::size_t size;      ///< Messages currently waiting in memory.
+        std::size_t bytes;     ///< Bytes of topic and payload currently waiting in memory.
+        std::size_t onDisk;    ///< Messages currently waiting in the spill files.
+        std::size_t shards;    ///< Number of shards.
+        std::size_t unspilled; ///< SPILL: shards whose spill file could not be opened; they drop their overflow.
+    };
+
+    /**
+     * @brief Bounded lock-free multi-producer multi-consumer ring of messages.
+     *
+     * Same layout as CompletionQueue (Vyukov's bounded queue), holding message pointers.
+     * A push to a full ring fails; what happens to the message is up to the caller.
+     */
+    class MessageQueue
+    {
+        /**
+         * @brief One slot of the ring.
+         */
+        struct cell
+        {
+            std::atomic<std::size_t> sequence; ///< Position this cell is ready for.
+            mqtt::const_message_ptr msg;       ///< The stored message, empty once popped.
+        };
+
+        const std::size_t mask_;                          ///< Capacity - 1, capacity is a power of two.
+        std::unique_ptr<cell[]> cells_;                   ///< The ring.
+        alignas(64) std::atomic<std::size_t> enqueuePos_; ///< Next position to write.
+        alignas(64) std::atomic<std::size_t> dequeuePos_; ///< Next position to read.
+
+    public:
+        /**
+         * @brief Creates a ring holding at least @p capacity messages.
+         *
+         * @param capacity Requested capacity, rounded up to a power of two.
+         */
+        explicit MessageQueue(std::size_t capacity);
+
+        /**
+         * @brief Appends @p msg unless the ring is full.
+         *
+         * @return true if the message was queued.
+         */
+        bool push(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Pops the oldest message.
+         *
+         * @param msg Receives the message.
+         * @return true if a message was popped; false if the ring is empty.
+         */
+        bool try_pop(mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Returns the approximate number of queued messages.
+         */
+        std::size_t size() const;
+    };
+
+    /**
+     * @brief Inbound message queue made of one MessageQueue per shard.
+     *
+     * With one shard every consumer shares the same ring. With several shards each worker
+     * consumes its own shard, so workers never contend on the same ring, and messages of a
+     * topic stay in order. Consumers that call the shard-less pops take from any shard.
+     *
+     * Consumers that find the queue empty park on a condition variable. The producer only
+     * touches that condition variable when someone is parked.
+     *
+     * A full queue is handled according to inbound_queue_options::policy. With SPILL, once a
+     * shard has spilled, its later messages go to the spill file too so that the shard stays in
+     * order; consumers read the file back when the ring runs empty. Spilled messages keep their
+     * topic, payload, QoS and retained flag but lose their MQTT v5 properties.
+     */
+    class InboundQueue
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+        /**
+         * @brief Parking spot for consumers waiting on an empty queue.
+         */
+        struct parking
+        {
+            std::mutex guard;           ///< Mutex protecting the sleep, never the queue.
+            std::condition_variable cv; ///< Signalled on push and on close.
+            std::atomic<int> waiters;   ///< Number of parked consumers.
+
+            parking() : waiters(0)
+            {}
+
+            void notify_one();
+            void notify_all();
+        };
+
+        struct spill_file;
+
+        /**
+         * @brief One ring, its counters and the consumers parked on it.
+         */
+        struct shard
+        {
+            MessageQueue queue;                ///< Messages of this shard.
+            parking park;                      ///< Consumers waiting on this shard only.
+            std::unique_ptr<spill_file> spill; ///< Overflow file, SPILL policy only.
+            std::atomic<std::size_t> bytes;    ///< Bytes of the messages in the ring.
+            std::atomic<uint64_t> pushed;      ///< Messages accepted.
+            std::atomic<uint64_t> dropped;     ///< Arriving messages dropped.
+            std::atomic<uint64_t> evicted;     ///< Queued messages dropped to make room.
+            std::atomic<uint64_t> blocked;     ///< Pushes that waited for room.
+            std::atomic<uint64_t> spilled;     ///< Messages written to the spill file.
+
+            shard(std::size_t capacity, std::unique_ptr<spill_file> file);
+            ~shard();
+        };
+
+        const inbound_queue_options opts_;           ///< Limits, policy and watermarks.
+        std::vector<std::unique_ptr<shard>> shards_; ///< The shards, fixed at construction.
+        parking anyPark_;                            ///< Consumers waiting on any shard.
+        parking roomPark_;                           ///< Producers waiting for room, BLOCK policy only.
+        std::atomic<std::size_t> nextShard_;         ///< Shard tried first by the next shard-less pop.
+        std::atomic<bool> open_;                     ///< Whether pushes are accepted and waits may block.
+        std::atomic<bool> aboveHigh_;                ///< Whether the high watermark was reported and not cleared.
+
+        /**
+         * @brief Parks on @p park until @p pop succeeds, the queue is closed or the timeout expires.
+         */
+        template <typename Pop>
+        bool wait(parking& park, Pop&& pop, unsigned int wait_for);
+
+        /**
+         * @brief Returns the bytes accounted for @p msg: its topic and payload.
+         */
+        static std::size_t message_bytes(const mqtt::message& msg);
+
+        /**
+         * @brief Returns the bytes held by all shards.
+         */
+        std::size_t total_bytes() const;
+
+        /**
+         * @brief Checks whether a message of @p size bytes fits the byte limit.
+         */
+        bool fits(std::size_t size) const;
+
+        /**
+         * @brief Checks whether @p target can take a message of @p size bytes.
+         */
+        bool has_room(const shard& target, std::size_t size) const;
+
+        /**
+         * @brief Queues @p msg into the ring of @p target if it has room, with its byte accounting.
+         *
+         * @param overLimit Skips the byte limit, still counting the bytes; the ring capacity always applies.
+         */
+        bool enqueue(shard& target, const mqtt::const_message_ptr& msg, std::size_t size, bool overLimit = false);
+
+        /**
+         * @brief Pops from @p source, reading its spill file back if the ring is empty.
+         */
+        bool take(shard& source, mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Drops the oldest message of @p target, or of any shard if @p target is empty.
+         */
+        bool evict(shard& target);
+
+        /**
+         * @brief Blocks until @p target can take a message of @p size bytes.
+         *
+         * @return false on timeout or once the queue is closed.
+         */
+        bool wait_for_room(shard& target, std::size_t size);
+
+        /**
+         * @brief Moves messages from the spill file of @p target back into its ring while it has room.
+         *
+         * An empty ring always takes the first record, even past the byte limit: a consumer parked on one
+         * shard is not woken when other shards free bytes, so it could otherwise wait forever.
+         */
+        void refill(shard& target);
+
+        /**
+         * @brief Wakes the consumers parked on @p target or on any shard.
+         */
+        void notify_consumers(shard& target);
+
+        /**
+         * @brief Returns how full the queue is, as the larger of its count and byte ratios.
+         */
+        double fill_ratio() const;
+
+        /**
+         * @brief Reports crossing the high watermark after a push.
+         */
+        void check_high_watermark();
+
+        /**
+         * @brief Reports falling below the low watermark after a pop.
+         */
+        void check_low_watermark();
+
+        /**
+         * @brief Discards every queued and spilled message.
+         */
+        void discard();
+
+    public:
+        /**
+         * @brief Creates a closed queue.
+         *
+         * With the SPILL policy, a shard whose spill file cannot be opened drops its overflow instead; such shards
+         * are counted by unspilled_shards().
+         *
+         * @param opts Limits, number of shards, overflow policy and watermarks. Zero shards or a zero capacity is
+         * treated as one.
+         */
+        explicit InboundQueue(const inbound_queue_options& opts);
+
+        ~InboundQueue();
+
+        /**
+         * @brief Returns the number of shards.
+         */
+        inline std::size_t shard_count() const
+        {
+            return shards_.size();
+        }
+
+        /**
+         * @brief Returns the number of shards left without a spill file under the SPILL policy; 0 otherwise.
+         */
+        std::size_t unspilled_shards() const;
+
+        /**
+         * @brief Returns the shard receiving messages published to @p topic.
+         */
+        std::size_t shard_of(const std::string& topic) const;
+
+        /**
+         * @brief Discards queued messages and starts accepting pushes.
+         */
+        void open();
+
+        /**
+         * @brief Stops accepting pushes, discards queued messages and wakes every parked thread.
+         */
+        void close();
+
+        /**
+         * @brief Checks whether the queue accepts pushes.
+         */
+        inline bool is_open() const
+        {
+            return open_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Appends @p msg to the shard of its topic, applying the overflow policy if the queue is full.
+         *
+         * @return true if the message was queued or spilled; false if the queue is closed or the message was
+         * dropped.
+         */
+        bool push(mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Pops a message from any shard without waiting.
+         */
+        bool try_pop(mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Pops a message from shard @p index without waiting.
+         */
+        bool try_pop(std::size_t index, mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Pops a message from any shard, waiting up to @p wait_for milliseconds (0 waits indefinitely).
+         *
+         * @return true if a message was popped; false on timeout or once the queue is closed.
+         */
+        bool pop(mqtt::const_message_ptr& msg, unsigned int wait_for);
+
+        /**
+         * @brief Pops a message from shard @p index, waiting up to @p wait_for milliseconds (0 waits indefinitely).
+         *
+         * @return true if a message was popped; false on timeout or once the queue is closed.
+         */
+        bool pop(std::size_t index, mqtt::const_message_ptr& msg, unsigned int wait_for);
+
+        /**
+         * @brief Waits like pop() for one message from any shard, then takes up to @p max without waiting.
+         *
+         * @return The number of messages appended to @p out.
+         */
+        std::size_t pop_batch(std::vector<mqtt::const_message_ptr>& out, std::size_t max, unsigned int wait_for);
+
+        /**
+         * @brief Waits like pop() for one message from shard @p index, then takes up to @p max without waiting.
+         *
+         * @return The number of messages appended to @p out.
+         */
+        std::size_t pop_batch(std::size_t index,
+                              std::vector<mqtt::const_message_ptr>& out,
+                              std::size_t max,
+                              unsigned int wait_for);
+
+        /**
+         * @brief Returns a snapshot of the queue counters, summed over the shards.
+         */
+        inbound_queue_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_INBOUND_QUEUE__
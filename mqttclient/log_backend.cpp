@@ -0,0 +1,441 @@
+#include "log_backend.hpp"
+#include "log_limiter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ddbg
+{
+    namespace
+    {
+        constexpr int32_t PADDING_RECORD = -2; ///< Mode of the filler written before the ring wraps.
+
+        /**
+         * @brief Fixed part of a record; the message text follows it. Records are 8-byte aligned.
+         */
+        struct record_header
+        {
+            uint32_t size;    ///< Bytes of the record, text and alignment included. Read first.
+            int32_t mode;     ///< log_entry::mode, or PADDING_RECORD.
+            uint32_t line;    ///< log_entry::line.
+            uint32_t length;  ///< Bytes of message text.
+            int64_t when;     ///< log_entry::when.
+            const char* file; ///< log_entry::file.
+            const char* func; ///< log_entry::func.
+            uint64_t stamped; ///< log_entry::stamped.
+        };
+
+        inline std::size_t align8(std::size_t bytes)
+        {
+            return (bytes + 7) & ~static_cast<std::size_t>(7);
+        }
+
+        /**
+         * @brief Single-producer single-consumer byte ring of one logging thread.
+         */
+        struct ring
+        {
+            const std::size_t mask;                 ///< Capacity - 1, capacity is a power of two.
+            std::unique_ptr<uint64_t[]> words;      ///< Storage, as words for alignment.
+            alignas(64) std::atomic<uint64_t> head; ///< Next byte to write, owned by the logging thread.
+            std::atomic<bool> writing;              ///< Set while the logging thread is in submit_log_entry().
+            alignas(64) std::atomic<uint64_t> tail; ///< Next byte to read, owned by the background thread.
+            std::atomic<bool> orphaned;             ///< Set when the logging thread exits.
+
+            explicit ring(std::size_t capacity)
+                : mask(capacity - 1), words(new uint64_t[capacity / 8]), head(0), writing(false), tail(0),
+                  orphaned(false)
+            {}
+
+            inline char* bytes()
+            {
+                return reinterpret_cast<char*>(words.get());
+            }
+        };
+
+        /**
+         * @brief Process-wide state of the backend. Never destroyed, so threads may log during exit.
+         */
+        struct backend
+        {
+            std::mutex lifecycle;                      ///< Serializes start and stop.
+            std::mutex guard;                          ///< Protects rings and the flush counters.
+            std::condition_variable wake;              ///< Wakes the background thread early.
+            std::condition_variable flushed;           ///< Signalled after each drain.
+            std::vector<std::shared_ptr<ring>> rings;  ///< Rings of the logging threads.
+            async_log_options opts;                    ///< Options of the current run.
+            std::thread thread;                        ///< The background thread.
+            std::atomic<bool> running{false};          ///< Whether prints go to the rings.
+            bool stopping = false;                     ///< Tells the background thread to drain one last time.
+            std::atomic<uint64_t> generation{0};       ///< Bumped by every start, so threads take a new ring.
+            uint64_t flushRequested = 0;               ///< Flush tickets handed out.
+            uint64_t flushServed = 0;                  ///< Flush tickets whose records were written.
+            std::atomic<uint64_t> written{0};          ///< Records written.
+            std::atomic<uint64_t> dropped{0};          ///< Records dropped on a full ring.
+        };
+
+        backend& state()
+        {
+            static backend* instance = new backend();
+            return *instance;
+        }
+
+        /**
+         * @brief The calling thread's ring, released to the background thread when the thread exits.
+         */
+        struct thread_ring
+        {
+            std::shared_ptr<ring> current;
+            uint64_t generation = 0;
+
+            ~thread_ring()
+            {
+                if (current)
+                {
+                    current->orphaned.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        ring& local_ring(backend& b)
+        {
+            thread_local thread_ring local;
+            const uint64_t generation = b.generation.load(std::memory_order_acquire);
+            if (!local.current || local.generation != generation)
+            {
+                if (local.current)
+                {
+                    local.current->orphaned.store(true, std::memory_order_release);
+                }
+                std::size_t capacity = 1024;
+                while (capacity < b.opts.ringBytes)
+                {
+                    capacity <<= 1;
+                }
+                local.current = std::make_shared<ring>(capacity);
+                local.generation = generation;
+                std::lock_guard<std::mutex> lock(b.guard);
+                b.rings.push_back(local.current);
+            }
+            return *local.current;
+        }
+
+        /**
+         * @brief Reads a record's fields at @p offset of @p source.
+         */
+        log_entry read_entry(ring& source, std::size_t offset, const record_header& header)
+        {
+            log_entry entry;
+            entry.mode = header.mode;
+            entry.stamped = header.stamped != 0;
+            entry.when = header.when;
+            entry.file = header.file;
+            entry.line = header.line;
+            entry.func = header.func;
+            entry.message = std::string_view(source.bytes() + offset + sizeof(record_header), header.length);
+            return entry;
+        }
+
+        /**
+         * @brief Formats and writes every published record, oldest first across threads.
+         */
+        void drain(backend& b, std::vector<log_entry>& entries, std::string& out)
+        {
+            std::vector<std::shared_ptr<ring>> rings;
+            {
+                std::lock_guard<std::mutex> lock(b.guard);
+                rings = b.rings;
+            }
+            std::vector<uint64_t> ends(rings.size());
+            entries.clear();
+            for (std::size_t i = 0; i < rings.size(); ++i)
+            {
+                ring& source = *rings[i];
+                const uint64_t head = source.head.load(std::memory_order_acquire);
+                uint64_t pos = source.tail.load(std::memory_order_relaxed);
+                while (pos < head)
+                {
+                    const std::size_t offset = static_cast<std::size_t>(pos & source.mask);
+                    record_header header;
+                    std::memcpy(&header, source.bytes() + offset, sizeof(uint32_t) * 2);
+                    if (header.mode != PADDING_RECORD)
+                    {
+                        std::memcpy(&header, source.bytes() + offset, sizeof(header));
+                        entries.push_back(read_entry(source, offset, header));
+                    }
+                    pos += header.size;
+                }
+                ends[i] = pos;
+            }
+
+            if (!entries.empty())
+            {
+                std::stable_sort(entries.begin(), entries.end(),
+                                 [](const log_entry& lhs, const log_entry& rhs) { return lhs.when < rhs.when; });
+                out.clear();
+                for (const auto& entry : entries)
+                {
+                    append_log_entry(out, entry);
+                }
+                std::fwrite(out.data(), 1, out.size(), b.opts.output);
+                std::fflush(b.opts.output);
+                b.written.fetch_add(entries.size(), std::memory_order_relaxed);
+            }
+
+            bool orphans = false;
+            for (std::size_t i = 0; i < rings.size(); ++i)
+            {
+                rings[i]->tail.store(ends[i], std::memory_order_release);
+                orphans = orphans || rings[i]->orphaned.load(std::memory_order_acquire);
+            }
+            if (orphans)
+            {
+                // A ring whose thread exited is dropped once it is empty
+                std::lock_guard<std::mutex> lock(b.guard);
+                b.rings.erase(std::remove_if(b.rings.begin(), b.rings.end(),
+                                             [](const std::shared_ptr<ring>& r) {
+                                                 return r->orphaned.load(std::memory_order_acquire) &&
+                                                        r->tail.load(std::memory_order_relaxed) ==
+                                                            r->head.load(std::memory_order_acquire);
+                                             }),
+                              b.rings.end());
+            }
+        }
+
+        void run(backend& b)
+        {
+            std::vector<log_entry> entries;
+            std::string out;
+            while (true)
+            {
+                uint64_t requested;
+                bool stopping;
+                {
+                    std::lock_guard<std::mutex> lock(b.guard);
+                    requested = b.flushRequested;
+                    stopping = b.stopping;
+                }
+                if (!stopping)
+                {
+                    // Storms that ended are summarized here, as no further occurrence will report them
+                    flush_log_limits(true);
+                }
+                drain(b, entries, out);
+                {
+                    std::lock_guard<std::mutex> lock(b.guard);
+                    b.flushServed = requested;
+                }
+                b.flushed.notify_all();
+                if (stopping)
+                {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(b.guard);
+                b.wake.wait_for(lock, std::chrono::milliseconds(b.opts.flushInterval),
+                                [&] { return b.stopping || b.flushRequested != requested; });
+            }
+        }
+    } // namespace
+
+    std::string format_log_time(std::time_t when)
+    {
+        static const char* const DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        std::tm local{};
+#if defined(_WIN32)
+        localtime_s(&local, &when);
+#else
+        localtime_r(&when, &local);
+#endif
+        // Same layout as asctime()
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.3s %.3s%3d %.2d:%.2d:%.2d %d", DAYS[local.tm_wday],
+                      MONTHS[local.tm_mon], local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec,
+                      1900 + local.tm_year);
+        return buffer;
+    }
+
+    void append_log_entry(std::string& out, const log_entry& entry)
+    {
+        static const char* const COLORS[] = {"\033[31m", "\033[32m", "\033[34m"};
+        static const char* const PREFIXES[] = {"Error: ", "Info: ", "Debug: "};
+        const bool typed = entry.mode >= 0 && entry.mode < 3;
+
+        out += '\n';
+        if (typed)
+        {
+            out += COLORS[entry.mode];
+        }
+        if (entry.stamped)
+        {
+            // Consecutive entries mostly fall in the same second
+            thread_local std::time_t lastSecond = -1;
+            thread_local std::string lastText;
+            const std::time_t second = static_cast<std::time_t>(entry.when / 1000000000);
+            if (second != lastSecond)
+            {
+                lastText = format_log_time(second);
+                lastSecond = second;
+            }
+            out += '[';
+            out += lastText;
+            out += "]\n";
+        }
+        if (entry.file)
+        {
+            out += "(at ";
+            out += entry.file;
+            out += ':';
+            out += std::to_string(entry.line);
+            out += " - ";
+            out += entry.func;
+            out += ")\n";
+        }
+        if (typed)
+        {
+            out += PREFIXES[entry.mode];
+        }
+        out.append(entry.message.data(), entry.message.size());
+        out += "\033[0m";
+    }
+
+    bool start_async_logging(const async_log_options& opts)
+    {
+        backend& b = state();
+        std::lock_guard<std::mutex> lifecycle(b.lifecycle);
+        if (b.running.load())
+        {
+            return false;
+        }
+        b.opts = opts;
+        b.generation.fetch_add(1, std::memory_order_release);
+        b.running.store(true);
+        b.thread = std::thread(run, std::ref(b));
+        return true;
+    }
+
+    void stop_async_logging()
+    {
+        backend& b = state();
+        std::lock_guard<std::mutex> lifecycle(b.lifecycle);
+        if (!b.running.load())
+        {
+            return;
+        }
+        // Written by the final drain
+        flush_log_limits();
+        std::vector<std::shared_ptr<ring>> rings;
+        {
+            std::lock_guard<std::mutex> lock(b.guard);
+            b.running.store(false);
+            rings = b.rings;
+        }
+        // A thread that saw the backend running finishes its record before the final drain; the rings
+        // registered from now on see it stopped and print synchronously
+        for (const auto& r : rings)
+        {
+            while (r->writing.load())
+            {
+                std::this_thread::yield();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(b.guard);
+            b.stopping = true;
+        }
+        b.wake.notify_all();
+        b.thread.join();
+        std::lock_guard<std::mutex> lock(b.guard);
+        b.stopping = false;
+        b.rings.clear();
+    }
+
+    bool async_logging_enabled()
+    {
+        return state().running.load(std::memory_order_relaxed);
+    }
+
+    bool submit_log_entry(const log_entry& entry)
+    {
+        backend& b = state();
+        if (!b.running.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        ring& target = local_ring(b);
+        // Pairs with stop_async_logging(): either it waits for this record or we see the backend stopped
+        target.writing.store(true);
+        if (!b.running.load())
+        {
+            target.writing.store(false, std::memory_order_release);
+            return false;
+        }
+        const std::size_t capacity = target.mask + 1;
+        // A message longer than half the ring is truncated so that it always fits an empty ring
+        const std::size_t length = std::min(entry.message.size(), capacity / 2 - sizeof(record_header));
+        const std::size_t size = align8(sizeof(record_header) + length);
+
+        const uint64_t head = target.head.load(std::memory_order_relaxed);
+        const uint64_t tail = target.tail.load(std::memory_order_acquire);
+        const std::size_t offset = static_cast<std::size_t>(head & target.mask);
+        const std::size_t padding = offset + size > capacity ? capacity - offset : 0;
+        if (head + padding + size - tail > capacity)
+        {
+            target.writing.store(false, std::memory_order_release);
+            b.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        char* bytes = target.bytes();
+        if (padding > 0)
+        {
+            const uint32_t filler[2] = {static_cast<uint32_t>(padding), static_cast<uint32_t>(PADDING_RECORD)};
+            std::memcpy(bytes + offset, filler, sizeof(filler));
+        }
+        const std::size_t start = (offset + padding) & target.mask;
+        record_header header;
+        header.size = static_cast<uint32_t>(size);
+        header.mode = entry.mode;
+        header.line = entry.line;
+        header.length = static_cast<uint32_t>(length);
+        header.when = entry.when;
+        header.file = entry.file;
+        header.func = entry.func;
+        header.stamped = entry.stamped ? 1 : 0;
+        std::memcpy(bytes + start, &header, sizeof(header));
+        std::memcpy(bytes + start + sizeof(header), entry.message.data(), length);
+        target.head.store(head + padding + size, std::memory_order_release);
+        target.writing.store(false, std::memory_order_release);
+        return true;
+    }
+
+    void flush_async_log()
+    {
+        backend& b = state();
+        std::unique_lock<std::mutex> lock(b.guard);
+        if (!b.running.load())
+        {
+            return;
+        }
+        const uint64_t ticket = ++b.flushRequested;
+        b.wake.notify_all();
+        b.flushed.wait(lock, [&] { return b.flushServed >= ticket || !b.running.load(); });
+    }
+
+    async_log_stats get_async_log_stats()
+    {
+        backend& b = state();
+        async_log_stats stats{};
+        stats.written = b.written.load(std::memory_order_relaxed);
+        stats.dropped = b.dropped.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(b.guard);
+        stats.rings = b.rings.size();
+        return stats;
+    }
+} // namespace ddbg
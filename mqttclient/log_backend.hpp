@@ -0,0 +1,103 @@
+/**
+ * @file log_backend.hpp
+ * @brief Asynchronous backend of ddbg::Printer.
+ *
+ * Once started, ddbg::Printer::print() no longer formats the timestamp or the source line and
+ * no longer writes to stderr on the calling thread. It copies a compact record (mode, raw
+ * timestamp, source pointers and message text) into a ring owned by the calling thread, and a
+ * background thread formats and writes the records. A full ring drops the record and counts it;
+ * logging never blocks the caller.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_LOG_BACKEND__
+#define __CORE_MQTT_LOG_BACKEND__
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace ddbg
+{
+    /**
+     * @brief Configuration of the asynchronous log backend.
+     */
+    struct async_log_options
+    {
+        std::size_t ringBytes = 64 * 1024; ///< Bytes of the ring of each logging thread, rounded up to a power of two.
+        unsigned int flushInterval = 10;   ///< Milliseconds between two drains of the rings.
+        FILE* output = stderr;             ///< Destination of the formatted records.
+    };
+
+    /**
+     * @brief Snapshot of the asynchronous log backend counters.
+     */
+    struct async_log_stats
+    {
+        uint64_t written;  ///< Records formatted and written.
+        uint64_t dropped;  ///< Records dropped because the thread's ring was full.
+        std::size_t rings; ///< Rings currently registered, one per logging thread.
+    };
+
+    /**
+     * @brief One log entry, with every field still unformatted.
+     */
+    struct log_entry
+    {
+        int mode;                 ///< ddbg::Printer::MessageMode, or -1 without a type.
+        bool stamped;             ///< Whether the entry carries a timestamp line.
+        int64_t when;             ///< System clock time of the call, in nanoseconds since the epoch.
+        const char* file;         ///< Source file with static storage, or nullptr without line information.
+        unsigned int line;        ///< Source line.
+        const char* func;         ///< Source function, with static storage.
+        std::string_view message; ///< Message text.
+    };
+
+    /**
+     * @brief Appends @p entry to @p out in the layout written by ddbg::Printer::print().
+     */
+    void append_log_entry(std::string& out, const log_entry& entry);
+
+    /**
+     * @brief Formats @p when like asctime(), without the trailing newline, using the thread-safe localtime.
+     */
+    std::string format_log_time(std::time_t when);
+
+    /**
+     * @brief Starts the background thread and routes every ddbg::Printer::print() through the rings.
+     *
+     * @return false if the backend is already running.
+     */
+    bool start_async_logging(const async_log_options& opts = async_log_options());
+
+    /**
+     * @brief Writes the pending records and suppressed counts (flush_log_limits()), stops the background thread
+     * and returns to synchronous printing.
+     */
+    void stop_async_logging();
+
+    /**
+     * @brief Checks whether the asynchronous backend is running.
+     */
+    bool async_logging_enabled();
+
+    /**
+     * @brief Copies @p entry into the calling thread's ring.
+     *
+     * @return false if the backend is not running or the ring is full, in which case a full ring counts a drop.
+     */
+    bool submit_log_entry(const log_entry& entry);
+
+    /**
+     * @brief Blocks until every record submitted before the call is written.
+     */
+    void flush_async_log();
+
+    /**
+     * @brief Returns a snapshot of the backend counters, kept across restarts.
+     */
+    async_log_stats get_async_log_stats();
+} // namespace ddbg
+
+#endif // __CORE_MQTT_LOG_BACKEND__
@@ -0,0 +1,111 @@
+#include "log_limiter.hpp"
+#include <chrono>
+
+namespace ddbg
+{
+    namespace
+    {
+        std::atomic<unsigned int> limitInterval{1000}; ///< Milliseconds, see set_log_limit_interval().
+        std::atomic<LogLimiter*> limiters{nullptr};    ///< Call sites that suppressed a message, newest first.
+
+        inline int64_t steady_now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+    } // namespace
+
+    void set_log_limit_interval(unsigned int millis)
+    {
+        limitInterval.store(millis, std::memory_order_relaxed);
+    }
+
+    unsigned int get_log_limit_interval()
+    {
+        return limitInterval.load(std::memory_order_relaxed);
+    }
+
+    void flush_log_limits(bool elapsedOnly)
+    {
+        // Limiters are never removed, so the list can be walked while others join it
+        for (LogLimiter* limiter = limiters.load(std::memory_order_acquire); limiter; limiter = limiter->next_)
+        {
+            limiter->flush(elapsedOnly);
+        }
+    }
+
+    LogLimiter::slot& LogLimiter::find(uint64_t key)
+    {
+        const std::size_t home = static_cast<std::size_t>((key ^ (key >> 32)) % SLOTS);
+        for (std::size_t i = 0; i < SLOTS; ++i)
+        {
+            slot& candidate = slots_[(home + i) % SLOTS];
+            uint64_t current = candidate.key.load(std::memory_order_relaxed);
+            if (current == key)
+            {
+                return candidate;
+            }
+            if (current == 0 && (candidate.key.compare_exchange_strong(current, key, std::memory_order_relaxed) ||
+                                 current == key))
+            {
+                return candidate;
+            }
+        }
+        return slots_[home];
+    }
+
+    bool LogLimiter::admit(uint64_t key, uint64_t& repeated)
+    {
+        repeated = 0;
+        const int64_t interval = static_cast<int64_t>(get_log_limit_interval()) * 1000000;
+        if (interval == 0)
+        {
+            return true;
+        }
+        slot& counters = find(key ? key : 1);
+        const int64_t now = steady_now();
+        int64_t last = counters.last.load(std::memory_order_relaxed);
+        // Only the thread that moves `last` forward logs; the others count themselves as repeats
+        if ((last != 0 && now - last < interval) ||
+            !counters.last.compare_exchange_strong(last, now, std::memory_order_relaxed))
+        {
+            counters.lastSuppressed.store(now, std::memory_order_relaxed);
+            counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+            if (file_ && !registered_.load(std::memory_order_relaxed) &&
+                !registered_.exchange(true, std::memory_order_relaxed))
+            {
+                next_ = limiters.load(std::memory_order_relaxed);
+                while (!limiters.compare_exchange_weak(next_, this, std::memory_order_release,
+                                                       std::memory_order_relaxed))
+                {
+                }
+            }
+            return false;
+        }
+        repeated = counters.suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void LogLimiter::flush(bool elapsedOnly)
+    {
+        const int64_t interval = static_cast<int64_t>(get_log_limit_interval()) * 1000000;
+        const int64_t now = steady_now();
+        for (slot& counters : slots_)
+        {
+            if (counters.suppressed.load(std::memory_order_relaxed) == 0 ||
+                (elapsedOnly && now - counters.lastSuppressed.load(std::memory_order_relaxed) < interval))
+            {
+                continue;
+            }
+            // A concurrent admit() may take the count first; whoever exchanges it reports it
+            const uint64_t repeated = counters.suppressed.exchange(0, std::memory_order_relaxed);
+            if (repeated > 0)
+            {
+                derror1("(summary of the message logged at %s:%u)\n", file_ ? file_ : "?", line_)
+                    .repeated(repeated)
+                    .print();
+            }
+        }
+    }
+} // namespace ddbg
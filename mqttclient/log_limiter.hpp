@@ -0,0 +1,160 @@
+/**
+ * @file log_limiter.hpp
+ * @brief Suppression of repeated log messages, per call site and message key.
+ *
+ * A limited statement runs for the first occurrence of its key and then at most once per interval
+ * (set_log_limit_interval()). The occurrences skipped in between are counted, and the next statement
+ * that runs reports them as "[repeated N times]". The counters are atomics in a small table owned by
+ * the call site, so a storm of identical errors costs a clock read and a few atomic operations per
+ * call instead of a formatted line on stderr.
+ *
+ * When a storm stops, no further statement reports the last count. flush_log_limits() logs such
+ * counts as a summary line naming the call site; the asynchronous backend calls it on every drain
+ * for the keys that stayed quiet for a whole interval, and for every count when it stops. A storm
+ * still going on is left to its next admitted occurrence, so it keeps logging one line per interval.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_LOG_LIMITER__
+#define __CORE_MQTT_LOG_LIMITER__
+#include "monitor.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ddbg
+{
+    /**
+     * @brief Sets the minimum time between two messages of the same key at one call site; 0 disables suppression.
+     */
+    void set_log_limit_interval(unsigned int millis);
+
+    /**
+     * @brief Returns the suppression interval in milliseconds, 1000 unless set_log_limit_interval() changed it.
+     */
+    unsigned int get_log_limit_interval();
+
+    /**
+     * @brief Logs the occurrences still counted at every call site that suppressed a message.
+     *
+     * @param elapsedOnly If true, only the keys with no occurrence for a whole interval, whose storm ended.
+     */
+    void flush_log_limits(bool elapsedOnly = false);
+
+    /**
+     * @brief Suppression state of one call site, defined by the DD_LIMITED macro.
+     *
+     * Keys beyond the table size share a slot with another key, so the log volume stays bounded whatever
+     * the number of distinct messages.
+     */
+    class LogLimiter
+    {
+    public:
+        static constexpr std::size_t SLOTS = 8; ///< Distinct keys tracked per call site.
+
+        /**
+         * @brief Creates a limiter that flush_log_limits() does not know about.
+         */
+        constexpr LogLimiter() = default;
+
+        /**
+         * @brief Creates the limiter of the call site at @p file:@p line.
+         *
+         * It joins flush_log_limits() when it first suppresses a message, so it must have static storage.
+         */
+        constexpr LogLimiter(const char* file, unsigned int line) : file_(file), line_(line)
+        {}
+
+        /**
+         * @brief Decides whether an occurrence of @p key is logged.
+         *
+         * @param key Hash of what distinguishes the message, see log_key().
+         * @param repeated Set to the occurrences suppressed since the key was last logged, when logged.
+         * @return true if the message is logged.
+         */
+        bool admit(uint64_t key, uint64_t& repeated);
+
+        /**
+         * @brief Logs the occurrences suppressed since each key was last logged, as "[repeated N times]".
+         *
+         * @param elapsedOnly If true, only the keys with no occurrence for a whole interval, whose storm ended.
+         */
+        void flush(bool elapsedOnly);
+
+    private:
+        friend void flush_log_limits(bool elapsedOnly);
+
+        /**
+         * @brief Counters of one key.
+         */
+        struct slot
+        {
+            std::atomic<uint64_t> key{0};           ///< Key of the slot, 0 while free.
+            std::atomic<int64_t> last{0};           ///< Steady time of the last logged occurrence, 0 if none.
+            std::atomic<uint64_t> suppressed{0};    ///< Occurrences suppressed since then.
+            std::atomic<int64_t> lastSuppressed{0}; ///< Steady time of the last suppressed occurrence.
+        };
+
+        slot& find(uint64_t key);
+
+        const char* file_ = nullptr;          ///< Source file of the call site, nullptr if never flushed.
+        unsigned int line_ = 0;               ///< Source line of the call site.
+        std::atomic<bool> registered_{false}; ///< Whether the limiter joined the flush list.
+        LogLimiter* next_ = nullptr;          ///< Next limiter of the flush list, set before joining.
+        slot slots_[SLOTS];
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        inline uint64_t key_part(const T& part)
+        {
+            if constexpr (std::is_convertible_v<const T&, std::string_view> && !std::is_pointer_v<std::decay_t<T>>)
+            {
+                return std::hash<std::string_view>()(std::string_view(part));
+            }
+            else if constexpr (std::is_pointer_v<std::decay_t<T>>)
+            {
+                // Static strings such as op_error::message compare by address
+                return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(part));
+            }
+            else
+            {
+                return static_cast<uint64_t>(part);
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Combines numbers, enums, static string pointers and strings into a key for LogLimiter::admit().
+     */
+    template <typename... Parts>
+    inline uint64_t log_key(const Parts&... parts)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        ((hash = (hash ^ detail::key_part(parts)) * 1099511628211ull), ...);
+        return hash;
+    }
+} // namespace ddbg
+
+/// The LogLimiter of the enclosing call site.
+#define DD_LIMITER() ([]() -> ddbg::LogLimiter& {                                                                     \
+    static ddbg::LogLimiter limiter(__FILE__, __LINE__);                                                               \
+    return limiter;                                                                                                    \
+}())
+
+/// Runs the statement that follows only if @p key is admitted at this call site; @p repeated names a uint64_t
+/// holding the occurrences suppressed before it.
+#define DD_LIMITED(key, repeated)                                                                                      \
+    if (uint64_t repeated = 0; !DD_LIMITER().admit((key), repeated)) {}                                               \
+    else
+
+/// Error logging with timestamp, limited per call site and @p key.
+#define derror1_limited(key, msg, ...)                                                                                 \
+    DD_IF_ENABLED(DD_LEVEL_ERROR)                                                                                      \
+    DD_LIMITED(key, ddRepeated_) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR.DD_LEV1.repeated(ddRepeated_)
+
+#endif // __CORE_MQTT_LOG_LIMITER__
@@ -12,19 +12,83 @@
  * detail levels and message types (DEBUG, INFO, ERROR). The logging output is
  * written to stderr.
  *
+ * Each macro expands to a statement guarded by two thresholds. Levels above DD_COMPILE_LEVEL are
+ * removed at compile time; levels above the runtime level (set_log_level()) are skipped with one
+ * relaxed atomic load. Either way the format arguments and the operands of the following
+ * operator<< chain are not evaluated.
+ *
+ * With start_async_logging() (see log_backend.hpp), print() hands the message to a background
+ * thread instead of formatting and writing it on the calling thread.
+ *
  * @author duyld15
  */
-
+#ifndef __CORE_MQTT_MONITOR__
+#define __CORE_MQTT_MONITOR__
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cstdarg>
+#include <atomic>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <chrono>
+#include <cstdio>
+#include "log_backend.hpp"
 
 using namespace std;
 
+/// Threshold that disables every level.
+#define DD_LEVEL_OFF -1
+/// Threshold of ERROR messages only.
+#define DD_LEVEL_ERROR 0
+/// Threshold of ERROR and INFO messages.
+#define DD_LEVEL_INFO 1
+/// Threshold of every message.
+#define DD_LEVEL_DEBUG 2
+
+/// Highest level compiled in; DEBUG by default, INFO with NDEBUG.
+#ifndef DD_COMPILE_LEVEL
+#ifdef NDEBUG
+#define DD_COMPILE_LEVEL DD_LEVEL_INFO
+#else
+#define DD_COMPILE_LEVEL DD_LEVEL_DEBUG
+#endif
+#endif
+
 namespace ddbg
 {
+    namespace detail
+    {
+        inline std::atomic<int> logLevel{DD_LEVEL_DEBUG}; ///< Runtime threshold, see set_log_level().
+    } // namespace detail
+
+    /**
+     * @brief Sets the highest level printed at runtime, one of the DD_LEVEL_* values.
+     *
+     * Levels removed by DD_COMPILE_LEVEL stay removed whatever the runtime level.
+     */
+    inline void set_log_level(int level)
+    {
+        detail::logLevel.store(level, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the runtime level, DD_LEVEL_DEBUG unless set_log_level() changed it.
+     */
+    inline int get_log_level()
+    {
+        return detail::logLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks @p level against the runtime level only; see DD_LOG_ENABLED for both thresholds.
+     */
+    inline bool log_enabled(int level)
+    {
+        return level <= detail::logLevel.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief Empty structure used as a log output terminator.
      */
@@ -47,12 +111,20 @@ namespace ddbg
      */
     class Printer
     {
-        string message_;           ///< Accumulated log message.
-        string startcolor_;        ///< ANSI color code for starting the output.
-        const string finishcolor_; ///< ANSI code to reset the output formatting.
-        string modeprefix_;        ///< Prefix to denote the log message type (Error, Info, Debug).
-        string lineinfo_;          ///< Information about the file and line number.
-        string timestamp_;         ///< Timestamp for when the message was logged.
+        string message_;     ///< Accumulated log message.
+        int mode_;           ///< MessageMode selecting the color and prefix, -1 for none.
+        bool stamped_;       ///< Whether a timestamp line is printed.
+        int64_t when_;       ///< Time of the timestamp, in nanoseconds since the epoch.
+        const char* file_;   ///< Source file of the line information, nullptr for none.
+        unsigned int line_;  ///< Source line of the line information.
+        const char* func_;   ///< Source function of the line information.
+
+        static int64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
 
 
     public:
@@ -70,7 +142,8 @@ namespace ddbg
          * @brief Constructs a Printer with an initial message.
          * @param message The initial log message.
          */
-        explicit Printer(const string& message) : message_(message), finishcolor_("\033[0m")
+        explicit Printer(const string& message)
+            : message_(message), mode_(-1), stamped_(false), when_(0), file_(nullptr), line_(0), func_(nullptr)
         {}
 
         /**
@@ -88,24 +161,30 @@ namespace ddbg
             va_list args;
             va_start(args, msg);
 
-            // Determine the size of the formatted string
+            // Format into a stack buffer, which holds most messages in a single pass
+            char small[256];
             va_list argsCopy;
             va_copy(argsCopy, args);
-            int size = vsnprintf(nullptr, 0, msg, argsCopy) + 1; // Include null terminator
+            int size = vsnprintf(small, sizeof(small), msg, argsCopy);
             va_end(argsCopy);
+            if (size < 0)
+            {
+                va_end(args);
+                return Printer(string());
+            }
+            if (static_cast<size_t>(size) < sizeof(small))
+            {
+                va_end(args);
+                return Printer(string(small, static_cast<size_t>(size)));
+            }
 
             // Allocate a buffer to hold the formatted string
-            std::vector<char> buffer(size);
-
-            // Format the string
-            vsnprintf(buffer.data(), size, msg, args);
+            std::vector<char> buffer(static_cast<size_t>(size) + 1); // Include null terminator
+            vsnprintf(buffer.data(), buffer.size(), msg, args);
 
             // Clean up the variable argument list
             va_end(args);
-
-            // Return the formatted string
-            auto mes = std::string(buffer.data());
-            return Printer(mes);
+            return Printer(string(buffer.data(), static_cast<size_t>(size)));
         }
 
         /**
@@ -118,63 +197,40 @@ namespace ddbg
          */
         Printer& type(MessageMode mesmode)
         {
-            switch (mesmode)
-            {
-            case MessageMode::ERROR:
-            {
-                modeprefix_ = string("Error: ");
-                startcolor_ = "\033[31m";
-            }
-            break;
-            case MessageMode::INFO:
-            {
-                modeprefix_ = string("Info: ");
-                startcolor_ = "\033[32m";
-            }
-            break;
-            case MessageMode::DEBUG:
-            {
-                modeprefix_ = string("Debug: ");
-                startcolor_ = "\033[34m";
-            }
-            break;
-            default:
-                break;
-            }
+            mode_ = mesmode;
             return *this;
         }
 
         /**
          * @brief Appends a timestamp to the log message.
          *
-         * Formats the current time and adds it to the log output.
+         * Records the current time; it is formatted when the message is printed.
          *
          * @return A reference to the modified Printer object.
          */
         Printer& timestamp()
         {
-            time_t now = time(nullptr);
-            struct tm* timeinfo = localtime(&now);
-            string timestamp = asctime(timeinfo);
-            timestamp.pop_back(); // Remove newline character
-            timestamp_ = "[" + timestamp + "]\n";
+            stamped_ = true;
+            when_ = now();
             return *this;
         }
 
         /**
          * @brief Adds file and line information to the log message.
          *
-         * Formats the file name and line number where the log message was generated.
+         * The location is formatted when the message is printed, so @p file and @p func must have static
+         * storage duration, like `__FILE__` and `__FUNCTION__`.
          *
          * @param file The source file name.
          * @param line The line number in the source file.
+         * @param func The function name.
          * @return A reference to the modified Printer object.
          */
         Printer& lineinfo(const char* file, unsigned int line, const char* func)
         {
-            stringstream ss;
-            ss << "at " << file << ":" << line << " - " << func;
-            lineinfo_ = "(" + ss.str() + ")\n";
+            file_ = file;
+            line_ = line;
+            func_ = func;
             return *this;
         }
 
@@ -202,6 +258,21 @@ namespace ddbg
             return *this;
         }
 
+        /**
+         * @brief Prefixes the message with the number of identical messages suppressed before it, if any.
+         *
+         * @param times Suppressed occurrences, see log_limiter.hpp.
+         * @return A reference to the modified Printer object.
+         */
+        Printer& repeated(uint64_t times)
+        {
+            if (times > 0)
+            {
+                message_.insert(0, "[repeated " + std::to_string(times) + " times] ");
+            }
+            return *this;
+        }
+
         /**
          * @brief Appends a newline to the log message.
          *
@@ -216,7 +287,7 @@ namespace ddbg
         /**
          * @brief Overloaded operator to append data to the log message.
          *
-         * Uses a stringstream to convert data to string and appends it to the log message.
+         * Strings and characters are appended as they are; other types go through a stringstream.
          *
          * @tparam T The type of data to append.
          * @param data The data to append.
@@ -225,9 +296,32 @@ namespace ddbg
         template <typename T>
         Printer& operator<<(T&& data)
         {
-            stringstream ss;
-            ss << data;
-            message_.append(ss.str());
+            using type = std::decay_t<T>;
+            if constexpr (std::is_array_v<std::remove_reference_t<T>>)
+            {
+                message_.append(std::string_view(data));
+            }
+            else if constexpr (std::is_same_v<type, const char*> || std::is_same_v<type, char*>)
+            {
+                if (data)
+                {
+                    message_.append(data);
+                }
+            }
+            else if constexpr (std::is_convertible_v<const type&, std::string_view>)
+            {
+                message_.append(std::string_view(data));
+            }
+            else if constexpr (std::is_same_v<type, char>)
+            {
+                message_.push_back(data);
+            }
+            else
+            {
+                stringstream ss;
+                ss << data;
+                message_.append(ss.str());
+            }
             return *this;
         }
 
@@ -261,23 +355,51 @@ namespace ddbg
          */
         void operator<<(std::ostream& (*manip)(std::ostream&))
         {
+            if (async_logging_enabled())
+            {
+                // The manipulator's output (e.g. std::endl's newline) travels with the message
+                if (manip == static_cast<std::ostream& (*)(std::ostream&)>(std::endl))
+                {
+                    message_.push_back('\n');
+                }
+                else
+                {
+                    ostringstream tail;
+                    manip(tail);
+                    message_.append(tail.str());
+                }
+                this->print();
+                return;
+            }
             this->print();
             manip(std::cerr);
         }
 
         /**
          * @brief Prints the accumulated log message to stderr with formatting.
+         *
+         * While the asynchronous backend runs, the message is queued to it instead and dropped if the
+         * calling thread's ring is full. A message the backend refuses because it stopped meanwhile is
+         * printed here.
          */
         void print()
         {
-            fprintf(stderr,
-                    "\n%s%s%s%s%s%s",
-                    startcolor_.c_str(),
-                    timestamp_.c_str(),
-                    lineinfo_.c_str(),
-                    modeprefix_.c_str(),
-                    message_.c_str(),
-                    finishcolor_.c_str());
+            log_entry entry{mode_, stamped_, stamped_ ? when_ : 0, file_, line_, func_, message_};
+            if (async_logging_enabled())
+            {
+                if (!stamped_)
+                {
+                    // Still needed to order the entries of different threads
+                    entry.when = now();
+                }
+                if (submit_log_entry(entry) || async_logging_enabled())
+                {
+                    return;
+                }
+            }
+            string out;
+            append_log_entry(out, entry);
+            fwrite(out.data(), 1, out.size(), stderr);
         }
     };
 
@@ -304,31 +426,40 @@ namespace ddbg
 /// Macro to set the message type to INFO.
 #define DD_INFO type(DD_PRINTER::MessageMode::INFO)
 
-#ifndef NDEBUG
+static_assert(DD_LEVEL_ERROR == ddbg::Printer::ERROR && DD_LEVEL_INFO == ddbg::Printer::INFO &&
+                  DD_LEVEL_DEBUG == ddbg::Printer::DEBUG,
+              "DD_LEVEL_* must match ddbg::Printer::MessageMode");
+
+/// Checks both thresholds of @p level; a constant false above DD_COMPILE_LEVEL.
+#define DD_LOG_ENABLED(level) ((level) <= DD_COMPILE_LEVEL && ddbg::log_enabled(level))
+
+/// Runs the statement that follows only if @p level is enabled. The else chain keeps it a single statement.
+#define DD_IF_ENABLED(level)                                                                                           \
+    if constexpr ((level) > DD_COMPILE_LEVEL) {}                                                                       \
+    else if (!ddbg::log_enabled(level)) {}                                                                             \
+    else
+
 /// Macro for debug-level logging.
-#define ddebug(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG
+#define ddebug(msg, ...) DD_IF_ENABLED(DD_LEVEL_DEBUG) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG
 /// Macro for debug-level logging with timestamp.
-#define ddebug1(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG.DD_LEV1
+#define ddebug1(msg, ...) DD_IF_ENABLED(DD_LEVEL_DEBUG) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG.DD_LEV1
 /// Macro for debug-level logging with timestamp and line info.
-#define ddebug2(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG.DD_LEV2
-#else
-#define ddebug(msg, ...) DD_PRINTER::format("[MDEBUG]")
-#define ddebug1(msg, ...) DD_PRINTER::format("[MDEBUG]")
-#define ddebug2(msg, ...) DD_PRINTER::format("[MDEBUG2]")
-#endif
+#define ddebug2(msg, ...) DD_IF_ENABLED(DD_LEVEL_DEBUG) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_DEBUG.DD_LEV2
 
 /// Macro for informational logging.
-#define dinfo(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO
+#define dinfo(msg, ...) DD_IF_ENABLED(DD_LEVEL_INFO) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO
 /// Macro for informational logging with timestamp.
-#define dinfo1(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO.DD_LEV1
+#define dinfo1(msg, ...) DD_IF_ENABLED(DD_LEVEL_INFO) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO.DD_LEV1
 /// Macro for informational logging with timestamp and line info.
-#define dinfo2(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO.DD_LEV2
+#define dinfo2(msg, ...) DD_IF_ENABLED(DD_LEVEL_INFO) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_INFO.DD_LEV2
 
 /// Macro for error logging.
-#define derror(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR
+#define derror(msg, ...) DD_IF_ENABLED(DD_LEVEL_ERROR) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR
 /// Macro for error logging with timestamp.
-#define derror1(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR.DD_LEV1
+#define derror1(msg, ...) DD_IF_ENABLED(DD_LEVEL_ERROR) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR.DD_LEV1
 /// Macro for error logging with timestamp and line info.
-#define derror2(msg, ...) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR.DD_LEV2
+#define derror2(msg, ...) DD_IF_ENABLED(DD_LEVEL_ERROR) DD_PRINTER::format(msg, ##__VA_ARGS__).DD_ERROR.DD_LEV2
+
+} // namespace ddbg
 
-} // namespace ddbg
\ No newline at end of file
+#endif // __CORE_MQTT_MONITOR__
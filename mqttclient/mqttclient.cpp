@@ -1,6 +1,11 @@
 #include "mqttclient.hpp"
 #include "monitor.hpp"
+#include "binary_log.hpp"
+#include "log_limiter.hpp"
+#include <algorithm>
 #include <sstream>
+#include <thread>
+#include <cstdint>
 
 using namespace mqtt;
 
@@ -8,7 +13,7 @@ namespace mqttcpp
 {
     std::unique_ptr<MqttClient> MqttClient::Instance{nullptr};
 
-    static std::string mqttEventToString(CallbackEvent event)
+    static const char* mqttEventToString(CallbackEvent event)
     {
         switch (event)
         {
@@ -33,6 +38,25 @@ namespace mqttcpp
         }
     }
 
+    static const char* completionLabel(mqtt::token::Type type, bool success)
+    {
+        switch (type)
+        {
+        case mqtt::token::CONNECT:
+            return success ? "connect done" : "connect failed";
+        case mqtt::token::SUBSCRIBE:
+            return success ? "subscribe done" : "subscribe failed";
+        case mqtt::token::PUBLISH:
+            return success ? "publish done" : "publish failed";
+        case mqtt::token::UNSUBSCRIBE:
+            return success ? "unsubscribe done" : "unsubscribe failed";
+        case mqtt::token::DISCONNECT:
+            return success ? "disconnect done" : "disconnect failed";
+        default:
+            return success ? "action done" : "action failed";
+        }
+    }
+
     DefaultActionListener::DefaultActionListener(MqttClient* parent) : parent_(parent)
     {}
 
@@ -40,12 +64,12 @@ namespace mqttcpp
     {
         if (parent_)
         {
-            parent_->self_handle_callback_event(CallbackEvent::EVENT_ACTION_FAILURE,
-                                                mqtt::token::create(tok.get_type(),
-                                                                    *tok.get_client(),
-                                                                    tok.get_topics(),
-                                                                    tok.get_user_context(),
-                                                                    *tok.get_action_callback()));
+            uint64_t latency = 0;
+            if (tok.get_type() == mqtt::token::PUBLISH)
+            {
+                latency = parent_->on_publish_complete(tok);
+            }
+            parent_->report_completion(tok, false, latency);
         }
     }
 
@@ -53,84 +77,251 @@ namespace mqttcpp
     {
         if (parent_)
         {
-            parent_->self_handle_callback_event(CallbackEvent::EVENT_ACTION_SUCCESS,
-                                                token::create(tok.get_type(),
-                                                              *tok.get_client(),
-                                                              tok.get_topics(),
-                                                              tok.get_user_context(),
-                                                              *tok.get_action_callback()));
+            uint64_t latency = 0;
+            if (tok.get_type() == mqtt::token::PUBLISH)
+            {
+                latency = parent_->on_publish_complete(tok);
+            }
+            else if (tok.get_type() == mqtt::token::CONNECT)
+            {
+                parent_->on_connect_complete(tok);
+            }
+            parent_->report_completion(tok, true, latency);
         }
     }
 
-    bool MqttClient::common_try(std::function<void()> fn, const char* fnId)
+    BatchToken::BatchToken(std::size_t size) : parent_(nullptr), size_(size), pending_(size)
+    {}
+
+    void BatchToken::retain_until_complete(std::shared_ptr<BatchToken> self)
     {
-        try
+        lg lock(guard_);
+        if (pending_ > 0)
         {
-            fn();
-            if (excPtr_)
+            self_ = std::move(self);
+        }
+    }
+
+    void BatchToken::complete_one(publish_failure* failure)
+    {
+        std::shared_ptr<BatchToken> keepAlive;
+        {
+            lg lock(guard_);
+            if (failure)
             {
-                *excPtr_ = ExceptionTrace();
+                failures_.push_back(std::move(*failure));
             }
+            if (pending_ > 0 && --pending_ == 0)
+            {
+                keepAlive = std::move(self_);
+                cv_.notify_all();
+            }
+        }
+    }
+
+    void BatchToken::on_failure(const mqtt::token& tok)
+    {
+        if (parent_)
+        {
+            parent_->on_publish_complete(tok);
+            parent_->record_completion(tok, false);
+        }
+        publish_failure failure{reinterpret_cast<std::uintptr_t>(tok.get_user_context()),
+                                tok.get_return_code(),
+                                static_cast<int>(tok.get_reason_code()),
+                                tok.get_error_message()};
+        complete_one(&failure);
+    }
+
+    void BatchToken::on_success(const mqtt::token& tok)
+    {
+        if (parent_)
+        {
+            parent_->on_publish_complete(tok);
+            parent_->record_completion(tok, true);
+        }
+        complete_one(nullptr);
+    }
+
+    PublishWaiter::PublishWaiter(MqttClient* parent) : parent_(parent), done_(false)
+    {}
+
+    void PublishWaiter::retain_until_complete(std::shared_ptr<PublishWaiter> self)
+    {
+        lg lock(guard_);
+        if (!done_)
+        {
+            self_ = std::move(self);
+        }
+    }
+
+    void PublishWaiter::complete()
+    {
+        std::shared_ptr<PublishWaiter> keepAlive;
+        {
+            lg lock(guard_);
+            done_ = true;
+            keepAlive = std::move(self_);
+            cv_.notify_all();
+        }
+    }
+
+    void PublishWaiter::on_failure(const mqtt::token& tok)
+    {
+        parent_->report_completion(tok, false, parent_->on_publish_complete(tok));
+        complete();
+    }
+
+    void PublishWaiter::on_success(const mqtt::token& tok)
+    {
+        parent_->report_completion(tok, true, parent_->on_publish_complete(tok));
+        complete();
+    }
+
+    bool PublishWaiter::wait_for(unsigned int wait_for)
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        if (wait_for == 0)
+        {
+            cv_.wait(lock, [this] { return done_; });
             return true;
         }
-        catch (const mqtt::exception& exc)
+        return cv_.wait_for(lock, std::chrono::milliseconds(wait_for), [this] { return done_; });
+    }
+
+    bool BatchToken::is_complete() const
+    {
+        lg lock(guard_);
+        return pending_ == 0;
+    }
+
+    void BatchToken::wait()
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    bool BatchToken::wait_for(unsigned int wait_for)
+    {
+        if (wait_for == 0)
         {
-            derror1("[MqttClient] %s error: ", fnId) << exc.what() << std::endl;
+            wait();
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(guard_);
+        return cv_.wait_for(lock, std::chrono::milliseconds(wait_for), [this] { return pending_ == 0; });
+    }
+
+    std::size_t BatchToken::failed() const
+    {
+        lg lock(guard_);
+        return failures_.size();
+    }
+
+    std::vector<publish_failure> BatchToken::get_failures() const
+    {
+        lg lock(guard_);
+        return failures_;
+    }
+
+    bool MqttClient::report_result(const op_result& result, const char* fnId, const mqtt::exception* exc)
+    {
+        const op_error& error = result.error();
+        switch (error.type)
+        {
+        case ExceptionType::NONE:
             if (excPtr_)
             {
-                *excPtr_ = ExceptionTrace(exc);
+                *excPtr_ = ExceptionTrace();
             }
-        }
-        catch (const std::exception& exc)
-        {
-            derror1("[MqttClient] %s error: Standard exception\n", fnId).print();
+            return true;
+        case ExceptionType::MQTT:
+            // Repeated failures, e.g. every publish while the broker is gone, are summarized per interval
+            recorder_.record(fnId, 0, 0, error.returnCode, error.reasonCode);
+            derror1_limited(ddbg::log_key(fnId, error.returnCode, error.reasonCode, error.message),
+                            "[MqttClient] %s error: %s (rc=%d, reason=%d)\n",
+                            fnId,
+                            exc ? exc->what() : result.message(),
+                            error.returnCode,
+                            error.reasonCode)
+                .print();
+            if (excPtr_ && exc)
+            {
+                // paho's own exception, with its text
+                *excPtr_ = ExceptionTrace(*exc);
+            }
+            else if (excPtr_)
+            {
+                *excPtr_ = ExceptionTrace(
+                    mqtt::exception(error.returnCode, static_cast<mqtt::ReasonCode>(error.reasonCode), error.message));
+            }
+            break;
+        case ExceptionType::STANDARD:
+            recorder_.record(fnId, 0, 0, MQTTASYNC_FAILURE);
+            derror1_limited(ddbg::log_key(fnId, error.type), "[MqttClient] %s error: Standard exception\n", fnId)
+                .print();
             if (excPtr_)
             {
-                *excPtr_ = ExceptionTrace(exc);
+                *excPtr_ = ExceptionTrace(std::exception());
             }
-        }
-        catch (...)
-        {
-            derror1("[MqttClient] %s error: Unknown exception\n", fnId).print();
+            break;
+        case ExceptionType::UNKNOWN:
+        default:
+            recorder_.record(fnId, 0, 0, MQTTASYNC_FAILURE);
+            derror1_limited(ddbg::log_key(fnId, error.type), "[MqttClient] %s error: Unknown exception\n", fnId)
+                .print();
             if (excPtr_)
             {
                 char buffer[100];
                 sprintf(buffer, "Unknown exception from excuting \"%s\"\n", fnId);
                 *excPtr_ = ExceptionTrace(buffer);
             }
+            break;
         }
         return false;
     }
 
     void MqttClient::self_handle_callback_event(CallbackEvent event, CallbackVariant info)
     {
-        dinfo2("[MqttClient] Event ") << mqttEventToString(event) << std::endl;
+        const char* eventName = mqttEventToString(event);
+        if (event == CallbackEvent::EVENT_MESSAGE_ARRIVED && info.asMessage())
+        {
+            recorder_.record(eventName, FlightRecorder::topic_hash(info.asMessage()->get_topic()));
+        }
+        else
+        {
+            recorder_.record(eventName);
+        }
+        dinfo2("[MqttClient] Event ") << eventName << std::endl;
         switch (event)
         {
         case CallbackEvent::EVENT_CONNECTED:
-        {
-            std::ostringstream oss;
-            oss << "Connected to broker." << std::endl;
-            if (!info.asString().empty())
+            // The texts are only built when INFO messages are printed
+            if (DD_LOG_ENABLED(DD_LEVEL_INFO))
             {
-                oss << " Cause: " << info.asString();
+                std::ostringstream oss;
+                oss << "Connected to broker." << std::endl;
+                if (!info.asString().empty())
+                {
+                    oss << " Cause: " << info.asString();
+                }
+                dinfo1(oss.str().c_str()) << std::endl;
             }
-            dinfo1(oss.str().c_str()) << std::endl;
-        }
-        break;
+            break;
         case CallbackEvent::EVENT_DISCONNECTED:
-        {
-            std::ostringstream oss;
-            oss << "Disconnected from broker.";
-            disconnect_data disconnData = info.asDisconnectData();
-            if (!disconnData.props.empty())
+            if (DD_LOG_ENABLED(DD_LEVEL_INFO))
             {
-                oss << " ReasonString: " << get<string>(disconnData.props, property::REASON_STRING)
-                    << ", ReasonCode: " << disconnData.reason;
+                std::ostringstream oss;
+                oss << "Disconnected from broker.";
+                disconnect_data disconnData = info.asDisconnectData();
+                if (!disconnData.props.empty())
+                {
+                    oss << " ReasonString: " << get<string>(disconnData.props, property::REASON_STRING)
+                        << ", ReasonCode: " << disconnData.reason;
+                }
+                dinfo1(oss.str().c_str()) << std::endl;
             }
-            dinfo1(oss.str().c_str()) << std::endl;
-        }
-        break;
+            break;
         case CallbackEvent::EVENT_CONNECTION_UPDATE:
         {
             auto* data = &info.asConnectData();
@@ -140,25 +331,26 @@ namespace mqttcpp
         }
         break;
         case CallbackEvent::EVENT_CONNECTION_LOST:
-        {
-            std::ostringstream oss;
-            oss << "Connection lost.";
-            if (!info.asString().empty())
+            if (DD_LOG_ENABLED(DD_LEVEL_INFO))
             {
-                oss << " Cause: " << info.asString();
+                std::ostringstream oss;
+                oss << "Connection lost.";
+                if (!info.asString().empty())
+                {
+                    oss << " Cause: " << info.asString();
+                }
+                dinfo1(oss.str().c_str()) << std::endl;
             }
-            dinfo1(oss.str().c_str()) << std::endl;
-        }
-        break;
+            break;
         case CallbackEvent::EVENT_MESSAGE_ARRIVED:
         {
             mqtt::const_message_ptr msg = info.asMessage();
             if (msg)
             {
-                std::ostringstream oss;
-                oss << "Topic: " << msg->get_topic() << ", Payload: " << msg->to_string()
-                    << ", Retained: " << (msg->is_retained() ? "true" : "false");
-                dinfo1("Message arrived: ") << oss.str() << std::endl;
+                dbinfo("Message arrived: topic %s, %zu bytes, qos %d, retained %d", msg->get_topic(),
+                       msg->get_payload().size(), msg->get_qos(), msg->is_retained());
+                dinfo1("Message arrived: ") << "Topic: " << msg->get_topic() << ", Payload: " << msg->to_string()
+                                            << ", Retained: " << (msg->is_retained() ? "true" : "false") << std::endl;
             }
         }
         break;
@@ -172,10 +364,7 @@ namespace mqttcpp
 
                 if (ptok->get_type() == mqtt::token::DISCONNECT)
                 {
-                    mqtt::properties props;
-                    props.add({mqtt::property::REASON_STRING, "User has manually disconnected to brocker"});
-                    this->self_handle_callback_event(CallbackEvent::EVENT_DISCONNECTED,
-                                                     disconnect_data{props, mqtt::ReasonCode::NORMAL_DISCONNECTION});
+                    report_manual_disconnect();
                 }
             }
         }
@@ -206,13 +395,10 @@ namespace mqttcpp
         : pubListener_(new DefaultActionListener(this)), subListener_(new DefaultActionListener(this)),
           unsubListener_(new DefaultActionListener(this)), connListener_(new DefaultActionListener(this)),
           disconnListener_(new DefaultActionListener(this)), consumeFlag_(false), client_(serverAddress, clientId),
-          excPtr_(new ExceptionTrace())
+          excPtr_(new ExceptionTrace()), completionMode_(CompletionMode::RECORDS)
     {
-        connOpts_.set_keep_alive_interval(60);
-        connOpts_.set_clean_session(true);
-        connOpts_.set_automatic_reconnect(true);
-        connOpts_.set_connect_timeout(10);
-
+        connOpts_ = default_connect_options();
+        recorder_.set_name(clientId);
         set_default_handler();
     }
 
@@ -222,8 +408,10 @@ namespace mqttcpp
         : connOpts_(connectOptions), pubListener_(new DefaultActionListener(this)),
           subListener_(new DefaultActionListener(this)), unsubListener_(new DefaultActionListener(this)),
           connListener_(new DefaultActionListener(this)), disconnListener_(new DefaultActionListener(this)),
-          consumeFlag_(false), client_(serverAddress, clientId), excPtr_(new ExceptionTrace())
+          consumeFlag_(false), client_(serverAddress, clientId), excPtr_(new ExceptionTrace()),
+          completionMode_(CompletionMode::RECORDS)
     {
+        recorder_.set_name(clientId);
         set_default_handler();
     }
 
@@ -234,13 +422,22 @@ namespace mqttcpp
         : connOpts_(connectOptions), pubListener_(new DefaultActionListener(this)),
           subListener_(new DefaultActionListener(this)), unsubListener_(new DefaultActionListener(this)),
           connListener_(new DefaultActionListener(this)), disconnListener_(new DefaultActionListener(this)),
-          consumeFlag_(false), client_(serverAddress, clientId, createOptions, nullptr), excPtr_(new ExceptionTrace())
+          consumeFlag_(false), client_(serverAddress, clientId, createOptions, nullptr), excPtr_(new ExceptionTrace()),
+          completionMode_(CompletionMode::RECORDS)
     {
+        recorder_.set_name(clientId);
         set_default_handler();
     }
 
     MqttClient::~MqttClient()
     {
+        // Once no callback holds a copy of the executor, dropping ours runs the queued messages and joins the workers
+        closing_.store(true);
+        while (messageCallbacks_.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+        set_handler_workers(handler_executor_options());
         consume_message(false);
     }
 
@@ -249,18 +446,39 @@ namespace mqttcpp
         connOpts_ = opts;
     }
 
+    mqtt::connect_options MqttClient::default_connect_options()
+    {
+        mqtt::connect_options opts;
+        opts.set_keep_alive_interval(60);
+        opts.set_clean_session(true);
+        opts.set_automatic_reconnect(true);
+        opts.set_connect_timeout(10);
+        return opts;
+    }
+
     void MqttClient::set_event_handler(std::function<void(CallbackEvent, CallbackVariant)> handler)
     {
         exteventHandler_ = handler;
     }
 
+    mqtt::token_ptr MqttClient::start_connect(mqtt::iaction_listener& listener)
+    {
+        dinfo1("[MqttClient] Connecting to broker...\n").print();
+        recorder_.record("connect");
+        return client_.connect(connOpts_, nullptr, listener);
+    }
+
+    op_result MqttClient::try_connect(mqtt::token_ptr& token)
+    {
+        return run_operation([this, &token]() {
+            token = start_connect(*connListener_);
+            return op_result();
+        });
+    }
+
     bool MqttClient::connect(mqtt::token_ptr& token)
     {
-        std::function<void()> fn = [this, &token]() mutable {
-            dinfo1("[MqttClient] Connecting to broker...\n").print();
-            token = client_.connect(connOpts_, nullptr, *connListener_);
-        };
-        return common_try(fn, "Connect");
+        return common_try([this, &token]() { token = start_connect(*connListener_); }, "Connect");
     }
 
     bool MqttClient::connect(bool wait, unsigned int wait_for)
@@ -274,13 +492,24 @@ namespace mqttcpp
         return res;
     }
 
+    mqtt::token_ptr MqttClient::start_disconnect(mqtt::iaction_listener& listener)
+    {
+        dinfo1("[MqttClient] Disconnecting...") << std::endl;
+        recorder_.record("disconnect");
+        return client_.disconnect(10000, nullptr, listener);
+    }
+
+    op_result MqttClient::try_disconnect(mqtt::token_ptr& token)
+    {
+        return run_operation([this, &token]() {
+            token = start_disconnect(*disconnListener_);
+            return op_result();
+        });
+    }
+
     bool MqttClient::disconnect(mqtt::token_ptr& token)
     {
-        std::function<void()> fn = [this, &token]() mutable {
-            dinfo1("[MqttClient] Disconnecting...") << std::endl;
-            token = client_.disconnect(10000, nullptr, *disconnListener_);
-        };
-        return common_try(fn, "Disconnect");
+        return common_try([this, &token]() { token = start_disconnect(*disconnListener_); }, "Disconnect");
     }
 
     bool MqttClient::disconnect(bool wait, unsigned int wait_for)
@@ -294,17 +523,31 @@ namespace mqttcpp
         return res;
     }
 
+    mqtt::token_ptr MqttClient::start_subscribe(const std::string& topic,
+                                                unsigned int qos,
+                                                mqtt::iaction_listener& listener)
+    {
+        dinfo1("[MqttClient] Subscribing to '") << topic << "' with QOS=" << qos << "..." << std::endl;
+        recorder_.record("subscribe", FlightRecorder::topic_hash(topic));
+        return client_.subscribe(topic,
+                                 static_cast<int>(qos),
+                                 nullptr,
+                                 listener,
+                                 mqtt::subscribe_options(true, true, subscribe_options::DONT_SEND_RETAINED));
+    }
+
+    op_result MqttClient::try_subscribe(mqtt::token_ptr& token, const std::string& topic, unsigned int qos)
+    {
+        return run_operation([this, &token, &topic, qos]() {
+            token = start_subscribe(topic, qos, *subListener_);
+            return op_result();
+        });
+    }
+
     bool MqttClient::subscribe(mqtt::token_ptr& token, const std::string& topic, unsigned int qos)
     {
-        std::function<void()> fn = [this, &token, &topic, &qos]() mutable {
-            dinfo1("[MqttClient] Subscribing to '") << topic << "' with QOS=" << qos << "..." << std::endl;
-            token = client_.subscribe(topic,
-                                      qos,
-                                      nullptr,
-                                      *subListener_,
-                                      mqtt::subscribe_options(true, true, subscribe_options::DONT_SEND_RETAINED));
-        };
-        return common_try(fn, "Subscribe");
+        return common_try([this, &token, &topic, qos]() { token = start_subscribe(topic, qos, *subListener_); },
+                          "Subscribe");
     }
 
     bool MqttClient::subscribe(const std::string& topic, unsigned int qos, bool wait, unsigned int wait_for)
@@ -319,13 +562,25 @@ namespace mqttcpp
         return res;
     }
 
+    mqtt::token_ptr MqttClient::start_unsubscribe(const std::string& topic, mqtt::iaction_listener& listener)
+    {
+        dinfo1("[MqttClient] Unsubscribing from '") << topic << "'..." << std::endl;
+        recorder_.record("unsubscribe", FlightRecorder::topic_hash(topic));
+        return client_.unsubscribe(topic, nullptr, listener);
+    }
+
+    op_result MqttClient::try_unsubscribe(mqtt::token_ptr& token, const std::string& topic)
+    {
+        return run_operation([this, &token, &topic]() {
+            token = start_unsubscribe(topic, *unsubListener_);
+            return op_result();
+        });
+    }
+
     bool MqttClient::unsubscribe(mqtt::token_ptr& token, const std::string& topic)
     {
-        std::function<void()> fn = [this, &token, &topic]() mutable {
-            dinfo1("[MqttClient] Unsubscribing from '") << topic << "'..." << std::endl;
-            token = client_.unsubscribe(topic, nullptr, *unsubListener_);
-        };
-        return common_try(fn, "Unsubscribe");
+        return common_try([this, &token, &topic]() { token = start_unsubscribe(topic, *unsubListener_); },
+                          "Unsubscribe");
     }
 
     bool MqttClient::unsubscribe(const std::string& topic, bool wait, unsigned int wait_for)
@@ -339,17 +594,31 @@ namespace mqttcpp
         return res;
     }
 
+    op_result MqttClient::try_publish(mqtt::token_ptr& token,
+                                      const std::string& topic,
+                                      const std::string& payload,
+                                      unsigned int qos)
+    {
+        return run_operation([this, &token, &topic, &qos, &payload]() {
+            return start_publish(token, mqtt::make_message(topic, payload, static_cast<int>(qos), false));
+        });
+    }
+
+    op_result MqttClient::try_publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg)
+    {
+        return run_operation([this, &token, &msg]() { return start_publish(token, std::move(msg)); });
+    }
+
     bool MqttClient::publish(mqtt::token_ptr& token,
                              const std::string& topic,
                              const std::string& payload,
                              unsigned int qos)
     {
-        std::function<void()> fn = [this, &token, &topic, &qos, &payload]() mutable {
-            dinfo1("[MqttClient] Publishing to '") << topic << "': " << payload << std::endl;
-            mqtt::message_ptr pubmsg = mqtt::make_message(topic, payload, qos, false);
-            token = client_.publish(pubmsg, nullptr, *pubListener_);
-        };
-        return common_try(fn, "Publish");
+        return report_operation(
+            [this, &token, &topic, &qos, &payload]() {
+                return start_publish(token, mqtt::make_message(topic, payload, static_cast<int>(qos), false));
+            },
+            "Publish");
     }
 
     bool MqttClient::publish(const std::string& topic,
@@ -358,15 +627,514 @@ namespace mqttcpp
                              bool wait,
                              unsigned int wait_for)
     {
+        if (wait && may_defer(topic))
+        {
+            return publish_and_wait(mqtt::make_message(topic, payload, static_cast<int>(qos), false), wait_for);
+        }
         mqtt::token_ptr token;
         bool res = publish(token, topic, payload, qos);
-        if (res && wait)
+        if (res && wait && token)
+        {
+            make_wait(token, wait_for);
+        }
+        return res;
+    }
+
+    bool MqttClient::publish(mqtt::token_ptr& token,
+                             const std::string& topic,
+                             mqtt::binary_ref payload,
+                             unsigned int qos)
+    {
+        return report_operation(
+            [this, &token, &topic, &qos, &payload]() {
+                return start_publish(token,
+                                     mqtt::make_message(topic, std::move(payload), static_cast<int>(qos), false));
+            },
+            "Publish");
+    }
+
+    bool MqttClient::publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg)
+    {
+        return report_operation([this, &token, &msg]() { return start_publish(token, std::move(msg)); }, "Publish");
+    }
+
+    bool MqttClient::publish(mqtt::const_message_ptr msg, bool wait, unsigned int wait_for)
+    {
+        if (wait && may_defer(msg->get_topic()))
+        {
+            return publish_and_wait(std::move(msg), wait_for);
+        }
+        mqtt::token_ptr token;
+        bool res = publish(token, std::move(msg));
+        if (res && wait && token)
         {
             make_wait(token, wait_for);
         }
         return res;
     }
 
+    bool MqttClient::connect_async(completion_callback onComplete)
+    {
+        OperationListener* listener = opListeners_.acquire(this, std::move(onComplete));
+        bool res = common_try([this, listener]() { start_connect(*listener); }, "Connect");
+        if (!res)
+        {
+            opListeners_.release(listener);
+        }
+        return res;
+    }
+
+    bool MqttClient::disconnect_async(completion_callback onComplete)
+    {
+        OperationListener* listener = opListeners_.acquire(this, std::move(onComplete));
+        bool res = common_try([this, listener]() { start_disconnect(*listener); }, "Disconnect");
+        if (!res)
+        {
+            opListeners_.release(listener);
+        }
+        return res;
+    }
+
+    bool MqttClient::subscribe(completion_callback onComplete, const std::string& topic, unsigned int qos)
+    {
+        OperationListener* listener = opListeners_.acquire(this, std::move(onComplete));
+        bool res = common_try([this, listener, &topic, qos]() { start_subscribe(topic, qos, *listener); }, "Subscribe");
+        if (!res)
+        {
+            opListeners_.release(listener);
+        }
+        return res;
+    }
+
+    bool MqttClient::unsubscribe(completion_callback onComplete, const std::string& topic)
+    {
+        OperationListener* listener = opListeners_.acquire(this, std::move(onComplete));
+        bool res = common_try([this, listener, &topic]() { start_unsubscribe(topic, *listener); }, "Unsubscribe");
+        if (!res)
+        {
+            opListeners_.release(listener);
+        }
+        return res;
+    }
+
+    bool MqttClient::publish(completion_callback onComplete,
+                             const std::string& topic,
+                             const std::string& payload,
+                             unsigned int qos)
+    {
+        return publish(std::move(onComplete), mqtt::make_message(topic, payload, static_cast<int>(qos), false));
+    }
+
+    bool MqttClient::publish(completion_callback onComplete, mqtt::const_message_ptr msg)
+    {
+        OperationListener* listener = opListeners_.acquire(this, std::move(onComplete));
+        bool dropped = false;
+        bool res = report_operation(
+            [this, listener, &msg, &dropped]() {
+                mqtt::token_ptr token;
+                return submit_publish(token, msg, *listener, nullptr, dropped);
+            },
+            "Publish");
+        if (!res)
+        {
+            opListeners_.release(listener);
+        }
+        else if (dropped)
+        {
+            listener->dismiss(completion_record{
+                mqtt::token::PUBLISH, 0, nullptr, MQTTASYNC_FAILURE, mqtt::ReasonCode::QUOTA_EXCEEDED, 0});
+        }
+        return res;
+    }
+
+    bool MqttClient::publish_batch(batch_token_ptr& token, const std::vector<publish_request>& msgs)
+    {
+        return publish_batch(token, msgs, std::vector<std::size_t>());
+    }
+
+    bool MqttClient::publish_batch(batch_token_ptr& token,
+                                   const std::vector<publish_request>& msgs,
+                                   const std::vector<std::size_t>& indices)
+    {
+        token = std::make_shared<BatchToken>(msgs.size());
+        token->retain_until_complete(token);
+        bool allSubmitted = true;
+        auto fn = [this, &token, &msgs, &indices, &allSubmitted]() mutable {
+            dinfo1("[MqttClient] Publishing batch of %zu messages\n", msgs.size()).print();
+            BatchToken& batch = *token;
+            batch.parent_ = this;
+            for (std::size_t i = 0; i < msgs.size(); ++i)
+            {
+                const publish_request& req = msgs[i];
+                const std::size_t index = i < indices.size() ? indices[i] : i;
+                bool dropped = false;
+                op_result res = run_operation([this, &batch, &req, &dropped, index]() {
+                    mqtt::token_ptr msgToken;
+                    mqtt::message_ptr pubmsg =
+                        mqtt::make_message(req.topic, req.payload, static_cast<int>(req.qos), req.retained, req.props);
+                    return submit_publish(
+                        msgToken, pubmsg, batch, reinterpret_cast<void*>(static_cast<std::uintptr_t>(index)), dropped);
+                });
+                if (dropped)
+                {
+                    res = op_result::failure(MQTTASYNC_FAILURE,
+                                             mqtt::ReasonCode::QUOTA_EXCEEDED,
+                                             "Dropped by the publish rate limit");
+                }
+                if (!res)
+                {
+                    publish_failure failure{index, res.return_code(), res.reason_code(), res.message()};
+                    batch.complete_one(&failure);
+                    allSubmitted = false;
+                }
+            }
+            drain_publish_queue();
+        };
+        return common_try(fn, "Publish batch") && allSubmitted;
+    }
+
+    bool MqttClient::publish_batch(const std::vector<publish_request>& msgs, bool wait, unsigned int wait_for)
+    {
+        batch_token_ptr token;
+        bool res = publish_batch(token, msgs);
+        if (wait)
+        {
+            token->wait_for(wait_for);
+        }
+        return res;
+    }
+
+    op_result MqttClient::submit_publish(mqtt::token_ptr& token,
+                                         mqtt::const_message_ptr msg,
+                                         mqtt::iaction_listener& listener,
+                                         void* context,
+                                         bool& dropped)
+    {
+        dbinfo("Publish: topic %s, %zu bytes, qos %d", msg->get_topic(), msg->get_payload().size(), msg->get_qos());
+        recorder_.record("publish", FlightRecorder::topic_hash(msg->get_topic()));
+        token = nullptr;
+        switch (rateLimiter_.acquire(msg->get_topic()))
+        {
+        case RateLimiter::Decision::DROP:
+            ddebug1("[MqttClient] Rate limit dropped a message to '") << msg->get_topic() << "'" << std::endl;
+            dropped = true;
+            return op_result();
+        case RateLimiter::Decision::FAIL:
+            return op_result::failure(
+                MQTTASYNC_FAILURE, mqtt::ReasonCode::QUOTA_EXCEEDED, "Publish rate limit exceeded");
+        case RateLimiter::Decision::PASS:
+        default:
+            break;
+        }
+
+        queued_publish pub{msg, &listener, context};
+        if (conflator_.matches(msg->get_topic()))
+        {
+            queued_publish superseded;
+            if (conflator_.replace(pub, superseded))
+            {
+                report_superseded(superseded);
+                return op_result();
+            }
+            if (!client_.is_connected() || !pubWindow_.try_admit(msg))
+            {
+                if (conflator_.defer(std::move(pub), superseded))
+                {
+                    report_superseded(superseded);
+                }
+                return op_result();
+            }
+        }
+        else
+        {
+            switch (pubWindow_.admit(pub))
+            {
+            case PublishWindow::Admission::QUEUED:
+                drain_publish_queue();
+                return op_result();
+            case PublishWindow::Admission::REJECTED:
+                // The message never goes out, so it must not count against the rate limits
+                rateLimiter_.release(msg->get_topic());
+                return op_result::failure(MQTTASYNC_MAX_MESSAGES_INFLIGHT, 0, "Publish window is full");
+            case PublishWindow::Admission::ADMITTED:
+            default:
+                break;
+            }
+        }
+
+        try
+        {
+            token = send_publish(msg, context, listener);
+        }
+        catch (...)
+        {
+            if (msg->get_qos() > 0)
+            {
+                pubWindow_.release();
+            }
+            throw;
+        }
+        return op_result();
+    }
+
+    op_result MqttClient::start_publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg)
+    {
+        bool dropped = false;
+        return submit_publish(token, std::move(msg), *pubListener_, nullptr, dropped);
+    }
+
+    void MqttClient::drain_publish_queue()
+    {
+        queued_publish pub;
+        while (pubWindow_.take_ready(pub))
+        {
+            try
+            {
+                send_publish(pub.msg, pub.context, *pub.listener);
+            }
+            catch (const mqtt::exception& exc)
+            {
+                derror1_limited(ddbg::log_key(pub.msg->get_topic(), exc.get_return_code()),
+                                "[MqttClient] Queued publish to '")
+                    << pub.msg->get_topic() << "' failed: " << exc.what() << std::endl;
+                pubWindow_.release();
+                mqtt::token_ptr failed = mqtt::token::create(mqtt::token::PUBLISH,
+                                                             client_,
+                                                             mqtt::string_collection::create(pub.msg->get_topic()),
+                                                             pub.context,
+                                                             *pub.listener);
+                pub.listener->on_failure(*failed);
+            }
+        }
+
+        while (client_.is_connected() && conflator_.take(pub))
+        {
+            queued_publish superseded;
+            if (!pubWindow_.try_admit(pub.msg))
+            {
+                if (conflator_.restore(std::move(pub), superseded))
+                {
+                    report_superseded(superseded);
+                }
+                break;
+            }
+            try
+            {
+                send_publish(pub.msg, pub.context, *pub.listener);
+            }
+            catch (const mqtt::exception& exc)
+            {
+                derror1_limited(ddbg::log_key(pub.msg->get_topic(), exc.get_return_code()),
+                                "[MqttClient] Conflated publish to '")
+                    << pub.msg->get_topic() << "' failed: " << exc.what() << std::endl;
+                if (pub.msg->get_qos() > 0)
+                {
+                    pubWindow_.release();
+                }
+                if (conflator_.restore(std::move(pub), superseded))
+                {
+                    report_superseded(superseded);
+                }
+                break;
+            }
+        }
+    }
+
+    bool MqttClient::may_defer(const std::string& topic) const
+    {
+        return pubWindow_.get_options().mode == BackpressureMode::QUEUE || conflator_.matches(topic);
+    }
+
+    bool MqttClient::publish_and_wait(mqtt::const_message_ptr msg, unsigned int wait_for)
+    {
+        auto waiter = std::make_shared<PublishWaiter>(this);
+        waiter->retain_until_complete(waiter);
+        bool dropped = false;
+        bool res = report_operation(
+            [this, &msg, &waiter, &dropped]() {
+                mqtt::token_ptr token;
+                return submit_publish(token, std::move(msg), *waiter, nullptr, dropped);
+            },
+            "Publish");
+        if (!res || dropped)
+        {
+            // The waiter was never handed to a token or a queue
+            waiter->complete();
+        }
+        else
+        {
+            waiter->wait_for(wait_for);
+        }
+        return res;
+    }
+
+    void MqttClient::report_superseded(queued_publish& pub)
+    {
+        if (!pub.listener || pub.listener == pubListener_.get())
+        {
+            return;
+        }
+        if (auto* waiter = dynamic_cast<PublishWaiter*>(pub.listener))
+        {
+            // Like the default listener, a superseded value reports no completion of its own
+            waiter->complete();
+            return;
+        }
+        mqtt::token_ptr done = mqtt::token::create(mqtt::token::PUBLISH,
+                                                   client_,
+                                                   mqtt::string_collection::create(pub.msg->get_topic()),
+                                                   pub.context,
+                                                   *pub.listener);
+        pub.listener->on_success(*done);
+    }
+
+    uint64_t MqttClient::on_publish_complete(const mqtt::token& tok)
+    {
+        // Only real delivery tokens carry a message; synthesized failure tokens already gave their slot back
+        const auto* dtok = dynamic_cast<const mqtt::delivery_token*>(&tok);
+        if (!dtok || !dtok->get_message() || dtok->get_message()->get_qos() == 0)
+        {
+            return 0;
+        }
+        const bool success = tok.get_return_code() == MQTTASYNC_SUCCESS;
+        const uint64_t latency = sendTimes_.take_latency(dtok->get_message_id(), success);
+        if (congestion_.on_complete(latency, success))
+        {
+            pubWindow_.set_limit(congestion_.window());
+        }
+        pubWindow_.release();
+        drain_publish_queue();
+        return latency;
+    }
+
+    void MqttClient::on_connect_complete(const mqtt::token& tok)
+    {
+        // MQTT v5: a CONNACK without Receive Maximum means 65535
+        std::size_t receiveMaximum = 65535;
+        mqtt::connect_response rsp = tok.get_connect_response();
+        const mqtt::properties& props = rsp.get_properties();
+        if (props.contains(mqtt::property::RECEIVE_MAXIMUM))
+        {
+            receiveMaximum = mqtt::get<uint16_t>(props, mqtt::property::RECEIVE_MAXIMUM);
+        }
+        congestion_.set_receive_maximum(receiveMaximum);
+        if (congestion_.enabled())
+        {
+            pubWindow_.set_limit(congestion_.window());
+            drain_publish_queue();
+        }
+    }
+
+    void MqttClient::record_completion(const mqtt::token& tok, bool success)
+    {
+        mqtt::const_string_collection_ptr topics = tok.get_topics();
+        recorder_.record(completionLabel(tok.get_type(), success),
+                         topics && topics->size() > 0 ? FlightRecorder::topic_hash((*topics)[0]) : 0,
+                         tok.get_message_id(),
+                         tok.get_return_code(),
+                         static_cast<int>(tok.get_reason_code()));
+    }
+
+    void MqttClient::report_completion(const mqtt::token& tok, bool success, uint64_t latencyNanos)
+    {
+        record_completion(tok, success);
+
+        if (completionMode_.load(std::memory_order_relaxed) == CompletionMode::TOKEN_EVENTS)
+        {
+            self_handle_callback_event(
+                success ? CallbackEvent::EVENT_ACTION_SUCCESS : CallbackEvent::EVENT_ACTION_FAILURE,
+                mqtt::token::create(
+                    tok.get_type(), *tok.get_client(), tok.get_topics(), tok.get_user_context(), *tok.get_action_callback()));
+            return;
+        }
+
+        completion_record record{tok.get_type(),
+                                 tok.get_message_id(),
+                                 tok.get_user_context(),
+                                 tok.get_return_code(),
+                                 static_cast<int>(tok.get_reason_code()),
+                                 latencyNanos};
+        auto handler = std::atomic_load(&completionHandler_);
+        if (handler)
+        {
+            (*handler)(record);
+        }
+        else
+        {
+            completion_queue()->push(record);
+        }
+
+        if (success && tok.get_type() == mqtt::token::DISCONNECT)
+        {
+            report_manual_disconnect();
+        }
+    }
+
+    void MqttClient::report_manual_disconnect()
+    {
+        mqtt::properties props;
+        props.add({mqtt::property::REASON_STRING, "User has manually disconnected to brocker"});
+        self_handle_callback_event(CallbackEvent::EVENT_DISCONNECTED,
+                                   disconnect_data{props, mqtt::ReasonCode::NORMAL_DISCONNECTION});
+    }
+
+    void MqttClient::set_completion_handler(std::function<void(const completion_record&)> handler)
+    {
+        std::atomic_store(&completionHandler_,
+                          handler ? std::make_shared<const completion_handler>(std::move(handler))
+                                  : std::shared_ptr<const completion_handler>());
+    }
+
+    mqtt::delivery_token_ptr MqttClient::send_publish(const mqtt::const_message_ptr& msg,
+                                                      void* context,
+                                                      mqtt::iaction_listener& listener)
+    {
+        const auto sentAt = std::chrono::steady_clock::now();
+        mqtt::delivery_token_ptr token = client_.publish(msg, context, listener);
+        if (msg->get_qos() == 0)
+        {
+            return token;
+        }
+        // One stamp serves both the congestion controller and the record latency
+        if (congestion_.enabled() || completionMode_.load(std::memory_order_relaxed) == CompletionMode::RECORDS)
+        {
+            // A fast ack may already have completed on the callback thread without a latency; count it now
+            const uint64_t latency = sendTimes_.stamp(token->get_message_id(), sentAt);
+            if (latency > 0 && congestion_.on_complete(latency, true))
+            {
+                pubWindow_.set_limit(congestion_.window());
+            }
+        }
+        return token;
+    }
+
+    std::shared_ptr<CompletionQueue> MqttClient::completion_queue()
+    {
+        auto queue = std::atomic_load(&completions_);
+        if (!queue)
+        {
+            auto created = std::make_shared<CompletionQueue>();
+            queue = std::atomic_compare_exchange_strong(&completions_, &queue, created) ? created : queue;
+        }
+        return queue;
+    }
+
+    void MqttClient::set_congestion_control(const congestion_options& opts)
+    {
+        congestion_.configure(opts);
+        if (congestion_.enabled())
+        {
+            pubWindow_.set_limit(congestion_.window());
+            drain_publish_queue();
+        }
+    }
+
+    void MqttClient::set_publish_window(const publish_window_options& opts)
+    {
+        pubWindow_.set_options(opts);
+        drain_publish_queue();
+    }
+
     bool MqttClient::connected()
     {
         return client_.is_connected();
@@ -374,23 +1142,137 @@ namespace mqttcpp
 
     bool MqttClient::consume_message(bool allow)
     {
-        std::function<void()> fn = [this, &allow]() mutable {
+        auto fn = [this, &allow]() mutable {
+            lg lock(consumeGuard_);
+            std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+            if (allow && !queue)
             {
-                lg lock(consumeGuard_);
-                if (allow)
+                queue = std::make_shared<InboundQueue>(inboundOpts_);
+                if (queue->unspilled_shards() > 0)
                 {
-                    client_.start_consuming();
-                }
-                else
-                {
-                    client_.stop_consuming();
+                    derror1("[MqttClient] Cannot open ")
+                        << queue->unspilled_shards() << " inbound spill file(s) at '" << inboundOpts_.spillPath
+                        << "', their shards drop overflow instead" << std::endl;
                 }
+                std::atomic_store(&inbound_, queue);
+            }
+            if (queue)
+            {
+                // Closing drops the backlog and wakes consumers so that they return once saving stops
+                allow ? queue->open() : queue->close();
             }
             consumeFlag_.store(allow);
         };
-        ostringstream oss;
-        oss << "Turn " << (allow ? "on" : "off");
-        return common_try(fn, oss.str().c_str());
+        return common_try(fn, allow ? "Turn on" : "Turn off");
+    }
+
+    void MqttClient::save_message(const mqtt::const_message_ptr& msg)
+    {
+        if (!consumeFlag_.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        if (queue)
+        {
+            queue->push(msg);
+        }
+    }
+
+    bool MqttClient::set_inbound_queue(const inbound_queue_options& opts)
+    {
+        lg lock(consumeGuard_);
+        if (consumeFlag_.load())
+        {
+            return false;
+        }
+        auto queue = std::make_shared<InboundQueue>(opts);
+        if (queue->unspilled_shards() > 0)
+        {
+            derror1("[MqttClient] Cannot open ") << queue->unspilled_shards() << " inbound spill file(s) at '"
+                                                 << opts.spillPath << "', keeping the previous queue" << std::endl;
+            return false;
+        }
+        inboundOpts_ = opts;
+        // Consumers still inside a call keep their own reference; the previous queue goes with the last one
+        std::atomic_store(&inbound_, std::move(queue));
+        return true;
+    }
+
+    std::size_t MqttClient::inbound_shard_of(const std::string& topic) const
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue ? queue->shard_of(topic) : 0;
+    }
+
+    inbound_queue_stats MqttClient::get_inbound_stats() const
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue ? queue->get_stats() : inbound_queue_stats{};
+    }
+
+    TopicDispatcher::handler_id MqttClient::add_message_handler(const std::string& filter,
+                                                                TopicDispatcher::message_handler handler)
+    {
+        return dispatcher_.add(filter, std::move(handler));
+    }
+
+    bool MqttClient::remove_message_handler(TopicDispatcher::handler_id id)
+    {
+        return dispatcher_.remove(id);
+    }
+
+    void MqttClient::handle_message(const mqtt::const_message_ptr& msg)
+    {
+        dispatcher_.dispatch(msg);
+        self_handle_callback_event(CallbackEvent::EVENT_MESSAGE_ARRIVED, msg);
+    }
+
+    void MqttClient::message_arrived(const mqtt::const_message_ptr& msg)
+    {
+        // Counted before closing_ is read, so ~MqttClient either waits for this call or makes it return
+        messageCallbacks_.fetch_add(1);
+        struct in_progress
+        {
+            std::atomic<unsigned int>& count;
+            ~in_progress()
+            {
+                count.fetch_sub(1);
+            }
+        } scope{messageCallbacks_};
+        if (closing_.load())
+        {
+            return;
+        }
+        save_message(msg);
+        auto executor = std::atomic_load(&executor_);
+        if (executor)
+        {
+            executor->submit(msg);
+        }
+        else
+        {
+            handle_message(msg);
+        }
+    }
+
+    void MqttClient::set_handler_workers(const handler_executor_options& opts)
+    {
+        lg lock(executorGuard_);
+        std::shared_ptr<HandlerExecutor> executor;
+        if (opts.workers > 0)
+        {
+            executor = std::make_shared<HandlerExecutor>(
+                opts, [this](const mqtt::const_message_ptr& msg) { this->handle_message(msg); });
+        }
+        // The previous workers drain and stop once the callback thread lets go of them; ~MqttClient waits for that
+        std::atomic_store(&executor_, std::move(executor));
+    }
+
+    handler_executor_stats MqttClient::get_handler_stats() const
+    {
+        auto executor = std::atomic_load(&executor_);
+        return executor ? executor->get_stats() : handler_executor_stats{};
     }
 
     bool MqttClient::get_next_message(mqtt::binary& msg)
@@ -405,10 +1287,9 @@ namespace mqttcpp
             return false;
         }
 
-        std::function<void()> fn = [this, &msg]() mutable {
-            lg lock(consumeGuard_);
+        auto fn = [this, &msg]() mutable {
             mqtt::const_message_ptr msg_ptr;
-            if (client_.try_consume_message(&msg_ptr))
+            if (get_next_message(msg_ptr))
             {
                 msg = msg_ptr->to_string();
             }
@@ -416,4 +1297,62 @@ namespace mqttcpp
         return common_try(fn, "Pop message");
     }
 
+    bool MqttClient::wait_next_message(mqtt::binary& msg, unsigned int wait_for)
+    {
+        mqtt::const_message_ptr msg_ptr;
+        if (!wait_next_message(msg_ptr, wait_for))
+        {
+            return false;
+        }
+        msg = msg_ptr->to_string();
+        return true;
+    }
+
+    std::size_t MqttClient::drain_messages(std::vector<mqtt::binary>& out, std::size_t max, unsigned int wait_for)
+    {
+        std::vector<mqtt::const_message_ptr> taken;
+        const std::size_t count = drain_messages(taken, max, wait_for);
+        out.reserve(out.size() + count);
+        for (const auto& msg : taken)
+        {
+            out.push_back(msg->to_string());
+        }
+        return count;
+    }
+
+    bool MqttClient::get_next_message(mqtt::const_message_ptr& msg)
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue && queue->try_pop(msg);
+    }
+
+    bool MqttClient::wait_next_message(mqtt::const_message_ptr& msg, unsigned int wait_for)
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue && queue->pop(msg, wait_for);
+    }
+
+    std::size_t MqttClient::drain_messages(std::vector<mqtt::const_message_ptr>& out,
+                                           std::size_t max,
+                                           unsigned int wait_for)
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue ? queue->pop_batch(out, max, wait_for) : 0;
+    }
+
+    bool MqttClient::wait_next_message(std::size_t shard, mqtt::const_message_ptr& msg, unsigned int wait_for)
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue && queue->pop(shard, msg, wait_for);
+    }
+
+    std::size_t MqttClient::drain_messages(std::size_t shard,
+                                           std::vector<mqtt::const_message_ptr>& out,
+                                           std::size_t max,
+                                           unsigned int wait_for)
+    {
+        std::shared_ptr<InboundQueue> queue = std::atomic_load(&inbound_);
+        return queue ? queue->pop_batch(shard, out, max, wait_for) : 0;
+    }
+
 } // namespace mqttcpp
@@ -5,8 +5,23 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
+#include <vector>
+#include <type_traits>
 #include "mqtt/async_client.h"
 #include "types.hpp"
+#include "publish_window.hpp"
+#include "congestion_controller.hpp"
+#include "conflator.hpp"
+#include "rate_limiter.hpp"
+#include "completion_queue.hpp"
+#include "send_times.hpp"
+#include "operation_listener.hpp"
+#include "op_result.hpp"
+#include "inbound_queue.hpp"
+#include "topic_dispatcher.hpp"
+#include "handler_executor.hpp"
+#include "flight_recorder.hpp"
 
 namespace mqttcpp
 {
@@ -22,9 +37,157 @@ namespace mqttcpp
         EVENT_ACTION_FAILURE     ///< Event received from client when an action fails.
     };
 
+    /**
+     * @brief Aggregate completion handle for a batch of publishes.
+     *
+     * A BatchToken is registered as the action listener of every message submitted by
+     * MqttClient::publish_batch. It counts completions and records failures, so the caller
+     * waits on one handle instead of holding one token per message. Failures are collected,
+     * never thrown.
+     */
+    class BatchToken : public mqtt::iaction_listener
+    {
+        friend class MqttClient;
+        using lg = std::lock_guard<std::mutex>;
+
+        class MqttClient* parent_;              ///< Client that submitted the batch.
+        mutable std::mutex guard_;              ///< Mutex guarding the completion state.
+        std::condition_variable cv_;            ///< Signalled when the last message completes.
+        const std::size_t size_;                ///< Number of messages in the batch.
+        std::size_t pending_;                   ///< Messages not yet acknowledged or failed.
+        std::vector<publish_failure> failures_; ///< Messages that failed, in completion order.
+        std::shared_ptr<BatchToken> self_;      ///< Keeps the listener alive while paho still references it.
+
+        /**
+         * @brief Marks one message as completed and releases waiters once the batch is done.
+         *
+         * @param failure The failure to record, or nullptr if the message succeeded.
+         */
+        void complete_one(publish_failure* failure);
+
+        /**
+         * @brief Holds a reference to the batch until every message has completed.
+         *
+         * @param self The shared pointer owning this batch.
+         */
+        void retain_until_complete(std::shared_ptr<BatchToken> self);
+
+    public:
+        /**
+         * @brief Constructs a batch handle expecting @p size completions.
+         *
+         * @param size Number of messages in the batch.
+         */
+        explicit BatchToken(std::size_t size);
+
+        /**
+         * @brief Records the failed delivery of one message of the batch.
+         *
+         * @param asyncActionToken The token of the failed publish. Its user context is the message index.
+         */
+        void on_failure(const mqtt::token& asyncActionToken) override;
+
+        /**
+         * @brief Records the successful delivery of one message of the batch.
+         *
+         * @param asyncActionToken The token of the completed publish.
+         */
+        void on_success(const mqtt::token& asyncActionToken) override;
+
+        /**
+         * @brief Returns the number of messages in the batch.
+         */
+        inline std::size_t size() const
+        {
+            return size_;
+        }
+
+        /**
+         * @brief Checks whether every message of the batch has completed.
+         *
+         * @return true if no message is pending anymore.
+         */
+        bool is_complete() const;
+
+        /**
+         * @brief Blocks until every message of the batch has completed.
+         */
+        void wait();
+
+        /**
+         * @brief Blocks until every message of the batch has completed or the timeout expires.
+         *
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if the batch completed; false if the timeout expired first.
+         */
+        bool wait_for(unsigned int wait_for);
+
+        /**
+         * @brief Returns the number of messages that failed so far.
+         */
+        std::size_t failed() const;
+
+        /**
+         * @brief Returns a copy of the failures recorded so far.
+         */
+        std::vector<publish_failure> get_failures() const;
+    };
+
+    using batch_token_ptr = std::shared_ptr<BatchToken>;
+
+    /**
+     * @brief Completion handle of a waiting publish that the client may defer.
+     *
+     * Used by the waiting publish overloads when the message can be queued by the QUEUE backpressure
+     * mode or held back by conflation, so no paho token exists yet to wait on. The completion is
+     * reported exactly as DefaultActionListener does, then the waiting caller is released. A
+     * superseded conflated value releases it too, since the newer value is delivered in its place.
+     */
+    class PublishWaiter : public mqtt::iaction_listener
+    {
+        friend class MqttClient;
+        using lg = std::lock_guard<std::mutex>;
+
+        class MqttClient* parent_;            ///< Client that submitted the publish.
+        mutable std::mutex guard_;            ///< Mutex guarding the completion state.
+        std::condition_variable cv_;          ///< Signalled when the publish completes.
+        bool done_;                           ///< Whether the publish completed.
+        std::shared_ptr<PublishWaiter> self_; ///< Keeps the listener alive while the client still references it.
+
+        /**
+         * @brief Marks the publish as completed and releases the waiting caller.
+         */
+        void complete();
+
+        /**
+         * @brief Holds a reference to the waiter until the publish has completed.
+         *
+         * @param self The shared pointer owning this waiter.
+         */
+        void retain_until_complete(std::shared_ptr<PublishWaiter> self);
+
+    public:
+        /**
+         * @brief Constructs a waiter for one publish of @p parent.
+         */
+        explicit PublishWaiter(class MqttClient* parent);
+
+        void on_failure(const mqtt::token& asyncActionToken) override;
+        void on_success(const mqtt::token& asyncActionToken) override;
+
+        /**
+         * @brief Blocks until the publish has completed or the timeout expires.
+         *
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if the publish completed; false if the timeout expired first.
+         */
+        bool wait_for(unsigned int wait_for);
+    };
+
     class MqttClient
     {
         using lg = std::lock_guard<std::mutex>;
+        using completion_handler = std::function<void(const completion_record&)>;
 
         /**
          * @brief Sets the default handlers for various MQTT client events.
@@ -46,6 +209,7 @@ namespace mqttcpp
 
                 [this](const mqtt::string& cause) {
                     this->self_handle_callback_event(CallbackEvent::EVENT_CONNECTED, cause);
+                    this->drain_publish_queue();
                 });
             client_.set_connection_lost_handler(
 
@@ -59,9 +223,7 @@ namespace mqttcpp
                 this->self_handle_callback_event(CallbackEvent::EVENT_CONNECTION_UPDATE, data);
                 return true;
             });
-            client_.set_message_callback([this](mqtt::const_message_ptr msg) {
-                this->self_handle_callback_event(CallbackEvent::EVENT_MESSAGE_ARRIVED, msg);
-            });
+            client_.set_message_callback([this](mqtt::const_message_ptr msg) { this->message_arrived(msg); });
         }
 
         /**
@@ -83,14 +245,85 @@ namespace mqttcpp
             }
         }
 
+        /**
+         * @brief Runs a callable returning an op_result, converting anything it throws into a failed result.
+         *
+         * Nothing is logged or stored in the last exception.
+         *
+         * @param fn The callable object to be executed.
+         * @return The result of @p fn, or the error of the exception it threw.
+         */
+        template <typename Fn>
+        inline op_result run_operation(Fn&& fn)
+        {
+            try
+            {
+                return fn();
+            }
+            catch (...)
+            {
+                return op_result::from_current_exception();
+            }
+        }
+
+        /**
+         * @brief Logs a failed result and stores it as the last exception, for the bool API.
+         *
+         * A successful result clears the last exception.
+         *
+         * @param result The result of the operation.
+         * @param fnId A string identifier for the operation, used for logging.
+         * @param exc The paho exception the failure came from, if any. Its text is logged and it is stored as is.
+         * @return result.ok()
+         */
+        bool report_result(const op_result& result, const char* fnId, const mqtt::exception* exc = nullptr);
+
+        /**
+         * @brief Runs a callable returning an op_result and reports the outcome, for the bool API.
+         *
+         * Unlike run_operation(), a paho exception is caught here rather than converted first, so the last
+         * exception keeps paho's own text without op_result having to carry it.
+         *
+         * @param fn The callable object to be executed.
+         * @param fnId A string identifier for the operation, used for logging.
+         * @return true if @p fn succeeded, false otherwise.
+         */
+        template <typename Fn>
+        inline bool report_operation(Fn&& fn, const char* fnId)
+        {
+            try
+            {
+                return report_result(fn(), fnId);
+            }
+            catch (const mqtt::exception& exc)
+            {
+                return report_result(op_result::from_current_exception(), fnId, &exc);
+            }
+            catch (...)
+            {
+                return report_result(op_result::from_current_exception(), fnId);
+            }
+        }
+
         /**
          * @brief Attempts to execute a given function and handles any exceptions.
          *
+         * A template so that the callable is invoked in place, without being wrapped in a std::function.
+         *
          * @param fn The callable object to be executed.
          * @param fnId A string identifier for the function, used for logging or debugging purposes.
          * @return true if the function executed without throwing an exception, false otherwise.
          */
-        bool common_try(std::function<void()> fn, const char* fnId);
+        template <typename Fn>
+        inline bool common_try(Fn&& fn, const char* fnId)
+        {
+            return report_operation(
+                [&fn]() {
+                    fn();
+                    return op_result();
+                },
+                fnId);
+        }
 
         /**
          * @brief Consumes a message from the MQTT client.
@@ -106,8 +339,162 @@ namespace mqttcpp
          */
         bool consume_message(bool allow);
 
+        /**
+         * @brief Pushes an arrived message to the inbound queue while saving is on.
+         *
+         * @param msg The arrived message.
+         */
+        void save_message(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Message callback: saves the message, then hands it to the handler workers or runs its handlers.
+         *
+         * Does nothing once ~MqttClient started, which waits for the calls already in progress.
+         *
+         * @param msg The arrived message.
+         */
+        void message_arrived(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Runs the topic handlers of an arrived message, then raises EVENT_MESSAGE_ARRIVED.
+         *
+         * Runs on the callback thread, or on a handler worker when set_handler_workers() started some.
+         *
+         * @param msg The arrived message.
+         */
+        void handle_message(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Logs, records and starts a connection with @p listener.
+         *
+         * @throws mqtt::exception if the client refuses the request.
+         */
+        mqtt::token_ptr start_connect(mqtt::iaction_listener& listener);
+
+        /**
+         * @brief Logs, records and starts a disconnection with @p listener.
+         *
+         * @throws mqtt::exception if the client refuses the request.
+         */
+        mqtt::token_ptr start_disconnect(mqtt::iaction_listener& listener);
+
+        /**
+         * @brief Logs, records and starts a subscription to @p topic with @p listener.
+         *
+         * @throws mqtt::exception if the client refuses the request.
+         */
+        mqtt::token_ptr start_subscribe(const std::string& topic, unsigned int qos, mqtt::iaction_listener& listener);
+
+        /**
+         * @brief Logs, records and starts unsubscribing from @p topic with @p listener.
+         *
+         * @throws mqtt::exception if the client refuses the request.
+         */
+        mqtt::token_ptr start_unsubscribe(const std::string& topic, mqtt::iaction_listener& listener);
+
+        /**
+         * @brief Submits @p msg with the default publish listener.
+         *
+         * @throws mqtt::exception if the client failed to publish.
+         */
+        op_result start_publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Submits a publish through the in-flight window.
+         *
+         * Takes a window slot for QoS 1/2 messages according to the configured backpressure mode
+         * before handing the message to the underlying client. Messages to conflated topics never
+         * wait: if they cannot be sent right away they replace the topic's pending value instead.
+         * Rate limits are applied first. A queued, conflated or dropped message leaves @p token empty.
+         *
+         * @param token Receives the delivery token of the publish, or nullptr if the message was queued.
+         * @param msg The message to publish.
+         * @param listener The listener to register with the publish.
+         * @param context The user context to register with the publish.
+         * @param dropped Set to true if a DROP rate limit discarded the message, in which case @p listener is
+         * never called.
+         * @return A failure if a rate limit or the window rejected the message.
+         * @throws mqtt::exception if the client failed to publish; the window slot is given back first.
+         */
+        op_result submit_publish(mqtt::token_ptr& token,
+                                 mqtt::const_message_ptr msg,
+                                 mqtt::iaction_listener& listener,
+                                 void* context,
+                                 bool& dropped);
+
+        /**
+         * @brief Submits queued publishes while the in-flight window has free slots.
+         *
+         * Runs the QUEUE backlog first, then flushes pending conflated values while connected.
+         * A queued publish that cannot be submitted gives its slot back and is reported as a
+         * failure to its listener.
+         */
+        void drain_publish_queue();
+
+        /**
+         * @brief Reports a conflated publish that was replaced by a newer value.
+         *
+         * Listeners other than the default publish listener (e.g. a BatchToken) receive a success,
+         * since the topic's newer value is delivered in its place.
+         *
+         * @param pub The superseded publish.
+         */
+        void report_superseded(queued_publish& pub);
+
+        /**
+         * @brief Checks whether a publish to @p topic may be deferred instead of getting a token at once.
+         *
+         * True in the QUEUE backpressure mode and for conflated topics.
+         */
+        bool may_defer(const std::string& topic) const;
+
+        /**
+         * @brief Publishes @p msg through a PublishWaiter and waits for its completion.
+         *
+         * Used by the waiting overloads when may_defer() holds. A message dropped by a DROP rate limit
+         * returns at once.
+         *
+         * @param msg The message to publish.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish_and_wait(mqtt::const_message_ptr msg, unsigned int wait_for);
+
+        /**
+         * @brief Hands a publish to the underlying client.
+         *
+         * Stamps the send time of QoS 1/2 messages for the congestion controller and for completion records. The
+         * time is taken before the call, so latency samples include the send itself.
+         *
+         * @param msg The message to publish.
+         * @param context User context passed to @p listener.
+         * @param listener Listener notified of the completion.
+         * @return The delivery token returned by the client.
+         */
+        mqtt::delivery_token_ptr send_publish(const mqtt::const_message_ptr& msg,
+                                              void* context,
+                                              mqtt::iaction_listener& listener);
+
+        /**
+         * @brief Raises EVENT_DISCONNECTED for a disconnect requested by the user.
+         */
+        void report_manual_disconnect();
+
+        /**
+         * @brief Starts a connection whose completion runs @p onComplete.
+         */
+        bool connect_async(completion_callback onComplete);
+
+        /**
+         * @brief Starts a disconnection whose completion runs @p onComplete.
+         */
+        bool disconnect_async(completion_callback onComplete);
+
     protected:
         friend class DefaultActionListener;
+        friend class BatchToken;
+        friend class PublishWaiter;
+        friend class OperationListener;
 
         mqtt::connect_options connOpts_;                          ///< Connection options for the MQTT client.
         std::unique_ptr<mqtt::iaction_listener> pubListener_;     ///< Listener for publish actions.
@@ -115,14 +502,77 @@ namespace mqttcpp
         std::unique_ptr<mqtt::iaction_listener> unsubListener_;   ///< Listener for unsubscribe actions.
         std::unique_ptr<mqtt::iaction_listener> connListener_;    ///< Listener for connection actions.
         std::unique_ptr<mqtt::iaction_listener> disconnListener_; ///< Listener for disconnection actions.
+        OperationListenerPool opListeners_;                       ///< Listeners of calls with a completion callback.
 
-        std::mutex consumeGuard_;       ///< Mutex for guarding the message consumption.
-        std::condition_variable cv_;    ///< Condition variable for message consumption.
-        std::atomic<bool> consumeFlag_; ///< Flag to control message consumption.
+        std::mutex consumeGuard_;                                  ///< Mutex guarding start, stop and queue changes.
+        std::atomic<bool> consumeFlag_;                            ///< Flag to control message consumption.
+        std::shared_ptr<InboundQueue> inbound_;                    ///< Saved messages, accessed atomically.
+        inbound_queue_options inboundOpts_;                        ///< Options of the inbound queue.
+        TopicDispatcher dispatcher_;                               ///< Handlers registered per topic filter.
+        std::mutex executorGuard_;                                 ///< Mutex serializing handler worker changes.
+        std::shared_ptr<HandlerExecutor> executor_;                ///< Handler workers, accessed atomically.
+        std::atomic<bool> closing_{false};                         ///< Set by ~MqttClient to stop message callbacks.
+        std::atomic<unsigned int> messageCallbacks_{0};            ///< Message callbacks in progress.
 
         mqtt::async_client client_;                                           ///< Client object for the MQTT client.
         std::function<void(CallbackEvent, CallbackVariant)> exteventHandler_; ///< External event handler callback.
         exception_trace_ptr excPtr_; ///< Pointer to the last exception that was caught.
+        PublishWindow pubWindow_;                                     ///< In-flight window for QoS 1/2 publishes.
+        CongestionController congestion_;                             ///< Adaptive sizing of the in-flight window.
+        Conflator conflator_;                                         ///< Last-value conflation of outgoing publishes.
+        RateLimiter rateLimiter_;                                     ///< Token-bucket limits on outgoing publishes.
+        SendTimes sendTimes_;                                         ///< Send time of in-flight QoS 1/2 publishes.
+        std::shared_ptr<CompletionQueue> completions_;                ///< Queued records; created lazily, atomic.
+        std::atomic<CompletionMode> completionMode_;                  ///< How completed operations are reported.
+        std::shared_ptr<const completion_handler> completionHandler_; ///< Record handler, accessed atomically.
+        FlightRecorder recorder_;                                     ///< Trace of the last operations and events.
+
+        /**
+         * @brief Handles the completion of a publish, successful or not.
+         *
+         * Gives the window slot of a QoS 1/2 message back and submits queued publishes that now fit.
+         *
+         * @param tok The completed publish token.
+         * @return The latency of the publish in nanoseconds, taken from sendTimes_; 0 if unknown.
+         */
+        uint64_t on_publish_complete(const mqtt::token& tok);
+
+        /**
+         * @brief Handles the completion of a connect request.
+         *
+         * Caps the congestion window at the Receive Maximum announced in the broker's CONNACK.
+         *
+         * @param tok The completed connect token.
+         */
+        void on_connect_complete(const mqtt::token& tok);
+
+        /**
+         * @brief Records a completed operation in the flight recorder.
+         *
+         * Called for every completion, including those of batches and per-call callbacks that do not go
+         * through report_completion().
+         *
+         * @param tok The completed token.
+         * @param success Whether the operation succeeded.
+         */
+        void record_completion(const mqtt::token& tok, bool success);
+
+        /**
+         * @brief Reports a completed operation according to the completion mode.
+         *
+         * In RECORDS mode a completion_record goes to the completion handler, or to the completion queue
+         * when no handler is set. In TOKEN_EVENTS mode the token is cloned and raised as an event.
+         *
+         * @param tok The completed token.
+         * @param success Whether the operation succeeded.
+         * @param latencyNanos Latency returned by on_publish_complete(), 0 for other operations.
+         */
+        void report_completion(const mqtt::token& tok, bool success, uint64_t latencyNanos = 0);
+
+        /**
+         * @brief Returns the completion queue, creating it on first use.
+         */
+        std::shared_ptr<CompletionQueue> completion_queue();
 
         /**
          * @brief Handles a callback event.
@@ -152,6 +602,21 @@ namespace mqttcpp
          */
         void set_connOpts(const mqtt::connect_options opts);
 
+        /**
+         * @brief Returns the MQTT connection options used by connect().
+         */
+        inline const mqtt::connect_options& get_connOpts() const
+        {
+            return connOpts_;
+        }
+
+        /**
+         * @brief Returns the connection options a client gets when none are given.
+         *
+         * Keep-alive of 60 seconds, clean session, automatic reconnect and a 10 second connect timeout.
+         */
+        static mqtt::connect_options default_connect_options();
+
         /**
          * @brief Sets the event handler callback.
          *
@@ -211,6 +676,35 @@ namespace mqttcpp
          */
         bool disconnect(bool wait = true, unsigned int wait_for = 0);
 
+        /**
+         * @brief Connects to the MQTT broker and runs @p onComplete when the attempt completes.
+         *
+         * The callback runs on the client's callback thread and bypasses the event handler and the
+         * completion queue. A template so that captureless lambdas do not clash with connect(bool).
+         *
+         * @param onComplete Callable taking a `const completion_record&`.
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        template <typename Fn,
+                  typename = std::enable_if_t<std::is_invocable_v<Fn&, const completion_record&>>>
+        inline bool connect(Fn&& onComplete)
+        {
+            return connect_async(completion_callback(std::forward<Fn>(onComplete)));
+        }
+
+        /**
+         * @brief Disconnects from the MQTT broker and runs @p onComplete when done.
+         *
+         * @param onComplete Callable taking a `const completion_record&`.
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        template <typename Fn,
+                  typename = std::enable_if_t<std::is_invocable_v<Fn&, const completion_record&>>>
+        inline bool disconnect(Fn&& onComplete)
+        {
+            return disconnect_async(completion_callback(std::forward<Fn>(onComplete)));
+        }
+
         /**
          * @brief Subscribes to a specified MQTT topic with a given Quality of Service (QoS) level.
          *
@@ -236,6 +730,16 @@ namespace mqttcpp
          */
         bool subscribe(const std::string& topic, unsigned int qos = 1, bool wait = true, unsigned int wait_for = 0);
 
+        /**
+         * @brief Subscribes to @p topic and runs @p onComplete when the broker acknowledges.
+         *
+         * @param onComplete Continuation run once on the client's callback thread.
+         * @param topic The topic to which the client will subscribe.
+         * @param qos The Quality of Service level for the subscription (0, 1, or 2).
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        bool subscribe(completion_callback onComplete, const std::string& topic, unsigned int qos = 1);
+
         /**
          * @brief Unsubscribes from a given MQTT topic.
          * 
@@ -260,6 +764,15 @@ namespace mqttcpp
          */
         bool unsubscribe(const std::string& topic, bool wait = true, unsigned int wait_for = 0);
 
+        /**
+         * @brief Unsubscribes from @p topic and runs @p onComplete when the broker acknowledges.
+         *
+         * @param onComplete Continuation run once on the client's callback thread.
+         * @param topic The MQTT topic to unsubscribe from.
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        bool unsubscribe(completion_callback onComplete, const std::string& topic);
+
         /**
          * @brief Publishes a message to a specified MQTT topic.
          * 
@@ -280,7 +793,8 @@ namespace mqttcpp
          * This function sends a message with the specified payload to the given MQTT topic.
          * The Quality of Service (QoS) level is configurable through the qos parameter.
          * Optionally, it can wait for an acknowledgment or confirmation after publishing,
-         * as specified by the wait and wait_for parameters.
+         * as specified by the wait and wait_for parameters. A message queued by the QUEUE backpressure
+         * mode or held back by conflation is waited for until it is delivered or superseded.
          *
          * @param topic The MQTT topic where the message is to be published.
          * @param payload The content of the message to be sent.
@@ -297,11 +811,414 @@ namespace mqttcpp
                      unsigned int wait_for = 0);
 
         /**
-         * @brief Retrieves the last exception that was thrown.
-         * 
-         * This function returns a pointer to the last exception that was caught and stored.
-         * 
-         * @return exception_trace_ptr A pointer to the last exception.
+         * @brief Publishes a shared payload buffer to a specified MQTT topic without copying it.
+         *
+         * The buffer behind @p payload is reference counted and handed to the outgoing message as is,
+         * so large payloads can be published (or re-published) without another copy.
+         *
+         * @param token A reference to an MQTT token pointer that will be used for the publish operation.
+         * @param topic The topic to which the message will be published.
+         * @param payload The shared, immutable message payload.
+         * @param qos The Quality of Service level for the message delivery (default is QOS).
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(mqtt::token_ptr& token, const std::string& topic, mqtt::binary_ref payload, unsigned int qos = 1);
+
+        /**
+         * @brief Publishes a text payload to a specified MQTT topic.
+         *
+         * Keeps string literal payloads, which convert to both std::string and mqtt::binary_ref, on the
+         * copying overload.
+         *
+         * @param token A reference to an MQTT token pointer that will be used for the publish operation.
+         * @param topic The topic to which the message will be published.
+         * @param payload The null-terminated message payload.
+         * @param qos The Quality of Service level for the message delivery (default is QOS).
+         * @return true if no error occurs; false otherwise.
+         */
+        inline bool publish(mqtt::token_ptr& token, const std::string& topic, const char* payload, unsigned int qos = 1)
+        {
+            return publish(token, topic, std::string(payload), qos);
+        }
+
+        /**
+         * @brief Publishes a prebuilt message.
+         *
+         * The message is passed to the underlying client as is, including its QoS, retained flag and
+         * properties.
+         *
+         * @param token A reference to an MQTT token pointer that will be used for the publish operation.
+         * @param msg The message to publish.
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Publishes a prebuilt message.
+         *
+         * Optionally waits until the delivery is complete or times out, including while the message is
+         * queued by the QUEUE backpressure mode or held back by conflation.
+         *
+         * @param msg The message to publish.
+         * @param wait If true, blocks until the operation completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(mqtt::const_message_ptr msg, bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Publishes a message and runs @p onComplete when its delivery completes.
+         *
+         * The continuation runs once, on the client's callback thread, instead of going through the event
+         * handler or the completion queue. A message dropped by a rate limit completes immediately with
+         * QUOTA_EXCEEDED; a conflated message that is superseded completes successfully.
+         *
+         * @param onComplete Continuation run once when the publish completes.
+         * @param topic The topic to which the message will be published.
+         * @param payload The message payload.
+         * @param qos The Quality of Service level for the message (0, 1, or 2).
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        bool publish(completion_callback onComplete,
+                     const std::string& topic,
+                     const std::string& payload,
+                     unsigned int qos = 1);
+
+        /**
+         * @brief Publishes a prebuilt message and runs @p onComplete when its delivery completes.
+         *
+         * @param onComplete Continuation run once when the publish completes.
+         * @param msg The message to publish. It is shared with the client, never copied.
+         * @return true if no error occurs; false otherwise, in which case @p onComplete is never called.
+         */
+        bool publish(completion_callback onComplete, mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Publishes a batch of messages in a single pass.
+         *
+         * Every message is handed to the underlying client under one error guard and one log line,
+         * with @p token registered as the shared action listener. A message that cannot be submitted
+         * is recorded as a failure in @p token instead of aborting the batch, as is a message that
+         * fails later while in flight.
+         *
+         * @param token Receives the aggregate completion handle of the batch.
+         * @param msgs The messages to publish.
+         * @return true if every message was submitted; false otherwise (see BatchToken::get_failures).
+         */
+        bool publish_batch(batch_token_ptr& token, const std::vector<publish_request>& msgs);
+
+        /**
+         * @brief Publishes a batch of messages that is part of a larger batch.
+         *
+         * Behaves like publish_batch(token, msgs), except that failures of msgs[i] are reported with
+         * index @p indices[i] instead of i, so a caller that split its batch can map them back.
+         *
+         * @param token Receives the aggregate completion handle of the batch.
+         * @param msgs The messages to publish.
+         * @param indices Position of each message in the caller's batch. Messages past its end keep their own.
+         * @return true if every message was submitted; false otherwise (see BatchToken::get_failures).
+         */
+        bool publish_batch(batch_token_ptr& token,
+                           const std::vector<publish_request>& msgs,
+                           const std::vector<std::size_t>& indices);
+
+        /**
+         * @brief Publishes a batch of messages in a single pass.
+         *
+         * Optionally waits until every message of the batch has completed or the timeout expires.
+         *
+         * @param msgs The messages to publish.
+         * @param wait If true, blocks until the batch completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every message was submitted; false otherwise.
+         */
+        bool publish_batch(const std::vector<publish_request>& msgs, bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Connects to the MQTT broker, returning the outcome of this call only.
+         *
+         * The try_ operations never throw, log failures or touch the last exception, so their result cannot be
+         * overwritten by another thread. Like the bool API, they still log their progress at INFO level. Both run the
+         * same operation bodies; the bool API only adds the reporting.
+         *
+         * @param token Receives the connect token.
+         * @return The outcome of submitting the request.
+         */
+        op_result try_connect(mqtt::token_ptr& token);
+
+        /**
+         * @brief Disconnects from the MQTT broker, returning the outcome of this call only.
+         *
+         * @param token Receives the disconnect token.
+         * @return The outcome of submitting the request.
+         */
+        op_result try_disconnect(mqtt::token_ptr& token);
+
+        /**
+         * @brief Subscribes to @p topic, returning the outcome of this call only.
+         *
+         * @param token Receives the subscribe token.
+         * @param topic The topic to which the client will subscribe.
+         * @param qos The Quality of Service level for the subscription (0, 1, or 2).
+         * @return The outcome of submitting the request.
+         */
+        op_result try_subscribe(mqtt::token_ptr& token, const std::string& topic, unsigned int qos = 1);
+
+        /**
+         * @brief Unsubscribes from @p topic, returning the outcome of this call only.
+         *
+         * @param token Receives the unsubscribe token.
+         * @param topic The topic to unsubscribe from.
+         * @return The outcome of submitting the request.
+         */
+        op_result try_unsubscribe(mqtt::token_ptr& token, const std::string& topic);
+
+        /**
+         * @brief Publishes a message, returning the outcome of this call only.
+         *
+         * A rate limit in FAIL mode fails with QUOTA_EXCEEDED and a full window in FAIL mode with
+         * MQTTASYNC_MAX_MESSAGES_INFLIGHT, without throwing internally. A message dropped by a DROP rate limit
+         * succeeds with an empty @p token.
+         *
+         * @param token Receives the delivery token, or nullptr if the message was queued, conflated or dropped.
+         * @param topic The topic to which the message will be published.
+         * @param payload The message payload.
+         * @param qos The Quality of Service level for the message (0, 1, or 2).
+         * @return The outcome of submitting the message.
+         */
+        op_result try_publish(mqtt::token_ptr& token,
+                              const std::string& topic,
+                              const std::string& payload,
+                              unsigned int qos = 1);
+
+        /**
+         * @brief Publishes a prebuilt message, returning the outcome of this call only.
+         *
+         * @param token Receives the delivery token, or nullptr if the message was queued, conflated or dropped.
+         * @param msg The message to publish.
+         * @return The outcome of submitting the message.
+         */
+        op_result try_publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Configures the in-flight window for QoS 1/2 publishes.
+         *
+         * When more than `maxInflight` acknowledged publishes are outstanding, further publishes
+         * block (up to `blockTimeout`), fail immediately, or are queued and submitted as slots free
+         * up, depending on `mode`. A rejected publish fails with MQTTASYNC_MAX_MESSAGES_INFLIGHT.
+         * In BLOCK mode, do not publish from the client's callback thread: that thread delivers the
+         * completions that free the window.
+         *
+         * @param opts The window configuration. A `maxInflight` of 0 disables the limit.
+         */
+        void set_publish_window(const publish_window_options& opts);
+
+        /**
+         * @brief Returns a snapshot of the in-flight window counters.
+         *
+         * @return The current occupancy, limit, backlog and blocking counters.
+         */
+        inline publish_window_stats get_publish_window_stats() const
+        {
+            return pubWindow_.get_stats();
+        }
+
+        /**
+         * @brief Enables or disables adaptive sizing of the in-flight window.
+         *
+         * While enabled, the controller measures publish-to-acknowledgement latency and drives the
+         * `maxInflight` of the publish window with additive increase and multiplicative decrease,
+         * bounded by the broker's Receive Maximum. The backpressure mode and deadlines still come from
+         * set_publish_window(). Disabling it leaves the last computed limit in place.
+         *
+         * @param opts The controller configuration.
+         */
+        void set_congestion_control(const congestion_options& opts);
+
+        /**
+         * @brief Returns a snapshot of the congestion controller state.
+         *
+         * @return The current window, its ceiling, latency estimates and adjustment counters.
+         */
+        inline congestion_stats get_congestion_stats() const
+        {
+            return congestion_.get_stats();
+        }
+
+        /**
+         * @brief Enables last-value conflation for topics matching @p filter.
+         *
+         * A publish to a conflated topic that cannot be sent right away (disconnected, or the in-flight
+         * window is full) is parked instead of blocking or queueing. A newer publish to the same topic
+         * replaces the parked value in place, so only the latest value is sent once the client catches up.
+         *
+         * @param filter An MQTT topic filter, wildcards allowed.
+         * @return false if @p filter is not a well-formed topic filter.
+         */
+        inline bool add_conflation_filter(const std::string& filter)
+        {
+            return conflator_.add_filter(filter);
+        }
+
+        /**
+         * @brief Disables last-value conflation for @p filter.
+         *
+         * Values already parked are still sent.
+         *
+         * @param filter A filter previously passed to add_conflation_filter().
+         */
+        inline void remove_conflation_filter(const std::string& filter)
+        {
+            conflator_.remove_filter(filter);
+        }
+
+        /**
+         * @brief Returns a snapshot of the conflation counters.
+         *
+         * @return The number of parked topics and how many values were parked, replaced and flushed.
+         */
+        inline conflation_stats get_conflation_stats() const
+        {
+            return conflator_.get_stats();
+        }
+
+        /**
+         * @brief Limits the publish rate of the whole client.
+         *
+         * The limit is a token bucket refilled at @p rate messages per second and holding up to @p burst
+         * messages. A publish over the limit is delayed, silently dropped, or failed with QUOTA_EXCEEDED
+         * depending on @p mode. Limits apply before the in-flight window and conflation.
+         *
+         * @param rate Messages per second; 0 removes the limit.
+         * @param burst Maximum number of messages that may be sent back to back.
+         * @param mode What to do with publishes over the limit.
+         */
+        inline void set_rate_limit(double rate, std::size_t burst, RateLimitMode mode = RateLimitMode::DELAY)
+        {
+            rateLimiter_.set_global_limit(rate, burst, mode);
+        }
+
+        /**
+         * @brief Limits the publish rate of the topics matching @p filter.
+         *
+         * All matching topics share one bucket. A publish must conform to the global limit and to every
+         * topic limit it matches.
+         *
+         * @param filter An MQTT topic filter, wildcards allowed.
+         * @param rate Messages per second; 0 removes the limit.
+         * @param burst Maximum number of messages that may be sent back to back.
+         * @param mode What to do with publishes over the limit.
+         * @return false if @p filter is not a well-formed topic filter.
+         */
+        inline bool set_topic_rate_limit(const std::string& filter,
+                                         double rate,
+                                         std::size_t burst,
+                                         RateLimitMode mode = RateLimitMode::DELAY)
+        {
+            return rateLimiter_.set_topic_limit(filter, rate, burst, mode);
+        }
+
+        /**
+         * @brief Returns a snapshot of the rate limiter counters.
+         *
+         * @return How many publishes were delayed, for how long, and how many were dropped or failed.
+         */
+        inline rate_limit_stats get_rate_limit_stats() const
+        {
+            return rateLimiter_.get_stats();
+        }
+
+        /**
+         * @brief Returns the last operations, completions and callback events of this client, oldest first.
+         *
+         * The client always records its last FlightRecorder::DEFAULT_EVENTS events. Topics are kept as
+         * FlightRecorder::topic_hash() values, never as text.
+         */
+        inline std::vector<flight_event> get_flight_events() const
+        {
+            return recorder_.snapshot();
+        }
+
+        /**
+         * @brief Writes the recorded events of this client to @p fd, one line each. Async-signal-safe.
+         *
+         * FlightRecorder::install_fatal_signal_dump() does the same for every client on a crash.
+         */
+        inline void dump_flight_recorder(int fd) const
+        {
+            recorder_.dump(fd);
+        }
+
+        /**
+         * @brief Selects how completed operations are reported.
+         *
+         * RECORDS (the default) reports every completion as a small completion_record without allocating.
+         * TOKEN_EVENTS restores the former behaviour: each completed token is cloned and passed to the
+         * event handler as EVENT_ACTION_SUCCESS or EVENT_ACTION_FAILURE.
+         *
+         * @param mode The completion mode.
+         */
+        inline void set_completion_mode(CompletionMode mode)
+        {
+            completionMode_.store(mode);
+        }
+
+        /**
+         * @brief Returns the current completion mode.
+         */
+        inline CompletionMode get_completion_mode() const
+        {
+            return completionMode_.load();
+        }
+
+        /**
+         * @brief Sets the handler receiving completion records in RECORDS mode.
+         *
+         * The handler runs on the client's callback thread and must not block. While a handler is set,
+         * records bypass the completion queue. Passing an empty handler routes them to the queue again.
+         *
+         * @param handler Called with each completion record.
+         */
+        void set_completion_handler(std::function<void(const completion_record&)> handler);
+
+        /**
+         * @brief Pops the oldest completion record from the completion queue.
+         *
+         * Never blocks. The queue is bounded: records arriving while it is full are dropped and counted.
+         *
+         * @param record Receives the record.
+         * @return true if a record was popped; false if the queue is empty.
+         */
+        inline bool poll_completion(completion_record& record)
+        {
+            auto queue = std::atomic_load(&completions_);
+            return queue && queue->pop(record);
+        }
+
+        /**
+         * @brief Returns a snapshot of the completion queue counters.
+         */
+        inline completion_stats get_completion_stats() const
+        {
+            auto queue = std::atomic_load(&completions_);
+            return queue ? queue->get_stats() : completion_stats{0, 0, 0};
+        }
+
+        /**
+         * @brief Returns how many pooled listeners exist and how many serve pending per-call callbacks.
+         */
+        inline operation_pool_stats get_operation_pool_stats() const
+        {
+            return opListeners_.get_stats();
+        }
+
+        /**
+         * @brief Retrieves the last exception that was thrown.
+         * 
+         * This function returns a pointer to the last exception that was caught and stored. It is shared by
+         * every thread using the client; use the try_ operations to get the error of one particular call.
+         * 
+         * @return exception_trace_ptr A pointer to the last exception.
          */
         inline exception_trace_ptr get_last_exception() const
         {
@@ -358,11 +1275,164 @@ namespace mqttcpp
         /**
          * @brief Retrieves the next available MQTT binary message.
          *
+         * Never blocks. Leaves @p msg untouched when no message is available; use wait_next_message() to
+         * know whether one was delivered.
+         *
          * @param msg A reference to an mqtt::binary object that will be populated with the message data.
-         * @return true if a message was successfully retrieved, false otherwise.
+         * @return false if saving is off or an error occurred, true otherwise.
          */
         bool get_next_message(mqtt::binary& msg);
 
+        /**
+         * @brief Waits for the next saved message.
+         *
+         * The calling thread sleeps until a message arrives, the timeout expires or saving is stopped.
+         *
+         * @param msg Receives the payload of the message.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if a message was delivered into @p msg; false on timeout or if saving is off.
+         */
+        bool wait_next_message(mqtt::binary& msg, unsigned int wait_for = 0);
+
+        /**
+         * @brief Waits for saved messages and takes up to @p max of them at once.
+         *
+         * Waits like wait_next_message() for the first message, then takes whatever else is already saved
+         * without waiting further.
+         *
+         * @param out Receives the payloads, appended in arrival order.
+         * @param max Maximum number of messages to take.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return The number of messages appended to @p out; 0 on timeout or if saving is off.
+         */
+        std::size_t drain_messages(std::vector<mqtt::binary>& out, std::size_t max, unsigned int wait_for = 0);
+
+        /**
+         * @brief Takes the next saved message without copying it.
+         *
+         * Never blocks. The message keeps its topic, QoS, retained flag and properties, and its payload is
+         * shared with the client rather than copied.
+         *
+         * @param msg Receives the message.
+         * @return true if a message was taken; false if none is saved.
+         */
+        bool get_next_message(mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Waits for the next saved message and takes it without copying it.
+         *
+         * @param msg Receives the message.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if a message was delivered into @p msg; false on timeout or if saving is off.
+         */
+        bool wait_next_message(mqtt::const_message_ptr& msg, unsigned int wait_for = 0);
+
+        /**
+         * @brief Waits for saved messages and takes up to @p max of them without copying them.
+         *
+         * @param out Receives the messages, appended in arrival order.
+         * @param max Maximum number of messages to take.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return The number of messages appended to @p out; 0 on timeout or if saving is off.
+         */
+        std::size_t drain_messages(std::vector<mqtt::const_message_ptr>& out,
+                                   std::size_t max,
+                                   unsigned int wait_for = 0);
+
+        /**
+         * @brief Configures the inbound queue holding saved messages.
+         *
+         * The queue is lock-free and bounded by a message count per shard and optionally by a total byte size.
+         * A message arriving while the queue is full is handled by the overflow policy: dropped (the default),
+         * let in by dropping the oldest messages, held by blocking the callback thread, or spilled to disk. Each
+         * kind of drop is counted in get_inbound_stats(), and the watermark handler lets the application shed
+         * load before the limit is hit. With several shards, each worker consumes its own shard through the
+         * shard overloads of wait_next_message() and drain_messages(), and all messages of a topic go to the
+         * same shard. The shard-less overloads take from any shard.
+         *
+         * @param opts Limits, number of shards, overflow policy and watermark handler.
+         * @return false if saving is on (stop saving messages before changing the queue), or if the SPILL policy
+         * cannot open its spill files; the previous queue stays in place in both cases.
+         */
+        bool set_inbound_queue(const inbound_queue_options& opts);
+
+        /**
+         * @brief Returns the shard receiving messages published to @p topic.
+         */
+        std::size_t inbound_shard_of(const std::string& topic) const;
+
+        /**
+         * @brief Waits for the next saved message of shard @p shard and takes it without copying it.
+         *
+         * @param shard Index of the shard, below inbound_queue_options::shards.
+         * @param msg Receives the message.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if a message was delivered into @p msg; false on timeout, if saving is off or if @p shard
+         * does not exist.
+         */
+        bool wait_next_message(std::size_t shard, mqtt::const_message_ptr& msg, unsigned int wait_for = 0);
+
+        /**
+         * @brief Waits for saved messages of shard @p shard and takes up to @p max of them without copying them.
+         *
+         * @param shard Index of the shard, below inbound_queue_options::shards.
+         * @param out Receives the messages, appended in arrival order.
+         * @param max Maximum number of messages to take.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return The number of messages appended to @p out; 0 on timeout, if saving is off or if @p shard does
+         * not exist.
+         */
+        std::size_t drain_messages(std::size_t shard,
+                                   std::vector<mqtt::const_message_ptr>& out,
+                                   std::size_t max,
+                                   unsigned int wait_for = 0);
+
+        /**
+         * @brief Returns a snapshot of the inbound queue counters.
+         */
+        inbound_queue_stats get_inbound_stats() const;
+
+        /**
+         * @brief Registers a handler for inbound messages matching a topic filter.
+         *
+         * Matching handlers run on the callback thread for every arriving message, before the external event
+         * handler receives EVENT_MESSAGE_ARRIVED. Registering a handler does not subscribe; subscribe to a
+         * filter covering @p filter as well.
+         *
+         * @param filter An MQTT topic filter, with `+` and `#` wildcards.
+         * @param handler Called with each matching message.
+         * @return An id for remove_message_handler(); TopicDispatcher::INVALID_HANDLER if @p filter is malformed.
+         */
+        TopicDispatcher::handler_id add_message_handler(const std::string& filter,
+                                                        TopicDispatcher::message_handler handler);
+
+        /**
+         * @brief Unregisters a handler added with add_message_handler().
+         *
+         * @return true if the handler was registered.
+         */
+        bool remove_message_handler(TopicDispatcher::handler_id id);
+
+        /**
+         * @brief Moves message handling off the callback thread onto a pool of worker threads.
+         *
+         * Topic handlers and the EVENT_MESSAGE_ARRIVED event of each message run on the worker owning the
+         * message's key (the topic, one of its levels or a custom hash). Messages with the same key are handled
+         * in arrival order; different keys are handled in parallel, so a slow handler no longer stalls the
+         * callback thread and the keepalive. Saving to the inbound queue still happens on the callback thread.
+         * Messages queued to replaced or removed workers are still handled, but not necessarily before later
+         * messages of the same key. Must not be called from a handler running on a worker.
+         *
+         * @param opts Number of workers, queue capacity and key; 0 workers handles messages on the callback
+         * thread again.
+         */
+        void set_handler_workers(const handler_executor_options& opts);
+
+        /**
+         * @brief Returns a snapshot of the handler worker counters, all zero without workers.
+         */
+        handler_executor_stats get_handler_stats() const;
+
         static std::unique_ptr<MqttClient> Instance;
     };
 
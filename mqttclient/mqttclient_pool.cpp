@@ -0,0 +1,217 @@
+#include "mqttclient_pool.hpp"
+#include "monitor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace mqttcpp
+{
+    namespace
+    {
+        /**
+         * @brief 64-bit FNV-1a, used instead of std::hash so routing is identical on every platform.
+         */
+        uint64_t fnv1a(const std::string& text)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : text)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        /**
+         * @brief Jump consistent hash (Lamping and Veach): growing the pool only moves 1/n of the topics.
+         */
+        std::size_t jump_hash(uint64_t key, std::size_t buckets)
+        {
+            int64_t b = -1;
+            int64_t j = 0;
+            while (j < static_cast<int64_t>(buckets))
+            {
+                b = j;
+                key = key * 2862933555777941757ull + 1;
+                j = static_cast<int64_t>(static_cast<double>(b + 1) *
+                                         (static_cast<double>(1ll << 31) / static_cast<double>((key >> 33) + 1)));
+            }
+            return static_cast<std::size_t>(b);
+        }
+    } // namespace
+
+    MqttClientPool::MqttClientPool(const std::string& serverAddress,
+                                   const std::string& clientIdPrefix,
+                                   std::size_t size,
+                                   mqtt::connect_options connectOptions)
+    {
+        size = std::max<std::size_t>(size, 1);
+        clients_.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            clients_.push_back(
+                std::make_unique<MqttClient>(serverAddress, clientIdPrefix + "-" + std::to_string(i), connectOptions));
+        }
+    }
+
+    bool MqttClientPool::wait_all(const std::vector<mqtt::token_ptr>& tokens, unsigned int wait_for)
+    {
+        using clock = std::chrono::steady_clock;
+        const auto deadline = clock::now() + std::chrono::milliseconds(wait_for);
+        bool ok = true;
+        for (const auto& token : tokens)
+        {
+            if (!token)
+            {
+                continue;
+            }
+            try
+            {
+                if (wait_for == 0)
+                {
+                    token->wait();
+                }
+                else
+                {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+                    ok = token->wait_for(std::max(left, std::chrono::milliseconds(1))) && ok;
+                }
+                ok = ok && token->get_return_code() == MQTTASYNC_SUCCESS;
+            }
+            catch (const mqtt::exception& exc)
+            {
+                derror1("[MqttClientPool] Operation failed: %s\n", exc.what()).print();
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    std::size_t MqttClientPool::shard_of(const std::string& topic) const
+    {
+        return clients_.size() == 1 ? 0 : jump_hash(fnv1a(topic), clients_.size());
+    }
+
+    void MqttClientPool::set_event_handler(std::function<void(CallbackEvent, CallbackVariant)> handler)
+    {
+        for (auto& client : clients_)
+        {
+            client->set_event_handler(handler);
+        }
+    }
+
+    bool MqttClientPool::connect(bool wait, unsigned int wait_for)
+    {
+        std::vector<mqtt::token_ptr> tokens(clients_.size());
+        bool ok = true;
+        for (std::size_t i = 0; i < clients_.size(); ++i)
+        {
+            ok = clients_[i]->connect(tokens[i]) && ok;
+        }
+        if (wait)
+        {
+            ok = wait_all(tokens, wait_for) && ok;
+        }
+        return ok;
+    }
+
+    bool MqttClientPool::disconnect(bool wait, unsigned int wait_for)
+    {
+        std::vector<mqtt::token_ptr> tokens(clients_.size());
+        bool ok = true;
+        for (std::size_t i = 0; i < clients_.size(); ++i)
+        {
+            ok = clients_[i]->disconnect(tokens[i]) && ok;
+        }
+        if (wait)
+        {
+            ok = wait_all(tokens, wait_for) && ok;
+        }
+        return ok;
+    }
+
+    bool MqttClientPool::connected()
+    {
+        return connected_count() == clients_.size();
+    }
+
+    std::size_t MqttClientPool::connected_count()
+    {
+        return static_cast<std::size_t>(
+            std::count_if(clients_.begin(), clients_.end(), [](const auto& client) { return client->connected(); }));
+    }
+
+    bool MqttClientPool::publish(mqtt::token_ptr& token,
+                                 const std::string& topic,
+                                 const std::string& payload,
+                                 unsigned int qos)
+    {
+        return client_for(topic).publish(token, topic, payload, qos);
+    }
+
+    bool MqttClientPool::publish(const std::string& topic,
+                                 const std::string& payload,
+                                 unsigned int qos,
+                                 bool wait,
+                                 unsigned int wait_for)
+    {
+        return client_for(topic).publish(topic, payload, qos, wait, wait_for);
+    }
+
+    bool MqttClientPool::publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg)
+    {
+        MqttClient& owner = client_for(msg->get_topic());
+        return owner.publish(token, std::move(msg));
+    }
+
+    bool MqttClientPool::publish_batch(std::vector<batch_token_ptr>& tokens, const std::vector<publish_request>& msgs)
+    {
+        std::vector<std::vector<publish_request>> shards(clients_.size());
+        std::vector<std::vector<std::size_t>> positions(clients_.size());
+        for (std::size_t i = 0; i < msgs.size(); ++i)
+        {
+            const std::size_t shard = shard_of(msgs[i].topic);
+            shards[shard].push_back(msgs[i]);
+            positions[shard].push_back(i);
+        }
+
+        tokens.clear();
+        bool ok = true;
+        for (std::size_t i = 0; i < shards.size(); ++i)
+        {
+            if (shards[i].empty())
+            {
+                continue;
+            }
+            batch_token_ptr token;
+            ok = clients_[i]->publish_batch(token, shards[i], positions[i]) && ok;
+            tokens.push_back(std::move(token));
+        }
+        return ok;
+    }
+
+    bool MqttClientPool::publish_batch(const std::vector<publish_request>& msgs, bool wait, unsigned int wait_for)
+    {
+        std::vector<batch_token_ptr> tokens;
+        bool ok = publish_batch(tokens, msgs);
+        if (wait)
+        {
+            using clock = std::chrono::steady_clock;
+            const auto deadline = clock::now() + std::chrono::milliseconds(wait_for);
+            for (const auto& token : tokens)
+            {
+                if (wait_for == 0)
+                {
+                    token->wait();
+                }
+                else
+                {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+                    ok = token->wait_for(static_cast<unsigned int>(std::max<int64_t>(left.count(), 1))) && ok;
+                }
+                ok = ok && token->failed() == 0;
+            }
+        }
+        return ok;
+    }
+} // namespace mqttcpp
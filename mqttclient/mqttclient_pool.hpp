@@ -0,0 +1,191 @@
+/**
+ * @file mqttclient_pool.hpp
+ * @brief A pool of MqttClient connections sharing the publish load.
+ *
+ * One MqttClient is one TCP connection and one paho send thread. The pool owns several
+ * clients connected to the same broker and routes each publish to one of them by a
+ * consistent hash of its topic, so all messages of a topic travel over the same
+ * connection and keep their order.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_CLIENT_POOL__
+#define __CORE_MQTT_CLIENT_POOL__
+#include <memory>
+#include <string>
+#include <vector>
+#include "mqttclient.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Owns N MqttClient instances and shards publishes across them by topic.
+     *
+     * Client IDs are derived from a common prefix as `<prefix>-<index>`. Connect, disconnect
+     * and status calls apply to every client in the pool; anything else (subscriptions,
+     * per-connection tuning) is done on the individual clients returned by client().
+     */
+    class MqttClientPool
+    {
+        std::vector<std::unique_ptr<MqttClient>> clients_; ///< The pooled clients, indexed by shard.
+
+        /**
+         * @brief Waits for every token in @p tokens, sharing one deadline.
+         *
+         * @param tokens The tokens to wait for; null entries are skipped.
+         * @param wait_for Maximum time (in milliseconds) to wait in total. 0 waits indefinitely.
+         * @return true if every token completed successfully in time.
+         */
+        static bool wait_all(const std::vector<mqtt::token_ptr>& tokens, unsigned int wait_for);
+
+    public:
+        /**
+         * @brief Creates @p size clients for @p serverAddress with derived client IDs.
+         *
+         * @param serverAddress The broker address shared by every client.
+         * @param clientIdPrefix Prefix of the client IDs; client i uses `<prefix>-<i>`.
+         * @param size Number of connections. Values below 1 are treated as 1.
+         * @param connectOptions Connection options applied to every client. The default is what a lone
+         *        MqttClient uses, including automatic reconnect.
+         */
+        MqttClientPool(const std::string& serverAddress,
+                       const std::string& clientIdPrefix,
+                       std::size_t size,
+                       mqtt::connect_options connectOptions = MqttClient::default_connect_options());
+
+        /**
+         * @brief Returns the number of clients in the pool.
+         */
+        inline std::size_t size() const
+        {
+            return clients_.size();
+        }
+
+        /**
+         * @brief Returns the client at @p index.
+         *
+         * @param index A shard index, lower than size().
+         */
+        inline MqttClient& client(std::size_t index)
+        {
+            return *clients_.at(index);
+        }
+
+        /**
+         * @brief Returns the index of the client that publishes to @p topic.
+         *
+         * The mapping only depends on the topic and the pool size, so it is stable across runs
+         * and processes.
+         *
+         * @param topic The topic to route.
+         */
+        std::size_t shard_of(const std::string& topic) const;
+
+        /**
+         * @brief Returns the client that publishes to @p topic.
+         *
+         * @param topic The topic to route.
+         */
+        inline MqttClient& client_for(const std::string& topic)
+        {
+            return *clients_[shard_of(topic)];
+        }
+
+        /**
+         * @brief Sets the event handler of every client in the pool.
+         *
+         * @param handler The handler, invoked from the callback thread of whichever client raised the event.
+         */
+        void set_event_handler(std::function<void(CallbackEvent, CallbackVariant)> handler);
+
+        /**
+         * @brief Connects every client to the broker.
+         *
+         * The connections are started together and, if requested, waited for with one shared deadline.
+         *
+         * @param wait If true, blocks until every connection completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every client started (and, when waiting, completed) its connection.
+         */
+        bool connect(bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Disconnects every client from the broker.
+         *
+         * @param wait If true, blocks until every disconnection completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every client started (and, when waiting, completed) its disconnection.
+         */
+        bool disconnect(bool wait = true, unsigned int wait_for = 0);
+
+        /**
+         * @brief Checks whether every client in the pool is connected.
+         */
+        bool connected();
+
+        /**
+         * @brief Returns how many clients in the pool are connected.
+         */
+        std::size_t connected_count();
+
+        /**
+         * @brief Publishes a message through the client owning @p topic.
+         *
+         * @param token A reference to a token pointer that will be used to track the publication.
+         * @param topic The topic to which the message will be published.
+         * @param payload The message payload.
+         * @param qos The Quality of Service level for the message (0, 1, or 2).
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(mqtt::token_ptr& token, const std::string& topic, const std::string& payload, unsigned int qos);
+
+        /**
+         * @brief Publishes a message through the client owning @p topic.
+         *
+         * @param topic The topic to which the message will be published.
+         * @param payload The message payload.
+         * @param qos The Quality of Service level for the message (0, 1, or 2).
+         * @param wait If true, blocks until the operation completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(const std::string& topic,
+                     const std::string& payload,
+                     unsigned int qos = 1,
+                     bool wait = true,
+                     unsigned int wait_for = 0);
+
+        /**
+         * @brief Publishes a prebuilt message through the client owning its topic.
+         *
+         * @param token A reference to a token pointer that will be used to track the publication.
+         * @param msg The message to publish. It is shared with the client, never copied.
+         * @return true if no error occurs; false otherwise.
+         */
+        bool publish(mqtt::token_ptr& token, mqtt::const_message_ptr msg);
+
+        /**
+         * @brief Publishes a batch, splitting it into one sub-batch per client.
+         *
+         * Messages keep their relative order within each topic. Failure indices reported by each
+         * BatchToken refer to positions in @p msgs, not in the sub-batch.
+         *
+         * @param tokens Receives one BatchToken per client that was given messages.
+         * @param msgs The messages to publish.
+         * @return true if every message was submitted; false if at least one submission failed.
+         */
+        bool publish_batch(std::vector<batch_token_ptr>& tokens, const std::vector<publish_request>& msgs);
+
+        /**
+         * @brief Publishes a batch across the pool and optionally waits for all of it.
+         *
+         * @param msgs The messages to publish.
+         * @param wait If true, blocks until every sub-batch completed or the timeout expires.
+         * @param wait_for Maximum time (in milliseconds) to wait. A value of 0 indicates infinite timeout.
+         * @return true if every message was submitted and, when waiting, acknowledged.
+         */
+        bool publish_batch(const std::vector<publish_request>& msgs, bool wait = true, unsigned int wait_for = 0);
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_CLIENT_POOL__
@@ -0,0 +1,67 @@
+#include "op_result.hpp"
+
+namespace mqttcpp
+{
+    const char* return_code_message(int returnCode)
+    {
+        switch (returnCode)
+        {
+        case MQTTASYNC_SUCCESS:
+            return "Success";
+        case MQTTASYNC_FAILURE:
+            return "Operation failed";
+        case MQTTASYNC_PERSISTENCE_ERROR:
+            return "Persistence error";
+        case MQTTASYNC_DISCONNECTED:
+            return "Client is disconnected";
+        case MQTTASYNC_MAX_MESSAGES_INFLIGHT:
+            return "Too many messages in flight";
+        case MQTTASYNC_BAD_UTF8_STRING:
+            return "Invalid UTF-8 string";
+        case MQTTASYNC_NULL_PARAMETER:
+            return "Null parameter";
+        case MQTTASYNC_TOPICNAME_TRUNCATED:
+            return "Topic name truncated";
+        case MQTTASYNC_BAD_STRUCTURE:
+            return "Bad structure";
+        case MQTTASYNC_BAD_QOS:
+            return "Invalid QoS";
+        case MQTTASYNC_NO_MORE_MSGIDS:
+            return "No more message identifiers";
+        case MQTTASYNC_OPERATION_INCOMPLETE:
+            return "Operation incomplete";
+        case MQTTASYNC_MAX_BUFFERED_MESSAGES:
+            return "Too many buffered messages";
+        case MQTTASYNC_SSL_NOT_SUPPORTED:
+            return "SSL is not supported";
+        case MQTTASYNC_BAD_PROTOCOL:
+            return "Invalid protocol";
+        case MQTTASYNC_BAD_MQTT_OPTION:
+            return "Invalid MQTT option";
+        case MQTTASYNC_WRONG_MQTT_VERSION:
+            return "Wrong MQTT version";
+        default:
+            return "MQTT error";
+        }
+    }
+
+    op_result op_result::from_current_exception()
+    {
+        try
+        {
+            throw;
+        }
+        catch (const mqtt::exception& exc)
+        {
+            return failure(exc.get_return_code(), exc.get_reason_code(), return_code_message(exc.get_return_code()));
+        }
+        catch (const std::exception&)
+        {
+            return op_result(op_error{ExceptionType::STANDARD, MQTTASYNC_FAILURE, 0, "Standard exception"});
+        }
+        catch (...)
+        {
+            return op_result(op_error{ExceptionType::UNKNOWN, MQTTASYNC_FAILURE, 0, "Unknown exception"});
+        }
+    }
+} // namespace mqttcpp
@@ -0,0 +1,113 @@
+/**
+ * @file op_result.hpp
+ * @brief Compact, non-throwing result of a client operation.
+ *
+ * An op_result carries its own error (paho return code, MQTT v5 reason code and a static
+ * message) so a caller can inspect the outcome of one call without going through the shared
+ * ExceptionTrace of the client.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_OP_RESULT__
+#define __CORE_MQTT_OP_RESULT__
+#include "types.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Error part of an op_result.
+     *
+     * Trivially copyable: the message always points to a string literal.
+     */
+    struct op_error
+    {
+        ExceptionType type;  ///< Kind of failure, NONE on success.
+        int returnCode;      ///< paho return code (MQTTASYNC_*), MQTTASYNC_SUCCESS on success.
+        int reasonCode;      ///< MQTT v5 reason code, 0 if not available.
+        const char* message; ///< Static description of the failure, never freed.
+    };
+
+    /**
+     * @brief Returns a static description of a paho return code.
+     *
+     * @param returnCode A paho return code (MQTTASYNC_*).
+     * @return A string literal; "MQTT error" for codes without a dedicated description.
+     */
+    const char* return_code_message(int returnCode);
+
+    /**
+     * @brief Outcome of a client operation, in the spirit of `std::expected<void, op_error>`.
+     */
+    class op_result
+    {
+        op_error error_; ///< The error, or a NONE error on success.
+
+        constexpr explicit op_result(const op_error& error) : error_(error)
+        {}
+
+    public:
+        /**
+         * @brief Constructs a successful result.
+         */
+        constexpr op_result() : error_{ExceptionType::NONE, 0, 0, "Success"}
+        {}
+
+        /**
+         * @brief Constructs a failed MQTT result.
+         *
+         * @param returnCode The paho return code.
+         * @param reasonCode The MQTT v5 reason code, 0 if not available.
+         * @param message A string literal describing the failure.
+         */
+        static constexpr op_result failure(int returnCode, int reasonCode, const char* message)
+        {
+            return op_result(op_error{ExceptionType::MQTT, returnCode, reasonCode, message});
+        }
+
+        /**
+         * @brief Converts the exception currently being handled into a result.
+         *
+         * Must be called from within a catch block. Only the codes are kept; the exception itself
+         * is neither copied nor logged.
+         */
+        static op_result from_current_exception();
+
+        /**
+         * @brief Checks whether the operation succeeded.
+         */
+        constexpr bool ok() const
+        {
+            return error_.type == ExceptionType::NONE;
+        }
+
+        constexpr explicit operator bool() const
+        {
+            return ok();
+        }
+
+        /**
+         * @brief Returns the error. Its type is NONE if the operation succeeded.
+         */
+        constexpr const op_error& error() const
+        {
+            return error_;
+        }
+
+        constexpr int return_code() const
+        {
+            return error_.returnCode;
+        }
+
+        constexpr int reason_code() const
+        {
+            return error_.reasonCode;
+        }
+
+        constexpr const char* message() const
+        {
+            return error_.message;
+        }
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_OP_RESULT__
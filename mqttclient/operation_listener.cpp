@@ -0,0 +1,98 @@
+#include "operation_listener.hpp"
+#include "mqttclient.hpp"
+
+namespace mqttcpp
+{
+    OperationListener::OperationListener(OperationListenerPool* pool) : parent_(nullptr), pool_(pool)
+    {}
+
+    void OperationListener::complete(const mqtt::token& tok, bool success)
+    {
+        MqttClient* parent = parent_;
+        uint64_t latency = 0;
+        if (tok.get_type() == mqtt::token::PUBLISH)
+        {
+            latency = parent->on_publish_complete(tok);
+        }
+        else if (success && tok.get_type() == mqtt::token::CONNECT)
+        {
+            parent->on_connect_complete(tok);
+        }
+        parent->record_completion(tok, success);
+
+        completion_record record{tok.get_type(),
+                                 tok.get_message_id(),
+                                 tok.get_user_context(),
+                                 tok.get_return_code(),
+                                 static_cast<int>(tok.get_reason_code()),
+                                 latency};
+        // Recycle first so the callback may start a new operation with this very listener
+        completion_callback callback = std::move(callback_);
+        pool_->release(this);
+        if (callback)
+        {
+            callback(record);
+        }
+
+        if (success && tok.get_type() == mqtt::token::DISCONNECT)
+        {
+            parent->report_manual_disconnect();
+        }
+    }
+
+    void OperationListener::dismiss(const completion_record& record)
+    {
+        completion_callback callback = std::move(callback_);
+        pool_->release(this);
+        if (callback)
+        {
+            callback(record);
+        }
+    }
+
+    void OperationListener::on_failure(const mqtt::token& asyncActionToken)
+    {
+        complete(asyncActionToken, false);
+    }
+
+    void OperationListener::on_success(const mqtt::token& asyncActionToken)
+    {
+        complete(asyncActionToken, true);
+    }
+
+    OperationListener* OperationListenerPool::acquire(MqttClient* parent, completion_callback callback)
+    {
+        OperationListener* listener = nullptr;
+        {
+            lg lock(guard_);
+            if (free_.empty())
+            {
+                storage_.push_back(std::make_unique<OperationListener>(this));
+                // Keep room for every listener so release() never reallocates
+                free_.reserve(storage_.capacity());
+                listener = storage_.back().get();
+            }
+            else
+            {
+                listener = free_.back();
+                free_.pop_back();
+            }
+        }
+        listener->parent_ = parent;
+        listener->callback_ = std::move(callback);
+        return listener;
+    }
+
+    void OperationListenerPool::release(OperationListener* listener)
+    {
+        listener->callback_ = nullptr;
+        lg lock(guard_);
+        free_.push_back(listener);
+    }
+
+    operation_pool_stats OperationListenerPool::get_stats() const
+    {
+        lg lock(guard_);
+        return operation_pool_stats{storage_.size(), storage_.size() - free_.size()};
+    }
+} // namespace mqttcpp
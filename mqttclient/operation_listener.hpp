@@ -0,0 +1,229 @@
+/**
+ * @file operation_listener.hpp
+ * @brief Pooled action listeners carrying a per-call completion callback.
+ *
+ * paho needs an action listener that outlives each asynchronous call. Instead of allocating
+ * one per call, listeners are recycled through a pool owned by the client: a listener is
+ * taken when the operation starts and given back just before its callback runs.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_OPERATION_LISTENER__
+#define __CORE_MQTT_OPERATION_LISTENER__
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "mqtt/iaction_listener.h"
+#include "completion_queue.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Continuation invoked once when an operation completes.
+     *
+     * A move-only callable stored inline, so attaching a callback to an operation never allocates. Captures are
+     * limited to InlineSize bytes, enough for a shared_ptr and a std::string; a larger capture fails to compile
+     * and should hold its state behind a pointer instead.
+     */
+    class completion_callback
+    {
+    public:
+        static constexpr std::size_t InlineSize = 64; ///< Largest callable stored, in bytes.
+
+        completion_callback() noexcept = default;
+
+        completion_callback(std::nullptr_t) noexcept
+        {}
+
+        /**
+         * @brief Stores @p fn. A null function pointer or an empty std::function leaves the callback empty.
+         */
+        template <typename Fn,
+                  typename F = std::decay_t<Fn>,
+                  typename = std::enable_if_t<!std::is_same_v<F, completion_callback> &&
+                                              std::is_invocable_v<F&, const completion_record&>>>
+        completion_callback(Fn&& fn)
+        {
+            static_assert(sizeof(F) <= InlineSize, "completion callback capture exceeds completion_callback::InlineSize");
+            static_assert(alignof(F) <= alignof(std::max_align_t), "completion callback is over-aligned");
+            static_assert(std::is_nothrow_move_constructible_v<F>, "completion callback must be nothrow movable");
+            if constexpr (std::is_constructible_v<bool, F&>)
+            {
+                if (!static_cast<bool>(fn))
+                {
+                    return;
+                }
+            }
+            ::new (static_cast<void*>(&storage_)) F(std::forward<Fn>(fn));
+            ops_ = &ops_for<F>;
+        }
+
+        completion_callback(completion_callback&& other) noexcept
+        {
+            take(other);
+        }
+
+        completion_callback& operator=(completion_callback&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        completion_callback& operator=(std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        completion_callback(const completion_callback&) = delete;
+        completion_callback& operator=(const completion_callback&) = delete;
+
+        ~completion_callback()
+        {
+            reset();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return ops_ != nullptr;
+        }
+
+        void operator()(const completion_record& record)
+        {
+            ops_->invoke(&storage_, record);
+        }
+
+    private:
+        /**
+         * @brief Type-erased operations of the stored callable.
+         */
+        struct operations
+        {
+            void (*invoke)(void* fn, const completion_record& record);
+            void (*move)(void* to, void* from) noexcept; ///< Move-constructs into @p to, then destroys @p from.
+            void (*destroy)(void* fn) noexcept;
+        };
+
+        template <typename F>
+        static constexpr operations ops_for{
+            [](void* fn, const completion_record& record) { (*static_cast<F*>(fn))(record); },
+            [](void* to, void* from) noexcept {
+                ::new (to) F(std::move(*static_cast<F*>(from)));
+                static_cast<F*>(from)->~F();
+            },
+            [](void* fn) noexcept { static_cast<F*>(fn)->~F(); }};
+
+        void take(completion_callback& other) noexcept
+        {
+            if (other.ops_)
+            {
+                other.ops_->move(&storage_, &other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+
+        void reset() noexcept
+        {
+            if (ops_)
+            {
+                ops_->destroy(&storage_);
+                ops_ = nullptr;
+            }
+        }
+
+        std::aligned_storage_t<InlineSize, alignof(std::max_align_t)> storage_; ///< The stored callable.
+        const operations* ops_ = nullptr;                                       ///< Null when empty.
+    };
+
+    /**
+     * @brief Snapshot of the listener pool counters.
+     */
+    struct operation_pool_stats
+    {
+        std::size_t allocated; ///< Listeners created so far; the pool never shrinks.
+        std::size_t inUse;     ///< Listeners attached to pending operations.
+    };
+
+    class OperationListenerPool;
+
+    /**
+     * @brief Action listener that runs one completion callback and returns to its pool.
+     *
+     * Completions still update the client's publish window, congestion controller and
+     * connection state, but bypass the client's event handler and completion queue.
+     */
+    class OperationListener : public mqtt::iaction_listener
+    {
+        friend class OperationListenerPool;
+
+        class MqttClient* parent_;     ///< Client that started the operation.
+        OperationListenerPool* pool_;  ///< Pool the listener returns to.
+        completion_callback callback_; ///< Continuation of the pending operation.
+
+        /**
+         * @brief Runs the client bookkeeping, recycles the listener, then invokes the callback.
+         */
+        void complete(const mqtt::token& tok, bool success);
+
+    public:
+        explicit OperationListener(OperationListenerPool* pool);
+
+        /**
+         * @brief Completes the operation without a token, e.g. when it never reached the broker.
+         *
+         * @param record The record passed to the callback.
+         */
+        void dismiss(const completion_record& record);
+
+        void on_failure(const mqtt::token& asyncActionToken) override;
+        void on_success(const mqtt::token& asyncActionToken) override;
+    };
+
+    /**
+     * @brief Free list of OperationListener objects.
+     *
+     * The pool grows on demand and reuses listeners afterwards, so in steady state starting
+     * an operation with a callback does not allocate a listener.
+     */
+    class OperationListenerPool
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+        mutable std::mutex guard_;                                ///< Mutex guarding the free list.
+        std::vector<std::unique_ptr<OperationListener>> storage_; ///< Every listener ever created.
+        std::vector<OperationListener*> free_;                    ///< Listeners ready for reuse.
+
+    public:
+        /**
+         * @brief Takes a listener and attaches @p callback to it.
+         *
+         * @param parent The client starting the operation.
+         * @param callback The continuation to run on completion.
+         * @return A listener to register with the operation.
+         */
+        OperationListener* acquire(class MqttClient* parent, completion_callback callback);
+
+        /**
+         * @brief Gives a listener back without running its callback.
+         *
+         * @param listener A listener returned by acquire() whose operation was never started.
+         */
+        void release(OperationListener* listener);
+
+        /**
+         * @brief Returns a snapshot of the pool counters.
+         */
+        operation_pool_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_OPERATION_LISTENER__
@@ -0,0 +1,135 @@
+#include "publish_window.hpp"
+
+namespace mqttcpp
+{
+    PublishWindow::PublishWindow() : inflight_(0), blockedCount_(0), blockedNanos_(0), rejected_(0)
+    {}
+
+    void PublishWindow::set_options(const publish_window_options& opts)
+    {
+        {
+            lg lock(guard_);
+            opts_ = opts;
+        }
+        cv_.notify_all();
+    }
+
+    publish_window_options PublishWindow::get_options() const
+    {
+        lg lock(guard_);
+        return opts_;
+    }
+
+    void PublishWindow::set_limit(std::size_t maxInflight)
+    {
+        {
+            lg lock(guard_);
+            opts_.maxInflight = maxInflight;
+        }
+        cv_.notify_all();
+    }
+
+    PublishWindow::Admission PublishWindow::admit(queued_publish& pub)
+    {
+        if (pub.msg->get_qos() == 0)
+        {
+            return Admission::ADMITTED;
+        }
+
+        std::unique_lock<std::mutex> lock(guard_);
+        if (opts_.mode == BackpressureMode::QUEUE)
+        {
+            // Keep submission order: nothing overtakes messages already in the backlog
+            if (queue_.empty() && has_room())
+            {
+                ++inflight_;
+                return Admission::ADMITTED;
+            }
+            if (opts_.maxQueued == 0 || queue_.size() < opts_.maxQueued)
+            {
+                queue_.push_back(std::move(pub));
+                return Admission::QUEUED;
+            }
+            ++rejected_;
+            return Admission::REJECTED;
+        }
+
+        if (!has_room())
+        {
+            if (opts_.mode == BackpressureMode::FAIL)
+            {
+                ++rejected_;
+                return Admission::REJECTED;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            bool ready = true;
+            if (opts_.blockTimeout == 0)
+            {
+                cv_.wait(lock, [this] { return has_room(); });
+            }
+            else
+            {
+                ready = cv_.wait_until(lock, start + std::chrono::milliseconds(opts_.blockTimeout), [this] {
+                    return has_room();
+                });
+            }
+            ++blockedCount_;
+            blockedNanos_ += static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            if (!ready)
+            {
+                ++rejected_;
+                return Admission::REJECTED;
+            }
+        }
+        ++inflight_;
+        return Admission::ADMITTED;
+    }
+
+    bool PublishWindow::try_admit(const mqtt::const_message_ptr& msg)
+    {
+        if (msg->get_qos() == 0)
+        {
+            return true;
+        }
+        lg lock(guard_);
+        if (!queue_.empty() || !has_room())
+        {
+            return false;
+        }
+        ++inflight_;
+        return true;
+    }
+
+    void PublishWindow::release()
+    {
+        {
+            lg lock(guard_);
+            if (inflight_ > 0)
+            {
+                --inflight_;
+            }
+        }
+        cv_.notify_one();
+    }
+
+    bool PublishWindow::take_ready(queued_publish& pub)
+    {
+        lg lock(guard_);
+        if (queue_.empty() || !has_room())
+        {
+            return false;
+        }
+        pub = std::move(queue_.front());
+        queue_.pop_front();
+        ++inflight_;
+        return true;
+    }
+
+    publish_window_stats PublishWindow::get_stats() const
+    {
+        lg lock(guard_);
+        return publish_window_stats{inflight_, opts_.maxInflight, queue_.size(), blockedCount_, blockedNanos_, rejected_};
+    }
+} // namespace mqttcpp
@@ -0,0 +1,162 @@
+/**
+ * @file publish_window.hpp
+ * @brief Bounded in-flight window for outgoing QoS 1/2 publishes.
+ *
+ * The window limits how many acknowledged publishes may be outstanding at once and
+ * applies a configurable backpressure mode when that limit is reached.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_PUBLISH_WINDOW__
+#define __CORE_MQTT_PUBLISH_WINDOW__
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "mqtt/message.h"
+#include "mqtt/iaction_listener.h"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Behaviour of a publish when the in-flight window is full.
+     */
+    enum class BackpressureMode
+    {
+        BLOCK, ///< Block the caller until a slot frees up or the deadline expires.
+        FAIL,  ///< Fail the publish immediately.
+        QUEUE  ///< Queue the message and submit it asynchronously once a slot frees up.
+    };
+
+    /**
+     * @brief Configuration of the publish window.
+     */
+    struct publish_window_options
+    {
+        std::size_t maxInflight = 0;                     ///< Maximum outstanding QoS 1/2 publishes, 0 for unlimited.
+        BackpressureMode mode = BackpressureMode::BLOCK; ///< What to do when the window is full.
+        unsigned int blockTimeout = 0;                   ///< BLOCK deadline in milliseconds, 0 to wait indefinitely.
+        std::size_t maxQueued = 0;                       ///< QUEUE capacity, 0 for unbounded.
+    };
+
+    /**
+     * @brief Snapshot of the publish window counters.
+     */
+    struct publish_window_stats
+    {
+        std::size_t inflight;  ///< QoS 1/2 publishes currently awaiting completion.
+        std::size_t limit;     ///< Current in-flight limit, 0 for unlimited.
+        std::size_t queued;    ///< Messages waiting in the QUEUE backlog.
+        uint64_t blockedCount; ///< Number of publishes that had to block.
+        uint64_t blockedNanos; ///< Total time spent blocked, in nanoseconds.
+        uint64_t rejected;     ///< Publishes refused because the window was full.
+    };
+
+    /**
+     * @brief A publish that was deferred by the QUEUE backpressure mode.
+     */
+    struct queued_publish
+    {
+        mqtt::const_message_ptr msg;                ///< The message to submit.
+        mqtt::iaction_listener* listener = nullptr; ///< Listener to register with the deferred publish.
+        void* context = nullptr;                    ///< User context to register with the deferred publish.
+    };
+
+    /**
+     * @brief Counts outstanding QoS 1/2 publishes and enforces the in-flight limit.
+     *
+     * QoS 0 messages are never counted. A slot is taken by admit() and given back by
+     * release() when the publish completes, successfully or not.
+     */
+    class PublishWindow
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+        mutable std::mutex guard_;         ///< Mutex guarding the window state.
+        std::condition_variable cv_;       ///< Signalled when a slot is released.
+        publish_window_options opts_;      ///< Current configuration.
+        std::size_t inflight_;             ///< Outstanding QoS 1/2 publishes.
+        std::deque<queued_publish> queue_; ///< Backlog of the QUEUE mode.
+        uint64_t blockedCount_;            ///< Number of publishes that had to block.
+        uint64_t blockedNanos_;            ///< Total time spent blocked.
+        uint64_t rejected_;                ///< Publishes refused because the window was full.
+
+        inline bool has_room() const
+        {
+            return opts_.maxInflight == 0 || inflight_ < opts_.maxInflight;
+        }
+
+    public:
+        /**
+         * @brief Result of asking the window for a slot.
+         */
+        enum class Admission
+        {
+            ADMITTED, ///< The caller may submit the message now.
+            QUEUED,   ///< The message was stored and will be returned by take_ready().
+            REJECTED  ///< The window is full and the message must not be submitted.
+        };
+
+        PublishWindow();
+
+        /**
+         * @brief Replaces the window configuration.
+         *
+         * Raising the limit does not submit queued messages by itself; call take_ready() afterwards.
+         *
+         * @param opts The new configuration.
+         */
+        void set_options(const publish_window_options& opts);
+
+        /**
+         * @brief Returns the current window configuration.
+         */
+        publish_window_options get_options() const;
+
+        /**
+         * @brief Changes only the in-flight limit, keeping the rest of the configuration.
+         *
+         * @param maxInflight The new limit, 0 for unlimited.
+         */
+        void set_limit(std::size_t maxInflight);
+
+        /**
+         * @brief Takes a slot for @p pub according to the configured backpressure mode.
+         *
+         * @param pub The publish asking for a slot. It is moved into the backlog if queued.
+         * @return Whether the message may be submitted, was queued, or was rejected.
+         */
+        Admission admit(queued_publish& pub);
+
+        /**
+         * @brief Takes a slot for @p msg only if one is free right now, whatever the backpressure mode.
+         *
+         * Never blocks, queues or counts a rejection. QoS 0 messages are always admitted.
+         *
+         * @param msg The message asking for a slot.
+         * @return true if the caller may submit the message now.
+         */
+        bool try_admit(const mqtt::const_message_ptr& msg);
+
+        /**
+         * @brief Gives back the slot of a completed QoS 1/2 publish.
+         */
+        void release();
+
+        /**
+         * @brief Pops the next queued message if a slot is free, taking the slot for it.
+         *
+         * @param pub Receives the message to submit.
+         * @return true if a message was popped; false if the backlog is empty or the window is full.
+         */
+        bool take_ready(queued_publish& pub);
+
+        /**
+         * @brief Returns a snapshot of the window counters.
+         */
+        publish_window_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_PUBLISH_WINDOW__
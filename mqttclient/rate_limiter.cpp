@@ -0,0 +1,164 @@
+#include "rate_limiter.hpp"
+#include "topic_filter.hpp"
+#include "topic_simd.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace mqttcpp
+{
+    static int64_t steady_now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    TokenBucket::TokenBucket(double rate, std::size_t burst)
+        : tat_(0), interval_(std::max<int64_t>(1, static_cast<int64_t>(1e9 / rate))),
+          tolerance_(static_cast<int64_t>(std::max<std::size_t>(burst, 1) - 1) * interval_)
+    {}
+
+    int64_t TokenBucket::try_acquire(int64_t now)
+    {
+        int64_t old = tat_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            int64_t tat = std::max(old, now);
+            if (tat - now > tolerance_)
+            {
+                return tat - now - tolerance_;
+            }
+            if (tat_.compare_exchange_weak(old, tat + interval_, std::memory_order_relaxed))
+            {
+                return 0;
+            }
+        }
+    }
+
+    int64_t TokenBucket::reserve(int64_t now)
+    {
+        int64_t old = tat_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            int64_t tat = std::max(old, now);
+            if (tat_.compare_exchange_weak(old, tat + interval_, std::memory_order_relaxed))
+            {
+                return std::max<int64_t>(0, tat - now - tolerance_);
+            }
+        }
+    }
+
+    void TokenBucket::refund()
+    {
+        tat_.fetch_sub(interval_, std::memory_order_relaxed);
+    }
+
+    RateLimiter::RateLimiter()
+        : rules_(std::make_shared<const rule_set>()), active_(false), delayed_(0), delayedNanos_(0), dropped_(0),
+          failed_(0)
+    {}
+
+    void RateLimiter::set_rule(const std::string& filter, double rate, std::size_t burst, RateLimitMode mode)
+    {
+        lg lock(configGuard_);
+        auto rules = std::make_shared<rule_set>(*std::atomic_load(&rules_));
+        rules->erase(std::remove_if(rules->begin(), rules->end(), [&filter](const rule& r) { return r.filter == filter; }),
+                     rules->end());
+        if (rate > 0)
+        {
+            rule r{filter, mode, std::make_shared<TokenBucket>(rate, burst)};
+            // The global limit is checked first
+            rules->insert(filter.empty() ? rules->begin() : rules->end(), std::move(r));
+        }
+        active_.store(!rules->empty());
+        std::atomic_store(&rules_, std::shared_ptr<const rule_set>(std::move(rules)));
+    }
+
+    void RateLimiter::set_global_limit(double rate, std::size_t burst, RateLimitMode mode)
+    {
+        set_rule(std::string(), rate, burst, mode);
+    }
+
+    bool RateLimiter::set_topic_limit(const std::string& filter, double rate, std::size_t burst, RateLimitMode mode)
+    {
+        if (!is_valid_topic_filter(filter))
+        {
+            return false;
+        }
+        set_rule(filter, rate, burst, mode);
+        return true;
+    }
+
+    RateLimiter::Decision RateLimiter::acquire(const std::string& topic)
+    {
+        if (!active_.load(std::memory_order_relaxed))
+        {
+            return Decision::PASS;
+        }
+
+        std::shared_ptr<const rule_set> rules = std::atomic_load(&rules_);
+        const int64_t now = steady_now();
+        int64_t wait = 0;
+        for (auto it = rules->begin(); it != rules->end(); ++it)
+        {
+            if (!it->filter.empty() && !filter_matches(it->filter, topic))
+            {
+                continue;
+            }
+            if (it->mode == RateLimitMode::DELAY)
+            {
+                wait = std::max(wait, it->bucket->reserve(now));
+                continue;
+            }
+            if (it->bucket->try_acquire(now) != 0)
+            {
+                // Give back what the earlier buckets handed out for this publish
+                for (auto taken = rules->begin(); taken != it; ++taken)
+                {
+                    if (taken->filter.empty() || filter_matches(taken->filter, topic))
+                    {
+                        taken->bucket->refund();
+                    }
+                }
+                if (it->mode == RateLimitMode::DROP)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return Decision::DROP;
+                }
+                failed_.fetch_add(1, std::memory_order_relaxed);
+                return Decision::FAIL;
+            }
+        }
+
+        if (wait > 0)
+        {
+            delayed_.fetch_add(1, std::memory_order_relaxed);
+            delayedNanos_.fetch_add(static_cast<uint64_t>(wait), std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+        return Decision::PASS;
+    }
+
+    void RateLimiter::release(const std::string& topic)
+    {
+        if (!active_.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        std::shared_ptr<const rule_set> rules = std::atomic_load(&rules_);
+        for (const auto& r : *rules)
+        {
+            if (r.filter.empty() || filter_matches(r.filter, topic))
+            {
+                r.bucket->refund();
+            }
+        }
+    }
+
+    rate_limit_stats RateLimiter::get_stats() const
+    {
+        return rate_limit_stats{delayed_.load(), delayedNanos_.load(), dropped_.load(), failed_.load()};
+    }
+} // namespace mqttcpp
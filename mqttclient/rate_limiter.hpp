@@ -0,0 +1,174 @@
+/**
+ * @file rate_limiter.hpp
+ * @brief Token-bucket rate limiting of outgoing publishes.
+ *
+ * Buckets are implemented with the generic cell rate algorithm (GCRA): the whole bucket
+ * state is one atomic "theoretical arrival time", so taking a token is a single
+ * compare-and-swap and never takes a lock.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_RATE_LIMITER__
+#define __CORE_MQTT_RATE_LIMITER__
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mqttcpp
+{
+    /**
+     * @brief What happens to a publish that exceeds its rate limit.
+     */
+    enum class RateLimitMode
+    {
+        DELAY, ///< Block the caller until a token is available.
+        DROP,  ///< Silently discard the message.
+        FAIL   ///< Fail the publish with a QUOTA_EXCEEDED error.
+    };
+
+    /**
+     * @brief Snapshot of the rate limiter counters.
+     */
+    struct rate_limit_stats
+    {
+        uint64_t delayed;      ///< Publishes that had to wait for a token.
+        uint64_t delayedNanos; ///< Total time spent waiting, in nanoseconds.
+        uint64_t dropped;      ///< Publishes discarded by a DROP limit.
+        uint64_t failed;       ///< Publishes refused by a FAIL limit.
+    };
+
+    /**
+     * @brief Lock-free token bucket.
+     *
+     * Refills at `rate` tokens per second and holds at most `burst` tokens.
+     */
+    class TokenBucket
+    {
+        std::atomic<int64_t> tat_; ///< Theoretical arrival time of the next conforming request, in ns.
+        const int64_t interval_;   ///< Nanoseconds per token.
+        const int64_t tolerance_;  ///< How far ahead of now the arrival time may run: (burst - 1) * interval.
+
+    public:
+        /**
+         * @brief Constructs a full bucket.
+         *
+         * @param rate Tokens added per second. Must be positive.
+         * @param burst Bucket capacity. Values below 1 are treated as 1.
+         */
+        TokenBucket(double rate, std::size_t burst);
+
+        /**
+         * @brief Takes a token if one is available.
+         *
+         * @param now Current steady-clock time, in nanoseconds.
+         * @return 0 if a token was taken; otherwise the nanoseconds until one becomes available.
+         */
+        int64_t try_acquire(int64_t now);
+
+        /**
+         * @brief Takes a token unconditionally, going into debt if needed.
+         *
+         * @param now Current steady-clock time, in nanoseconds.
+         * @return The nanoseconds the caller must wait before using the token (0 if none).
+         */
+        int64_t reserve(int64_t now);
+
+        /**
+         * @brief Gives back a token taken by try_acquire() or reserve().
+         */
+        void refund();
+    };
+
+    /**
+     * @brief Applies a global limit and per topic-filter limits to publishes.
+     *
+     * The rule set is immutable once published and swapped atomically on reconfiguration,
+     * so concurrent publishers only read a shared pointer and update bucket atomics.
+     */
+    class RateLimiter
+    {
+        using lg = std::lock_guard<std::mutex>;
+
+        /**
+         * @brief A configured limit.
+         */
+        struct rule
+        {
+            std::string filter;                  ///< Topic filter, empty for the global limit.
+            RateLimitMode mode;                  ///< What to do when the limit is exceeded.
+            std::shared_ptr<TokenBucket> bucket; ///< The bucket shared by every matching topic.
+        };
+        using rule_set = std::vector<rule>;
+
+        std::mutex configGuard_;                ///< Serializes reconfiguration.
+        std::shared_ptr<const rule_set> rules_; ///< Current rules, accessed with std::atomic_load/store.
+        std::atomic<bool> active_;              ///< Whether any rule is configured.
+        std::atomic<uint64_t> delayed_;         ///< Publishes that had to wait.
+        std::atomic<uint64_t> delayedNanos_;    ///< Total time spent waiting.
+        std::atomic<uint64_t> dropped_;         ///< Publishes discarded.
+        std::atomic<uint64_t> failed_;          ///< Publishes refused.
+
+        void set_rule(const std::string& filter, double rate, std::size_t burst, RateLimitMode mode);
+
+    public:
+        /**
+         * @brief Outcome of asking the limiter for a publish.
+         */
+        enum class Decision
+        {
+            PASS, ///< The publish may proceed (possibly after a DELAY wait).
+            DROP, ///< The publish must be discarded silently.
+            FAIL  ///< The publish must fail.
+        };
+
+        RateLimiter();
+
+        /**
+         * @brief Sets the limit applied to every publish.
+         *
+         * @param rate Messages per second; 0 removes the limit.
+         * @param burst Maximum number of messages that may be sent back to back.
+         * @param mode What to do with publishes over the limit.
+         */
+        void set_global_limit(double rate, std::size_t burst, RateLimitMode mode);
+
+        /**
+         * @brief Sets a limit shared by every topic matching @p filter.
+         *
+         * @param filter An MQTT topic filter, wildcards allowed.
+         * @param rate Messages per second; 0 removes the limit.
+         * @param burst Maximum number of messages that may be sent back to back.
+         * @param mode What to do with publishes over the limit.
+         * @return false if @p filter is not a well-formed topic filter, in which case nothing changes.
+         */
+        bool set_topic_limit(const std::string& filter, double rate, std::size_t burst, RateLimitMode mode);
+
+        /**
+         * @brief Takes a token from the global bucket and from every bucket matching @p topic.
+         *
+         * DELAY limits make the caller sleep. If a DROP or FAIL limit is exceeded, tokens already
+         * taken from other buckets are given back.
+         *
+         * @param topic The topic being published to.
+         * @return Whether the publish may proceed.
+         */
+        Decision acquire(const std::string& topic);
+
+        /**
+         * @brief Gives back the tokens a passed acquire() took for @p topic, when the publish is not sent after all.
+         *
+         * @param topic The topic given to acquire().
+         */
+        void release(const std::string& topic);
+
+        /**
+         * @brief Returns a snapshot of the limiter counters.
+         */
+        rate_limit_stats get_stats() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_RATE_LIMITER__
@@ -0,0 +1,119 @@
+#include "send_times.hpp"
+#include <algorithm>
+
+namespace mqttcpp
+{
+    static constexpr unsigned TIME_SHIFT = 4;                      ///< Send times are kept in units of 16 ns.
+    static constexpr uint64_t TIME_MASK = (uint64_t(1) << 46) - 1; ///< Bits of the send time kept per slot.
+    static constexpr uint64_t ID_MASK = 0xFFFF;                    ///< MQTT packet identifiers are 16 bits.
+    static constexpr uint64_t ACKED = uint64_t(1) << 63;           ///< The slot holds an ack time, not a send time.
+    static constexpr uint64_t ACKED_OK = uint64_t(1) << 62;        ///< The early completion was a success.
+
+    static uint64_t time_units(std::chrono::steady_clock::time_point when)
+    {
+        return (static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count()) >>
+                TIME_SHIFT) &
+               TIME_MASK;
+    }
+
+    static bool same_id(uint64_t entry, int msgId)
+    {
+        return (entry & ID_MASK) == (static_cast<uint64_t>(msgId) & ID_MASK);
+    }
+
+    SendTimes::SendTimes() : slots_(nullptr)
+    {}
+
+    SendTimes::~SendTimes()
+    {
+        delete[] slots_.load(std::memory_order_acquire);
+    }
+
+    std::atomic<uint64_t>* SendTimes::table()
+    {
+        std::atomic<uint64_t>* slots = slots_.load(std::memory_order_acquire);
+        if (!slots)
+        {
+            auto* fresh = new std::atomic<uint64_t>[Slots]();
+            if (slots_.compare_exchange_strong(slots, fresh, std::memory_order_acq_rel))
+            {
+                slots = fresh;
+            }
+            else
+            {
+                delete[] fresh;
+            }
+        }
+        return slots;
+    }
+
+    uint64_t SendTimes::stamp(int msgId, clock::time_point sentAt)
+    {
+        if (msgId <= 0)
+        {
+            return 0;
+        }
+        std::atomic<uint64_t>& slot = table()[static_cast<std::size_t>(msgId) % Slots];
+        const uint64_t sent = time_units(sentAt);
+        uint64_t entry = slot.load(std::memory_order_relaxed);
+        while (true)
+        {
+            if ((entry & ACKED) && same_id(entry, msgId))
+            {
+                // An ack taken before the send time wraps to more than half the range: it belongs to an
+                // earlier publish with this identifier
+                const uint64_t elapsed = (((entry >> 16) & TIME_MASK) - sent) & TIME_MASK;
+                if (elapsed <= TIME_MASK / 2)
+                {
+                    if (!slot.compare_exchange_weak(entry, 0, std::memory_order_relaxed))
+                    {
+                        continue;
+                    }
+                    return (entry & ACKED_OK) ? std::max<uint64_t>(elapsed << TIME_SHIFT, 1) : 0;
+                }
+            }
+            // A valid packet identifier is never 0, so a stamped slot never reads as empty
+            if (slot.compare_exchange_weak(
+                    entry, (sent << 16) | (static_cast<uint64_t>(msgId) & ID_MASK), std::memory_order_relaxed))
+            {
+                return 0;
+            }
+        }
+    }
+
+    uint64_t SendTimes::take_latency(int msgId, bool success)
+    {
+        if (msgId <= 0)
+        {
+            return 0;
+        }
+        std::atomic<uint64_t>& slot = table()[static_cast<std::size_t>(msgId) % Slots];
+        const uint64_t now = time_units(clock::now());
+        uint64_t entry = slot.load(std::memory_order_relaxed);
+        while (true)
+        {
+            if (entry != 0 && !(entry & ACKED))
+            {
+                // Stamped by a later publish sharing the slot: leave it to its owner
+                if (!same_id(entry, msgId))
+                {
+                    return 0;
+                }
+                if (slot.compare_exchange_weak(entry, 0, std::memory_order_relaxed))
+                {
+                    const uint64_t elapsed = (now - (entry >> 16)) & TIME_MASK;
+                    return elapsed << TIME_SHIFT;
+                }
+                continue;
+            }
+            // Not stamped yet: the publish call has not returned. Leave the ack time for stamp()
+            const uint64_t mark = ACKED | (success ? ACKED_OK : 0) | (now << 16) |
+                                  (static_cast<uint64_t>(msgId) & ID_MASK);
+            if (slot.compare_exchange_weak(entry, mark, std::memory_order_relaxed))
+            {
+                return 0;
+            }
+        }
+    }
+} // namespace mqttcpp
@@ -0,0 +1,74 @@
+/**
+ * @file send_times.hpp
+ * @brief Send times of in-flight QoS 1/2 publishes, by packet identifier.
+ *
+ * One table per client feeds both the congestion controller and the latency of completion
+ * records, so a publish is stamped once and its latency taken once.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_SEND_TIMES__
+#define __CORE_MQTT_SEND_TIMES__
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mqttcpp
+{
+    /**
+     * @brief Lock-free table of send times indexed by packet identifier, modulo Slots.
+     *
+     * The table is allocated by the first stamp or completion, so a client that never publishes at QoS 1/2 does
+     * not pay for it. Each slot packs the 16-bit packet identifier with the low 46 bits of the send time, in units
+     * of 16 ns, so latencies up to 13 days come out right across the wrap. With more than Slots publishes in
+     * flight two of them may share a slot: the later send wins, and the other publish finds another identifier
+     * there and completes with an unknown latency rather than the later send's.
+     *
+     * The acknowledgement may be handled before the publish call returns and stamps its send time. The
+     * completion then leaves its own time in the slot, and the late stamp takes the latency from it.
+     */
+    class SendTimes
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::atomic<std::atomic<uint64_t>*> slots_; ///< Tagged send or ack time per slot, 0 if empty; null until used.
+
+        /**
+         * @brief Returns the slots, allocating them on first use.
+         */
+        std::atomic<uint64_t>* table();
+
+    public:
+        static constexpr std::size_t Slots = 4096; ///< Packet identifiers tracked, modulo.
+
+        SendTimes();
+        ~SendTimes();
+
+        SendTimes(const SendTimes&) = delete;
+        SendTimes& operator=(const SendTimes&) = delete;
+
+        /**
+         * @brief Records the send time of a QoS 1/2 publish.
+         *
+         * @param msgId The MQTT packet identifier of the publish.
+         * @param sentAt Time taken before the publish was handed to the client.
+         * @return The latency in nanoseconds if the publish was already acknowledged, which take_latency()
+         *         could not report; 0 otherwise, or if the early completion was a failure.
+         */
+        uint64_t stamp(int msgId, clock::time_point sentAt);
+
+        /**
+         * @brief Returns and forgets the time elapsed since the stamp of @p msgId.
+         *
+         * If @p msgId is not stamped yet, the completion time is kept for the stamp that follows.
+         *
+         * @param msgId The MQTT packet identifier of the publish.
+         * @param success Whether the publish was acknowledged; a late stamp reports no latency for a failure.
+         * @return The latency in nanoseconds, 0 if the send time is unknown.
+         */
+        uint64_t take_latency(int msgId, bool success = true);
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_SEND_TIMES__
@@ -0,0 +1,126 @@
+#include "topic_dispatcher.hpp"
+#include "topic_filter.hpp"
+#include <mutex>
+
+namespace mqttcpp
+{
+    TopicDispatcher::TopicDispatcher() : count_(0)
+    {}
+
+    TopicDispatcher::handler_id TopicDispatcher::add(const std::string& filter, message_handler handler)
+    {
+        if (!handler)
+        {
+            return INVALID_HANDLER;
+        }
+        return add(filter, std::make_shared<const message_handler>(std::move(handler)));
+    }
+
+    TopicDispatcher::handler_id TopicDispatcher::add(const std::string& filter, handler_ptr handler)
+    {
+        if (!handler || !*handler || !is_valid_topic_filter(filter))
+        {
+            return INVALID_HANDLER;
+        }
+        std::unique_lock<std::shared_mutex> lock(guard_);
+        uint32_t index;
+        if (!freeSlots_.empty())
+        {
+            index = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots_.size());
+            // Generations start at 1 so that no id equals INVALID_HANDLER
+            slots_.push_back(slot{nullptr, TopicIndex::NONE, 1});
+        }
+        slot& s = slots_[index];
+        s.handler = std::move(handler);
+        s.node = index_.insert(filter, index);
+        ++count_;
+        return (static_cast<handler_id>(s.generation) << 32) | index;
+    }
+
+    bool TopicDispatcher::remove(handler_id id)
+    {
+        const auto index = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+        const auto generation = static_cast<uint32_t>(id >> 32);
+        std::unique_lock<std::shared_mutex> lock(guard_);
+        if (index >= slots_.size() || slots_[index].generation != generation || !slots_[index].handler)
+        {
+            return false;
+        }
+        slot& s = slots_[index];
+        index_.erase(s.node, index);
+        s.handler.reset();
+        s.node = TopicIndex::NONE;
+        ++s.generation;
+        freeSlots_.push_back(index);
+        --count_;
+        return true;
+    }
+
+    void TopicDispatcher::clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(guard_);
+        index_.clear();
+        freeSlots_.clear();
+        for (uint32_t index = 0; index < slots_.size(); ++index)
+        {
+            // Bumping the generation keeps the ids handed out so far invalid
+            slots_[index].handler.reset();
+            slots_[index].node = TopicIndex::NONE;
+            ++slots_[index].generation;
+            freeSlots_.push_back(index);
+        }
+        count_ = 0;
+    }
+
+    std::size_t TopicDispatcher::size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(guard_);
+        return count_;
+    }
+
+    std::size_t TopicDispatcher::memory_usage() const
+    {
+        std::shared_lock<std::shared_mutex> lock(guard_);
+        return index_.memory_usage() + slots_.capacity() * sizeof(slot) + freeSlots_.capacity() * sizeof(uint32_t);
+    }
+
+    void TopicDispatcher::match(const std::string& topic, std::vector<handler_ptr>& out) const
+    {
+        thread_local std::vector<uint32_t> matched;
+        matched.clear();
+        std::shared_lock<std::shared_mutex> lock(guard_);
+        index_.match(topic, matched);
+        for (uint32_t index : matched)
+        {
+            out.push_back(slots_[index].handler);
+        }
+    }
+
+    std::size_t TopicDispatcher::dispatch(const mqtt::const_message_ptr& msg) const
+    {
+        // Reused across dispatches; a handler dispatching again appends after our matches
+        thread_local std::vector<handler_ptr> matched;
+        struct truncate
+        {
+            std::vector<handler_ptr>& handlers;
+            std::size_t size;
+            ~truncate()
+            {
+                handlers.resize(size);
+            }
+        } restore{matched, matched.size()};
+        match(msg->get_topic(), matched);
+        const std::size_t last = matched.size();
+        for (std::size_t i = restore.size; i < last; ++i)
+        {
+            const message_handler& handler = *matched[i];
+            handler(msg);
+        }
+        return last - restore.size;
+    }
+} // namespace mqttcpp
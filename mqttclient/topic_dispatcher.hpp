@@ -0,0 +1,129 @@
+/**
+ * @file topic_dispatcher.hpp
+ * @brief Routes inbound messages to handlers registered per topic filter.
+ *
+ * Filters are stored in a TopicIndex, a trie with one node per topic level, so matching a
+ * message costs time proportional to the depth of its topic (and the wildcards met on the
+ * way) rather than to the number of registered filters.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_TOPIC_DISPATCHER__
+#define __CORE_MQTT_TOPIC_DISPATCHER__
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "mqtt/message.h"
+#include "topic_index.hpp"
+
+namespace mqttcpp
+{
+    /**
+     * @brief Dispatches messages to the handlers of every topic filter they match.
+     *
+     * Handlers can be added and removed from any thread while messages are dispatched. They are
+     * invoked outside the internal lock, so a handler may itself add or remove handlers.
+     */
+    class TopicDispatcher
+    {
+    public:
+        using message_handler = std::function<void(const mqtt::const_message_ptr&)>;
+        using handler_ptr = std::shared_ptr<const message_handler>;
+        using handler_id = uint64_t;
+
+        /**
+         * @brief Id never returned by add(), reported for rejected filters.
+         */
+        static constexpr handler_id INVALID_HANDLER = 0;
+
+    private:
+        /**
+         * @brief A registered handler; its index is the value stored in the topic index.
+         */
+        struct slot
+        {
+            handler_ptr handler; ///< The handler, empty while the slot is free.
+            uint32_t node;       ///< Node of the filter in the topic index.
+            uint32_t generation; ///< Upper half of the handler id, bumped when the slot is freed.
+        };
+
+        mutable std::shared_mutex guard_; ///< Shared by dispatches, exclusive for changes.
+        TopicIndex index_;                ///< Filters, mapped to slot indexes.
+        std::vector<slot> slots_;         ///< Registered handlers.
+        std::vector<uint32_t> freeSlots_; ///< Slots available for reuse.
+        std::size_t count_;               ///< Number of registered handlers.
+
+    public:
+        TopicDispatcher();
+
+        TopicDispatcher(const TopicDispatcher&) = delete;
+        TopicDispatcher& operator=(const TopicDispatcher&) = delete;
+
+        /**
+         * @brief Registers @p handler for messages matching @p filter.
+         *
+         * Several handlers may share a filter; a message matching several filters is delivered once per
+         * matching handler.
+         *
+         * @param filter An MQTT topic filter, with `+` and `#` wildcards.
+         * @param handler Called with each matching message, on the thread calling dispatch().
+         * @return An id for remove(); INVALID_HANDLER if @p filter is malformed or @p handler is empty.
+         */
+        handler_id add(const std::string& filter, message_handler handler);
+
+        /**
+         * @brief Registers a shared handler; registering one handler under many filters stores it only once.
+         */
+        handler_id add(const std::string& filter, handler_ptr handler);
+
+        /**
+         * @brief Rejects a null handler; picks neither overload above for `add(filter, nullptr)`.
+         *
+         * @return INVALID_HANDLER.
+         */
+        inline handler_id add(const std::string&, std::nullptr_t)
+        {
+            return INVALID_HANDLER;
+        }
+
+        /**
+         * @brief Unregisters a handler. A dispatch already in progress may still invoke it once.
+         *
+         * @return true if the handler was registered.
+         */
+        bool remove(handler_id id);
+
+        /**
+         * @brief Unregisters every handler.
+         */
+        void clear();
+
+        /**
+         * @brief Returns the number of registered handlers.
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Returns the bytes allocated for the filters and handler slots, handlers themselves excluded.
+         */
+        std::size_t memory_usage() const;
+
+        /**
+         * @brief Appends the handlers matching @p topic to @p out.
+         */
+        void match(const std::string& topic, std::vector<handler_ptr>& out) const;
+
+        /**
+         * @brief Invokes every handler whose filter matches the topic of @p msg.
+         *
+         * @return The number of handlers invoked.
+         */
+        std::size_t dispatch(const mqtt::const_message_ptr& msg) const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_TOPIC_DISPATCHER__
@@ -0,0 +1,26 @@
+#include "topic_filter.hpp"
+
+namespace mqttcpp
+{
+    bool is_valid_topic_filter(const std::string& filter)
+    {
+        if (filter.empty())
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < filter.size(); ++i)
+        {
+            if (filter[i] != '+' && filter[i] != '#')
+            {
+                continue;
+            }
+            bool levelStart = i == 0 || filter[i - 1] == '/';
+            bool levelEnd = i + 1 == filter.size() || filter[i + 1] == '/';
+            if (!levelStart || !levelEnd || (filter[i] == '#' && i + 1 != filter.size()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace mqttcpp
@@ -0,0 +1,25 @@
+/**
+ * @file topic_filter.hpp
+ * @brief MQTT topic filter validation.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_TOPIC_FILTER__
+#define __CORE_MQTT_TOPIC_FILTER__
+#include <string>
+
+namespace mqttcpp
+{
+    /**
+     * @brief Checks whether a string is a well-formed MQTT topic filter.
+     *
+     * A filter is well-formed if it is not empty, `+` only appears as a whole level and `#` only
+     * appears as the whole last level.
+     *
+     * @param filter The topic filter to check.
+     * @return true if @p filter can be subscribed to.
+     */
+    bool is_valid_topic_filter(const std::string& filter);
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_TOPIC_FILTER__
@@ -0,0 +1,451 @@
+#include "topic_index.hpp"
+#include "topic_filter.hpp"
+#include "topic_simd.hpp"
+#include <functional>
+
+namespace mqttcpp
+{
+    static constexpr std::size_t INITIAL_SLOTS = 16;
+
+    TopicIndex::TopicIndex()
+    {
+        clear();
+    }
+
+    void TopicIndex::clear()
+    {
+        levelChars_.clear();
+        levels_.clear();
+        levelSlots_.assign(INITIAL_SLOTS, NONE);
+        freeLevels_ = NONE;
+        levelCount_ = 0;
+        levelGarbage_ = 0;
+        nodes_.assign(1, node{NONE, NONE, NONE, 0});
+        freeNodes_ = NONE;
+        edges_.assign(INITIAL_SLOTS, NONE);
+        edgeCount_ = 0;
+        links_.clear();
+        freeLinks_ = NONE;
+        size_ = 0;
+    }
+
+    std::string_view TopicIndex::level_at(uint32_t id) const
+    {
+        return std::string_view(levelChars_.data() + levels_[id].offset, levels_[id].size);
+    }
+
+    std::size_t TopicIndex::level_slot(std::string_view level) const
+    {
+        return std::hash<std::string_view>()(level) & (levelSlots_.size() - 1);
+    }
+
+    uint32_t TopicIndex::find_level(std::string_view level) const
+    {
+        const std::size_t mask = levelSlots_.size() - 1;
+        for (std::size_t i = level_slot(level); levelSlots_[i] != NONE; i = (i + 1) & mask)
+        {
+            if (level_at(levelSlots_[i]) == level)
+            {
+                return levelSlots_[i];
+            }
+        }
+        return NONE;
+    }
+
+    void TopicIndex::grow_levels()
+    {
+        levelSlots_.assign(levelSlots_.size() * 2, NONE);
+        const std::size_t mask = levelSlots_.size() - 1;
+        for (uint32_t id = 0; id < levels_.size(); ++id)
+        {
+            if (levels_[id].size == NONE)
+            {
+                continue;
+            }
+            std::size_t i = level_slot(level_at(id));
+            while (levelSlots_[i] != NONE)
+            {
+                i = (i + 1) & mask;
+            }
+            levelSlots_[i] = id;
+        }
+    }
+
+    uint32_t TopicIndex::intern_level(std::string_view level)
+    {
+        uint32_t id = find_level(level);
+        if (id != NONE)
+        {
+            return id;
+        }
+        if ((levelCount_ + 1) * 2 > levelSlots_.size())
+        {
+            grow_levels();
+        }
+        id = freeLevels_;
+        if (id != NONE)
+        {
+            freeLevels_ = levels_[id].offset;
+        }
+        else
+        {
+            id = static_cast<uint32_t>(levels_.size());
+            levels_.emplace_back();
+        }
+        levels_[id] = level_entry{static_cast<uint32_t>(levelChars_.size()), static_cast<uint32_t>(level.size()), 0};
+        levelChars_.append(level.data(), level.size());
+        ++levelCount_;
+        const std::size_t mask = levelSlots_.size() - 1;
+        std::size_t i = level_slot(level);
+        while (levelSlots_[i] != NONE)
+        {
+            i = (i + 1) & mask;
+        }
+        levelSlots_[i] = id;
+        return id;
+    }
+
+    void TopicIndex::release_level(uint32_t id)
+    {
+        if (--levels_[id].refs > 0)
+        {
+            return;
+        }
+        const std::size_t mask = levelSlots_.size() - 1;
+        std::size_t i = level_slot(level_at(id));
+        while (levelSlots_[i] != id)
+        {
+            i = (i + 1) & mask;
+        }
+        levelSlots_[i] = NONE;
+        // Backward-shift deletion, as in erase_edge()
+        for (std::size_t j = (i + 1) & mask; levelSlots_[j] != NONE; j = (j + 1) & mask)
+        {
+            std::size_t home = level_slot(level_at(levelSlots_[j]));
+            bool between = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!between)
+            {
+                levelSlots_[i] = levelSlots_[j];
+                levelSlots_[j] = NONE;
+                i = j;
+            }
+        }
+        levelGarbage_ += levels_[id].size;
+        levels_[id] = level_entry{freeLevels_, NONE, 0};
+        freeLevels_ = id;
+        --levelCount_;
+        if (levelGarbage_ * 2 > levelChars_.size())
+        {
+            compact_levels();
+        }
+    }
+
+    void TopicIndex::compact_levels()
+    {
+        std::string packed;
+        packed.reserve(levelChars_.size() - levelGarbage_);
+        for (level_entry& entry : levels_)
+        {
+            if (entry.size != NONE)
+            {
+                const auto offset = static_cast<uint32_t>(packed.size());
+                packed.append(levelChars_, entry.offset, entry.size);
+                entry.offset = offset;
+            }
+        }
+        // assign() keeps the capacity already allocated
+        levelChars_.assign(packed);
+        levelGarbage_ = 0;
+    }
+
+    std::size_t TopicIndex::edge_slot(uint32_t parent, uint32_t level) const
+    {
+        uint64_t key = ((static_cast<uint64_t>(parent) << 32) | level) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(key >> 32) & (edges_.size() - 1);
+    }
+
+    uint32_t TopicIndex::find_child(uint32_t parent, uint32_t level) const
+    {
+        const std::size_t mask = edges_.size() - 1;
+        for (std::size_t i = edge_slot(parent, level); edges_[i] != NONE; i = (i + 1) & mask)
+        {
+            const node& child = nodes_[edges_[i]];
+            if (child.parent == parent && child.level == level)
+            {
+                return edges_[i];
+            }
+        }
+        return NONE;
+    }
+
+    void TopicIndex::insert_edge(uint32_t child)
+    {
+        // Linear probing stays short up to three quarters full
+        if ((edgeCount_ + 1) * 4 > edges_.size() * 3)
+        {
+            grow_edges();
+        }
+        const std::size_t mask = edges_.size() - 1;
+        std::size_t i = edge_slot(nodes_[child].parent, nodes_[child].level);
+        while (edges_[i] != NONE)
+        {
+            i = (i + 1) & mask;
+        }
+        edges_[i] = child;
+        ++edgeCount_;
+    }
+
+    void TopicIndex::erase_edge(uint32_t child)
+    {
+        const std::size_t mask = edges_.size() - 1;
+        std::size_t i = edge_slot(nodes_[child].parent, nodes_[child].level);
+        while (edges_[i] != child)
+        {
+            i = (i + 1) & mask;
+        }
+        edges_[i] = NONE;
+        --edgeCount_;
+        // Backward-shift deletion: move later entries of the probe run into the hole
+        for (std::size_t j = (i + 1) & mask; edges_[j] != NONE; j = (j + 1) & mask)
+        {
+            std::size_t home = edge_slot(nodes_[edges_[j]].parent, nodes_[edges_[j]].level);
+            bool between = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!between)
+            {
+                edges_[i] = edges_[j];
+                edges_[j] = NONE;
+                i = j;
+            }
+        }
+    }
+
+    void TopicIndex::grow_edges()
+    {
+        std::vector<uint32_t> old(edges_.size() * 2, NONE);
+        old.swap(edges_);
+        const std::size_t mask = edges_.size() - 1;
+        for (uint32_t child : old)
+        {
+            if (child != NONE)
+            {
+                std::size_t i = edge_slot(nodes_[child].parent, nodes_[child].level);
+                while (edges_[i] != NONE)
+                {
+                    i = (i + 1) & mask;
+                }
+                edges_[i] = child;
+            }
+        }
+    }
+
+    uint32_t TopicIndex::add_child(uint32_t parent, uint32_t level)
+    {
+        uint32_t id = freeNodes_;
+        if (id != NONE)
+        {
+            freeNodes_ = nodes_[id].values;
+        }
+        else
+        {
+            id = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[id] = node{parent, level, NONE, 0};
+        insert_edge(id);
+        if (level < PLUS_LEVEL)
+        {
+            ++levels_[level].refs;
+        }
+        nodes_[parent].children += 1;
+        if (level == PLUS_LEVEL)
+        {
+            nodes_[parent].children |= HAS_PLUS;
+        }
+        else if (level == HASH_LEVEL)
+        {
+            nodes_[parent].children |= HAS_HASH;
+        }
+        return id;
+    }
+
+    uint32_t TopicIndex::walk(const std::string& filter, bool create)
+    {
+        uint32_t current = 0;
+        std::size_t pos = 0;
+        while (pos <= filter.size())
+        {
+            std::size_t end = filter.find('/', pos);
+            if (end == std::string::npos)
+            {
+                end = filter.size();
+            }
+            std::string_view level(filter.data() + pos, end - pos);
+            pos = end + 1;
+            uint32_t id = PLUS_LEVEL;
+            if (level == "#")
+            {
+                id = HASH_LEVEL;
+            }
+            else if (level != "+")
+            {
+                id = create ? intern_level(level) : find_level(level);
+            }
+            uint32_t child = id == NONE ? NONE : find_child(current, id);
+            if (child == NONE)
+            {
+                if (!create)
+                {
+                    return NONE;
+                }
+                child = add_child(current, id);
+            }
+            current = child;
+        }
+        return current;
+    }
+
+    uint32_t TopicIndex::insert(const std::string& filter, uint32_t value)
+    {
+        if (!is_valid_topic_filter(filter))
+        {
+            return NONE;
+        }
+        const uint32_t id = walk(filter, true);
+        uint32_t link = freeLinks_;
+        if (link != NONE)
+        {
+            freeLinks_ = links_[link].next;
+        }
+        else
+        {
+            link = static_cast<uint32_t>(links_.size());
+            links_.emplace_back();
+        }
+        links_[link] = value_link{value, nodes_[id].values};
+        nodes_[id].values = link;
+        ++size_;
+        return id;
+    }
+
+    void TopicIndex::prune(uint32_t id)
+    {
+        while (id != 0 && nodes_[id].values == NONE && nodes_[id].children == 0)
+        {
+            node& n = nodes_[id];
+            const uint32_t parent = n.parent;
+            erase_edge(id);
+            nodes_[parent].children -= 1;
+            if (n.level == PLUS_LEVEL)
+            {
+                nodes_[parent].children &= ~HAS_PLUS;
+            }
+            else if (n.level == HASH_LEVEL)
+            {
+                nodes_[parent].children &= ~HAS_HASH;
+            }
+            else
+            {
+                release_level(n.level);
+            }
+            n.parent = NONE;
+            n.values = freeNodes_;
+            freeNodes_ = id;
+            id = parent;
+        }
+    }
+
+    bool TopicIndex::erase(uint32_t id, uint32_t value)
+    {
+        if (id == 0 || id >= nodes_.size() || nodes_[id].parent == NONE)
+        {
+            return false;
+        }
+        for (uint32_t* link = &nodes_[id].values; *link != NONE; link = &links_[*link].next)
+        {
+            if (links_[*link].value == value)
+            {
+                const uint32_t removed = *link;
+                *link = links_[removed].next;
+                links_[removed].next = freeLinks_;
+                freeLinks_ = removed;
+                --size_;
+                prune(id);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TopicIndex::erase(const std::string& filter, uint32_t value)
+    {
+        if (!is_valid_topic_filter(filter))
+        {
+            return false;
+        }
+        const uint32_t id = walk(filter, false);
+        return id != NONE && erase(id, value);
+    }
+
+    void TopicIndex::collect(uint32_t id,
+                             const std::vector<uint32_t>& levels,
+                             std::size_t depth,
+                             bool wildcards,
+                             std::vector<uint32_t>& out) const
+    {
+        const uint32_t children = nodes_[id].children;
+        // "a/#" matches "a" and everything below it
+        if ((children & HAS_HASH) && wildcards)
+        {
+            for (uint32_t link = nodes_[find_child(id, HASH_LEVEL)].values; link != NONE; link = links_[link].next)
+            {
+                out.push_back(links_[link].value);
+            }
+        }
+        if (depth == levels.size())
+        {
+            for (uint32_t link = nodes_[id].values; link != NONE; link = links_[link].next)
+            {
+                out.push_back(links_[link].value);
+            }
+            return;
+        }
+        if ((children & CHILD_COUNT) > 0 && levels[depth] != NONE)
+        {
+            const uint32_t child = find_child(id, levels[depth]);
+            if (child != NONE)
+            {
+                collect(child, levels, depth + 1, true, out);
+            }
+        }
+        if ((children & HAS_PLUS) && wildcards)
+        {
+            collect(find_child(id, PLUS_LEVEL), levels, depth + 1, true, out);
+        }
+    }
+
+    void TopicIndex::match(const std::string& topic, std::vector<uint32_t>& out) const
+    {
+        // Each topic level is looked up in the dictionary once; unknown levels only match wildcards
+        thread_local std::vector<std::string_view> parts(32);
+        thread_local std::vector<uint32_t> levels;
+        std::size_t count = split_topic(topic, parts.data(), parts.size());
+        if (count > parts.size())
+        {
+            parts.resize(count);
+            split_topic(topic, parts.data(), parts.size());
+        }
+        levels.clear();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            levels.push_back(find_level(parts[i]));
+        }
+        collect(0, levels, 0, topic.empty() || topic[0] != '$', out);
+    }
+
+    std::size_t TopicIndex::memory_usage() const
+    {
+        return levelChars_.capacity() + levels_.capacity() * sizeof(level_entry) +
+               levelSlots_.capacity() * sizeof(uint32_t) + nodes_.capacity() * sizeof(node) +
+               edges_.capacity() * sizeof(uint32_t) + links_.capacity() * sizeof(value_link);
+    }
+} // namespace mqttcpp
@@ -0,0 +1,174 @@
+/**
+ * @file topic_index.hpp
+ * @brief Memory-compact index of MQTT topic filters.
+ *
+ * The index is a trie of topic levels stored in a few contiguous arrays instead of
+ * heap-allocated nodes: level strings are interned once in a dictionary (and dropped with
+ * the last node using them), nodes are 16-byte records addressed by 32-bit ids, and the
+ * children of every node live in one shared open-addressing table of node ids, keyed by
+ * the (parent, level) pair each node already stores. A million per-device filters fit in
+ * well under 100 MB.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_TOPIC_INDEX__
+#define __CORE_MQTT_TOPIC_INDEX__
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mqttcpp
+{
+    /**
+     * @brief Maps MQTT topic filters to 32-bit values and finds the values matching a topic.
+     *
+     * A filter may hold several values and a value may be stored under several filters. The
+     * index is not thread-safe; callers serialize changes against lookups.
+     */
+    class TopicIndex
+    {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX; ///< Missing node, level or value.
+
+    private:
+        static constexpr uint32_t PLUS_LEVEL = NONE - 2;      ///< Level of a `+` node.
+        static constexpr uint32_t HASH_LEVEL = NONE - 1;      ///< Level of a `#` node.
+        static constexpr uint32_t HAS_PLUS = 1u << 31;        ///< Flag of node::children: a `+` child exists.
+        static constexpr uint32_t HAS_HASH = 1u << 30;        ///< Flag of node::children: a `#` child exists.
+        static constexpr uint32_t CHILD_COUNT = HAS_HASH - 1; ///< Mask of node::children counting children.
+
+        /**
+         * @brief One topic level of the trie.
+         */
+        struct node
+        {
+            uint32_t parent;   ///< Parent node, NONE for the root and for free nodes.
+            uint32_t level;    ///< Level id of the edge from the parent, or PLUS_LEVEL / HASH_LEVEL.
+            uint32_t values;   ///< First link of the values stored here, or NONE. Next free node when free.
+            uint32_t children; ///< Number of children, with the HAS_PLUS and HAS_HASH flags.
+        };
+
+        /**
+         * @brief Link of a node's value list; free links are chained through next.
+         */
+        struct value_link
+        {
+            uint32_t value; ///< Stored value.
+            uint32_t next;  ///< Next link, or NONE.
+        };
+
+        /**
+         * @brief One interned level; free entries are chained through offset and have size NONE.
+         */
+        struct level_entry
+        {
+            uint32_t offset; ///< Start of the level in levelChars_, or next free level id.
+            uint32_t size;   ///< Length of the level, NONE when free.
+            uint32_t refs;   ///< Nodes whose edge carries this level.
+        };
+
+        std::string levelChars_;           ///< Characters of every interned level, back to back, with gaps once freed.
+        std::vector<level_entry> levels_;  ///< Interned levels by id.
+        std::vector<uint32_t> levelSlots_; ///< Open-addressing table of level ids, NONE when empty.
+        uint32_t freeLevels_;              ///< First free level id, or NONE.
+        std::size_t levelCount_;           ///< Levels in use.
+        std::size_t levelGarbage_;         ///< Characters of freed levels still in levelChars_.
+        std::vector<node> nodes_;          ///< Nodes; node 0 is the root.
+        uint32_t freeNodes_;               ///< First free node, or NONE.
+        std::vector<uint32_t> edges_;      ///< Open-addressing table of child nodes, NONE when empty.
+        std::size_t edgeCount_;            ///< Occupied slots of edges_.
+        std::vector<value_link> links_;    ///< Value lists of every node.
+        uint32_t freeLinks_;               ///< First free link, or NONE.
+        std::size_t size_;                 ///< Number of stored (filter, value) pairs.
+
+        std::string_view level_at(uint32_t id) const;
+        std::size_t level_slot(std::string_view level) const;
+        uint32_t find_level(std::string_view level) const;
+        uint32_t intern_level(std::string_view level);
+        void release_level(uint32_t id);
+        void grow_levels();
+        void compact_levels();
+
+        std::size_t edge_slot(uint32_t parent, uint32_t level) const;
+        uint32_t find_child(uint32_t parent, uint32_t level) const;
+        void insert_edge(uint32_t child);
+        void erase_edge(uint32_t child);
+        void grow_edges();
+
+        uint32_t add_child(uint32_t parent, uint32_t level);
+        void prune(uint32_t id);
+
+        /**
+         * @brief Returns the node of @p filter, creating the missing ones if @p create is set.
+         *
+         * @return The node id, or NONE if @p filter is absent and @p create is not set.
+         */
+        uint32_t walk(const std::string& filter, bool create);
+
+        void collect(uint32_t id,
+                     const std::vector<uint32_t>& levels,
+                     std::size_t depth,
+                     bool wildcards,
+                     std::vector<uint32_t>& out) const;
+
+    public:
+        TopicIndex();
+
+        /**
+         * @brief Stores @p value under @p filter.
+         *
+         * @return The id of the filter's node, for erase(uint32_t, uint32_t); NONE if @p filter is malformed.
+         */
+        uint32_t insert(const std::string& filter, uint32_t value);
+
+        /**
+         * @brief Removes one occurrence of @p value from node @p id, as returned by insert().
+         *
+         * @return true if the value was stored there.
+         */
+        bool erase(uint32_t id, uint32_t value);
+
+        /**
+         * @brief Removes one occurrence of @p value from @p filter.
+         *
+         * @return true if the value was stored under @p filter.
+         */
+        bool erase(const std::string& filter, uint32_t value);
+
+        /**
+         * @brief Appends to @p out the values of every filter matching @p topic.
+         *
+         * Wildcards at the first level never match topics starting with `$`.
+         */
+        void match(const std::string& topic, std::vector<uint32_t>& out) const;
+
+        /**
+         * @brief Removes every filter and interned level.
+         */
+        void clear();
+
+        /**
+         * @brief Returns the number of stored (filter, value) pairs.
+         */
+        inline std::size_t size() const
+        {
+            return size_;
+        }
+
+        /**
+         * @brief Returns the number of distinct interned levels.
+         */
+        inline std::size_t level_count() const
+        {
+            return levelCount_;
+        }
+
+        /**
+         * @brief Returns the bytes allocated by the index.
+         */
+        std::size_t memory_usage() const;
+    };
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_TOPIC_INDEX__
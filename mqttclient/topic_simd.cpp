@@ -0,0 +1,411 @@
+#include "topic_simd.hpp"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MQTTCPP_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MQTTCPP_TARGET_AVX2
+#else
+#define MQTTCPP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace mqttcpp
+{
+    namespace
+    {
+        inline unsigned lowest_bit(uint32_t bits)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+        }
+
+        /**
+         * @brief Turns separator positions into level views, keeping at most max of them.
+         */
+        struct level_writer
+        {
+            const char* data;
+            std::string_view* levels;
+            std::size_t max;
+            std::size_t count;
+            std::size_t start;
+
+            inline void separator(std::size_t pos)
+            {
+                if (count < max)
+                {
+                    levels[count] = std::string_view(data + start, pos - start);
+                }
+                ++count;
+                start = pos + 1;
+            }
+
+            // Bit i of bits flags a separator at base + i
+            inline void separators(std::size_t base, uint32_t bits)
+            {
+                while (bits != 0)
+                {
+                    separator(base + lowest_bit(bits));
+                    bits &= bits - 1;
+                }
+            }
+
+            inline std::size_t finish(std::size_t size)
+            {
+                separator(size);
+                return count;
+            }
+        };
+
+        inline bool is_wildcard(char c)
+        {
+            return c == '+' || c == '#';
+        }
+
+        /**
+         * @brief Portable kernels, also used for the bytes the vector kernels leave over.
+         */
+        struct scalar_ops
+        {
+            static void scan(level_writer& out, const char* data, std::size_t i, std::size_t size)
+            {
+                for (; i < size; ++i)
+                {
+                    if (data[i] == '/')
+                    {
+                        out.separator(i);
+                    }
+                }
+            }
+
+            // Position of the first separator at or after i, or size
+            static std::size_t find(const char* data, std::size_t i, std::size_t size)
+            {
+                while (i < size && data[i] != '/')
+                {
+                    ++i;
+                }
+                return i;
+            }
+
+            // Length of the common prefix of filter and topic, stopping early at a wildcard of the filter
+            static std::size_t prefix(const char* filter, const char* topic, std::size_t i, std::size_t size)
+            {
+                while (i < size && filter[i] == topic[i] && !is_wildcard(filter[i]))
+                {
+                    ++i;
+                }
+                return i;
+            }
+        };
+
+#ifdef MQTTCPP_SIMD_X86
+        /**
+         * @brief 16 bytes per step. Inputs of at least one block end with an overlapping block instead of a
+         * scalar tail; shorter inputs go to scalar_ops.
+         */
+        struct sse2_ops
+        {
+            static inline uint32_t slashes(const char* data)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('/'))));
+            }
+
+            // Bit i is set where the bytes differ or the filter holds a wildcard
+            static inline uint32_t stops(const char* filter, const char* topic)
+            {
+                __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filter));
+                __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(topic));
+                __m128i wildcard =
+                    _mm_or_si128(_mm_cmpeq_epi8(f, _mm_set1_epi8('+')), _mm_cmpeq_epi8(f, _mm_set1_epi8('#')));
+                uint32_t same = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(f, t)));
+                return (~same & 0xFFFFu) | static_cast<uint32_t>(_mm_movemask_epi8(wildcard));
+            }
+
+            static void scan(level_writer& out, const char* data, std::size_t i, std::size_t size)
+            {
+                if (size - i < 16)
+                {
+                    return scalar_ops::scan(out, data, i, size);
+                }
+                for (; i + 16 <= size; i += 16)
+                {
+                    out.separators(i, slashes(data + i));
+                }
+                if (i < size)
+                {
+                    out.separators(i, slashes(data + size - 16) >> (16 - (size - i)));
+                }
+            }
+
+            static std::size_t find(const char* data, std::size_t i, std::size_t size)
+            {
+                if (size - i < 16)
+                {
+                    return scalar_ops::find(data, i, size);
+                }
+                for (; i + 16 <= size; i += 16)
+                {
+                    if (uint32_t bits = slashes(data + i))
+                    {
+                        return i + lowest_bit(bits);
+                    }
+                }
+                uint32_t bits = i < size ? slashes(data + size - 16) >> (16 - (size - i)) : 0;
+                return bits ? i + lowest_bit(bits) : size;
+            }
+
+            static std::size_t prefix(const char* filter, const char* topic, std::size_t i, std::size_t size)
+            {
+                if (size - i < 16)
+                {
+                    return scalar_ops::prefix(filter, topic, i, size);
+                }
+                for (; i + 16 <= size; i += 16)
+                {
+                    if (uint32_t bits = stops(filter + i, topic + i))
+                    {
+                        return i + lowest_bit(bits);
+                    }
+                }
+                uint32_t bits = i < size ? stops(filter + size - 16, topic + size - 16) >> (16 - (size - i)) : 0;
+                return bits ? i + lowest_bit(bits) : size;
+            }
+        };
+
+        /**
+         * @brief 32 bytes per step; the remainder goes to sse2_ops.
+         */
+        struct avx2_ops
+        {
+            static MQTTCPP_TARGET_AVX2 inline uint32_t slashes(const char* data)
+            {
+                __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+                return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('/'))));
+            }
+
+            static MQTTCPP_TARGET_AVX2 inline uint32_t stops(const char* filter, const char* topic)
+            {
+                __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(filter));
+                __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(topic));
+                __m256i wildcard = _mm256_or_si256(_mm256_cmpeq_epi8(f, _mm256_set1_epi8('+')),
+                                                   _mm256_cmpeq_epi8(f, _mm256_set1_epi8('#')));
+                uint32_t same = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(f, t)));
+                return ~same | static_cast<uint32_t>(_mm256_movemask_epi8(wildcard));
+            }
+
+            static MQTTCPP_TARGET_AVX2 void scan(level_writer& out, const char* data, std::size_t i, std::size_t size)
+            {
+                for (; i + 32 <= size; i += 32)
+                {
+                    out.separators(i, slashes(data + i));
+                }
+                sse2_ops::scan(out, data, i, size);
+            }
+
+            static MQTTCPP_TARGET_AVX2 std::size_t find(const char* data, std::size_t i, std::size_t size)
+            {
+                for (; i + 32 <= size; i += 32)
+                {
+                    if (uint32_t bits = slashes(data + i))
+                    {
+                        return i + lowest_bit(bits);
+                    }
+                }
+                return sse2_ops::find(data, i, size);
+            }
+
+            static MQTTCPP_TARGET_AVX2 std::size_t prefix(const char* filter, const char* topic, std::size_t i,
+                                                          std::size_t size)
+            {
+                for (; i + 32 <= size; i += 32)
+                {
+                    if (uint32_t bits = stops(filter + i, topic + i))
+                    {
+                        return i + lowest_bit(bits);
+                    }
+                }
+                return sse2_ops::prefix(filter, topic, i, size);
+            }
+        };
+
+        bool cpu_has_avx2()
+        {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 0);
+            if (regs[0] < 7)
+            {
+                return false;
+            }
+            // The OS must also save the YMM registers on context switches
+            __cpuid(regs, 1);
+            const int osxsave = 1 << 27;
+            if ((regs[2] & osxsave) == 0 || (_xgetbv(0) & 6) != 6)
+            {
+                return false;
+            }
+            __cpuidex(regs, 7, 0);
+            return (regs[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }
+#endif
+
+        template <typename Ops>
+        std::size_t split_with(std::string_view topic, std::string_view* levels, std::size_t max)
+        {
+            level_writer out{topic.data(), levels, max, 0, 0};
+            Ops::scan(out, topic.data(), 0, topic.size());
+            return out.finish(topic.size());
+        }
+
+        template <typename Ops>
+        bool match_with(std::string_view filter, std::string_view topic)
+        {
+            if (filter.empty())
+            {
+                return false;
+            }
+            if (!topic.empty() && topic[0] == '$' && is_wildcard(filter[0]))
+            {
+                return false;
+            }
+
+            const char* fp = filter.data();
+            const char* tp = topic.data();
+            std::size_t f = 0;
+            std::size_t t = 0;
+            while (true)
+            {
+                // Skip the bytes both sides agree on, up to the next wildcard
+                std::size_t same = Ops::prefix(fp + f, tp + t, 0, std::min(filter.size() - f, topic.size() - t));
+                f += same;
+                t += same;
+                if (f == filter.size())
+                {
+                    return t == topic.size();
+                }
+                const char c = fp[f];
+                const bool levelStart = f == 0 || fp[f - 1] == '/';
+                if (levelStart && c == '#')
+                {
+                    return true;
+                }
+                if (levelStart && c == '+')
+                {
+                    t = Ops::find(tp, t, topic.size());
+                    ++f;
+                    continue;
+                }
+                if (t == topic.size())
+                {
+                    // "a/#" also matches "a"
+                    return filter.substr(f) == "/#";
+                }
+                if (c != tp[t])
+                {
+                    return false;
+                }
+                // A wildcard character inside a level is literal
+                ++f;
+                ++t;
+            }
+        }
+
+        /**
+         * @brief Entry points of one level, selected once.
+         */
+        struct kernel_set
+        {
+            std::size_t (*split)(std::string_view, std::string_view*, std::size_t);
+            bool (*match)(std::string_view, std::string_view);
+        };
+
+        kernel_set kernels_for(SimdLevel level)
+        {
+            switch (level)
+            {
+#ifdef MQTTCPP_SIMD_X86
+            case SimdLevel::AVX2:
+                return kernel_set{split_with<avx2_ops>, match_with<avx2_ops>};
+            case SimdLevel::SSE2:
+                return kernel_set{split_with<sse2_ops>, match_with<sse2_ops>};
+#endif
+            default:
+                return kernel_set{split_with<scalar_ops>, match_with<scalar_ops>};
+            }
+        }
+
+        SimdLevel detect_level()
+        {
+#ifdef MQTTCPP_SIMD_X86
+            return cpu_has_avx2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+            return SimdLevel::SCALAR;
+#endif
+        }
+
+        const kernel_set& active_kernels()
+        {
+            static const kernel_set kernels = kernels_for(simd_level());
+            return kernels;
+        }
+    } // namespace
+
+    SimdLevel simd_level()
+    {
+        static const SimdLevel level = detect_level();
+        return level;
+    }
+
+    bool simd_supported(SimdLevel level)
+    {
+        return static_cast<int>(level) <= static_cast<int>(simd_level());
+    }
+
+    const char* simd_level_name(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    std::size_t split_topic(std::string_view topic, std::string_view* levels, std::size_t max)
+    {
+        return active_kernels().split(topic, levels, max);
+    }
+
+    std::size_t split_topic(SimdLevel level, std::string_view topic, std::string_view* levels, std::size_t max)
+    {
+        return kernels_for(level).split(topic, levels, max);
+    }
+
+    bool filter_matches(std::string_view filter, std::string_view topic)
+    {
+        return active_kernels().match(filter, topic);
+    }
+
+    bool filter_matches(SimdLevel level, std::string_view filter, std::string_view topic)
+    {
+        return kernels_for(level).match(filter, topic);
+    }
+} // namespace mqttcpp
@@ -0,0 +1,73 @@
+/**
+ * @file topic_simd.hpp
+ * @brief Vectorized topic splitting and topic filter matching.
+ *
+ * Finding the `/` separators of a topic is the inner loop of inbound routing. The kernels
+ * here scan 16 (SSE2) or 32 (AVX2) bytes per step and fall back to a scalar loop on other
+ * CPUs. The best kernel supported by the running CPU is selected once, at first use.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_TOPIC_SIMD__
+#define __CORE_MQTT_TOPIC_SIMD__
+#include <cstddef>
+#include <string_view>
+
+namespace mqttcpp
+{
+    /**
+     * @brief Instruction sets the kernels are built for.
+     */
+    enum class SimdLevel
+    {
+        SCALAR, ///< Portable byte-by-byte loop.
+        SSE2,   ///< 16 bytes per step, x86 only.
+        AVX2    ///< 32 bytes per step, x86 only.
+    };
+
+    /**
+     * @brief Returns the best level supported by the running CPU, as used by the dispatching overloads.
+     */
+    SimdLevel simd_level();
+
+    /**
+     * @brief Checks whether the running CPU supports @p level.
+     */
+    bool simd_supported(SimdLevel level);
+
+    /**
+     * @brief Returns the name of @p level, e.g. "avx2".
+     */
+    const char* simd_level_name(SimdLevel level);
+
+    /**
+     * @brief Splits @p topic into its levels.
+     *
+     * @param topic The topic name or filter to split.
+     * @param levels Receives the first @p max levels, as views into @p topic.
+     * @param max Capacity of @p levels.
+     * @return The number of levels of @p topic, which may exceed @p max.
+     */
+    std::size_t split_topic(std::string_view topic, std::string_view* levels, std::size_t max);
+
+    /**
+     * @brief Same as split_topic(), with the kernel forced to @p level, which must be supported.
+     */
+    std::size_t split_topic(SimdLevel level, std::string_view topic, std::string_view* levels, std::size_t max);
+
+    /**
+     * @brief Checks whether a topic name matches an MQTT topic filter.
+     *
+     * Supports the `+` and `#` wildcards, and never matches a wildcard at the first level of a topic
+     * starting with `$`. A malformed filter (see is_valid_topic_filter()) gives an unspecified result,
+     * so filters are validated when they are registered.
+     */
+    bool filter_matches(std::string_view filter, std::string_view topic);
+
+    /**
+     * @brief Same as filter_matches(), with the kernel forced to @p level, which must be supported.
+     */
+    bool filter_matches(SimdLevel level, std::string_view filter, std::string_view topic);
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_TOPIC_SIMD__
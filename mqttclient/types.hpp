@@ -12,7 +12,10 @@
 #include <string>
 #include <memory>
 #include <type_traits>
+#include <vector>
 #include "mqtt/exception.h"
+#include "mqtt/buffer_ref.h"
+#include "mqtt/properties.h"
 
 namespace mqttcpp
 {
@@ -243,6 +246,32 @@ namespace mqttcpp
         mqtt::ReasonCode reason;
     };
 
+    /**
+     * @brief A single message submitted through MqttClient::publish_batch.
+     *
+     * The payload is held as a mqtt::binary_ref so that the same buffer can be shared
+     * with the outgoing mqtt::message without another copy.
+     */
+    struct publish_request
+    {
+        std::string topic;        ///< Topic to publish to.
+        mqtt::binary_ref payload; ///< Message payload.
+        unsigned int qos = 1;     ///< Quality of Service level (0, 1, or 2).
+        bool retained = false;    ///< Whether the broker should retain the message.
+        mqtt::properties props;   ///< MQTT v5 properties sent with the message.
+    };
+
+    /**
+     * @brief Describes why one message of a batch publish failed.
+     */
+    struct publish_failure
+    {
+        std::size_t index;   ///< Position of the message in the submitted batch.
+        int returnCode;      ///< Paho return code (MQTTASYNC_*).
+        int reasonCode;      ///< MQTT v5 reason code, 0 if not available.
+        std::string message; ///< Human readable description of the failure.
+    };
+
     /**
      * @brief Supported types for CallbackVariant.
      */
@@ -0,0 +1,124 @@
+#include "mqttclient.hpp"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+// Counts heap allocations made by the calling thread. Replacing the global operator new applies
+// to the whole test executable, so the hook is kept to a thread-local increment.
+namespace
+{
+    thread_local std::size_t threadAllocations = 0;
+    thread_local bool countingAllocations = true;
+
+    // Counts only the allocations made on this thread while @p fn runs
+    template <typename Fn>
+    std::size_t allocations_in(Fn&& fn)
+    {
+        const std::size_t before = threadAllocations;
+        countingAllocations = true;
+        fn();
+        countingAllocations = false;
+        return threadAllocations - before;
+    }
+
+    const std::string ALLOC_SERVER_ADDRESS{std::getenv("MQTT_SERVER") ? std::getenv("MQTT_SERVER")
+                                                                      : "tcp://localhost:1883"};
+    const std::string ALLOC_TOPIC{"test/allocation"};
+    const int ALLOC_TIMEOUT_MS = 4000;
+
+    class NullListener : public mqtt::iaction_listener
+    {
+    public:
+        void on_failure(const mqtt::token&) override
+        {}
+        void on_success(const mqtt::token&) override
+        {}
+    };
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (countingAllocations)
+    {
+        ++threadAllocations;
+    }
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+TEST(AllocationTest, ShouldNotAllocateBeyondPahoWhenPublishing)
+{
+    // Arrange
+    const int count = 1000;
+    mqtt::const_message_ptr msg = mqtt::make_message(ALLOC_TOPIC, "steady state", 0, false);
+
+    mqtt::async_client direct(ALLOC_SERVER_ADDRESS, "test_alloc_direct");
+    NullListener listener;
+    direct.connect(mqtt::connect_options(), nullptr, listener)->wait();
+
+    mqttcpp::MqttClient client(ALLOC_SERVER_ADDRESS, "test_alloc_wrapped");
+    ASSERT_TRUE(client.connect(true, ALLOC_TIMEOUT_MS));
+
+    mqtt::token_ptr token;
+    for (int i = 0; i < 100; ++i)
+    {
+        direct.publish(msg, nullptr, listener);
+        ASSERT_TRUE(client.publish(token, msg));
+    }
+
+    // Act: only the publish calls themselves are counted
+    std::size_t directAllocations = 0;
+    std::size_t wrappedAllocations = 0;
+    countingAllocations = false;
+    for (int i = 0; i < count; ++i)
+    {
+        directAllocations += allocations_in([&]() { direct.publish(msg, nullptr, listener); });
+        wrappedAllocations += allocations_in([&]() { client.publish(token, msg); });
+    }
+    countingAllocations = true;
+
+    // Assert
+    EXPECT_LE(wrappedAllocations, directAllocations);
+    token->wait();
+    client.disconnect(true, ALLOC_TIMEOUT_MS);
+    direct.disconnect(10000, nullptr, listener)->wait();
+}
+
+TEST(AllocationTest, ShouldStoreCompletionCallbacksInline)
+{
+    // Arrange: a typical capture, an owner kept alive until completion and a label past the small string buffer
+    auto owner = std::make_shared<int>(7);
+    std::string label(48, 'x');
+    int calls = 0;
+    mqttcpp::OperationListenerPool pool;
+    pool.release(pool.acquire(nullptr, nullptr));
+
+    // Act
+    std::size_t before = threadAllocations;
+    mqttcpp::completion_callback callback(
+        [owner, label = std::move(label), &calls](const mqttcpp::completion_record&) { calls += *owner; });
+    mqttcpp::OperationListener* listener = pool.acquire(nullptr, std::move(callback));
+    listener->dismiss(mqttcpp::completion_record{mqtt::token::PUBLISH, 1, nullptr, 0, 0, 0});
+    std::size_t allocations = threadAllocations - before;
+
+    // Assert
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(calls, 7);
+    EXPECT_EQ(owner.use_count(), 1);
+    EXPECT_EQ(pool.get_stats().inUse, 0u);
+}
@@ -0,0 +1,135 @@
+#include "binary_log.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ddbg;
+
+namespace
+{
+    // Encodes args the way the DD_BINARY macros do and renders them back
+    template <typename... Args>
+    std::string render(const char* format, const Args&... args)
+    {
+        std::vector<char> bytes((std::size_t{0} + ... + binlog::encoded_size(args)) + 1);
+        char* cursor = bytes.data();
+        ((cursor = binlog::encode(cursor, args)), ...);
+        return render_binary_format(format, bytes.data(), static_cast<std::size_t>(cursor - bytes.data()));
+    }
+
+    struct read_record
+    {
+        std::string text;
+        std::string file;
+        int mode;
+    };
+
+    std::vector<read_record> read_all(const std::string& path)
+    {
+        std::vector<read_record> records;
+        std::string error;
+        EXPECT_TRUE(read_binary_log(
+            path,
+            [&records](const binary_log_record& record) {
+                records.push_back(read_record{record.text, record.entry.file, record.entry.mode});
+            },
+            &error))
+            << error;
+        return records;
+    }
+} // namespace
+
+TEST(BinaryLogTest, ShouldRenderLikePrintf)
+{
+    // Arrange
+    const std::string topic = "fleet/dev42/telemetry";
+    char expected[256];
+    std::snprintf(expected, sizeof(expected), "%s|%5d|%-4u|%08.3f|%x|%c|%zu|%%|%.3s", topic.c_str(), -42, 7u, 3.14159,
+                  255u, 'z', static_cast<std::size_t>(1024), "abcdef");
+
+    // Act
+    std::string text = render("%s|%5d|%-4u|%08.3f|%x|%c|%zu|%%|%.3s", topic, -42, 7u, 3.14159, 255u, 'z',
+                              static_cast<std::size_t>(1024), "abcdef");
+
+    // Assert
+    EXPECT_EQ(text, expected);
+    EXPECT_EQ(render("%d and %d", 1), "1 and <missing>");
+    EXPECT_EQ(render("%d", "text"), "text");
+    EXPECT_EQ(render("%s", static_cast<const char*>(nullptr)), "(null)");
+}
+
+TEST(BinaryLogTest, ShouldReadBackEveryThreadsRecordsInOrder)
+{
+    // Arrange
+    const std::string path = ::testing::TempDir() + "ddbg_binary_log_order.bin";
+    binary_log_options opts;
+    opts.path = path;
+    opts.fileBytes = 1 << 20;
+    ASSERT_TRUE(start_binary_logging(opts));
+    const int perThread = 1000;
+
+    // Act
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i)
+            {
+                dbinfo("thread %d record %d of %s", t, i, std::string("topic"));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    stop_binary_logging();
+    std::vector<read_record> records = read_all(path);
+    std::remove(path.c_str());
+
+    // Assert
+    EXPECT_FALSE(binary_logging_enabled());
+    ASSERT_EQ(records.size(), 4u * perThread);
+    std::vector<int> next(4, 0);
+    for (const auto& record : records)
+    {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(std::sscanf(record.text.c_str(), "thread %d record %d of topic", &t, &i), 2) << record.text;
+        ASSERT_TRUE(t >= 0 && t < 4);
+        EXPECT_EQ(i, next[t]++);
+        EXPECT_EQ(record.mode, DD_LEVEL_INFO);
+        EXPECT_NE(record.file.find("binary_log.test.cpp"), std::string::npos);
+    }
+}
+
+TEST(BinaryLogTest, ShouldDropRecordsPastTheFileSize)
+{
+    // Arrange
+    const std::string path = ::testing::TempDir() + "ddbg_binary_log_full.bin";
+    binary_log_options opts;
+    opts.path = path;
+    opts.fileBytes = 4096;
+    ASSERT_TRUE(start_binary_logging(opts));
+    const binary_log_stats before = get_binary_log_stats();
+
+    // Act
+    for (int i = 0; i < 1000; ++i)
+    {
+        dberror("error %d", i);
+    }
+    stop_binary_logging();
+    dberror("after stop %d", 0);
+    const binary_log_stats after = get_binary_log_stats();
+    std::vector<read_record> records = read_all(path);
+    std::remove(path.c_str());
+
+    // Assert
+    EXPECT_GT(records.size(), 10u);
+    EXPECT_EQ(records.size() + 1, after.written - before.written); // The site description is a record too
+    EXPECT_EQ(records.size() + (after.dropped - before.dropped), 1000u);
+    EXPECT_LE(after.bytes, 4096u);
+    EXPECT_EQ(records.back().text, "error " + std::to_string(records.size() - 1));
+}
@@ -0,0 +1,90 @@
+#include "completion_queue.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    completion_record make_record(int msgId)
+    {
+        return completion_record{mqtt::token::PUBLISH, msgId, nullptr, 0, 0, 0};
+    }
+} // namespace
+
+TEST(CompletionQueueTest, ShouldPopInPushOrder)
+{
+    // Arrange
+    CompletionQueue queue(8);
+
+    // Act
+    for (int i = 1; i <= 5; ++i)
+    {
+        ASSERT_TRUE(queue.push(make_record(i)));
+    }
+
+    // Assert
+    completion_record record;
+    for (int i = 1; i <= 5; ++i)
+    {
+        ASSERT_TRUE(queue.pop(record));
+        EXPECT_EQ(record.msgId, i);
+    }
+    EXPECT_FALSE(queue.pop(record));
+}
+
+TEST(CompletionQueueTest, ShouldDropWhenFull)
+{
+    // Arrange
+    CompletionQueue queue(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.push(make_record(i)));
+    }
+
+    // Act
+    bool pushed = queue.push(make_record(99));
+
+    // Assert
+    EXPECT_FALSE(pushed);
+    auto stats = queue.get_stats();
+    EXPECT_EQ(stats.pushed, 4u);
+    EXPECT_EQ(stats.dropped, 1u);
+    EXPECT_EQ(stats.size, 4u);
+}
+
+TEST(CompletionQueueTest, ShouldNotLoseRecordsUnderConcurrentProducers)
+{
+    // Arrange
+    CompletionQueue queue(1 << 16);
+    const int perProducer = 10000;
+    std::vector<std::thread> producers;
+
+    // Act
+    for (int p = 0; p < 4; ++p)
+    {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                queue.push(make_record(p * perProducer + i + 1));
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    // Assert
+    std::vector<bool> seen(4 * perProducer + 1, false);
+    completion_record record;
+    int count = 0;
+    while (queue.pop(record))
+    {
+        ASSERT_FALSE(seen[static_cast<std::size_t>(record.msgId)]);
+        seen[static_cast<std::size_t>(record.msgId)] = true;
+        ++count;
+    }
+    EXPECT_EQ(count, 4 * perProducer);
+}
@@ -0,0 +1,128 @@
+#include "congestion_controller.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+
+using namespace mqttcpp;
+using namespace std::chrono_literals;
+
+// Test fixture
+class CongestionControllerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        congestion_options opts;
+        opts.enabled = true;
+        opts.initialWindow = 8;
+        opts.minWindow = 1;
+        controller.configure(opts);
+    }
+
+    CongestionController controller;
+};
+
+TEST_F(CongestionControllerTest, ShouldGrowAdditivelyWhileLatencyIsStable)
+{
+    // Act: a little more than one window of acknowledgements at a steady latency
+    for (int i = 0; i < 9; ++i)
+    {
+        controller.on_sample(1ms, true);
+    }
+
+    // Assert
+    EXPECT_EQ(controller.window(), 9u);
+    EXPECT_EQ(controller.get_stats().decreases, 0u);
+}
+
+TEST_F(CongestionControllerTest, ShouldCutWindowWhenLatencyRises)
+{
+    // Arrange
+    for (int i = 0; i < 32; ++i)
+    {
+        controller.on_sample(1ms, true);
+    }
+    std::size_t before = controller.window();
+
+    // Act: acknowledgements suddenly take much longer
+    for (int i = 0; i < 8; ++i)
+    {
+        controller.on_sample(20ms, true);
+    }
+
+    // Assert
+    EXPECT_LE(controller.window(), before / 2);
+    EXPECT_GE(controller.window(), 1u);
+    EXPECT_GT(controller.get_stats().decreases, 0u);
+}
+
+TEST_F(CongestionControllerTest, ShouldCutWindowOnFailure)
+{
+    // Act
+    bool changed = controller.on_sample(0ms, false);
+
+    // Assert
+    EXPECT_TRUE(changed);
+    EXPECT_EQ(controller.window(), 4u);
+}
+
+TEST_F(CongestionControllerTest, ShouldNeverExceedReceiveMaximum)
+{
+    // Arrange
+    controller.set_receive_maximum(5);
+
+    // Act
+    for (int i = 0; i < 1000; ++i)
+    {
+        controller.on_sample(1ms, true);
+    }
+
+    // Assert
+    EXPECT_EQ(controller.window(), 5u);
+    EXPECT_EQ(controller.get_stats().ceiling, 5u);
+}
+
+TEST_F(CongestionControllerTest, ShouldIgnoreSamplesWhenDisabled)
+{
+    // Arrange
+    controller.configure(congestion_options());
+
+    // Act
+    bool changed = controller.on_complete(1000000, false);
+
+    // Assert
+    EXPECT_FALSE(changed);
+    EXPECT_FALSE(controller.enabled());
+}
+
+TEST_F(CongestionControllerTest, ShouldKeepWindowAboveZeroWithZeroMinimum)
+{
+    // Arrange
+    congestion_options opts;
+    opts.enabled = true;
+    opts.initialWindow = 0;
+    opts.minWindow = 0;
+    controller.configure(opts);
+
+    // Act: keep failing long enough to cut a window of 1 several times
+    std::size_t initial = controller.window();
+    for (int i = 0; i < 10; ++i)
+    {
+        controller.on_sample(0ms, false);
+    }
+
+    // Assert: a window of 0 would mean an unlimited publish window
+    EXPECT_EQ(initial, 1u);
+    EXPECT_EQ(controller.window(), 1u);
+}
+
+TEST_F(CongestionControllerTest, ShouldTakeLatencyOfCompletions)
+{
+    // Act: 50 ms, then a failure with an unknown send time
+    bool grown = controller.on_complete(50000000, true);
+    bool cut = controller.on_complete(0, false);
+
+    // Assert
+    EXPECT_FALSE(grown);
+    EXPECT_TRUE(cut);
+    EXPECT_EQ(controller.get_stats().baseLatencyUs, 50000u);
+}
@@ -0,0 +1,191 @@
+#include "consumer_group.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace mqttcpp;
+
+namespace
+{
+    const std::string GROUP_SERVER_ADDRESS{std::getenv("MQTT_SERVER") ? std::getenv("MQTT_SERVER")
+                                                                      : "tcp://localhost:1883"};
+    const std::string GROUP_TOPIC{"test/group/readings"};
+    const int GROUP_TIMEOUT_MS = 4000;
+} // namespace
+
+// Test fixture
+class ConsumerGroupTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        group = std::make_unique<ConsumerGroup>(GROUP_SERVER_ADDRESS, "test_group", "ingest", 3);
+        publisher = std::make_unique<MqttClient>(GROUP_SERVER_ADDRESS, "test_group_publisher");
+        ASSERT_TRUE(publisher->connect(true, GROUP_TIMEOUT_MS));
+    }
+
+    void TearDown() override
+    {
+        publisher->disconnect(true, GROUP_TIMEOUT_MS);
+        if (group->connected_count() > 0)
+        {
+            group->disconnect(true, GROUP_TIMEOUT_MS);
+        }
+        group.reset();
+        publisher.reset();
+    }
+
+    void publish(int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            ASSERT_TRUE(publisher->publish(GROUP_TOPIC, "reading " + std::to_string(i), 1, true, GROUP_TIMEOUT_MS));
+        }
+    }
+
+    std::size_t drain(std::size_t expected)
+    {
+        std::size_t count = 0;
+        mqtt::const_message_ptr msg;
+        while (count < expected && group->wait_next_message(msg, GROUP_TIMEOUT_MS))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    std::unique_ptr<ConsumerGroup> group;
+    std::unique_ptr<MqttClient> publisher;
+};
+
+TEST_F(ConsumerGroupTest, ShouldBuildSharedFilter)
+{
+    EXPECT_EQ(ConsumerGroup::shared_filter("ingest", "a/+/c"), "$share/ingest/a/+/c");
+}
+
+TEST_F(ConsumerGroupTest, ShouldMergeMessagesFromEveryMember)
+{
+    // Arrange
+    ASSERT_TRUE(group->connect(true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group->subscribe("test/group/#", 1, true, GROUP_TIMEOUT_MS));
+
+    // Act
+    publish(30);
+    std::size_t received = drain(30);
+
+    // Assert: every message arrives exactly once, and the broker used more than one member
+    EXPECT_EQ(received, 30u);
+    mqtt::const_message_ptr extra;
+    EXPECT_FALSE(group->wait_next_message(extra, 100));
+    EXPECT_FALSE(group->get_next_message(extra));
+    auto stats = group->get_stats();
+    std::size_t busyMembers = 0;
+    for (auto count : stats.received)
+    {
+        busyMembers += count > 0;
+    }
+    EXPECT_GT(busyMembers, 1u);
+}
+
+TEST_F(ConsumerGroupTest, ShouldRejoinAfterReconnect)
+{
+    // Arrange: subscribe before connecting, members join as they come up
+    ASSERT_TRUE(group->subscribe("test/group/#", 1, true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group->connect(true, GROUP_TIMEOUT_MS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(group->get_stats().rejoins, 3u);
+
+    // Act
+    ASSERT_TRUE(group->member(0).disconnect(true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group->member(0).connect(true, GROUP_TIMEOUT_MS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    publish(30);
+
+    // Assert
+    EXPECT_EQ(group->get_stats().rejoins, 4u);
+    EXPECT_EQ(drain(30), 30u);
+    EXPECT_GT(group->get_stats().received[0], 0u);
+}
+
+TEST_F(ConsumerGroupTest, ShouldDeliverToMessageHandler)
+{
+    // Arrange
+    std::atomic<int> handled{0};
+    group->set_message_handler([&handled](std::size_t, mqtt::const_message_ptr) { ++handled; });
+    ASSERT_TRUE(group->connect(true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group->subscribe("test/group/#", 1, true, GROUP_TIMEOUT_MS));
+
+    // Act
+    publish(12);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(GROUP_TIMEOUT_MS);
+    while (handled.load() < 12 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Assert
+    EXPECT_EQ(handled.load(), 12);
+    EXPECT_EQ(group->get_stats().queued, 0u);
+}
+
+TEST_F(ConsumerGroupTest, ShouldWakeWaitingConsumerOnClose)
+{
+    // Arrange
+    std::atomic<bool> returned{false};
+    bool popped = true;
+    std::thread consumer([this, &returned, &popped]() {
+        mqtt::const_message_ptr msg;
+        popped = group->wait_next_message(msg, 0);
+        returned = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Act
+    group->close();
+    consumer.join();
+
+    // Assert
+    EXPECT_TRUE(returned.load());
+    EXPECT_FALSE(popped);
+    EXPECT_FALSE(group->is_open());
+    mqtt::const_message_ptr msg;
+    EXPECT_FALSE(group->wait_next_message(msg, 0));
+}
+
+TEST(ConsumerGroupQueueTest, ShouldBoundTheMergedQueue)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 4;
+    ConsumerGroup group(GROUP_SERVER_ADDRESS,
+                        "test_group_bounded",
+                        "bounded",
+                        2,
+                        MqttClient::default_connect_options(),
+                        opts);
+    MqttClient publisher(GROUP_SERVER_ADDRESS, "test_group_bounded_publisher");
+    ASSERT_TRUE(publisher.connect(true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group.connect(true, GROUP_TIMEOUT_MS));
+    ASSERT_TRUE(group.subscribe("test/group/bounded", 1, true, GROUP_TIMEOUT_MS));
+
+    // Act: nobody consumes, so the merged queue fills up
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(publisher.publish("test/group/bounded", "reading " + std::to_string(i), 1, true, GROUP_TIMEOUT_MS));
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(GROUP_TIMEOUT_MS);
+    while (group.get_stats().queue.dropped < 6 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Assert
+    auto stats = group.get_stats();
+    EXPECT_EQ(stats.queued, 4u);
+    EXPECT_EQ(stats.queue.dropped, 6u);
+    publisher.disconnect(true, GROUP_TIMEOUT_MS);
+    group.disconnect(true, GROUP_TIMEOUT_MS);
+}
@@ -0,0 +1,194 @@
+#include "flight_recorder.hpp"
+#include <gtest/gtest.h>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+using namespace mqttcpp;
+
+TEST(FlightRecorderTest, ShouldKeepTheLastEventsInOrder)
+{
+    // Arrange
+    FlightRecorder recorder(100);
+    const uint64_t topic = FlightRecorder::topic_hash("fleet/dev42/telemetry");
+
+    // Act
+    for (int i = 0; i < 1000; ++i)
+    {
+        recorder.record("publish", topic, i, i % 3, 0);
+    }
+    std::vector<flight_event> events = recorder.snapshot();
+
+    // Assert: rounded up to 128 slots, holding events 872 to 999
+    ASSERT_EQ(recorder.capacity(), 128u);
+    ASSERT_EQ(events.size(), 128u);
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        const int id = static_cast<int>(872 + i);
+        EXPECT_EQ(events[i].seq, static_cast<uint64_t>(id));
+        EXPECT_EQ(events[i].messageId, id);
+        EXPECT_EQ(events[i].result, id % 3);
+        EXPECT_EQ(events[i].topicHash, topic);
+        EXPECT_STREQ(events[i].what, "publish");
+        if (i > 0)
+        {
+            EXPECT_GE(events[i].when, events[i - 1].when);
+        }
+    }
+}
+
+TEST(FlightRecorderTest, ShouldRecordFromManyThreadsWithoutTearing)
+{
+    // Arrange
+    FlightRecorder recorder(4096);
+    const int perThread = 20000;
+
+    // Act: every event carries its thread in both the id and the result, so a torn slot mixes them
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&recorder, t] {
+            for (int i = 0; i < perThread; ++i)
+            {
+                recorder.record("event", static_cast<uint64_t>(t), t * perThread + i, t, -t);
+            }
+        });
+    }
+    std::vector<flight_event> during = recorder.snapshot();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    std::vector<flight_event> after = recorder.snapshot();
+
+    // Assert: a writer lapped by the whole ring drops its event rather than overwrite a newer one
+    ASSERT_LE(after.size(), 4096u);
+    ASSERT_GE(after.size() + recorder.lost(), 4096u);
+    ASSERT_FALSE(after.empty());
+    std::vector<int> last(4, -1);
+    for (const auto* events : {&during, &after})
+    {
+        for (const auto& event : *events)
+        {
+            ASSERT_EQ(event.messageId / perThread, event.result);
+            ASSERT_EQ(event.reason, -event.result);
+            ASSERT_EQ(event.topicHash, static_cast<uint64_t>(event.result));
+        }
+    }
+    for (const auto& event : after)
+    {
+        // Each thread's own events stay in the order it recorded them
+        EXPECT_GT(event.messageId, last[event.result]);
+        last[event.result] = event.messageId;
+    }
+}
+
+TEST(FlightRecorderTest, ShouldDumpEveryEventToADescriptor)
+{
+    // Arrange
+    FlightRecorder recorder(8);
+    recorder.set_name("dump-test-client");
+    recorder.record("connect");
+    recorder.record("publish", 0xabcdef, 7);
+    recorder.record("publish failed", 0xabcdef, 7, -3, 151);
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+
+    // Act
+    recorder.dump(fileno(output));
+    FlightRecorder::dump_all(fileno(output));
+    std::string text;
+    std::rewind(output);
+    char buffer[4096];
+    std::size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), output)) > 0)
+    {
+        text.append(buffer, read);
+    }
+    std::fclose(output);
+
+    // Assert: once from dump(), once more from dump_all()
+    std::size_t headers = 0;
+    for (std::size_t pos = text.find("flight recorder 'dump-test-client': events 0 to 3\n"); pos != std::string::npos;
+         pos = text.find("flight recorder 'dump-test-client'", pos + 1))
+    {
+        ++headers;
+    }
+    EXPECT_EQ(headers, 2u);
+    EXPECT_NE(text.find(" connect rc=0\n"), std::string::npos) << text;
+    EXPECT_NE(text.find(" publish topic=0000000000abcdef id=7 rc=0\n"), std::string::npos) << text;
+    EXPECT_NE(text.find(" publish failed topic=0000000000abcdef id=7 rc=-3 reason=151\n"), std::string::npos) << text;
+    EXPECT_EQ(text.find("#0 "), text.find("\n") + 1);
+}
+
+TEST(FlightRecorderTest, ShouldCountRecordersPastTheRegistry)
+{
+    // Arrange
+    const std::size_t before = FlightRecorder::unlisted_recorders();
+    std::vector<std::unique_ptr<FlightRecorder>> recorders;
+
+    // Act
+    for (int i = 0; i < 70; ++i)
+    {
+        recorders.emplace_back(new FlightRecorder(2));
+    }
+    const std::size_t full = FlightRecorder::unlisted_recorders();
+    recorders.clear();
+
+    // Assert: 64 slots, shared with any recorder alive elsewhere in the test binary
+    EXPECT_GE(full, before + 6);
+    EXPECT_EQ(FlightRecorder::unlisted_recorders(), before);
+}
+
+#if !defined(_WIN32)
+namespace
+{
+    void previous_abort_handler(int, siginfo_t* info, void*)
+    {
+        const char text[] = "previous handler saw its siginfo\n";
+        if (info && info->si_signo == SIGABRT)
+        {
+            (void)!::write(2, text, sizeof(text) - 1);
+        }
+        ::_exit(3);
+    }
+} // namespace
+
+TEST(FlightRecorderDeathTest, ShouldDumpOnAbort)
+{
+    EXPECT_DEATH(
+        {
+            FlightRecorder recorder(8);
+            recorder.set_name("abort-test-client");
+            recorder.record("publish", 0, 9);
+            FlightRecorder::install_fatal_signal_dump();
+            std::raise(SIGABRT);
+        },
+        "fatal signal [0-9]+, dumping MQTT client flight recorders.*flight recorder 'abort-test-client'.* publish "
+        "id=9 rc=0");
+}
+
+TEST(FlightRecorderDeathTest, ShouldChainAPreviousSiginfoHandler)
+{
+    EXPECT_EXIT(
+        {
+            struct sigaction previous{};
+            previous.sa_sigaction = previous_abort_handler;
+            previous.sa_flags = SA_SIGINFO;
+            sigemptyset(&previous.sa_mask);
+            ::sigaction(SIGABRT, &previous, nullptr);
+            FlightRecorder recorder(8);
+            recorder.set_name("chain-test-client");
+            FlightRecorder::install_fatal_signal_dump();
+            std::raise(SIGABRT);
+        },
+        ::testing::ExitedWithCode(3), "flight recorder 'chain-test-client'.*previous handler saw its siginfo");
+}
+#endif
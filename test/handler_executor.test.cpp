@@ -0,0 +1,158 @@
+#include "handler_executor.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    mqtt::const_message_ptr make_message(const std::string& topic, int seq)
+    {
+        return mqtt::make_message(topic, std::to_string(seq), 0, false);
+    }
+} // namespace
+
+TEST(HandlerExecutorTest, ShouldKeepOrderPerTopicAcrossWorkers)
+{
+    // Arrange
+    std::mutex guard;
+    std::map<std::string, std::vector<int>> seen;
+    handler_executor_options opts;
+    opts.workers = 4;
+    opts.capacity = 64;
+    const int perTopic = 500;
+
+    {
+        HandlerExecutor executor(opts, [&](const mqtt::const_message_ptr& msg) {
+            std::lock_guard<std::mutex> lock(guard);
+            seen[msg->get_topic()].push_back(std::stoi(msg->get_payload_str()));
+        });
+
+        // Act
+        for (int seq = 0; seq < perTopic; ++seq)
+        {
+            for (int t = 0; t < 8; ++t)
+            {
+                ASSERT_TRUE(executor.submit(make_message("devices/" + std::to_string(t), seq)));
+            }
+        }
+    }
+
+    // Assert
+    ASSERT_EQ(seen.size(), 8u);
+    for (const auto& entry : seen)
+    {
+        ASSERT_EQ(entry.second.size(), static_cast<std::size_t>(perTopic)) << entry.first;
+        for (int seq = 0; seq < perTopic; ++seq)
+        {
+            ASSERT_EQ(entry.second[static_cast<std::size_t>(seq)], seq) << entry.first;
+        }
+    }
+}
+
+TEST(HandlerExecutorTest, ShouldRunOtherKeysWhileOneHandlerIsSlow)
+{
+    // Arrange
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> fastDone;
+    handler_executor_options opts;
+    opts.workers = 2;
+    opts.keyHash = [](const mqtt::const_message_ptr& msg) -> std::size_t { return msg->get_topic() == "slow" ? 0 : 1; };
+    HandlerExecutor executor(opts, [&](const mqtt::const_message_ptr& msg) {
+        if (msg->get_topic() == "slow")
+        {
+            released.wait_for(std::chrono::seconds(5));
+        }
+        else
+        {
+            fastDone.set_value();
+        }
+    });
+
+    // Act
+    executor.submit(make_message("slow", 0));
+    executor.submit(make_message("fast", 0));
+
+    // Assert
+    EXPECT_EQ(fastDone.get_future().wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    release.set_value();
+}
+
+TEST(HandlerExecutorTest, ShouldShardByConfiguredTopicLevel)
+{
+    // Arrange
+    handler_executor_options opts;
+    opts.workers = 8;
+    opts.keyLevel = 1;
+    HandlerExecutor executor(opts, [](const mqtt::const_message_ptr&) {});
+    std::set<std::size_t> used;
+
+    // Act & Assert
+    for (int device = 0; device < 64; ++device)
+    {
+        const std::string prefix = "fleet/dev" + std::to_string(device);
+        const std::size_t target = executor.worker_of(make_message(prefix + "/temp", 0));
+        EXPECT_EQ(executor.worker_of(make_message(prefix + "/humidity/raw", 0)), target) << prefix;
+        used.insert(target);
+    }
+    EXPECT_GT(used.size(), 1u);
+    // Too few levels for the key: the whole topic is used
+    EXPECT_EQ(executor.key_of(make_message("fleet", 0)), std::hash<std::string>()("fleet"));
+}
+
+TEST(HandlerExecutorTest, ShouldDropOrBlockWhenWorkerIsFull)
+{
+    // Arrange
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    handler_executor_options opts;
+    opts.workers = 1;
+    opts.capacity = 2;
+    opts.dropWhenFull = true;
+    handler_executor_stats dropping{};
+    {
+        HandlerExecutor executor(opts, [&](const mqtt::const_message_ptr&) {
+            released.wait_for(std::chrono::seconds(5));
+        });
+
+        // Act
+        for (int i = 0; i < 10; ++i)
+        {
+            executor.submit(make_message("t", i));
+        }
+        dropping = executor.get_stats();
+        release.set_value();
+    }
+    opts.dropWhenFull = false;
+    handler_executor_stats blocking{};
+    {
+        HandlerExecutor executor(opts, [](const mqtt::const_message_ptr&) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        });
+        for (int i = 0; i < 50; ++i)
+        {
+            ASSERT_TRUE(executor.submit(make_message("t", i)));
+        }
+        while (executor.get_stats().executed < 50)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        blocking = executor.get_stats();
+    }
+
+    // Assert
+    // One message runs and two wait; the rest are dropped
+    EXPECT_GE(dropping.dropped, 7u);
+    EXPECT_EQ(dropping.submitted + dropping.dropped, 10u);
+    EXPECT_GT(blocking.blocked, 0u);
+    EXPECT_EQ(blocking.dropped, 0u);
+    EXPECT_EQ(blocking.submitted, 50u);
+}
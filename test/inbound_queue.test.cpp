@@ -0,0 +1,402 @@
+#include "inbound_queue.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    mqtt::const_message_ptr make_msg(const std::string& topic, int seq)
+    {
+        return mqtt::make_message(topic, std::to_string(seq), 0, false);
+    }
+} // namespace
+
+TEST(InboundQueueTest, ShouldPopInArrivalOrder)
+{
+    // Arrange
+    InboundQueue queue(inbound_queue_options{8, 1});
+    queue.open();
+
+    // Act
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.push(make_msg("a/b", i)));
+    }
+
+    // Assert
+    mqtt::const_message_ptr msg;
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.try_pop(msg));
+        EXPECT_EQ(msg->get_payload_str(), std::to_string(i));
+    }
+    EXPECT_FALSE(queue.try_pop(msg));
+}
+
+TEST(InboundQueueTest, ShouldDropWhenShardIsFullOrClosed)
+{
+    // Arrange
+    InboundQueue queue(inbound_queue_options{4, 1});
+
+    // Act
+    bool acceptedWhileClosed = queue.push(make_msg("a/b", 0));
+    queue.open();
+    int accepted = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        accepted += queue.push(make_msg("a/b", i)) ? 1 : 0;
+    }
+
+    // Assert
+    EXPECT_FALSE(acceptedWhileClosed);
+    EXPECT_EQ(accepted, 4);
+    inbound_queue_stats stats = queue.get_stats();
+    EXPECT_EQ(stats.pushed, 4u);
+    EXPECT_EQ(stats.dropped, 2u);
+    EXPECT_EQ(stats.size, 4u);
+}
+
+TEST(InboundQueueTest, ShouldKeepTopicsOnTheirShard)
+{
+    // Arrange
+    InboundQueue queue(inbound_queue_options{64, 4});
+    queue.open();
+    const std::vector<std::string> topics{"sensors/1", "sensors/2", "sensors/3", "sensors/4", "sensors/5"};
+
+    // Act
+    for (int i = 0; i < 10; ++i)
+    {
+        for (const auto& topic : topics)
+        {
+            ASSERT_TRUE(queue.push(make_msg(topic, i)));
+        }
+    }
+
+    // Assert
+    std::size_t total = 0;
+    for (std::size_t shard = 0; shard < queue.shard_count(); ++shard)
+    {
+        std::vector<mqtt::const_message_ptr> msgs;
+        total += queue.pop_batch(shard, msgs, 1000, 1);
+        std::map<std::string, int> next;
+        for (const auto& msg : msgs)
+        {
+            EXPECT_EQ(queue.shard_of(msg->get_topic()), shard);
+            EXPECT_EQ(msg->get_payload_str(), std::to_string(next[msg->get_topic()]++));
+        }
+    }
+    EXPECT_EQ(total, 50u);
+}
+
+TEST(InboundQueueTest, ShouldWakeParkedConsumerOnPushAndClose)
+{
+    // Arrange
+    InboundQueue queue(inbound_queue_options{8, 2});
+    queue.open();
+    auto consumer = [&queue] {
+        mqtt::const_message_ptr msg;
+        return queue.pop(msg, 0);
+    };
+
+    // Act
+    auto first = std::async(std::launch::async, consumer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_TRUE(queue.push(make_msg("a/b", 1)));
+    ASSERT_EQ(first.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    auto second = std::async(std::launch::async, consumer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+
+    // Assert
+    ASSERT_EQ(second.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_TRUE(first.get());
+    EXPECT_FALSE(second.get());
+}
+
+TEST(InboundQueueTest, ShouldDeliverEachMessageOnceToConcurrentConsumers)
+{
+    // Arrange
+    const int count = 20000;
+    InboundQueue queue(inbound_queue_options{1024, 1});
+    queue.open();
+    std::atomic<int> consumed{0};
+    std::vector<std::vector<int>> seen(4);
+    std::vector<std::thread> consumers;
+    for (std::size_t c = 0; c < seen.size(); ++c)
+    {
+        consumers.emplace_back([&, c] {
+            mqtt::const_message_ptr msg;
+            while (consumed.load() < count)
+            {
+                if (queue.pop(msg, 10))
+                {
+                    seen[c].push_back(std::stoi(msg->get_payload_str()));
+                    consumed.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // Act
+    for (int i = 0; i < count; ++i)
+    {
+        while (!queue.push(make_msg("a/b", i)))
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& t : consumers)
+    {
+        t.join();
+    }
+
+    // Assert
+    std::set<int> unique;
+    for (const auto& s : seen)
+    {
+        unique.insert(s.begin(), s.end());
+    }
+    EXPECT_EQ(unique.size(), static_cast<std::size_t>(count));
+}
+
+TEST(InboundQueueTest, ShouldEvictOldestWhenFull)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 3;
+    opts.policy = OverflowPolicy::DROP_OLDEST;
+    InboundQueue queue(opts);
+    queue.open();
+
+    // Act
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.push(make_msg("a/b", i)));
+    }
+
+    // Assert
+    std::vector<mqtt::const_message_ptr> msgs;
+    ASSERT_EQ(queue.pop_batch(msgs, 10, 1), 3u);
+    EXPECT_EQ(msgs[0]->get_payload_str(), "2");
+    EXPECT_EQ(msgs[2]->get_payload_str(), "4");
+    inbound_queue_stats stats = queue.get_stats();
+    EXPECT_EQ(stats.pushed, 5u);
+    EXPECT_EQ(stats.evicted, 2u);
+    EXPECT_EQ(stats.dropped, 0u);
+}
+
+TEST(InboundQueueTest, ShouldCapTotalBytesAcrossShards)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 100;
+    opts.shards = 2;
+    opts.maxBytes = 40;
+    InboundQueue queue(opts);
+    queue.open();
+    const std::string payload(7, 'x');
+
+    // Act
+    int accepted = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        // 3 bytes of topic and 7 of payload
+        accepted += queue.push(mqtt::make_message("t/" + std::to_string(i), payload, 0, false)) ? 1 : 0;
+    }
+    mqtt::const_message_ptr msg;
+    ASSERT_TRUE(queue.try_pop(msg));
+    bool acceptedAfterPop = queue.push(mqtt::make_message("t/x", payload, 0, false));
+
+    // Assert
+    EXPECT_EQ(accepted, 4);
+    EXPECT_TRUE(acceptedAfterPop);
+    inbound_queue_stats stats = queue.get_stats();
+    EXPECT_EQ(stats.bytes, 40u);
+    EXPECT_EQ(stats.dropped, 6u);
+}
+
+TEST(InboundQueueTest, ShouldBlockProducerUntilConsumerMakesRoom)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 2;
+    opts.policy = OverflowPolicy::BLOCK;
+    opts.blockTimeout = 2000;
+    InboundQueue queue(opts);
+    queue.open();
+    ASSERT_TRUE(queue.push(make_msg("a/b", 0)));
+    ASSERT_TRUE(queue.push(make_msg("a/b", 1)));
+
+    // Act
+    auto producer = std::async(std::launch::async, [&queue] { return queue.push(make_msg("a/b", 2)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool blocked = producer.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout;
+    mqtt::const_message_ptr msg;
+    ASSERT_TRUE(queue.try_pop(msg));
+
+    // Assert
+    EXPECT_TRUE(blocked);
+    ASSERT_EQ(producer.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_TRUE(producer.get());
+    EXPECT_EQ(queue.get_stats().blocked, 1u);
+    EXPECT_EQ(queue.get_stats().size, 2u);
+}
+
+TEST(InboundQueueTest, ShouldDropAfterBlockTimeout)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 1;
+    opts.policy = OverflowPolicy::BLOCK;
+    opts.blockTimeout = 10;
+    InboundQueue queue(opts);
+    queue.open();
+    ASSERT_TRUE(queue.push(make_msg("a/b", 0)));
+
+    // Act
+    bool accepted = queue.push(make_msg("a/b", 1));
+
+    // Assert
+    EXPECT_FALSE(accepted);
+    inbound_queue_stats stats = queue.get_stats();
+    EXPECT_EQ(stats.blocked, 1u);
+    EXPECT_EQ(stats.dropped, 1u);
+}
+
+TEST(InboundQueueTest, ShouldSpillToDiskAndReadBackInOrder)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 4;
+    opts.policy = OverflowPolicy::SPILL;
+    InboundQueue queue(opts);
+    queue.open();
+
+    // Act
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(queue.push(mqtt::make_message("a/b", std::to_string(i), 1, i % 2 == 0)));
+    }
+    inbound_queue_stats spilledStats = queue.get_stats();
+    std::vector<mqtt::const_message_ptr> msgs;
+    ASSERT_EQ(queue.pop_batch(msgs, 2, 1), 2u);
+    ASSERT_TRUE(queue.push(mqtt::make_message("a/b", "20", 1, true)));
+    while (queue.pop_batch(msgs, 3, 1) > 0)
+    {
+    }
+
+    // Assert
+    EXPECT_EQ(spilledStats.size, 4u);
+    EXPECT_EQ(spilledStats.onDisk, 16u);
+    EXPECT_EQ(spilledStats.spilled, 16u);
+    EXPECT_EQ(spilledStats.unspilled, 0u);
+    ASSERT_EQ(msgs.size(), 21u);
+    for (int i = 0; i < 21; ++i)
+    {
+        EXPECT_EQ(msgs[i]->get_payload_str(), std::to_string(i));
+        EXPECT_EQ(msgs[i]->get_qos(), 1);
+        EXPECT_EQ(msgs[i]->is_retained(), i % 2 == 0);
+    }
+    EXPECT_EQ(queue.get_stats().onDisk, 0u);
+    EXPECT_EQ(queue.get_stats().dropped, 0u);
+}
+
+TEST(InboundQueueTest, ShouldRefillAShardWhileOthersHoldTheByteLimit)
+{
+    // Arrange: one shard holds the whole byte limit, so the other shard's message goes to disk
+    inbound_queue_options opts;
+    opts.capacity = 4;
+    opts.shards = 2;
+    opts.maxBytes = 16;
+    opts.policy = OverflowPolicy::SPILL;
+    InboundQueue queue(opts);
+    queue.open();
+    std::string held = "held/0";
+    std::string spilled = "spilled/0";
+    for (int i = 1; queue.shard_of(spilled) == queue.shard_of(held); ++i)
+    {
+        spilled = "spilled/" + std::to_string(i);
+    }
+    ASSERT_TRUE(queue.push(mqtt::make_message(held, "0123456789abcdef", 1, false)));
+    ASSERT_TRUE(queue.push(mqtt::make_message(spilled, "1", 1, false)));
+    ASSERT_EQ(queue.get_stats().onDisk, 1u);
+
+    // Act: a consumer of the spilled shard must not park until the other shard frees bytes
+    auto consumer = std::async(std::launch::async, [&queue, &spilled] {
+        mqtt::const_message_ptr msg;
+        return queue.pop(queue.shard_of(spilled), msg, 0) ? msg->get_payload_str() : std::string();
+    });
+    bool returned = consumer.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+    queue.close();
+
+    // Assert
+    ASSERT_TRUE(returned);
+    EXPECT_EQ(consumer.get(), "1");
+    EXPECT_EQ(queue.get_stats().dropped, 0u);
+}
+
+TEST(InboundQueueTest, ShouldCountShardsWithoutSpillFile)
+{
+    // Arrange
+    inbound_queue_options opts;
+    opts.capacity = 2;
+    opts.shards = 2;
+    opts.policy = OverflowPolicy::SPILL;
+    opts.spillPath = "/nonexistent-directory/inbound";
+    InboundQueue queue(opts);
+    queue.open();
+
+    // Act
+    for (int i = 0; i < 10; ++i)
+    {
+        queue.push(mqtt::make_message("a/b", std::to_string(i), 1, false));
+    }
+
+    // Assert: the overflow is dropped as with DROP_NEWEST, and the stats say why
+    inbound_queue_stats stats = queue.get_stats();
+    EXPECT_EQ(queue.unspilled_shards(), 2u);
+    EXPECT_EQ(stats.unspilled, 2u);
+    EXPECT_EQ(stats.size, 2u);
+    EXPECT_EQ(stats.dropped, 8u);
+    EXPECT_EQ(stats.spilled, 0u);
+}
+
+TEST(InboundQueueTest, ShouldReportHighAndLowWatermarks)
+{
+    // Arrange
+    std::vector<bool> events;
+    inbound_queue_options opts;
+    opts.capacity = 10;
+    opts.highWatermark = 0.8;
+    opts.lowWatermark = 0.3;
+    opts.watermarkHandler = [&events](bool high) { events.push_back(high); };
+    InboundQueue queue(opts);
+    queue.open();
+
+    // Act
+    for (int i = 0; i < 7; ++i)
+    {
+        ASSERT_TRUE(queue.push(make_msg("a/b", i)));
+    }
+    std::size_t beforeHigh = events.size();
+    ASSERT_TRUE(queue.push(make_msg("a/b", 7)));
+    ASSERT_TRUE(queue.push(make_msg("a/b", 8)));
+    mqtt::const_message_ptr msg;
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.try_pop(msg));
+    }
+    std::size_t beforeLow = events.size();
+    ASSERT_TRUE(queue.try_pop(msg));
+
+    // Assert
+    EXPECT_EQ(beforeHigh, 0u);
+    EXPECT_EQ(beforeLow, 1u);
+    EXPECT_EQ(events, (std::vector<bool>{true, false}));
+}
@@ -0,0 +1,168 @@
+#include "monitor.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ddbg;
+
+namespace
+{
+    std::string read_all(FILE* file)
+    {
+        std::string text;
+        std::rewind(file);
+        char buffer[4096];
+        std::size_t read = 0;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text.append(buffer, read);
+        }
+        return text;
+    }
+} // namespace
+
+TEST(LogBackendTest, ShouldFormatEntriesLikeThePrinter)
+{
+    // Arrange
+    std::time_t when = 1700000000;
+    std::string expectedTime = std::asctime(std::localtime(&when));
+    expectedTime.pop_back();
+    log_entry entry{Printer::MessageMode::INFO, true, static_cast<int64_t>(when) * 1000000000, "file.cpp", 12, "fn",
+                    "hello"};
+    std::string out;
+
+    // Act
+    append_log_entry(out, entry);
+
+    // Assert
+    EXPECT_EQ(format_log_time(when), expectedTime);
+    EXPECT_EQ(out, "\n\033[32m[" + expectedTime + "]\n(at file.cpp:12 - fn)\nInfo: hello\033[0m");
+}
+
+TEST(LogBackendTest, ShouldWriteEveryThreadsRecordsInOrder)
+{
+    // Arrange
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+    ASSERT_TRUE(start_async_logging(opts));
+    const uint64_t writtenBefore = get_async_log_stats().written;
+    const int perThread = 500;
+
+    // Act
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i)
+            {
+                dinfo1("thread %d record %d", t, i) << DD_ENDL;
+                // Keep the small test rings from overflowing
+                if (i % 50 == 0)
+                {
+                    flush_async_log();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    flush_async_log();
+    stop_async_logging();
+    std::string text = read_all(output);
+    std::fclose(output);
+
+    // Assert
+    EXPECT_FALSE(async_logging_enabled());
+    EXPECT_EQ(get_async_log_stats().written - writtenBefore, 4u * perThread);
+    for (int t = 0; t < 4; ++t)
+    {
+        std::size_t pos = 0;
+        for (int i = 0; i < perThread; ++i)
+        {
+            std::string line = "Info: thread " + std::to_string(t) + " record " + std::to_string(i) + "\n";
+            pos = text.find(line, pos);
+            ASSERT_NE(pos, std::string::npos) << line;
+        }
+    }
+}
+
+TEST(LogBackendTest, ShouldCountDropsInsteadOfBlocking)
+{
+    // Arrange
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+    opts.ringBytes = 1024;
+    opts.flushInterval = 1000;
+    ASSERT_TRUE(start_async_logging(opts));
+    const async_log_stats before = get_async_log_stats();
+
+    // Act
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i)
+    {
+        derror("storm %d", i).print();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    const async_log_stats during = get_async_log_stats();
+    stop_async_logging();
+    std::fclose(output);
+
+    // Assert
+    EXPECT_GT(during.dropped - before.dropped, 900u);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+    EXPECT_FALSE(submit_log_entry(log_entry{0, false, 0, nullptr, 0, nullptr, "after stop"}));
+}
+
+TEST(LogBackendTest, ShouldWriteEveryAcceptedRecordWhenStoppingUnderLoad)
+{
+    // Arrange
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+
+    for (int round = 0; round < 10; ++round)
+    {
+        ASSERT_TRUE(start_async_logging(opts));
+        const uint64_t writtenBefore = get_async_log_stats().written;
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> accepted{0};
+
+        // Act: stop while every thread is still submitting
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                while (!done.load())
+                {
+                    if (submit_log_entry(log_entry{0, false, 0, nullptr, 0, nullptr, "racing stop"}))
+                    {
+                        accepted.fetch_add(1);
+                    }
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        stop_async_logging();
+        done.store(true);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        // Assert: a record reported as accepted was written by the final drain
+        ASSERT_EQ(get_async_log_stats().written - writtenBefore, accepted.load()) << "round " << round;
+    }
+    std::fclose(output);
+}
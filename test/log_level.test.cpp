@@ -0,0 +1,96 @@
+#include "monitor.hpp"
+#include <gtest/gtest.h>
+
+using namespace ddbg;
+
+namespace
+{
+    int evaluations = 0;
+
+    int counted(int value)
+    {
+        ++evaluations;
+        return value;
+    }
+
+// Statements above this threshold are compiled out of the function below
+#pragma push_macro("DD_COMPILE_LEVEL")
+#undef DD_COMPILE_LEVEL
+#define DD_COMPILE_LEVEL DD_LEVEL_ERROR
+    void log_info_compiled_out()
+    {
+        dinfo1("value %d", counted(1)) << counted(2) << DD_ENDL;
+    }
+#pragma pop_macro("DD_COMPILE_LEVEL")
+
+    class LogLevelTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            evaluations = 0;
+        }
+
+        void TearDown() override
+        {
+            set_log_level(DD_LEVEL_DEBUG);
+        }
+    };
+} // namespace
+
+TEST_F(LogLevelTest, ShouldNotEvaluateArgumentsBelowTheRuntimeLevel)
+{
+    // Arrange
+    set_log_level(DD_LEVEL_ERROR);
+
+    // Act
+    dinfo1("value %d", counted(1)) << counted(2) << DD_ENDL;
+    ddebug2("value %d", counted(3)).print();
+
+    // Assert
+    EXPECT_EQ(evaluations, 0);
+    EXPECT_FALSE(DD_LOG_ENABLED(DD_LEVEL_INFO));
+    EXPECT_TRUE(DD_LOG_ENABLED(DD_LEVEL_ERROR));
+}
+
+TEST_F(LogLevelTest, ShouldEvaluateArgumentsOfEnabledLevels)
+{
+    // Arrange
+    set_log_level(DD_LEVEL_INFO);
+
+    // Act
+    dinfo("value %d", counted(1)) << counted(2) << DD_ENDL;
+
+    // Assert
+    EXPECT_EQ(evaluations, 2);
+    EXPECT_EQ(get_log_level(), DD_LEVEL_INFO);
+}
+
+TEST_F(LogLevelTest, ShouldRemoveStatementsAboveTheCompileLevel)
+{
+    // Arrange
+    set_log_level(DD_LEVEL_DEBUG);
+
+    // Act
+    log_info_compiled_out();
+
+    // Assert
+    EXPECT_EQ(evaluations, 0);
+}
+
+TEST_F(LogLevelTest, ShouldStaySingleStatementInsideIfElse)
+{
+    // Arrange
+    set_log_level(DD_LEVEL_OFF);
+    bool tookElse = false;
+
+    // Act
+    if (evaluations == 0)
+        derror("value %d", counted(1)).print();
+    else
+        tookElse = true;
+
+    // Assert
+    EXPECT_FALSE(tookElse);
+    EXPECT_EQ(evaluations, 0);
+}
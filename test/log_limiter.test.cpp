@@ -0,0 +1,191 @@
+#include "log_limiter.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ddbg;
+
+namespace
+{
+    class LogLimiterTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override
+        {
+            set_log_limit_interval(1000);
+        }
+    };
+
+    std::string read_all(FILE* file)
+    {
+        std::string text;
+        std::rewind(file);
+        char buffer[4096];
+        std::size_t read = 0;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text.append(buffer, read);
+        }
+        return text;
+    }
+
+    std::size_t count_of(const std::string& text, const std::string& needle)
+    {
+        std::size_t count = 0;
+        for (std::size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+} // namespace
+
+TEST_F(LogLimiterTest, ShouldLogFirstOccurrenceThenSummarizeRepeats)
+{
+    // Arrange
+    set_log_limit_interval(50);
+    LogLimiter limiter;
+    uint64_t repeated = 0;
+    const uint64_t key = log_key("Publish", 3, 0);
+
+    // Act
+    bool first = limiter.admit(key, repeated);
+    uint64_t firstRepeated = repeated;
+    int suppressed = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        suppressed += limiter.admit(key, repeated) ? 0 : 1;
+    }
+    bool other = limiter.admit(log_key("Subscribe", 3, 0), repeated);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    bool summary = limiter.admit(key, repeated);
+
+    // Assert
+    EXPECT_TRUE(first);
+    EXPECT_EQ(firstRepeated, 0u);
+    EXPECT_EQ(suppressed, 100);
+    EXPECT_TRUE(other);
+    EXPECT_TRUE(summary);
+    EXPECT_EQ(repeated, 100u);
+}
+
+TEST_F(LogLimiterTest, ShouldNotSuppressWithZeroInterval)
+{
+    // Arrange
+    set_log_limit_interval(0);
+    LogLimiter limiter;
+    uint64_t repeated = 0;
+
+    // Act & Assert
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE(limiter.admit(1, repeated));
+    }
+}
+
+TEST_F(LogLimiterTest, ShouldBoundLogVolumeDuringErrorStorm)
+{
+    // Arrange
+    set_log_limit_interval(20);
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+    ASSERT_TRUE(start_async_logging(opts));
+    const int threads = 4;
+    const int perThread = 50000;
+
+    // Act: two distinct errors raised from one call site by every thread
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([] {
+            for (int i = 0; i < perThread; ++i)
+            {
+                const int rc = i % 2 ? -3 : -1;
+                derror1_limited(log_key("Publish", rc), "[Storm] Publish error: rc=%d\n", rc).print();
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    flush_async_log();
+    stop_async_logging();
+    std::string text = read_all(output);
+    std::fclose(output);
+
+    // Assert: at most one line per error and interval, and the summaries account for the rest
+    const auto windows = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 20 + 1;
+    const std::size_t lines = count_of(text, "[Storm] Publish error");
+    EXPECT_GE(lines, 2u);
+    EXPECT_LE(lines, static_cast<std::size_t>(2 * windows));
+    uint64_t summarized = 0;
+    for (std::size_t pos = text.find("[repeated "); pos != std::string::npos; pos = text.find("[repeated ", pos + 1))
+    {
+        summarized += std::stoull(text.substr(pos + 10));
+    }
+    EXPECT_EQ(summarized + lines, static_cast<uint64_t>(threads) * perThread);
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST_F(LogLimiterTest, ShouldSummarizeRepeatsOnceTheStormStops)
+{
+    // Arrange
+    set_log_limit_interval(20);
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+    ASSERT_TRUE(start_async_logging(opts));
+
+    // Act: a burst inside one interval, then silence
+    for (int i = 0; i < 100; ++i)
+    {
+        derror1_limited(log_key("Subscribe", -1), "[Burst] Subscribe error\n").print();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    flush_async_log();
+    std::string text = read_all(output);
+    stop_async_logging();
+    std::fclose(output);
+
+    // Assert: the suppressed occurrences are reported without another occurrence
+    EXPECT_EQ(count_of(text, "[Burst] Subscribe error"), 1u);
+    EXPECT_EQ(count_of(text, "[repeated 99 times] (summary of the message logged at "), 1u);
+}
+
+TEST_F(LogLimiterTest, ShouldNotSummarizeAStormStillGoingOn)
+{
+    // Arrange
+    set_log_limit_interval(50);
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    async_log_options opts;
+    opts.output = output;
+    ASSERT_TRUE(start_async_logging(opts));
+
+    // Act: one occurrence per millisecond over several intervals
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        derror1_limited(log_key("Unsubscribe", -1), "[Ongoing] Unsubscribe error\n").print();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    flush_async_log();
+    std::string text = read_all(output);
+    stop_async_logging();
+    std::fclose(output);
+
+    // Assert: every interval logs a single line, which carries the count of the previous one
+    const std::size_t lines = count_of(text, "[Ongoing] Unsubscribe error");
+    EXPECT_GE(lines, 2u);
+    EXPECT_EQ(count_of(text, "(summary of the message logged at "), 0u);
+    EXPECT_EQ(count_of(text, "[repeated "), lines - 1);
+}
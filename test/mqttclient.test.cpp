@@ -1,11 +1,15 @@
 #include "mqttclient.hpp"
+#include "log_limiter.hpp"
 #include <gtest/gtest.h>
+#include <atomic>
 #include <memory>
 #include <chrono>
 #include <thread>
 #include <future>
 #include <string>
 #include <cstdlib>
+#include <map>
+#include <set>
 
 using namespace mqtt;
 using namespace mqttcpp;
@@ -291,3 +295,1061 @@ TEST_F(MqttClientTest, ShouldHandleMessageConsumption)
     EXPECT_TRUE(client->stop_saving_message());
     EXPECT_FALSE(client->is_saving_message());
 }
+
+TEST_F(MqttClientTest, ShouldWaitForNextMessage)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    auto publisher = std::async(std::launch::async, [this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return client->publish(TOPIC, "awaited", QOS, false);
+    });
+
+    // Act
+    mqtt::binary msg;
+    bool delivered = client->wait_next_message(msg, TIMEOUT_MS);
+
+    // Assert
+    EXPECT_TRUE(publisher.get());
+    EXPECT_TRUE(delivered);
+    EXPECT_EQ(msg, "awaited");
+}
+
+TEST_F(MqttClientTest, ShouldTimeOutWhenNoMessageArrives)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+
+    // Act
+    mqtt::binary msg;
+    auto start = std::chrono::steady_clock::now();
+    bool delivered = client->wait_next_message(msg, 100);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Assert
+    EXPECT_FALSE(delivered);
+    EXPECT_TRUE(msg.empty());
+    EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+}
+
+TEST_F(MqttClientTest, ShouldDrainSavedMessagesInBatches)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC, "batch " + std::to_string(i), QOS, true, TIMEOUT_MS));
+    }
+
+    // Act
+    std::vector<mqtt::binary> msgs;
+    while (msgs.size() < 5 && client->drain_messages(msgs, 3, TIMEOUT_MS) > 0)
+    {
+        ASSERT_LE(msgs.size(), 5u);
+    }
+
+    // Assert
+    ASSERT_EQ(msgs.size(), 5u);
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(msgs[static_cast<std::size_t>(i)], "batch " + std::to_string(i));
+    }
+    EXPECT_EQ(client->drain_messages(msgs, 3, 50), 0u);
+}
+
+TEST_F(MqttClientTest, ShouldConsumeMessagesWithoutCopying)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    ASSERT_TRUE(client->publish(mqtt::make_message(TOPIC, "first", QOS, false), true, TIMEOUT_MS));
+    ASSERT_TRUE(client->publish(mqtt::make_message(TOPIC, "second", QOS, false), true, TIMEOUT_MS));
+
+    // Act
+    mqtt::const_message_ptr first;
+    bool delivered = client->wait_next_message(first, TIMEOUT_MS);
+    std::vector<mqtt::const_message_ptr> rest;
+    std::size_t drained = client->drain_messages(rest, 10, TIMEOUT_MS);
+
+    // Assert
+    ASSERT_TRUE(delivered);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->get_topic(), TOPIC);
+    EXPECT_EQ(first->get_qos(), QOS);
+    EXPECT_EQ(first->get_payload_str(), "first");
+    ASSERT_EQ(drained, 1u);
+    EXPECT_EQ(rest.front()->get_payload_str(), "second");
+    EXPECT_FALSE(client->get_next_message(first));
+}
+
+TEST_F(MqttClientTest, ShouldReleaseReplacedInboundQueues)
+{
+    // Arrange: only the client's options and the first queue's options reference the sentinel
+    auto sentinel = std::make_shared<int>(0);
+    inbound_queue_options first{256, 2};
+    first.watermarkHandler = [sentinel](bool) {};
+    ASSERT_TRUE(client->set_inbound_queue(first));
+    first = inbound_queue_options{};
+    ASSERT_EQ(sentinel.use_count(), 3);
+
+    // Act
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(client->set_inbound_queue(inbound_queue_options{256, 2}));
+    }
+
+    // Assert: the replaced queue is gone, and the current one still works
+    EXPECT_EQ(sentinel.use_count(), 1);
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    ASSERT_TRUE(client->publish(TOPIC, "after", QOS, true, TIMEOUT_MS));
+    mqtt::const_message_ptr msg;
+    ASSERT_TRUE(client->wait_next_message(msg, TIMEOUT_MS));
+    EXPECT_EQ(msg->get_payload_str(), "after");
+}
+
+TEST_F(MqttClientTest, ShouldRejectSpillQueueWithoutSpillFile)
+{
+    // Arrange
+    ASSERT_TRUE(client->set_inbound_queue(inbound_queue_options{256, 2}));
+    inbound_queue_options spilling{256, 2};
+    spilling.policy = OverflowPolicy::SPILL;
+    spilling.spillPath = "/nonexistent-directory/inbound";
+
+    // Act
+    bool accepted = client->set_inbound_queue(spilling);
+
+    // Assert: the previous queue stays in place
+    EXPECT_FALSE(accepted);
+    EXPECT_EQ(client->get_inbound_stats().shards, 2u);
+    EXPECT_EQ(client->get_inbound_stats().unspilled, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldConsumeShardedInboundQueuePerWorker)
+{
+    // Arrange
+    ASSERT_TRUE(client->set_inbound_queue(inbound_queue_options{256, 4}));
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC + "/#", QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    EXPECT_FALSE(client->set_inbound_queue(inbound_queue_options{256, 2}));
+    const int topics = 8;
+    for (int i = 0; i < topics; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC + "/" + std::to_string(i), "sharded", QOS, true, TIMEOUT_MS));
+    }
+
+    // Act
+    std::vector<std::future<std::vector<mqtt::const_message_ptr>>> workers;
+    for (std::size_t shard = 0; shard < 4; ++shard)
+    {
+        workers.push_back(std::async(std::launch::async, [this, shard] {
+            std::vector<mqtt::const_message_ptr> msgs;
+            while (client->drain_messages(shard, msgs, 100, 200) > 0)
+            {
+            }
+            return msgs;
+        }));
+    }
+
+    // Assert
+    std::size_t total = 0;
+    for (std::size_t shard = 0; shard < workers.size(); ++shard)
+    {
+        for (const auto& msg : workers[shard].get())
+        {
+            EXPECT_EQ(client->inbound_shard_of(msg->get_topic()), shard);
+            ++total;
+        }
+    }
+    EXPECT_EQ(total, static_cast<std::size_t>(topics));
+    EXPECT_EQ(client->get_inbound_stats().shards, 4u);
+}
+
+TEST_F(MqttClientTest, ShouldKeepNewestMessagesAndReportWatermarksWhenInboundQueueOverflows)
+{
+    // Arrange
+    std::atomic<int> highs{0};
+    inbound_queue_options opts;
+    opts.capacity = 2;
+    opts.policy = OverflowPolicy::DROP_OLDEST;
+    opts.watermarkHandler = [&highs](bool high) { highs += high ? 1 : 0; };
+    ASSERT_TRUE(client->set_inbound_queue(opts));
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+
+    // Act
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC, std::to_string(i), QOS, true, TIMEOUT_MS));
+    }
+    std::vector<mqtt::const_message_ptr> msgs;
+    for (int attempt = 0; attempt < 50 && client->get_inbound_stats().pushed < 5; ++attempt)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    client->drain_messages(msgs, 10, 200);
+
+    // Assert
+    ASSERT_EQ(msgs.size(), 2u);
+    EXPECT_EQ(msgs[0]->get_payload_str(), "3");
+    EXPECT_EQ(msgs[1]->get_payload_str(), "4");
+    EXPECT_EQ(client->get_inbound_stats().evicted, 3u);
+    EXPECT_EQ(highs.load(), 1);
+}
+
+TEST_F(MqttClientTest, ShouldDispatchMessagesToHandlersOfMatchingFilters)
+{
+    // Arrange
+    std::promise<std::string> matched;
+    std::atomic<bool> first{true};
+    std::atomic<int> unmatched{0};
+    auto id = client->add_message_handler(TOPIC + "/dispatch/+", [&](const mqtt::const_message_ptr& msg) {
+        if (first.exchange(false))
+        {
+            matched.set_value(msg->get_payload_str());
+        }
+    });
+    ASSERT_NE(id, TopicDispatcher::INVALID_HANDLER);
+    client->add_message_handler(TOPIC + "/other/#", [&unmatched](const mqtt::const_message_ptr&) { ++unmatched; });
+    EXPECT_EQ(client->add_message_handler(TOPIC + "/#/bad", [](const mqtt::const_message_ptr&) {}),
+              TopicDispatcher::INVALID_HANDLER);
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC + "/dispatch/#", QOS, true, TIMEOUT_MS));
+
+    // Act
+    ASSERT_TRUE(client->publish(TOPIC + "/dispatch/a", "routed", QOS, true, TIMEOUT_MS));
+    auto delivered = matched.get_future();
+
+    // Assert
+    ASSERT_EQ(delivered.wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+    EXPECT_EQ(delivered.get(), "routed");
+    EXPECT_EQ(unmatched.load(), 0);
+    EXPECT_TRUE(client->remove_message_handler(id));
+}
+
+TEST_F(MqttClientTest, ShouldRunHandlersOnWorkersInPerTopicOrder)
+{
+    // Arrange
+    handler_executor_options opts;
+    opts.workers = 2;
+    client->set_handler_workers(opts);
+    const int perTopic = 10;
+    std::mutex guard;
+    std::map<std::string, std::vector<std::string>> seen;
+    std::set<std::thread::id> threads;
+    std::promise<void> done;
+    std::atomic<int> remaining{2 * perTopic};
+    client->add_message_handler(TOPIC + "/workers/#", [&](const mqtt::const_message_ptr& msg) {
+        {
+            std::lock_guard<std::mutex> lock(guard);
+            seen[msg->get_topic()].push_back(msg->get_payload_str());
+            threads.insert(std::this_thread::get_id());
+        }
+        if (--remaining == 0)
+        {
+            done.set_value();
+        }
+    });
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC + "/workers/#", QOS, true, TIMEOUT_MS));
+
+    // Act
+    for (int i = 0; i < perTopic; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC + "/workers/a", std::to_string(i), QOS, true, TIMEOUT_MS));
+        ASSERT_TRUE(client->publish(TOPIC + "/workers/b", std::to_string(i), QOS, true, TIMEOUT_MS));
+    }
+
+    // Assert
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+    std::lock_guard<std::mutex> lock(guard);
+    for (const auto& entry : seen)
+    {
+        ASSERT_EQ(entry.second.size(), static_cast<std::size_t>(perTopic)) << entry.first;
+        for (int i = 0; i < perTopic; ++i)
+        {
+            EXPECT_EQ(entry.second[static_cast<std::size_t>(i)], std::to_string(i)) << entry.first;
+        }
+    }
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+    EXPECT_EQ(client->get_handler_stats().workers, 2u);
+}
+
+TEST_F(MqttClientTest, ShouldWakeWaitingConsumerWhenSavingStops)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->start_saving_message());
+    auto consumer = std::async(std::launch::async, [this] {
+        mqtt::binary msg;
+        return client->wait_next_message(msg);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Act
+    ASSERT_TRUE(client->stop_saving_message());
+
+    // Assert
+    ASSERT_EQ(consumer.wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+    EXPECT_FALSE(consumer.get());
+}
+
+// Batch Publishing Tests
+TEST_F(MqttClientTest, ShouldPublishBatchOfMessages)
+{
+    // Arrange
+    mqtt::token_ptr token;
+    ASSERT_TRUE(client->connect(token));
+    token->wait();
+    std::vector<publish_request> msgs;
+    for (int i = 0; i < 10; ++i)
+    {
+        publish_request req;
+        req.topic = TOPIC;
+        req.payload = std::string("batch message ") + std::to_string(i);
+        req.qos = QOS;
+        msgs.push_back(req);
+    }
+
+    // Act
+    batch_token_ptr batch;
+    bool result = client->publish_batch(batch, msgs);
+
+    // Assert
+    EXPECT_TRUE(result);
+    ASSERT_TRUE(batch != nullptr);
+    EXPECT_EQ(batch->size(), msgs.size());
+    EXPECT_TRUE(batch->wait_for(TIMEOUT_MS));
+    EXPECT_EQ(batch->failed(), 0u);
+}
+
+TEST_F(MqttClientTest, ShouldReportBatchFailuresWithoutThrowing)
+{
+    // Arrange: the client is not connected, so every submission fails
+    publish_request req;
+    req.topic = TOPIC;
+    req.payload = std::string("lost");
+    req.qos = QOS;
+    std::vector<publish_request> msgs(3, req);
+
+    // Act
+    batch_token_ptr batch;
+    bool result = false;
+    EXPECT_NO_THROW(result = client->publish_batch(batch, msgs));
+
+    // Assert
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(batch->is_complete());
+    auto failures = batch->get_failures();
+    ASSERT_EQ(failures.size(), msgs.size());
+    EXPECT_EQ(failures[0].index, 0u);
+    EXPECT_EQ(failures[2].index, 2u);
+}
+
+// Zero-copy Publishing Tests
+TEST_F(MqttClientTest, ShouldPublishSharedPayloadWithoutCopy)
+{
+    // Arrange
+    mqtt::token_ptr token;
+    ASSERT_TRUE(client->connect(token));
+    token->wait();
+    mqtt::binary_ref payload(std::string(64 * 1024, 'x'));
+    const char* buffer = payload.data();
+
+    // Act
+    bool result = client->publish(token, TOPIC, payload, QOS);
+    token->wait();
+
+    // Assert: the delivered message still points at the caller's buffer
+    EXPECT_TRUE(result);
+    auto dtok = std::dynamic_pointer_cast<mqtt::delivery_token>(token);
+    ASSERT_TRUE(dtok != nullptr);
+    EXPECT_EQ(dtok->get_message()->get_payload_ref().data(), buffer);
+}
+
+TEST_F(MqttClientTest, ShouldPublishStringLiteralPayload)
+{
+    // Arrange
+    mqtt::token_ptr token;
+    ASSERT_TRUE(client->connect(token));
+    token->wait();
+
+    // Act: a literal converts to both std::string and mqtt::binary_ref
+    bool result = client->publish(token, TOPIC, "hello", QOS);
+    token->wait();
+
+    // Assert
+    EXPECT_TRUE(result);
+    auto dtok = std::dynamic_pointer_cast<mqtt::delivery_token>(token);
+    ASSERT_TRUE(dtok != nullptr);
+    EXPECT_EQ(dtok->get_message()->to_string(), "hello");
+}
+
+TEST_F(MqttClientTest, ShouldPublishPrebuiltMessageWithoutCopy)
+{
+    // Arrange
+    mqtt::token_ptr token;
+    ASSERT_TRUE(client->connect(token));
+    token->wait();
+    mqtt::message_ptr msg = mqtt::make_message(TOPIC, std::string(64 * 1024, 'y'), QOS, false);
+
+    // Act
+    bool result = client->publish(token, msg);
+    token->wait();
+
+    // Assert: the very same message object was handed to the client
+    EXPECT_TRUE(result);
+    auto dtok = std::dynamic_pointer_cast<mqtt::delivery_token>(token);
+    ASSERT_TRUE(dtok != nullptr);
+    EXPECT_EQ(dtok->get_message().get(), msg.get());
+    EXPECT_TRUE(client->publish(msg, true, TIMEOUT_MS));
+}
+
+// Publish Window Tests
+TEST_F(MqttClientTest, ShouldBlockWhenPublishWindowIsFull)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::BLOCK;
+    opts.blockTimeout = TIMEOUT_MS;
+    client->set_publish_window(opts);
+
+    // Act
+    bool result = true;
+    for (int i = 0; i < 10; ++i)
+    {
+        result = client->publish(TOPIC, "windowed", 1, false) && result;
+        EXPECT_LE(client->get_publish_window_stats().inflight, 1u);
+    }
+    ASSERT_TRUE(client->publish(TOPIC, "last", 1, true, TIMEOUT_MS));
+
+    // Assert
+    EXPECT_TRUE(result);
+    auto stats = client->get_publish_window_stats();
+    EXPECT_EQ(stats.limit, 1u);
+    EXPECT_EQ(stats.rejected, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldFailFastWhenPublishWindowIsFull)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::FAIL;
+    client->set_publish_window(opts);
+    // Keep the callback thread busy so that acknowledgements cannot free the window while publishing
+    std::promise<void> stall;
+    std::shared_future<void> stalled = stall.get_future().share();
+    ASSERT_TRUE(client->subscribe([stalled](const completion_record&) { stalled.wait(); }, TOPIC));
+    std::shared_ptr<void> resume(nullptr, [&stall](void*) { stall.set_value(); });
+
+    // Act
+    uint64_t failures = 0;
+    for (int i = 0; i < 50; ++i)
+    {
+        if (!client->publish(TOPIC, "windowed", 1, false))
+        {
+            ++failures;
+            ASSERT_TRUE(client->get_last_exception()->getMqttException() != nullptr);
+            EXPECT_EQ(client->get_last_exception()->getMqttException()->get_return_code(),
+                      MQTTASYNC_MAX_MESSAGES_INFLIGHT);
+        }
+    }
+
+    // Assert
+    EXPECT_GT(failures, 0u);
+    EXPECT_EQ(client->get_publish_window_stats().rejected, failures);
+}
+
+TEST_F(MqttClientTest, ShouldQueuePublishesBeyondTheWindow)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::QUEUE;
+    client->set_publish_window(opts);
+    std::vector<publish_request> msgs(20);
+    for (auto& req : msgs)
+    {
+        req.topic = TOPIC;
+        req.payload = std::string("queued");
+        req.qos = 1;
+    }
+
+    // Act
+    batch_token_ptr batch;
+    bool result = client->publish_batch(batch, msgs);
+
+    // Assert: every queued message is eventually submitted and acknowledged
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(batch->wait_for(TIMEOUT_MS));
+    EXPECT_EQ(batch->failed(), 0u);
+    auto stats = client->get_publish_window_stats();
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_EQ(stats.inflight, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldWaitForQueuedPublishToComplete)
+{
+    // Arrange: stall the callback thread so that the window stays full and the backlog is not drained
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::QUEUE;
+    client->set_publish_window(opts);
+    std::promise<void> stall;
+    std::shared_future<void> stalled = stall.get_future().share();
+    ASSERT_TRUE(client->subscribe([stalled](const completion_record&) { stalled.wait(); }, TOPIC));
+    std::shared_ptr<void> resume(nullptr, [&stall](void*) { stall.set_value(); });
+    ASSERT_TRUE(client->publish(TOPIC, "first", 1, false));
+
+    // Act: the message is queued behind the first one, so no token exists when the call starts
+    auto pending = std::async(std::launch::async, [this] { return client->publish(TOPIC, "queued", 1, true, 0); });
+    bool returnedWhileQueued = pending.wait_for(std::chrono::milliseconds(300)) == std::future_status::ready;
+    resume.reset();
+    ASSERT_EQ(pending.wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+
+    // Assert: publish() returned only once the queued message was delivered
+    EXPECT_FALSE(returnedWhileQueued);
+    EXPECT_TRUE(pending.get());
+    auto stats = client->get_publish_window_stats();
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_EQ(stats.inflight, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldBoundCongestionWindowByReceiveMaximum)
+{
+    // Arrange
+    congestion_options opts;
+    opts.enabled = true;
+    opts.maxWindow = 1000;
+    client->set_congestion_control(opts);
+
+    // Act
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC, "adaptive", 1, true, TIMEOUT_MS));
+    }
+
+    // Assert: the test broker announces Receive Maximum 20 (mosquitto's default max_inflight_messages)
+    auto stats = client->get_congestion_stats();
+    EXPECT_EQ(stats.ceiling, 20u);
+    EXPECT_LE(stats.window, stats.ceiling);
+    EXPECT_EQ(client->get_publish_window_stats().limit, stats.window);
+}
+
+// Conflation Tests
+TEST_F(MqttClientTest, ShouldConflatePublishesWhileDisconnected)
+{
+    // Arrange
+    client->add_conflation_filter(TOPIC);
+
+    // Act: the client is not connected yet, so values are parked and replaced
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_TRUE(client->publish(TOPIC, "value " + std::to_string(i), QOS, false));
+    }
+    auto parked = client->get_conflation_stats();
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Assert
+    EXPECT_EQ(parked.pending, 1u);
+    EXPECT_EQ(parked.deferred, 1u);
+    EXPECT_EQ(parked.conflated, 99u);
+    auto flushed = client->get_conflation_stats();
+    EXPECT_EQ(flushed.pending, 0u);
+    EXPECT_EQ(flushed.flushed, 1u);
+}
+
+TEST_F(MqttClientTest, ShouldDeliverLatestConflatedValue)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    ASSERT_TRUE(client->subscribe(TOPIC, QOS, true, TIMEOUT_MS));
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::FAIL;
+    client->set_publish_window(opts);
+    client->add_conflation_filter(TOPIC);
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::string last;
+    client->set_event_handler([&](CallbackEvent event, CallbackVariant info) {
+        if (event == CallbackEvent::EVENT_MESSAGE_ARRIVED)
+        {
+            std::lock_guard<std::mutex> lock(m);
+            last = info.asMessage()->get_payload_str();
+            cv.notify_all();
+        }
+    });
+
+    // Act: publish faster than the window allows; conflated topics never fail
+    for (int i = 0; i < 50; ++i)
+    {
+        EXPECT_TRUE(client->publish(TOPIC, "value " + std::to_string(i), 1, false));
+    }
+
+    // Assert
+    std::unique_lock<std::mutex> lock(m);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MS), [&] { return last == "value 49"; }));
+    EXPECT_EQ(client->get_publish_window_stats().rejected, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldRejectMalformedConflationFilters)
+{
+    // Act
+    bool malformed = client->add_conflation_filter("test/#/topic");
+    bool wellFormed = client->add_conflation_filter("test/#");
+
+    // Assert: the malformed filter was not registered, so it does not park "test/x" while disconnected
+    EXPECT_FALSE(malformed);
+    EXPECT_TRUE(wellFormed);
+    client->remove_conflation_filter("test/#");
+    client->publish("test/x", "value", QOS, false);
+    EXPECT_EQ(client->get_conflation_stats().deferred, 0u);
+}
+
+// Rate Limit Tests
+TEST_F(MqttClientTest, ShouldFailPublishesOverRateLimit)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    client->set_rate_limit(1.0, 3, RateLimitMode::FAIL);
+
+    // Act
+    int published = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (client->publish(TOPIC, "limited", QOS, false))
+        {
+            ++published;
+        }
+        else
+        {
+            ASSERT_TRUE(client->get_last_exception()->getMqttException() != nullptr);
+            EXPECT_EQ(client->get_last_exception()->getMqttException()->get_reason_code(),
+                      mqtt::ReasonCode::QUOTA_EXCEEDED);
+        }
+    }
+
+    // Assert
+    EXPECT_EQ(published, 3);
+    EXPECT_EQ(client->get_rate_limit_stats().failed, 7u);
+}
+
+TEST_F(MqttClientTest, ShouldNotChargeRateLimitForWindowRejectedPublishes)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    client->set_rate_limit(1.0, 3, RateLimitMode::FAIL);
+    publish_window_options opts;
+    opts.maxInflight = 1;
+    opts.mode = BackpressureMode::FAIL;
+    client->set_publish_window(opts);
+    std::promise<void> stall;
+    std::shared_future<void> stalled = stall.get_future().share();
+    ASSERT_TRUE(client->subscribe([stalled](const completion_record&) { stalled.wait(); }, TOPIC));
+    std::shared_ptr<void> resume(nullptr, [&stall](void*) { stall.set_value(); });
+
+    // Act
+    for (int i = 0; i < 20; ++i)
+    {
+        client->publish(TOPIC, "windowed", 1, false);
+    }
+
+    // Assert: the publishes refused by the window left the rate budget to the ones that were sent
+    EXPECT_GT(client->get_publish_window_stats().rejected, 0u);
+    EXPECT_EQ(client->get_rate_limit_stats().failed, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldReportDroppedBatchMessagesAsFailures)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    client->set_topic_rate_limit(TOPIC, 1.0, 2, RateLimitMode::DROP);
+    std::vector<publish_request> msgs(5);
+    for (auto& req : msgs)
+    {
+        req.topic = TOPIC;
+        req.payload = std::string("dropped");
+        req.qos = 1;
+    }
+
+    // Act
+    batch_token_ptr batch;
+    bool result = client->publish_batch(batch, msgs);
+
+    // Assert
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(batch->wait_for(TIMEOUT_MS));
+    EXPECT_EQ(batch->failed(), 3u);
+    EXPECT_EQ(client->get_rate_limit_stats().dropped, 3u);
+}
+
+// Completion Tests
+TEST_F(MqttClientTest, ShouldQueueCompletionRecordsByDefault)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+
+    // Act
+    ASSERT_TRUE(client->publish(TOPIC, "recorded", 1, true, TIMEOUT_MS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    bool sawConnect = false;
+    bool sawPublish = false;
+    completion_record record;
+    while (client->poll_completion(record))
+    {
+        EXPECT_EQ(record.returnCode, MQTTASYNC_SUCCESS);
+        sawConnect = sawConnect || record.type == mqtt::token::CONNECT;
+        if (record.type == mqtt::token::PUBLISH)
+        {
+            sawPublish = true;
+            EXPECT_GT(record.msgId, 0);
+        }
+    }
+    EXPECT_TRUE(sawConnect);
+    EXPECT_TRUE(sawPublish);
+    EXPECT_EQ(client->get_completion_stats().dropped, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldDeliverCompletionRecordsToHandler)
+{
+    // Arrange
+    std::atomic<int> publishes{0};
+    client->set_completion_handler([&publishes](const completion_record& record) {
+        if (record.type == mqtt::token::PUBLISH)
+        {
+            ++publishes;
+        }
+    });
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+
+    // Act
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC, "handled", 1, true, TIMEOUT_MS));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert: records bypass the queue while a handler is set, so the queue is never created
+    EXPECT_EQ(publishes.load(), 10);
+    completion_record record;
+    EXPECT_FALSE(client->poll_completion(record));
+    EXPECT_EQ(client->get_completion_stats().pushed, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldShareSendTimesWithCongestionControl)
+{
+    // Arrange: stall the callback thread so that every publish is stamped before it completes
+    congestion_options opts;
+    opts.enabled = true;
+    client->set_congestion_control(opts);
+    std::atomic<int> publishes{0};
+    std::atomic<int> measured{0};
+    client->set_completion_handler([&publishes, &measured](const completion_record& record) {
+        if (record.type == mqtt::token::PUBLISH)
+        {
+            measured += record.latencyNanos > 0 ? 1 : 0;
+            ++publishes;
+        }
+    });
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    std::promise<void> stall;
+    std::shared_future<void> stalled = stall.get_future().share();
+    ASSERT_TRUE(client->subscribe([stalled](const completion_record&) { stalled.wait(); }, TOPIC));
+
+    // Act: fewer publishes than the initial window, so none of them waits for a slot
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_TRUE(client->publish(TOPIC, "measured", 1, false));
+    }
+    stall.set_value();
+    for (int i = 0; i < 100 && publishes.load() < 5; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Assert: one stamp per publish feeds both the controller and the record
+    EXPECT_EQ(publishes.load(), 5);
+    EXPECT_EQ(measured.load(), 5);
+    EXPECT_GT(client->get_congestion_stats().baseLatencyUs, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldRaiseTokenEventsInCompatibilityMode)
+{
+    // Arrange
+    std::promise<int> publishPromise;
+    auto publishFuture = publishPromise.get_future();
+    client->set_completion_mode(CompletionMode::TOKEN_EVENTS);
+    client->set_event_handler([&publishPromise](CallbackEvent event, CallbackVariant info) {
+        if (event == CallbackEvent::EVENT_ACTION_SUCCESS && info.asToken()->get_type() == mqtt::token::PUBLISH)
+        {
+            publishPromise.set_value(info.asToken()->get_message_id());
+        }
+    });
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+
+    // Act
+    ASSERT_TRUE(client->publish(TOPIC, "legacy", 1, false));
+
+    // Assert
+    ASSERT_EQ(publishFuture.wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+    completion_record record;
+    EXPECT_FALSE(client->poll_completion(record));
+}
+
+// Per-call Completion Callback Tests
+TEST_F(MqttClientTest, ShouldRunConnectAndSubscribeCallbacks)
+{
+    // Arrange
+    std::promise<int> connectPromise;
+    std::promise<int> subscribePromise;
+
+    // Act
+    ASSERT_TRUE(client->connect(
+        [&connectPromise](const completion_record& record) { connectPromise.set_value(record.returnCode); }));
+    ASSERT_EQ(connectPromise.get_future().get(), MQTTASYNC_SUCCESS);
+    ASSERT_TRUE(client->subscribe(
+        [&subscribePromise](const completion_record& record) { subscribePromise.set_value(record.type); },
+        TOPIC,
+        1));
+
+    // Assert
+    EXPECT_EQ(subscribePromise.get_future().get(), mqtt::token::SUBSCRIBE);
+    EXPECT_TRUE(client->connected());
+}
+
+TEST_F(MqttClientTest, ShouldReusePooledListenersForPublishCallbacks)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    std::mutex m;
+    std::condition_variable cv;
+    int completed = 0;
+
+    // Act: one publish at a time, each waiting for its own continuation
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(client->publish(
+            [&](const completion_record& record) {
+                EXPECT_EQ(record.type, mqtt::token::PUBLISH);
+                EXPECT_EQ(record.returnCode, MQTTASYNC_SUCCESS);
+                std::lock_guard<std::mutex> lock(m);
+                ++completed;
+                cv.notify_all();
+            },
+            TOPIC,
+            "callback " + std::to_string(i),
+            1));
+        std::unique_lock<std::mutex> lock(m);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MS), [&] { return completed == i + 1; }));
+    }
+
+    // Assert: callbacks bypass the completion queue and the pool did not grow per call
+    completion_record record;
+    while (client->poll_completion(record))
+    {
+        EXPECT_NE(record.type, mqtt::token::PUBLISH);
+    }
+    auto stats = client->get_operation_pool_stats();
+    EXPECT_LE(stats.allocated, 2u);
+    EXPECT_EQ(stats.inUse, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldCompleteDroppedPublishWithQuotaExceeded)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    client->set_rate_limit(1.0, 1, RateLimitMode::DROP);
+    ASSERT_TRUE(client->publish(TOPIC, "first", QOS, true, TIMEOUT_MS));
+    int reasonCode = 0;
+
+    // Act
+    bool result = client->publish([&reasonCode](const completion_record& record) { reasonCode = record.reasonCode; },
+                                  TOPIC,
+                                  "dropped",
+                                  1);
+
+    // Assert: the continuation ran synchronously since the message never left the client
+    EXPECT_TRUE(result);
+    EXPECT_EQ(reasonCode, mqtt::ReasonCode::QUOTA_EXCEEDED);
+    EXPECT_EQ(client->get_operation_pool_stats().inUse, 0u);
+}
+
+// Result API Tests
+TEST_F(MqttClientTest, ShouldReturnErrorCodesWithoutTouchingLastException)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true, TIMEOUT_MS));
+    client->set_rate_limit(1.0, 1, RateLimitMode::FAIL);
+    mqtt::token_ptr token;
+    ASSERT_TRUE(client->try_publish(token, TOPIC, "first", QOS).ok());
+
+    // Act
+    op_result result = client->try_publish(token, TOPIC, "second", QOS);
+
+    // Assert
+    EXPECT_FALSE(result.ok());
+    EXPECT_EQ(result.error().type, ExceptionType::MQTT);
+    EXPECT_EQ(result.return_code(), MQTTASYNC_FAILURE);
+    EXPECT_EQ(result.reason_code(), static_cast<int>(mqtt::ReasonCode::QUOTA_EXCEEDED));
+    EXPECT_STREQ(result.message(), "Publish rate limit exceeded");
+    EXPECT_EQ(client->get_last_exception()->getVariant(), ExceptionType::NONE);
+}
+
+TEST_F(MqttClientTest, ShouldReturnDisconnectedWhenPublishingOffline)
+{
+    // Arrange
+    mqtt::token_ptr token;
+
+    // Act
+    op_result result = client->try_publish(token, mqtt::make_message(TOPIC, "offline", QOS, false));
+
+    // Assert
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.return_code(), MQTTASYNC_DISCONNECTED);
+    EXPECT_EQ(client->get_publish_window_stats().inflight, 0u);
+}
+
+TEST_F(MqttClientTest, ShouldKeepPahoExceptionTextInLastException)
+{
+    // Arrange
+    const std::string expected = mqtt::exception(MQTTASYNC_DISCONNECTED).what();
+
+    // Act
+    bool result = client->subscribe(TOPIC, QOS, false);
+
+    // Assert: the bool API reports paho's own exception, not a rebuilt one
+    EXPECT_FALSE(result);
+    const mqtt::exception* exc = client->get_last_exception()->getMqttException();
+    ASSERT_TRUE(exc != nullptr);
+    EXPECT_EQ(exc->get_return_code(), MQTTASYNC_DISCONNECTED);
+    EXPECT_EQ(std::string(exc->what()), expected);
+}
+
+TEST_F(MqttClientTest, ShouldSummarizeRepeatedPublishErrorsWhileOffline)
+{
+    // Arrange
+    ddbg::set_log_limit_interval(1000);
+    FILE* output = std::tmpfile();
+    ASSERT_NE(output, nullptr);
+    ddbg::async_log_options opts;
+    opts.output = output;
+    ASSERT_TRUE(ddbg::start_async_logging(opts));
+    const int attempts = 20000;
+
+    // Act
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    for (int i = 0; i < attempts; ++i)
+    {
+        failed += client->publish(TOPIC, "offline", QOS, false) ? 0 : 1;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ddbg::flush_async_log();
+    ddbg::stop_async_logging();
+    std::string text;
+    std::rewind(output);
+    char buffer[4096];
+    std::size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), output)) > 0)
+    {
+        text.append(buffer, read);
+    }
+    std::fclose(output);
+
+    // Assert: one line per second at most, and the failures are still reported to the caller
+    std::size_t lines = 0;
+    for (std::size_t pos = text.find("Publish error"); pos != std::string::npos; pos = text.find("Publish error", pos + 1))
+    {
+        ++lines;
+    }
+    EXPECT_EQ(failed, attempts);
+    EXPECT_GE(lines, 1u);
+    EXPECT_LE(lines, static_cast<std::size_t>(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count() + 1));
+    EXPECT_EQ(client->get_last_exception()->getVariant(), ExceptionType::MQTT);
+}
+
+TEST_F(MqttClientTest, ShouldRecordOperationsInTheFlightRecorder)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true));
+    const std::string payload = "recorded";
+
+    // Act
+    bool result = client->publish(TOPIC, payload, QOS, true, TIMEOUT_MS);
+    std::vector<flight_event> events = client->get_flight_events();
+
+    // Assert: the operations come before their completions, and publishes carry the topic hash
+    ASSERT_TRUE(result);
+    auto find = [&events](const char* what, std::size_t from) {
+        for (std::size_t i = from; i < events.size(); ++i)
+        {
+            if (std::string(events[i].what) == what)
+            {
+                return i;
+            }
+        }
+        return events.size();
+    };
+    std::size_t connect = find("connect", 0);
+    std::size_t connected = find("connect done", connect);
+    std::size_t publish = find("publish", connected);
+    std::size_t delivered = find("publish done", publish);
+    ASSERT_LT(connect, events.size());
+    ASSERT_LT(connected, events.size());
+    ASSERT_LT(publish, events.size());
+    ASSERT_LT(delivered, events.size());
+    EXPECT_EQ(events[publish].topicHash, FlightRecorder::topic_hash(TOPIC));
+    EXPECT_EQ(events[delivered].result, 0);
+    EXPECT_LE(events[connect].when, events[delivered].when);
+}
+
+TEST_F(MqttClientTest, ShouldRecordBatchAndCallbackCompletions)
+{
+    // Arrange
+    ASSERT_TRUE(client->connect(true));
+    std::atomic<int> handled{0};
+    client->set_completion_handler([&handled](const completion_record&) { ++handled; });
+    publish_request req;
+    req.topic = TOPIC;
+    req.payload = std::string("recorded");
+    req.qos = 1;
+    std::vector<publish_request> msgs(3, req);
+
+    // Act
+    batch_token_ptr batch;
+    ASSERT_TRUE(client->publish_batch(batch, msgs));
+    ASSERT_TRUE(batch->wait_for(TIMEOUT_MS));
+    std::promise<void> done;
+    ASSERT_TRUE(client->publish([&done](const completion_record&) { done.set_value(); }, TOPIC, "recorded", 1));
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::milliseconds(TIMEOUT_MS)), std::future_status::ready);
+
+    // Assert: every acknowledgement is in the trace, and none went to the completion handler
+    std::size_t delivered = 0;
+    for (const auto& event : client->get_flight_events())
+    {
+        delivered += std::string(event.what) == "publish done";
+    }
+    EXPECT_EQ(delivered, msgs.size() + 1);
+    EXPECT_EQ(handled.load(), 0);
+}
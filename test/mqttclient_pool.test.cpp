@@ -0,0 +1,152 @@
+#include "mqttclient_pool.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <string>
+
+using namespace mqttcpp;
+
+namespace
+{
+    const std::string POOL_SERVER_ADDRESS{std::getenv("MQTT_SERVER") ? std::getenv("MQTT_SERVER")
+                                                                     : "tcp://localhost:1883"};
+    const int POOL_TIMEOUT_MS = 4000;
+} // namespace
+
+// Test fixture
+class MqttClientPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        pool = std::make_unique<MqttClientPool>(POOL_SERVER_ADDRESS, "test_pool", 4);
+    }
+
+    void TearDown() override
+    {
+        if (pool && pool->connected_count() > 0)
+        {
+            pool->disconnect(true, POOL_TIMEOUT_MS);
+        }
+        pool.reset();
+    }
+
+    std::unique_ptr<MqttClientPool> pool;
+};
+
+TEST_F(MqttClientPoolTest, ShouldConnectAndDisconnectEveryClient)
+{
+    // Act
+    bool connectResult = pool->connect(true, POOL_TIMEOUT_MS);
+    std::size_t connectedCount = pool->connected_count();
+    bool disconnectResult = pool->disconnect(true, POOL_TIMEOUT_MS);
+
+    // Assert
+    EXPECT_TRUE(connectResult);
+    EXPECT_EQ(connectedCount, 4u);
+    EXPECT_TRUE(disconnectResult);
+    EXPECT_EQ(pool->connected_count(), 0u);
+}
+
+TEST_F(MqttClientPoolTest, ShouldUseClientDefaultsWithoutConnectOptions)
+{
+    // Assert: pooled clients reconnect on their own, like a lone MqttClient
+    for (std::size_t i = 0; i < pool->size(); ++i)
+    {
+        const mqtt::connect_options& opts = pool->client(i).get_connOpts();
+        EXPECT_TRUE(opts.get_automatic_reconnect());
+        EXPECT_TRUE(opts.get_clean_session());
+        EXPECT_EQ(opts.get_keep_alive_interval(), std::chrono::seconds(60));
+        EXPECT_EQ(opts.get_connect_timeout(), std::chrono::seconds(10));
+    }
+}
+
+TEST_F(MqttClientPoolTest, ShouldRouteTopicsConsistently)
+{
+    // Arrange
+    MqttClientPool other(POOL_SERVER_ADDRESS, "test_pool_other", 4);
+    std::set<std::size_t> used;
+
+    // Act & Assert: the mapping depends only on the topic, and spreads topics over the pool
+    for (int i = 0; i < 200; ++i)
+    {
+        std::string topic = "pool/sensor/" + std::to_string(i);
+        std::size_t shard = pool->shard_of(topic);
+        EXPECT_LT(shard, pool->size());
+        EXPECT_EQ(shard, pool->shard_of(topic));
+        EXPECT_EQ(shard, other.shard_of(topic));
+        used.insert(shard);
+    }
+    EXPECT_EQ(used.size(), pool->size());
+}
+
+TEST_F(MqttClientPoolTest, ShouldPublishBatchAcrossShards)
+{
+    // Arrange
+    ASSERT_TRUE(pool->connect(true, POOL_TIMEOUT_MS));
+    std::vector<publish_request> msgs(100);
+    for (std::size_t i = 0; i < msgs.size(); ++i)
+    {
+        msgs[i].topic = "pool/batch/" + std::to_string(i % 10);
+        msgs[i].payload = std::string("value");
+        msgs[i].qos = 1;
+    }
+
+    // Act
+    std::vector<batch_token_ptr> tokens;
+    bool result = pool->publish_batch(tokens, msgs);
+
+    // Assert
+    EXPECT_TRUE(result);
+    std::size_t total = 0;
+    for (const auto& token : tokens)
+    {
+        EXPECT_TRUE(token->wait_for(POOL_TIMEOUT_MS));
+        EXPECT_EQ(token->failed(), 0u);
+        total += token->size();
+    }
+    EXPECT_EQ(total, msgs.size());
+}
+
+TEST_F(MqttClientPoolTest, ShouldReportBatchFailuresAtTheirPositionInTheBatch)
+{
+    // Arrange: the pool is not connected, so every submission fails; topics are interleaved over two shards
+    const std::string first = "pool/fail/a";
+    std::string second;
+    for (int i = 0; second.empty(); ++i)
+    {
+        std::string topic = "pool/fail/" + std::to_string(i);
+        if (pool->shard_of(topic) != pool->shard_of(first))
+        {
+            second = topic;
+        }
+    }
+    std::vector<publish_request> msgs(6);
+    for (std::size_t i = 0; i < msgs.size(); ++i)
+    {
+        msgs[i].topic = i % 2 == 0 ? first : second;
+        msgs[i].payload = std::string("lost");
+    }
+
+    // Act
+    std::vector<batch_token_ptr> tokens;
+    bool result = pool->publish_batch(tokens, msgs);
+
+    // Assert: every failure points back at the message it belongs to
+    EXPECT_FALSE(result);
+    ASSERT_EQ(tokens.size(), 2u);
+    std::set<std::size_t> indices;
+    for (const auto& token : tokens)
+    {
+        auto failures = token->get_failures();
+        ASSERT_EQ(failures.size(), 3u);
+        for (const auto& failure : failures)
+        {
+            ASSERT_LT(failure.index, msgs.size());
+            EXPECT_EQ(msgs[failure.index].topic, msgs[failures[0].index].topic);
+            indices.insert(failure.index);
+        }
+    }
+    EXPECT_EQ(indices.size(), msgs.size());
+}
@@ -0,0 +1,69 @@
+#include "op_result.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace mqttcpp;
+
+namespace
+{
+    template <typename Exc>
+    op_result result_of(const Exc& exc)
+    {
+        try
+        {
+            throw exc;
+        }
+        catch (...)
+        {
+            return op_result::from_current_exception();
+        }
+    }
+} // namespace
+
+TEST(OpResultTest, ShouldBeSuccessfulByDefault)
+{
+    // Arrange
+    op_result result;
+
+    // Assert
+    EXPECT_TRUE(result.ok());
+    EXPECT_TRUE(static_cast<bool>(result));
+    EXPECT_EQ(result.error().type, ExceptionType::NONE);
+    EXPECT_EQ(result.return_code(), MQTTASYNC_SUCCESS);
+}
+
+TEST(OpResultTest, ShouldKeepCodesOfMqttException)
+{
+    // Act
+    op_result result = result_of(mqtt::exception(MQTTASYNC_FAILURE, mqtt::ReasonCode::QUOTA_EXCEEDED, "quota"));
+
+    // Assert
+    EXPECT_FALSE(result.ok());
+    EXPECT_EQ(result.error().type, ExceptionType::MQTT);
+    EXPECT_EQ(result.return_code(), MQTTASYNC_FAILURE);
+    EXPECT_EQ(result.reason_code(), static_cast<int>(mqtt::ReasonCode::QUOTA_EXCEEDED));
+    EXPECT_STREQ(result.message(), return_code_message(MQTTASYNC_FAILURE));
+    static_assert(std::is_trivially_copyable<op_error>::value, "a failure must not allocate");
+}
+
+TEST(OpResultTest, ShouldClassifyOtherExceptions)
+{
+    // Act
+    op_result standard = result_of(std::runtime_error("boom"));
+    op_result unknown = result_of(42);
+
+    // Assert
+    EXPECT_EQ(standard.error().type, ExceptionType::STANDARD);
+    EXPECT_EQ(unknown.error().type, ExceptionType::UNKNOWN);
+    EXPECT_EQ(unknown.return_code(), MQTTASYNC_FAILURE);
+}
+
+TEST(OpResultTest, ShouldDescribeReturnCodesWithStaticMessages)
+{
+    // Assert
+    EXPECT_STREQ(return_code_message(MQTTASYNC_DISCONNECTED), "Client is disconnected");
+    EXPECT_STREQ(return_code_message(MQTTASYNC_MAX_MESSAGES_INFLIGHT), "Too many messages in flight");
+    EXPECT_STREQ(return_code_message(-1000), "MQTT error");
+}
@@ -0,0 +1,176 @@
+#include "rate_limiter.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+
+using namespace mqttcpp;
+using namespace std::chrono_literals;
+
+// Token Bucket Tests
+TEST(TokenBucketTest, ShouldAllowBurstThenRefuse)
+{
+    // Arrange
+    TokenBucket bucket(10.0, 5);
+    const int64_t now = 1000000000;
+
+    // Act & Assert: five tokens are available right away, the sixth arrives 100ms later
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(bucket.try_acquire(now), 0);
+    }
+    int64_t wait = bucket.try_acquire(now);
+    EXPECT_GT(wait, 0);
+    EXPECT_LE(wait, 100000000);
+    EXPECT_EQ(bucket.try_acquire(now + wait), 0);
+}
+
+TEST(TokenBucketTest, ShouldReserveIntoDebt)
+{
+    // Arrange
+    TokenBucket bucket(1000.0, 1);
+    const int64_t now = 1000000000;
+
+    // Act
+    int64_t first = bucket.reserve(now);
+    int64_t second = bucket.reserve(now);
+    int64_t third = bucket.reserve(now);
+
+    // Assert: each reservation waits one more interval
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(second, 1000000);
+    EXPECT_EQ(third, 2000000);
+}
+
+TEST(TokenBucketTest, ShouldRefundToken)
+{
+    // Arrange
+    TokenBucket bucket(1.0, 1);
+    const int64_t now = 1000000000;
+    ASSERT_EQ(bucket.try_acquire(now), 0);
+    ASSERT_GT(bucket.try_acquire(now), 0);
+
+    // Act
+    bucket.refund();
+
+    // Assert
+    EXPECT_EQ(bucket.try_acquire(now), 0);
+}
+
+// Rate Limiter Tests
+TEST(RateLimiterTest, ShouldPassEverythingWithoutLimits)
+{
+    // Arrange
+    RateLimiter limiter;
+
+    // Act & Assert
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(limiter.acquire("a/b"), RateLimiter::Decision::PASS);
+    }
+}
+
+TEST(RateLimiterTest, ShouldOnlyLimitMatchingTopics)
+{
+    // Arrange
+    RateLimiter limiter;
+    limiter.set_topic_limit("sensors/+/temp", 1.0, 2, RateLimitMode::DROP);
+
+    // Act
+    int passed = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        passed += limiter.acquire("sensors/" + std::to_string(i) + "/temp") == RateLimiter::Decision::PASS;
+        EXPECT_EQ(limiter.acquire("sensors/1/humidity"), RateLimiter::Decision::PASS);
+    }
+
+    // Assert: all matching topics share one bucket
+    EXPECT_EQ(passed, 2);
+    EXPECT_EQ(limiter.get_stats().dropped, 8u);
+}
+
+TEST(RateLimiterTest, ShouldRefundGlobalTokenWhenTopicLimitFails)
+{
+    // Arrange
+    RateLimiter limiter;
+    limiter.set_global_limit(1.0, 3, RateLimitMode::FAIL);
+    limiter.set_topic_limit("slow", 1.0, 1, RateLimitMode::FAIL);
+
+    // Act
+    EXPECT_EQ(limiter.acquire("slow"), RateLimiter::Decision::PASS);
+    EXPECT_EQ(limiter.acquire("slow"), RateLimiter::Decision::FAIL);
+    EXPECT_EQ(limiter.acquire("slow"), RateLimiter::Decision::FAIL);
+
+    // Assert: the refused publishes did not use up the global budget
+    EXPECT_EQ(limiter.acquire("fast"), RateLimiter::Decision::PASS);
+    EXPECT_EQ(limiter.acquire("fast"), RateLimiter::Decision::PASS);
+    EXPECT_EQ(limiter.acquire("fast"), RateLimiter::Decision::FAIL);
+    EXPECT_EQ(limiter.get_stats().failed, 3u);
+}
+
+TEST(RateLimiterTest, ShouldReleaseTokensOfUnsentPublish)
+{
+    // Arrange
+    RateLimiter limiter;
+    limiter.set_global_limit(1.0, 2, RateLimitMode::FAIL);
+    limiter.set_topic_limit("slow", 1.0, 1, RateLimitMode::FAIL);
+    ASSERT_EQ(limiter.acquire("slow"), RateLimiter::Decision::PASS);
+
+    // Act
+    limiter.release("slow");
+
+    // Assert: both the global and the topic bucket got their token back
+    EXPECT_EQ(limiter.acquire("slow"), RateLimiter::Decision::PASS);
+    EXPECT_EQ(limiter.acquire("fast"), RateLimiter::Decision::PASS);
+    EXPECT_EQ(limiter.acquire("fast"), RateLimiter::Decision::FAIL);
+}
+
+TEST(RateLimiterTest, ShouldDelayOverLimitPublishes)
+{
+    // Arrange
+    RateLimiter limiter;
+    limiter.set_global_limit(100.0, 1, RateLimitMode::DELAY);
+
+    // Act
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ(limiter.acquire("a"), RateLimiter::Decision::PASS);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Assert: five publishes had to wait 10ms each
+    EXPECT_GE(elapsed, 45ms);
+    EXPECT_EQ(limiter.get_stats().delayed, 5u);
+}
+
+TEST(RateLimiterTest, ShouldRemoveLimitWithZeroRate)
+{
+    // Arrange
+    RateLimiter limiter;
+    limiter.set_global_limit(1.0, 1, RateLimitMode::FAIL);
+    ASSERT_EQ(limiter.acquire("a"), RateLimiter::Decision::PASS);
+    ASSERT_EQ(limiter.acquire("a"), RateLimiter::Decision::FAIL);
+
+    // Act
+    limiter.set_global_limit(0, 0, RateLimitMode::FAIL);
+
+    // Assert
+    EXPECT_EQ(limiter.acquire("a"), RateLimiter::Decision::PASS);
+}
+
+TEST(RateLimiterTest, ShouldRejectMalformedTopicFilters)
+{
+    // Arrange
+    RateLimiter limiter;
+
+    // Act
+    bool midLevelHash = limiter.set_topic_limit("a/#/b", 1.0, 1, RateLimitMode::FAIL);
+    bool empty = limiter.set_topic_limit("", 1.0, 1, RateLimitMode::FAIL);
+
+    // Assert: nothing was limited, not even through the global rule's empty filter
+    EXPECT_FALSE(midLevelHash);
+    EXPECT_FALSE(empty);
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(limiter.acquire("a/x"), RateLimiter::Decision::PASS);
+    }
+}
@@ -0,0 +1,92 @@
+#include "send_times.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace mqttcpp;
+
+TEST(SendTimesTest, ShouldMeasureLatencyOnce)
+{
+    // Arrange
+    SendTimes times;
+    times.stamp(42, std::chrono::steady_clock::now());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    // Act
+    uint64_t first = times.take_latency(42);
+    uint64_t second = times.take_latency(42);
+
+    // Assert
+    EXPECT_GE(first, 2000000u);
+    EXPECT_EQ(second, 0u);
+}
+
+TEST(SendTimesTest, ShouldReportUnknownLatencyWithoutStamp)
+{
+    // Arrange
+    SendTimes times;
+
+    // Act
+    uint64_t beforeAnyStamp = times.take_latency(7);
+    times.stamp(0, std::chrono::steady_clock::now());
+    uint64_t withoutPacketId = times.take_latency(0);
+
+    // Assert
+    EXPECT_EQ(beforeAnyStamp, 0u);
+    EXPECT_EQ(withoutPacketId, 0u);
+}
+
+TEST(SendTimesTest, ShouldKeepTheLaterSendOfASharedSlot)
+{
+    // Arrange: two packet identifiers one table apart share a slot
+    SendTimes times;
+    const auto now = std::chrono::steady_clock::now();
+    times.stamp(5, now - std::chrono::seconds(10));
+    times.stamp(5 + static_cast<int>(SendTimes::Slots), now);
+
+    // Act
+    uint64_t latency = times.take_latency(5);
+    uint64_t later = times.take_latency(5 + static_cast<int>(SendTimes::Slots));
+
+    // Assert: the earlier publish must not borrow the later send time
+    EXPECT_EQ(latency, 0u);
+    EXPECT_GT(later, 0u);
+    EXPECT_LT(later, 1000000000u);
+}
+
+TEST(SendTimesTest, ShouldMeasureAnAckHandledBeforeTheStamp)
+{
+    // Arrange: the ack arrives on the callback thread while the publish call has not returned yet
+    SendTimes times;
+    const auto sentAt = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    // Act
+    uint64_t atCompletion = times.take_latency(9);
+    uint64_t atStamp = times.stamp(9, sentAt);
+    uint64_t afterwards = times.take_latency(9);
+
+    // Assert: the stamp reports the latency and leaves nothing behind
+    EXPECT_EQ(atCompletion, 0u);
+    EXPECT_GE(atStamp, 2000000u);
+    EXPECT_LT(atStamp, 1000000000u);
+    EXPECT_EQ(afterwards, 0u);
+}
+
+TEST(SendTimesTest, ShouldNotMeasureEarlyFailuresOrEarlierPublishes)
+{
+    // Arrange
+    SendTimes times;
+    times.take_latency(11, false);
+    times.take_latency(12);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Act: 12 is reused by a publish sent after the old ack
+    uint64_t failed = times.stamp(11, std::chrono::steady_clock::now());
+    uint64_t reused = times.stamp(12, std::chrono::steady_clock::now());
+
+    // Assert: the reused identifier is stamped normally
+    EXPECT_EQ(failed, 0u);
+    EXPECT_EQ(reused, 0u);
+    EXPECT_GT(times.take_latency(12), 0u);
+}
@@ -0,0 +1,156 @@
+#include "topic_dispatcher.hpp"
+#include "topic_filter.hpp"
+#include "topic_matches_reference.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    std::size_t count_matches(const TopicDispatcher& dispatcher, const std::string& topic)
+    {
+        std::vector<TopicDispatcher::handler_ptr> matched;
+        dispatcher.match(topic, matched);
+        return matched.size();
+    }
+} // namespace
+
+TEST(TopicDispatcherTest, ShouldInvokeHandlersOfMatchingFilters)
+{
+    // Arrange
+    TopicDispatcher dispatcher;
+    std::vector<std::string> calls;
+    auto record = [&calls](const std::string& name) {
+        return [&calls, name](const mqtt::const_message_ptr&) { calls.push_back(name); };
+    };
+    dispatcher.add("sensors/kitchen/temp", record("literal"));
+    dispatcher.add("sensors/+/temp", record("plus"));
+    dispatcher.add("sensors/#", record("hash"));
+    dispatcher.add("actuators/#", record("other"));
+
+    // Act
+    std::size_t invoked = dispatcher.dispatch(mqtt::make_message("sensors/kitchen/temp", "21", 0, false));
+
+    // Assert
+    EXPECT_EQ(invoked, 3u);
+    std::sort(calls.begin(), calls.end());
+    EXPECT_EQ(calls, (std::vector<std::string>{"hash", "literal", "plus"}));
+}
+
+TEST(TopicDispatcherTest, ShouldRejectMalformedFilters)
+{
+    TopicDispatcher dispatcher;
+    auto noop = [](const mqtt::const_message_ptr&) {};
+
+    EXPECT_EQ(dispatcher.add("a/#/b", noop), TopicDispatcher::INVALID_HANDLER);
+    EXPECT_EQ(dispatcher.add("a/b+", noop), TopicDispatcher::INVALID_HANDLER);
+    EXPECT_EQ(dispatcher.add("a/b", TopicDispatcher::message_handler()), TopicDispatcher::INVALID_HANDLER);
+    EXPECT_EQ(dispatcher.add("a/b", nullptr), TopicDispatcher::INVALID_HANDLER);
+    EXPECT_EQ(dispatcher.size(), 0u);
+}
+
+TEST(TopicDispatcherTest, ShouldStopMatchingRemovedHandlers)
+{
+    // Arrange
+    TopicDispatcher dispatcher;
+    auto noop = [](const mqtt::const_message_ptr&) {};
+    auto first = dispatcher.add("a/+/c", noop);
+    auto second = dispatcher.add("a/+/c", noop);
+    auto deep = dispatcher.add("a/b/c/d", noop);
+
+    // Act
+    bool removedFirst = dispatcher.remove(first);
+    bool removedTwice = dispatcher.remove(first);
+    std::size_t afterFirst = count_matches(dispatcher, "a/b/c");
+    dispatcher.remove(second);
+    dispatcher.remove(deep);
+
+    // Assert
+    EXPECT_TRUE(removedFirst);
+    EXPECT_FALSE(removedTwice);
+    EXPECT_EQ(afterFirst, 1u);
+    EXPECT_EQ(count_matches(dispatcher, "a/b/c"), 0u);
+    EXPECT_EQ(count_matches(dispatcher, "a/b/c/d"), 0u);
+    EXPECT_EQ(dispatcher.size(), 0u);
+}
+
+TEST(TopicDispatcherTest, ShouldAllowHandlersToUnregisterThemselves)
+{
+    // Arrange
+    TopicDispatcher dispatcher;
+    int calls = 0;
+    TopicDispatcher::handler_id id = TopicDispatcher::INVALID_HANDLER;
+    id = dispatcher.add("once/#", [&](const mqtt::const_message_ptr&) {
+        ++calls;
+        dispatcher.remove(id);
+    });
+    auto msg = mqtt::make_message("once/a", "x", 0, false);
+
+    // Act
+    dispatcher.dispatch(msg);
+    dispatcher.dispatch(msg);
+
+    // Assert
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(TopicDispatcherTest, ShouldAgreeWithTopicMatches)
+{
+    // Arrange
+    std::mt19937 rng(42);
+    const std::vector<std::string> levels{"a", "b", "", "$SYS", "c"};
+    auto random_levels = [&](bool wildcards) {
+        std::string out;
+        std::size_t depth = 1 + rng() % 4;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            if (i > 0)
+            {
+                out += '/';
+            }
+            unsigned pick = rng() % (wildcards ? 7 : 5);
+            if (pick == 5)
+            {
+                out += '+';
+            }
+            else if (pick == 6)
+            {
+                out += '#';
+                break;
+            }
+            else
+            {
+                out += levels[pick];
+            }
+        }
+        return out;
+    };
+    std::vector<std::string> filters;
+    TopicDispatcher dispatcher;
+    while (filters.size() < 200)
+    {
+        std::string filter = random_levels(true);
+        if (is_valid_topic_filter(filter))
+        {
+            filters.push_back(filter);
+            ASSERT_NE(dispatcher.add(filter, [](const mqtt::const_message_ptr&) {}), TopicDispatcher::INVALID_HANDLER)
+                << filter;
+        }
+    }
+
+    // Act & Assert
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::string topic = random_levels(false);
+        std::size_t expected = 0;
+        for (const auto& filter : filters)
+        {
+            expected += reference::topic_matches(filter, topic) ? 1 : 0;
+        }
+        EXPECT_EQ(count_matches(dispatcher, topic), expected) << topic;
+    }
+}
@@ -0,0 +1,51 @@
+#include "topic_filter.hpp"
+#include "topic_matches_reference.hpp"
+#include <gtest/gtest.h>
+
+using namespace mqttcpp;
+
+TEST(TopicFilterTest, ShouldMatchLiteralFilters)
+{
+    EXPECT_TRUE(reference::topic_matches("sensors/kitchen/temp", "sensors/kitchen/temp"));
+    EXPECT_FALSE(reference::topic_matches("sensors/kitchen/temp", "sensors/kitchen/humidity"));
+    EXPECT_FALSE(reference::topic_matches("sensors/kitchen", "sensors/kitchen/temp"));
+    EXPECT_FALSE(reference::topic_matches("sensors/kitchen/temp", "sensors/kitchen"));
+}
+
+TEST(TopicFilterTest, ShouldMatchSingleLevelWildcard)
+{
+    EXPECT_TRUE(reference::topic_matches("sensors/+/temp", "sensors/kitchen/temp"));
+    EXPECT_TRUE(reference::topic_matches("+/+", "a/b"));
+    EXPECT_TRUE(reference::topic_matches("a/+", "a/"));
+    EXPECT_FALSE(reference::topic_matches("sensors/+/temp", "sensors/kitchen/oven/temp"));
+    EXPECT_FALSE(reference::topic_matches("sensors/+", "sensors"));
+}
+
+TEST(TopicFilterTest, ShouldMatchMultiLevelWildcard)
+{
+    EXPECT_TRUE(reference::topic_matches("#", "a/b/c"));
+    EXPECT_TRUE(reference::topic_matches("sensors/#", "sensors/kitchen/temp"));
+    EXPECT_TRUE(reference::topic_matches("sensors/#", "sensors"));
+    EXPECT_TRUE(reference::topic_matches("sensors/+/#", "sensors/kitchen/temp"));
+    EXPECT_FALSE(reference::topic_matches("sensors/#", "actuators/kitchen"));
+}
+
+TEST(TopicFilterTest, ShouldNotMatchSystemTopicsWithLeadingWildcard)
+{
+    EXPECT_FALSE(reference::topic_matches("#", "$SYS/broker/uptime"));
+    EXPECT_FALSE(reference::topic_matches("+/broker/uptime", "$SYS/broker/uptime"));
+    EXPECT_TRUE(reference::topic_matches("$SYS/#", "$SYS/broker/uptime"));
+}
+
+TEST(TopicFilterTest, ShouldValidateFilters)
+{
+    EXPECT_TRUE(is_valid_topic_filter("sensors/+/temp"));
+    EXPECT_TRUE(is_valid_topic_filter("sensors/#"));
+    EXPECT_TRUE(is_valid_topic_filter("#"));
+    EXPECT_TRUE(is_valid_topic_filter("+"));
+    EXPECT_TRUE(is_valid_topic_filter("a//b"));
+    EXPECT_FALSE(is_valid_topic_filter(""));
+    EXPECT_FALSE(is_valid_topic_filter("sensors/#/temp"));
+    EXPECT_FALSE(is_valid_topic_filter("sensors/temp#"));
+    EXPECT_FALSE(is_valid_topic_filter("sensors/k+/temp"));
+}
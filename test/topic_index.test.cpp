@@ -0,0 +1,182 @@
+#include "topic_index.hpp"
+#include "topic_filter.hpp"
+#include "topic_matches_reference.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    std::vector<uint32_t> sorted_matches(const TopicIndex& index, const std::string& topic)
+    {
+        std::vector<uint32_t> out;
+        index.match(topic, out);
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+} // namespace
+
+TEST(TopicIndexTest, ShouldMatchLiteralAndWildcardFilters)
+{
+    // Arrange
+    TopicIndex index;
+    index.insert("sensors/kitchen/temp", 1);
+    index.insert("sensors/+/temp", 2);
+    index.insert("sensors/#", 3);
+    index.insert("#", 4);
+    index.insert("sensors/kitchen/temp", 5);
+
+    // Act & Assert
+    EXPECT_EQ(sorted_matches(index, "sensors/kitchen/temp"), (std::vector<uint32_t>{1, 2, 3, 4, 5}));
+    EXPECT_EQ(sorted_matches(index, "sensors/garage/temp"), (std::vector<uint32_t>{2, 3, 4}));
+    EXPECT_EQ(sorted_matches(index, "sensors"), (std::vector<uint32_t>{3, 4}));
+    EXPECT_EQ(sorted_matches(index, "$SYS/uptime"), (std::vector<uint32_t>{}));
+    EXPECT_EQ(index.size(), 5u);
+}
+
+TEST(TopicIndexTest, ShouldInternRepeatedLevelsOnce)
+{
+    // Arrange
+    TopicIndex index;
+
+    // Act
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        index.insert("fleet/" + std::to_string(i % 10) + "/device/" + std::to_string(i) + "/+", i);
+    }
+
+    // Assert
+    // "fleet", "device", the ten fleet numbers and the hundred device numbers, "0".."9" being shared
+    EXPECT_EQ(index.level_count(), 102u);
+    EXPECT_EQ(index.size(), 100u);
+}
+
+TEST(TopicIndexTest, ShouldReuseStorageAfterErase)
+{
+    // Arrange
+    TopicIndex index;
+    std::vector<uint32_t> nodes;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        nodes.push_back(index.insert("a/" + std::to_string(i) + "/b", i));
+    }
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE(index.erase(nodes[i], i));
+    }
+    const std::size_t memory = index.memory_usage();
+
+    // Act
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        index.insert("a/" + std::to_string(i) + "/b", i);
+    }
+
+    // Assert
+    EXPECT_FALSE(index.erase("a/1/b", 5000));
+    EXPECT_TRUE(index.erase("a/1/b", 1));
+    EXPECT_FALSE(index.erase("a/1/b", 1));
+    EXPECT_EQ(index.size(), 999u);
+    EXPECT_EQ(index.memory_usage(), memory);
+    EXPECT_EQ(index.insert("a/#/b", 0), TopicIndex::NONE);
+}
+
+TEST(TopicIndexTest, ShouldReleaseLevelsOfErasedFilters)
+{
+    // Arrange: every round uses new device ids, as with devices coming and going
+    TopicIndex index;
+    index.insert("fleet/+/status", 0);
+    std::size_t memory = 0;
+
+    // Act
+    for (uint32_t round = 0; round < 20; ++round)
+    {
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            index.insert("fleet/device-" + std::to_string(round * 1000 + i) + "/status", i);
+        }
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            ASSERT_TRUE(index.erase("fleet/device-" + std::to_string(round * 1000 + i) + "/status", i));
+        }
+        if (round == 1)
+        {
+            memory = index.memory_usage();
+        }
+    }
+
+    // Assert: only "fleet" and "status" are left, and the storage stopped growing after the first rounds
+    std::vector<uint32_t> out;
+    index.match("fleet/device-7/status", out);
+    EXPECT_EQ(index.level_count(), 2u);
+    EXPECT_EQ(index.memory_usage(), memory);
+    EXPECT_EQ(out, std::vector<uint32_t>{0});
+}
+
+TEST(TopicIndexTest, ShouldAgreeWithTopicMatchesThroughInsertsAndErases)
+{
+    // Arrange
+    std::mt19937 rng(7);
+    const std::vector<std::string> levels{"a", "b", "", "$SYS", "c", "dd"};
+    auto random_name = [&](bool wildcards) {
+        std::string out;
+        std::size_t depth = 1 + rng() % 5;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            if (i > 0)
+            {
+                out += '/';
+            }
+            unsigned pick = rng() % (wildcards ? 8 : 6);
+            if (pick == 6)
+            {
+                out += '+';
+            }
+            else if (pick == 7)
+            {
+                out += '#';
+                break;
+            }
+            else
+            {
+                out += levels[pick];
+            }
+        }
+        return out;
+    };
+    TopicIndex index;
+    std::vector<std::pair<std::string, uint32_t>> stored;
+    for (uint32_t value = 0; stored.size() < 400; ++value)
+    {
+        std::string filter = random_name(true);
+        if (is_valid_topic_filter(filter))
+        {
+            ASSERT_NE(index.insert(filter, value), TopicIndex::NONE);
+            stored.emplace_back(filter, value);
+        }
+    }
+    for (std::size_t i = 0; i < stored.size(); i += 2)
+    {
+        ASSERT_TRUE(index.erase(stored[i].first, stored[i].second));
+    }
+
+    // Act & Assert
+    for (int i = 0; i < 3000; ++i)
+    {
+        std::string topic = random_name(false);
+        std::vector<uint32_t> expected;
+        for (std::size_t s = 1; s < stored.size(); s += 2)
+        {
+            if (reference::topic_matches(stored[s].first, topic))
+            {
+                expected.push_back(stored[s].second);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(sorted_matches(index, topic), expected) << topic;
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file topic_matches_reference.hpp
+ * @brief Plain scalar MQTT topic filter matcher used as the reference in tests.
+ *
+ * The library matches with filter_matches() and the topic indexes. Randomized tests check
+ * them against this straightforward implementation.
+ *
+ * @author duyld15
+ */
+#ifndef __CORE_MQTT_TOPIC_MATCHES_REFERENCE__
+#define __CORE_MQTT_TOPIC_MATCHES_REFERENCE__
+#include <string>
+
+namespace mqttcpp
+{
+    namespace reference
+    {
+        /**
+         * @brief Checks whether a topic name matches a well-formed MQTT topic filter.
+         *
+         * Supports the single-level wildcard `+` and the multi-level wildcard `#`. As required
+         * by the MQTT specification, a filter starting with a wildcard never matches a topic
+         * starting with `$`. Malformed filters give unspecified results.
+         *
+         * @param filter The topic filter, e.g. `sensors/+/temperature` or `sensors/#`.
+         * @param topic The topic name to test.
+         * @return true if @p topic matches @p filter.
+         */
+        inline bool topic_matches(const std::string& filter, const std::string& topic)
+        {
+            if (!topic.empty() && topic[0] == '$' && !filter.empty() && (filter[0] == '+' || filter[0] == '#'))
+            {
+                return false;
+            }
+
+            std::size_t f = 0;
+            std::size_t t = 0;
+            while (f < filter.size())
+            {
+                if (filter[f] == '#')
+                {
+                    return true;
+                }
+                if (filter[f] == '+')
+                {
+                    // Skip one topic level
+                    while (t < topic.size() && topic[t] != '/')
+                    {
+                        ++t;
+                    }
+                    ++f;
+                }
+                else
+                {
+                    // Compare one literal level
+                    while (f < filter.size() && filter[f] != '/')
+                    {
+                        if (t >= topic.size() || topic[t] != filter[f])
+                        {
+                            return false;
+                        }
+                        ++f;
+                        ++t;
+                    }
+                    if (t < topic.size() && topic[t] != '/')
+                    {
+                        return false;
+                    }
+                }
+
+                if (f == filter.size())
+                {
+                    return t == topic.size();
+                }
+                // Both sides are now on a '/' separator
+                if (t == topic.size())
+                {
+                    // "a/#" also matches "a"
+                    return filter.compare(f, std::string::npos, "/#") == 0;
+                }
+                ++f;
+                ++t;
+            }
+            return t == topic.size() && filter.size() > 0;
+        }
+    } // namespace reference
+} // namespace mqttcpp
+
+#endif // __CORE_MQTT_TOPIC_MATCHES_REFERENCE__
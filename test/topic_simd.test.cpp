@@ -0,0 +1,160 @@
+#include "topic_simd.hpp"
+#include "topic_filter.hpp"
+#include "topic_matches_reference.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mqttcpp;
+
+namespace
+{
+    std::vector<SimdLevel> supported_levels()
+    {
+        std::vector<SimdLevel> out;
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2})
+        {
+            if (simd_supported(level))
+            {
+                out.push_back(level);
+            }
+        }
+        return out;
+    }
+
+    std::vector<std::string> reference_split(const std::string& topic)
+    {
+        std::vector<std::string> out;
+        std::size_t pos = 0;
+        while (pos <= topic.size())
+        {
+            std::size_t end = topic.find('/', pos);
+            if (end == std::string::npos)
+            {
+                end = topic.size();
+            }
+            out.push_back(topic.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        return out;
+    }
+
+    // Topics long enough to cross several 16 and 32 byte blocks, with empty, `$` and wildcard-like levels
+    std::string random_name(std::mt19937& rng, bool wildcards)
+    {
+        const std::vector<std::string> levels{"a", "", "$SYS", "telemetry", "device-0123456789abcdef", "x+y", "a#",
+                                              "sensors_with_a_rather_long_level_name_over_32_bytes"};
+        std::string out;
+        std::size_t depth = 1 + rng() % 8;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            if (i > 0)
+            {
+                out += '/';
+            }
+            unsigned pick = rng() % (levels.size() + (wildcards ? 2 : 0));
+            if (pick == levels.size())
+            {
+                out += '+';
+            }
+            else if (pick == levels.size() + 1)
+            {
+                out += '#';
+                break;
+            }
+            else
+            {
+                out += levels[pick];
+            }
+        }
+        return out;
+    }
+} // namespace
+
+TEST(TopicSimdTest, ShouldSplitTopicIntoLevels)
+{
+    std::string_view levels[4];
+
+    EXPECT_EQ(split_topic("sensors/kitchen/temp", levels, 4), 3u);
+    EXPECT_EQ(levels[0], "sensors");
+    EXPECT_EQ(levels[1], "kitchen");
+    EXPECT_EQ(levels[2], "temp");
+    EXPECT_EQ(split_topic("", levels, 4), 1u);
+    EXPECT_EQ(levels[0], "");
+    EXPECT_EQ(split_topic("/a//", levels, 4), 4u);
+    EXPECT_EQ(levels[3], "");
+}
+
+TEST(TopicSimdTest, ShouldCountLevelsBeyondCapacity)
+{
+    // Arrange
+    std::string topic = "0";
+    for (int i = 1; i < 100; ++i)
+    {
+        topic += "/" + std::to_string(i);
+    }
+
+    for (SimdLevel level : supported_levels())
+    {
+        std::string_view levels[8];
+
+        // Act
+        std::size_t count = split_topic(level, topic, levels, 8);
+
+        // Assert
+        EXPECT_EQ(count, 100u) << simd_level_name(level);
+        EXPECT_EQ(levels[7], "7") << simd_level_name(level);
+    }
+}
+
+TEST(TopicSimdTest, ShouldMatchLikeTopicMatches)
+{
+    EXPECT_TRUE(filter_matches("sensors/+/temp", "sensors/kitchen/temp"));
+    EXPECT_TRUE(filter_matches("sensors/#", "sensors"));
+    EXPECT_TRUE(filter_matches("+", ""));
+    EXPECT_FALSE(filter_matches("#", "$SYS/uptime"));
+    EXPECT_TRUE(filter_matches("$SYS/#", "$SYS/uptime"));
+    EXPECT_FALSE(filter_matches("sensors/+", "sensors"));
+    EXPECT_FALSE(filter_matches("", ""));
+}
+
+TEST(TopicSimdTest, ShouldAgreeWithScalarReferenceOnRandomInput)
+{
+    // Arrange
+    std::mt19937 rng(19);
+    const std::vector<SimdLevel> levels = supported_levels();
+    std::string_view parts[16];
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string topic = random_name(rng, false);
+        std::string filter = random_name(rng, true);
+        if (rng() % 4 == 0)
+        {
+            // Share a long prefix so the matcher compares whole blocks before diverging
+            filter = topic.substr(0, rng() % (topic.size() + 1)) + filter;
+        }
+        const std::vector<std::string> expectedLevels = reference_split(topic);
+        const bool validFilter = is_valid_topic_filter(filter);
+        const bool expectedMatch = validFilter && reference::topic_matches(filter, topic);
+
+        for (SimdLevel level : levels)
+        {
+            // Act
+            std::size_t count = split_topic(level, topic, parts, 16);
+
+            // Assert
+            ASSERT_EQ(count, expectedLevels.size()) << simd_level_name(level) << " " << topic;
+            for (std::size_t l = 0; l < count && l < 16; ++l)
+            {
+                ASSERT_EQ(parts[l], expectedLevels[l]) << simd_level_name(level) << " " << topic;
+            }
+            if (validFilter)
+            {
+                ASSERT_EQ(filter_matches(level, filter, topic), expectedMatch)
+                    << simd_level_name(level) << " " << filter << " " << topic;
+            }
+        }
+    }
+}